@@ -54,6 +54,23 @@ static const char *TAG = "FT5x06";
 #define FT5x06_TOUCH5_YH        (0x1D)
 #define FT5x06_TOUCH5_YL        (0x1E)
 
+/* Register block of one touch point: XH, XL, YH, YL, WEIGHT, MISC (area) */
+#define FT5x06_POINT_REG_SIZE   (6)
+#define FT5x06_POINT_WEIGHT     (4)
+#define FT5x06_MAX_POINTS       (5)
+
+#if CONFIG_ESP_LCD_TOUCH_FT5x06_BURST_READ
+/* Points covered by the burst read */
+#define FT5x06_BURST_POINTS     (CONFIG_ESP_LCD_TOUCH_MAX_POINTS < FT5x06_MAX_POINTS ? CONFIG_ESP_LCD_TOUCH_MAX_POINTS : FT5x06_MAX_POINTS)
+#if CONFIG_ESP_LCD_TOUCH_FT5x06_READ_STRENGTH
+#define FT5x06_BURST_LAST_POINT_SIZE    FT5x06_POINT_REG_SIZE
+#else
+#define FT5x06_BURST_LAST_POINT_SIZE    (4)
+#endif
+/* TD_STATUS, the full blocks of all points but the last, then the last point up to what is used */
+#define FT5x06_BURST_SIZE       (1 + FT5x06_POINT_REG_SIZE * (FT5x06_BURST_POINTS - 1) + FT5x06_BURST_LAST_POINT_SIZE)
+#endif
+
 #define FT5x06_ID_G_THGROUP             (0x80)
 #define FT5x06_ID_G_THPEAK              (0x81)
 #define FT5x06_ID_G_THCAL               (0x82)
@@ -167,6 +184,48 @@ err:
     return ret;
 }
 
+#if CONFIG_ESP_LCD_TOUCH_FT5x06_BURST_READ
+static esp_err_t esp_lcd_touch_ft5x06_read_data(esp_lcd_touch_handle_t tp)
+{
+    esp_err_t err;
+    uint8_t data[FT5x06_BURST_SIZE];
+    uint8_t points;
+    size_t i = 0;
+
+    assert(tp != NULL);
+
+    /* One transaction: status and the touch point registers right behind it */
+    err = touch_ft5x06_i2c_read(tp, FT5x06_TOUCH_POINTS, data, sizeof(data));
+    ESP_RETURN_ON_ERROR(err, TAG, "I2C read error!");
+
+    points = data[0];
+    if (points > FT5x06_MAX_POINTS || points == 0) {
+        return ESP_OK;
+    }
+
+    /* Number of touched points */
+    points = (points > FT5x06_BURST_POINTS ? FT5x06_BURST_POINTS : points);
+
+    portENTER_CRITICAL(&tp->data.lock);
+
+    /* Number of touched points */
+    tp->data.points = points;
+
+    /* Fill all coordinates */
+    for (i = 0; i < points; i++) {
+        const uint8_t *p = &data[1 + i * FT5x06_POINT_REG_SIZE];
+        tp->data.coords[i].x = (((uint16_t)p[0] & 0x0f) << 8) + p[1];
+        tp->data.coords[i].y = (((uint16_t)p[2] & 0x0f) << 8) + p[3];
+#if CONFIG_ESP_LCD_TOUCH_FT5x06_READ_STRENGTH
+        tp->data.coords[i].strength = p[FT5x06_POINT_WEIGHT];
+#endif
+    }
+
+    portEXIT_CRITICAL(&tp->data.lock);
+
+    return ESP_OK;
+}
+#else
 static esp_err_t esp_lcd_touch_ft5x06_read_data(esp_lcd_touch_handle_t tp)
 {
     esp_err_t err;
@@ -204,6 +263,7 @@ static esp_err_t esp_lcd_touch_ft5x06_read_data(esp_lcd_touch_handle_t tp)
 
     return ESP_OK;
 }
+#endif
 
 static bool esp_lcd_touch_ft5x06_get_xy(esp_lcd_touch_handle_t tp, uint16_t *x, uint16_t *y, uint16_t *strength, uint8_t *point_num, uint8_t max_point_num)
 {
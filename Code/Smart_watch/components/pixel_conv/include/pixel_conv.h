@@ -0,0 +1,87 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Side of the square tiles `pixel_conv_rotate_rgb565` transposes at a time: 16 pixels are 32 bytes, one cache line
+#define PIXEL_CONV_ROTATE_TILE 16
+
+/**
+ * @brief Pack XRGB8888 pixels (`lv_color32_t`, bytes B, G, R, X in memory) into the R, G, B byte stream of COLMOD 0x77
+ *
+ * @note  `dst` may equal `src`, the conversion is done in place in that case.
+ *
+ * @param[out] dst Output, `n * 3` bytes
+ * @param[in]  src Input, `n` pixels
+ * @param[in]  n   Number of pixels
+ */
+void pixel_conv_xrgb8888_to_rgb888(uint8_t *dst, const uint32_t *src, size_t n);
+
+/**
+ * @brief Swap the two bytes of every RGB565 pixel, e.g. for a renderer built without `LV_COLOR_16_SWAP`
+ *
+ * @note  `dst` may equal `src`.
+ *
+ * @param[out] dst Output, `n` pixels
+ * @param[in]  src Input, `n` pixels
+ * @param[in]  n   Number of pixels
+ */
+void pixel_conv_rgb565_swap(uint16_t *dst, const uint16_t *src, size_t n);
+
+/**
+ * @brief Expand RGB565 pixels into the 3-byte RGB666 stream of COLMOD 0x66 (6 bits in the top of every byte)
+ *
+ * @note  `dst` must not overlap `src`.
+ *
+ * @param[out] dst         Output, `n * 3` bytes
+ * @param[in]  src         Input, `n` pixels
+ * @param[in]  n           Number of pixels
+ * @param[in]  src_swapped Input pixels are byte swapped (`LV_COLOR_16_SWAP`)
+ */
+void pixel_conv_rgb565_to_rgb666(uint8_t *dst, const uint16_t *src, size_t n, bool src_swapped);
+
+/**
+ * @brief Quarter turns of `pixel_conv_rotate_rgb565`, same mapping as LVGL's `lv_disp_rot_t`
+ */
+typedef enum {
+    PIXEL_CONV_ROTATE_0,        /*!< dst[r][c] = src[r][c] */
+    PIXEL_CONV_ROTATE_90,       /*!< dst[r][c] = src[c][w - 1 - r], `dst` is `h` wide and `w` tall */
+    PIXEL_CONV_ROTATE_180,      /*!< dst[r][c] = src[h - 1 - r][w - 1 - c] */
+    PIXEL_CONV_ROTATE_270,      /*!< dst[r][c] = src[h - 1 - c][r], `dst` is `h` wide and `w` tall */
+} pixel_conv_rotation_t;
+
+/**
+ * @brief Rotate a block of 16-bit pixels (RGB565, swapped or not) into a packed buffer
+ *
+ * 90 and 270 degrees are transposed in PIXEL_CONV_ROTATE_TILE square tiles, so the source rows a tile reads
+ * and the destination rows it writes stay in the data cache even when `src` is in PSRAM.
+ *
+ * @note  `dst` must not overlap `src`.
+ *
+ * @param[out] dst        Output, `w * h` pixels, rows of `h` (90/270) or `w` (0/180) pixels without padding
+ * @param[in]  src        Top-left pixel of the input block
+ * @param[in]  src_stride Pixels from one input row to the next
+ * @param[in]  w          Input block width
+ * @param[in]  h          Input block height
+ * @param[in]  rot        Rotation
+ */
+void pixel_conv_rotate_rgb565(uint16_t *dst, const uint16_t *src, size_t src_stride, size_t w, size_t h,
+                              pixel_conv_rotation_t rot);
+
+/**
+ * @brief Name of the kernel set compiled in, "pie" on ESP32-S3, "swar" otherwise
+ */
+const char *pixel_conv_backend(void);
+
+#ifdef __cplusplus
+}
+#endif
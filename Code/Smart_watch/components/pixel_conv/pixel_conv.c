@@ -0,0 +1,260 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "pixel_conv.h"
+
+/*
+ * The portable kernels work a word at a time: four pixels are read, rearranged with shifts in
+ * registers and written as three (RGB888/RGB666) or two (RGB565) aligned 32-bit stores, instead of
+ * one byte store per channel. Pixels before the first aligned word and after the last full group
+ * go through the scalar versions. Little-endian only, like every target of this project.
+ *
+ * On ESP32-S3 the RGB565 swap uses the PIE vector unit (32 bytes per iteration). PIE has no
+ * three-way byte interleave, so the RGB888 and RGB666 kernels stay on the word-at-a-time path.
+ *
+ * The rotation works on 2x2 pixel blocks: one word from each of two neighbouring source rows
+ * holds the two pixels of two destination rows, so four pixels take two loads and two stores
+ * and the halfwords are recombined with shifts. Odd sizes and unaligned blocks fall back to
+ * one pixel at a time, with the same tiling.
+ */
+#if defined(__XTENSA__) && CONFIG_IDF_TARGET_ESP32S3
+#define PIXEL_CONV_USE_PIE 1
+#else
+#define PIXEL_CONV_USE_PIE 0
+#endif
+
+typedef uint32_t __attribute__((may_alias)) pixel_conv_word_t;
+
+#if PIXEL_CONV_USE_PIE
+// pixel_conv_esp32s3.S: swap `blocks` * 16 pixels, both pointers 16-byte aligned
+extern void pixel_conv_rgb565_swap_pie(uint16_t *dst, const uint16_t *src, size_t blocks);
+#endif
+
+static inline uint32_t pixel_conv_xrgb_to_rgb(uint32_t p)
+{
+    // 0xXXRRGGBB -> R | G << 8 | B << 16, the byte order on the wire
+    return ((p >> 16) & 0xff) | (p & 0xff00) | ((p & 0xff) << 16);
+}
+
+static inline uint32_t pixel_conv_565_to_666(uint16_t v)
+{
+    // Widen the 5-bit channels by replicating their top bit, then align every channel to the top of its byte
+    const uint32_t r = ((v >> 11) << 1) | (v >> 15);
+    const uint32_t g = (v >> 5) & 0x3f;
+    const uint32_t b = ((v & 0x1f) << 1) | ((v >> 4) & 0x01);
+    return (r << 2) | (g << 10) | (b << 18);
+}
+
+static inline uint16_t pixel_conv_bswap16(uint16_t v)
+{
+    return (uint16_t)((v << 8) | (v >> 8));
+}
+
+void pixel_conv_xrgb8888_to_rgb888(uint8_t *dst, const uint32_t *src, size_t n)
+{
+    size_t i = 0;
+    if (((uintptr_t)dst & 3) == 0) {
+        pixel_conv_word_t *out = (pixel_conv_word_t *)dst;
+        for (; i + 4 <= n; i += 4) {
+            // Read the whole group first, so converting in place never overwrites unread input
+            const uint32_t q0 = pixel_conv_xrgb_to_rgb(src[i]);
+            const uint32_t q1 = pixel_conv_xrgb_to_rgb(src[i + 1]);
+            const uint32_t q2 = pixel_conv_xrgb_to_rgb(src[i + 2]);
+            const uint32_t q3 = pixel_conv_xrgb_to_rgb(src[i + 3]);
+            *out++ = q0 | (q1 << 24);
+            *out++ = (q1 >> 8) | (q2 << 16);
+            *out++ = (q2 >> 16) | (q3 << 8);
+        }
+    }
+    for (; i < n; i++) {
+        const uint32_t q = pixel_conv_xrgb_to_rgb(src[i]);
+        dst[i * 3] = q;
+        dst[i * 3 + 1] = q >> 8;
+        dst[i * 3 + 2] = q >> 16;
+    }
+}
+
+void pixel_conv_rgb565_swap(uint16_t *dst, const uint16_t *src, size_t n)
+{
+#if PIXEL_CONV_USE_PIE
+    if (((uintptr_t)dst & 15) == ((uintptr_t)src & 15)) {
+        while (n && ((uintptr_t)dst & 15)) {
+            *dst++ = pixel_conv_bswap16(*src++);
+            n--;
+        }
+        const size_t blocks = n / 16;
+        pixel_conv_rgb565_swap_pie(dst, src, blocks);
+        dst += blocks * 16;
+        src += blocks * 16;
+        n -= blocks * 16;
+    }
+#endif
+    if (((uintptr_t)dst & 3) == ((uintptr_t)src & 3)) {
+        if (n && ((uintptr_t)dst & 3)) {
+            *dst++ = pixel_conv_bswap16(*src++);
+            n--;
+        }
+        pixel_conv_word_t *out = (pixel_conv_word_t *)dst;
+        const pixel_conv_word_t *in = (const pixel_conv_word_t *)src;
+        const size_t words = n / 2;
+        for (size_t i = 0; i < words; i++) {
+            const uint32_t w = in[i];
+            out[i] = ((w & 0x00ff00ff) << 8) | ((w >> 8) & 0x00ff00ff);
+        }
+        dst += words * 2;
+        src += words * 2;
+        n -= words * 2;
+    }
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = pixel_conv_bswap16(src[i]);
+    }
+}
+
+void pixel_conv_rgb565_to_rgb666(uint8_t *dst, const uint16_t *src, size_t n, bool src_swapped)
+{
+    size_t i = 0;
+    if (((uintptr_t)dst & 3) == 0) {
+        pixel_conv_word_t *out = (pixel_conv_word_t *)dst;
+        for (; i + 4 <= n; i += 4) {
+            uint16_t v0 = src[i], v1 = src[i + 1], v2 = src[i + 2], v3 = src[i + 3];
+            if (src_swapped) {
+                v0 = pixel_conv_bswap16(v0);
+                v1 = pixel_conv_bswap16(v1);
+                v2 = pixel_conv_bswap16(v2);
+                v3 = pixel_conv_bswap16(v3);
+            }
+            const uint32_t q0 = pixel_conv_565_to_666(v0);
+            const uint32_t q1 = pixel_conv_565_to_666(v1);
+            const uint32_t q2 = pixel_conv_565_to_666(v2);
+            const uint32_t q3 = pixel_conv_565_to_666(v3);
+            *out++ = q0 | (q1 << 24);
+            *out++ = (q1 >> 8) | (q2 << 16);
+            *out++ = (q2 >> 16) | (q3 << 8);
+        }
+    }
+    for (; i < n; i++) {
+        const uint32_t q = pixel_conv_565_to_666(src_swapped ? pixel_conv_bswap16(src[i]) : src[i]);
+        dst[i * 3] = q;
+        dst[i * 3 + 1] = q >> 8;
+        dst[i * 3 + 2] = q >> 16;
+    }
+}
+
+static inline size_t pixel_conv_min(size_t a, size_t b)
+{
+    return a < b ? a : b;
+}
+
+// 90 degrees, `w`, `h` and `src_stride` even, `src` and `dst` word aligned
+static void pixel_conv_rotate90_words(uint16_t *dst, const uint16_t *src, size_t src_stride, size_t w, size_t h)
+{
+    for (size_t c0 = 0; c0 < h; c0 += PIXEL_CONV_ROTATE_TILE) {
+        const size_t c1 = pixel_conv_min(c0 + PIXEL_CONV_ROTATE_TILE, h);
+        for (size_t r0 = 0; r0 < w; r0 += PIXEL_CONV_ROTATE_TILE) {
+            const size_t r1 = pixel_conv_min(r0 + PIXEL_CONV_ROTATE_TILE, w);
+            for (size_t r = r0; r < r1; r += 2) {
+                // Source columns w - 2 - r and w - 1 - r become destination rows r + 1 and r
+                const uint16_t *col = src + (w - 2 - r);
+                pixel_conv_word_t *out0 = (pixel_conv_word_t *)(dst + r * h);
+                pixel_conv_word_t *out1 = (pixel_conv_word_t *)(dst + (r + 1) * h);
+                for (size_t c = c0; c < c1; c += 2) {
+                    const uint32_t a = *(const pixel_conv_word_t *)(col + c * src_stride);
+                    const uint32_t b = *(const pixel_conv_word_t *)(col + (c + 1) * src_stride);
+                    out0[c / 2] = (a >> 16) | (b & 0xffff0000);
+                    out1[c / 2] = (a & 0xffff) | (b << 16);
+                }
+            }
+        }
+    }
+}
+
+// 270 degrees, same requirements as pixel_conv_rotate90_words
+static void pixel_conv_rotate270_words(uint16_t *dst, const uint16_t *src, size_t src_stride, size_t w, size_t h)
+{
+    for (size_t c0 = 0; c0 < h; c0 += PIXEL_CONV_ROTATE_TILE) {
+        const size_t c1 = pixel_conv_min(c0 + PIXEL_CONV_ROTATE_TILE, h);
+        for (size_t r0 = 0; r0 < w; r0 += PIXEL_CONV_ROTATE_TILE) {
+            const size_t r1 = pixel_conv_min(r0 + PIXEL_CONV_ROTATE_TILE, w);
+            for (size_t r = r0; r < r1; r += 2) {
+                // Source columns r and r + 1, read bottom-up, become destination rows r and r + 1
+                const uint16_t *col = src + (h - 1) * src_stride + r;
+                pixel_conv_word_t *out0 = (pixel_conv_word_t *)(dst + r * h);
+                pixel_conv_word_t *out1 = (pixel_conv_word_t *)(dst + (r + 1) * h);
+                for (size_t c = c0; c < c1; c += 2) {
+                    const uint32_t a = *(const pixel_conv_word_t *)(col - c * src_stride);
+                    const uint32_t b = *(const pixel_conv_word_t *)(col - (c + 1) * src_stride);
+                    out0[c / 2] = (a & 0xffff) | (b << 16);
+                    out1[c / 2] = (a >> 16) | (b & 0xffff0000);
+                }
+            }
+        }
+    }
+}
+
+// 180 degrees, same requirements as pixel_conv_rotate90_words
+static void pixel_conv_rotate180_words(uint16_t *dst, const uint16_t *src, size_t src_stride, size_t w, size_t h)
+{
+    pixel_conv_word_t *out = (pixel_conv_word_t *)dst;
+    for (size_t r = 0; r < h; r++) {
+        const pixel_conv_word_t *in = (const pixel_conv_word_t *)(src + (h - 1 - r) * src_stride);
+        for (size_t c = w / 2; c > 0; c--) {
+            const uint32_t v = in[c - 1];
+            *out++ = (v >> 16) | (v << 16);
+        }
+    }
+}
+
+void pixel_conv_rotate_rgb565(uint16_t *dst, const uint16_t *src, size_t src_stride, size_t w, size_t h,
+                              pixel_conv_rotation_t rot)
+{
+    if (rot == PIXEL_CONV_ROTATE_0) {
+        for (size_t r = 0; r < h; r++) {
+            memcpy(dst + r * w, src + r * src_stride, w * sizeof(uint16_t));
+        }
+        return;
+    }
+    const bool words = ((uintptr_t)dst & 3) == 0 && ((uintptr_t)src & 3) == 0 && ((w | h | src_stride) & 1) == 0;
+    if (rot == PIXEL_CONV_ROTATE_180) {
+        if (words) {
+            pixel_conv_rotate180_words(dst, src, src_stride, w, h);
+            return;
+        }
+        for (size_t r = 0; r < h; r++) {
+            const uint16_t *in = src + (h - 1 - r) * src_stride + w - 1;
+            for (size_t c = 0; c < w; c++) {
+                *dst++ = *(in - c);
+            }
+        }
+        return;
+    }
+    if (words) {
+        if (rot == PIXEL_CONV_ROTATE_90) {
+            pixel_conv_rotate90_words(dst, src, src_stride, w, h);
+        } else {
+            pixel_conv_rotate270_words(dst, src, src_stride, w, h);
+        }
+        return;
+    }
+    for (size_t c0 = 0; c0 < h; c0 += PIXEL_CONV_ROTATE_TILE) {
+        const size_t c1 = pixel_conv_min(c0 + PIXEL_CONV_ROTATE_TILE, h);
+        for (size_t r0 = 0; r0 < w; r0 += PIXEL_CONV_ROTATE_TILE) {
+            const size_t r1 = pixel_conv_min(r0 + PIXEL_CONV_ROTATE_TILE, w);
+            for (size_t r = r0; r < r1; r++) {
+                for (size_t c = c0; c < c1; c++) {
+                    dst[r * h + c] = rot == PIXEL_CONV_ROTATE_90 ? src[c * src_stride + (w - 1 - r)]
+                                                                 : src[(h - 1 - c) * src_stride + r];
+                }
+            }
+        }
+    }
+}
+
+const char *pixel_conv_backend(void)
+{
+    return PIXEL_CONV_USE_PIE ? "pie" : "swar";
+}
@@ -0,0 +1,324 @@
+/*
+ * Asset pack benchmark: the SquareLine images served by disp_assets from the pack the firmware build writes to the
+ * "assets" partition, here mapped from the file, against the same images linked into the program.
+ *
+ *   asset_bench [--pack FILE] [--rounds N]
+ *
+ * Opens the pack as main.c does (image IDs checked against ui_assets.h, CRC verified) and checks every image:
+ * its descriptor points into the mapping, so nothing was copied, it has the size of the original and LVGL draws
+ * the same frame from both. Prints the time to map the pack and to verify it, averaged over --rounds (default
+ * 100) opens. Then damaged packs must be refused with the error disp_assets.h gives for them: a flipped data
+ * byte, another set of images, a pack cut short, not a pack, no partition.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "lvgl.h"
+#include "ui.h"
+#include "ui_assets.h"
+
+#include "disp_assets.h"
+#include "disp_img.h"
+
+#define BENCH_H_RES             368
+#define BENCH_V_RES             448
+#define BENCH_BG                0x404040
+
+static const char *TAG = "asset_bench";
+
+static lv_color_t frame[BENCH_H_RES * BENCH_V_RES];
+static lv_color_t ref[BENCH_H_RES * BENCH_V_RES];
+
+// Exported by SquareLine but used by no screen, so ui.h does not declare it
+LV_IMG_DECLARE(ui_img_watch_png);
+
+// The linked-in originals, by ID
+static const lv_img_dsc_t *const originals[UI_ASSET_COUNT] = {
+    [UI_ASSET_1718491849] = &ui_img_1718491849,
+    [UI_ASSET_1726297279_195593_PNG] = &ui_img_1726297279_195593_png,
+    [UI_ASSET_543043862] = &ui_img_543043862,
+    [UI_ASSET_671965521] = &ui_img_671965521,
+    [UI_ASSET_812553787] = &ui_img_812553787,
+    [UI_ASSET_AIRPRESSURE_PNG] = &ui_img_airpressure_png,
+    [UI_ASSET_AIRPUMP_PNG] = &ui_img_airpump_png,
+    [UI_ASSET_BLUETOOTH_PNG] = &ui_img_bluetooth_png,
+    [UI_ASSET_BOOTH_PNG] = &ui_img_booth_png,
+    [UI_ASSET_CHENSHI_PNG] = &ui_img_chenshi_png,
+    [UI_ASSET_COPY_PNG] = &ui_img_copy_png,
+    [UI_ASSET_DINGWEI_PNG] = &ui_img_dingwei_png,
+    [UI_ASSET_DUOYUN_PNG] = &ui_img_duoyun_png,
+    [UI_ASSET_GUADUAN_PNG] = &ui_img_guaduan_png,
+    [UI_ASSET_HEART_PNG] = &ui_img_heart_png,
+    [UI_ASSET_HEARTSMALL_PNG] = &ui_img_heartsmall_png,
+    [UI_ASSET_HELLO_PNG] = &ui_img_hello_png,
+    [UI_ASSET_HUNDRED_POINTS_COLOR_PNG] = &ui_img_hundred_points_color_png,
+    [UI_ASSET_JIETING_PNG] = &ui_img_jieting_png,
+    [UI_ASSET_KALULI_PNG] = &ui_img_kaluli_png,
+    [UI_ASSET_LIANJIE_PNG] = &ui_img_lianjie_png,
+    [UI_ASSET_LIFANG_PNG] = &ui_img_lifang_png,
+    [UI_ASSET_PARTY_POPPER_COLOR_PNG] = &ui_img_party_popper_color_png,
+    [UI_ASSET_SHANDIAN_PNG] = &ui_img_shandian_png,
+    [UI_ASSET_SHQ2_PNG] = &ui_img_shq2_png,
+    [UI_ASSET_SMILING_FACE_WITH_HEARTS_COLOR_PNG] = &ui_img_smiling_face_with_hearts_color_png,
+    [UI_ASSET_STATE_PNG] = &ui_img_state_png,
+    [UI_ASSET_WATCH_PNG] = &ui_img_watch_png,
+    [UI_ASSET_WIFI_PNG] = &ui_img_wifi_png,
+    [UI_ASSET_YOUJIAN_PNG] = &ui_img_youjian_png,
+    [UI_ASSET_ZUJI_PNG] = &ui_img_zuji_png,
+    [UI_ASSET_ZUOBIAO_PNG] = &ui_img_zuobiao_png,
+    [UI_ASSET_ZZZ_COLOR_PNG] = &ui_img_zzz_color_png,
+};
+
+static void bench_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    const int32_t w = lv_area_get_width(area);
+    for (int32_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&frame[y * BENCH_H_RES + area->x1], color_map, w * sizeof(lv_color_t));
+        color_map += w;
+    }
+    lv_disp_flush_ready(drv);
+}
+
+static void bench_draw(lv_obj_t *img, const lv_img_dsc_t *src)
+{
+    lv_img_set_src(img, src);
+    lv_obj_center(img);
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);
+}
+
+// Every image of the pack against its original; returns the failures
+static int bench_check_images(disp_assets_handle_t assets, lv_obj_t *img)
+{
+    int failures = 0;
+    disp_assets_info_t info;
+    disp_assets_get_info(assets, &info);
+    size_t raw_bytes = 0;
+    for (size_t id = 0; id < UI_ASSET_COUNT; id++) {
+        const lv_img_dsc_t *dsc = disp_assets_get(assets, id);
+        const lv_img_dsc_t *orig = originals[id];
+        const char *name = disp_assets_get_name(assets, id);
+        raw_bytes += orig->data_size;
+        if (dsc != ui_assets[id] || disp_assets_find(assets, name) != dsc) {
+            ESP_LOGE(TAG, "%s: ID %u and name give different images", name, (unsigned)id);
+            failures++;
+            continue;
+        }
+        if (dsc->header.w != orig->header.w || dsc->header.h != orig->header.h ||
+            (dsc->header.cf != orig->header.cf && !disp_img_is_compressed(dsc))) {
+            ESP_LOGE(TAG, "%s: %dx%d cf %d, original %dx%d cf %d", name, dsc->header.w, dsc->header.h,
+                     dsc->header.cf, orig->header.w, orig->header.h, orig->header.cf);
+            failures++;
+            continue;
+        }
+        bench_draw(img, orig);
+        memcpy(ref, frame, sizeof(frame));
+        bench_draw(img, dsc);
+        if (memcmp(ref, frame, sizeof(frame))) {
+            ESP_LOGE(TAG, "%s: frame differs from the original", name);
+            failures++;
+        }
+    }
+    if (disp_assets_get(assets, UI_ASSET_COUNT) || disp_assets_find(assets, "ui_img_none")) {
+        ESP_LOGE(TAG, "an image out of the pack was served");
+        failures++;
+    }
+    printf("%u images: %u bytes linked in, %u bytes of pack in a %u byte partition\n", (unsigned)info.count,
+           (unsigned)raw_bytes, (unsigned)info.pack_bytes, (unsigned)info.partition_bytes);
+    return failures;
+}
+
+// Image data must lie in one mapping of the file, at the offsets of the pack entries, not in copies
+static int bench_check_mapped(disp_assets_handle_t assets, const char *path)
+{
+    disp_assets_info_t info;
+    disp_assets_get_info(assets, &info);
+    FILE *f = fopen(path, "rb");
+    uint8_t *file = malloc(info.pack_bytes);
+    const bool read = f && fread(file, 1, info.pack_bytes, f) == info.pack_bytes;
+    if (f) {
+        fclose(f);
+    }
+    int failures = read ? 0 : 1;
+    const uint8_t *entries = file + 32;
+    const uint32_t first = entries[0] | entries[1] << 8 | entries[2] << 16 | (uint32_t)entries[3] << 24;
+    for (size_t id = 0; id < UI_ASSET_COUNT && read; id++) {
+        const uint8_t *e = entries + 16 * id;
+        const uint32_t offset = e[0] | e[1] << 8 | e[2] << 16 | (uint32_t)e[3] << 24;
+        const lv_img_dsc_t *dsc = ui_assets[id];
+        if (dsc->data - ui_assets[0]->data != (ptrdiff_t)offset - (ptrdiff_t)first ||
+            memcmp(dsc->data, file + offset, dsc->data_size)) {
+            failures++;
+        }
+    }
+    free(file);
+    if (failures) {
+        ESP_LOGE(TAG, "images not served from one mapping of %s", path);
+    }
+    return failures ? 1 : 0;
+}
+
+// A copy of the pack with `edit` applied, added as partition `label`; returns the file to delete
+static char *bench_damaged(const char *path, const char *label, void (*edit)(uint8_t *pack, long *size))
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *pack = malloc(size);
+    const bool read = fread(pack, 1, size, f) == (size_t)size;
+    fclose(f);
+    char *tmp = strdup("/tmp/asset_bench_XXXXXX");
+    const int fd = mkstemp(tmp);
+    if (read && fd >= 0) {
+        edit(pack, &size);
+        if (write(fd, pack, size) != size) {
+            ESP_LOGE(TAG, "cannot write %s", tmp);
+        }
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    free(pack);
+    ESP_ERROR_CHECK(esp_partition_sim_add_file(label, ESP_PARTITION_TYPE_DATA,
+                                               (esp_partition_subtype_t)DISP_ASSETS_PARTITION_SUBTYPE, tmp));
+    return tmp;
+}
+
+static void bench_flip_data(uint8_t *pack, long *size)
+{
+    pack[*size - 1] ^= 0x01;
+}
+
+static void bench_cut_short(uint8_t *pack, long *size)
+{
+    *size /= 2;
+}
+
+static void bench_not_pack(uint8_t *pack, long *size)
+{
+    pack[0] ^= 0xFF;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = UI_ASSETS_PACK;
+    int rounds = 100;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--pack") && i + 1 < argc) {
+            path = argv[++i];
+        } else if (!strcmp(argv[i], "--rounds") && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--pack FILE] [--rounds N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (rounds < 1) {
+        rounds = 1;
+    }
+
+    lv_init();
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf1[BENCH_H_RES * BENCH_V_RES];
+    lv_disp_draw_buf_init(&draw_buf, buf1, NULL, BENCH_H_RES * BENCH_V_RES);
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = BENCH_H_RES;
+    disp_drv.ver_res = BENCH_V_RES;
+    disp_drv.flush_cb = bench_flush_cb;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_drv_register(&disp_drv);
+    // No cache, every draw decodes its rows
+    const disp_img_config_t img_config = {0};
+    disp_img_handle_t decoder = NULL;
+    ESP_ERROR_CHECK(disp_img_new(&img_config, &decoder));
+    lv_obj_t *scr = lv_obj_create(NULL);
+    lv_obj_set_style_bg_color(scr, lv_color_hex(BENCH_BG), 0);
+    lv_obj_t *img = lv_img_create(scr);
+    lv_disp_load_scr(scr);
+
+    ESP_ERROR_CHECK(esp_partition_sim_add_file(DISP_ASSETS_DEFAULT_LABEL, ESP_PARTITION_TYPE_DATA,
+                                               (esp_partition_subtype_t)DISP_ASSETS_PARTITION_SUBTYPE, path));
+    disp_assets_config_t config = {
+        .images = ui_assets,
+        .count = UI_ASSET_COUNT,
+        .ids_hash = UI_ASSETS_HASH,
+        .verify = true,
+    };
+    int failures = 0;
+    uint64_t map_us = 0, verify_us = 0;
+    for (int r = 0; r < rounds; r++) {
+        disp_assets_handle_t assets = NULL;
+        const esp_err_t err = disp_assets_new(&config, &assets);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "%s: %s", path, esp_err_to_name(err));
+            return 1;
+        }
+        disp_assets_info_t info;
+        disp_assets_get_info(assets, &info);
+        map_us += info.map_us;
+        verify_us += info.verify_us;
+        if (r == rounds - 1) {
+            failures += bench_check_images(assets, img);
+            failures += bench_check_mapped(assets, path);
+            lv_img_set_src(img, NULL);
+        }
+        // One open logged is enough
+        esp_log_level_set("*", ESP_LOG_WARN);
+        disp_assets_del(assets);
+    }
+    printf("open: map %.1f us, verify %.1f us (avg of %d)\n", (double)map_us / rounds, (double)verify_us / rounds,
+           rounds);
+    for (size_t id = 0; id < UI_ASSET_COUNT; id++) {
+        if (ui_assets[id]->data || ui_assets[id]->data_size) {
+            ESP_LOGE(TAG, "descriptor %u not emptied by disp_assets_del", (unsigned)id);
+            failures++;
+            break;
+        }
+    }
+
+    // Damaged packs, each refused with the error it logs
+    struct {
+        const char *what;
+        const char *label;
+        void (*edit)(uint8_t *pack, long *size);
+        uint32_t ids_hash;
+        esp_err_t expected;
+    } cases[] = {
+        {"flipped data byte", "flipped", bench_flip_data, UI_ASSETS_HASH, ESP_ERR_INVALID_CRC},
+        {"other images", DISP_ASSETS_DEFAULT_LABEL, NULL, UI_ASSETS_HASH ^ 1, ESP_ERR_INVALID_VERSION},
+        {"cut short", "short", bench_cut_short, UI_ASSETS_HASH, ESP_ERR_INVALID_SIZE},
+        {"not a pack", "garbage", bench_not_pack, UI_ASSETS_HASH, ESP_ERR_INVALID_VERSION},
+        {"no partition", "missing", NULL, UI_ASSETS_HASH, ESP_ERR_NOT_FOUND},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        char *tmp = cases[i].edit ? bench_damaged(path, cases[i].label, cases[i].edit) : NULL;
+        config.label = cases[i].label;
+        config.ids_hash = cases[i].ids_hash;
+        disp_assets_handle_t assets = NULL;
+        const esp_err_t err = disp_assets_new(&config, &assets);
+        printf("%-18s %s\n", cases[i].what, esp_err_to_name(err));
+        if (err != cases[i].expected || assets || ui_assets[0]->data) {
+            ESP_LOGE(TAG, "%s: expected %s", cases[i].what, esp_err_to_name(cases[i].expected));
+            failures++;
+        }
+        if (assets) {
+            disp_assets_del(assets);
+        }
+        if (tmp) {
+            unlink(tmp);
+            free(tmp);
+        }
+    }
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,792 @@
+/*
+ * Flush benchmark: renders the SquareLine screens through example_lvgl_flush_cb into the
+ * simulated SH8601 and reports per-frame bus statistics.
+ *
+ *   flush_bench [--frames N] [--png DIR] [--engine serialized|pipelined] [--render-ns-per-px N]
+ *               [--regions [--area-cost-ns N] [--pixel-cost-ns N]] [--fb] [--te US [--te-sync]]
+ *               [--rotate 90|180|270] [--buf STRATEGY | --buf-sweep] [--internal-kb N] [--psram-ns-per-px N]
+ *               [--aod HOURS]
+ *
+ * With --engine the frames go through the disp_flush engine on a realtime bus (transfers take
+ * their modelled time and complete asynchronously) and render/transfer overlap is reported.
+ * --render-ns-per-px adds a fixed drawing cost per rendered pixel, so the host renders about as
+ * slowly as the ESP32-S3 and the render/transfer ratio is close to the watch.
+ * --regions runs the disp_region planner on the invalid areas before every refresh, the cost model
+ * defaults to DISP_REGION_DEFAULT_AREA_COST_NS / DISP_REGION_DEFAULT_PIXEL_COST_NS. At the end the planner
+ * is attached again and one frame is refreshed through the refresh timer it wraps.
+ * --fb renders in LVGL direct mode into a full-screen framebuffer and sends it through disp_fb, which
+ * only transmits the segments whose hash changed (not combinable with --engine).
+ * --te gives the simulated panel a TE line with the given refresh period and counts transfers the scan
+ * line runs through (tears); after the regular scenes, a 60-frame animation is run twice, redrawing the
+ * whole screen and only the arcs. By default those frames are refreshed back to back like the free-running
+ * refresh timer; --te-sync starts every refresh on a TE edge through disp_te and reports its deadlines.
+ * --rotate sets the LVGL rotation and sends the frames through disp_rotate, then checks that markers drawn
+ * at logical points land where LVGL and disp_rotate_touch_point map touches on them, and reports the rotation share of the frame time
+ * (not combinable with --fb).
+ * --buf lets disp_buf allocate the draw buffers (auto, sram-double, sram-single or psram-bounce) out of a
+ * modelled internal heap of --internal-kb (default HEAP_CAPS_SIM_INTERNAL_SIZE). --buf-sweep then redraws
+ * every screen with every strategy on a realtime bus and prints frame rate against RAM; --psram-ns-per-px
+ * adds a drawing cost per pixel while the stripes are in PSRAM, which the host does not model.
+ * --aod puts the panel in always-on mode through disp_aod and runs HOURS of minute updates on a virtual
+ * clock, then reports renders, bus traffic, CPU time and lit pixels per hour and checks that the face
+ * stays inside the partial area and that the watch face comes back unchanged.
+ */
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_lcd_panel_ops.h"
+#include "lvgl.h"
+
+#include "ui.h"
+#include "disp_port.h"
+#include "disp_flush.h"
+#include "disp_region.h"
+#include "disp_fb.h"
+#include "disp_te.h"
+#include "disp_rotate.h"
+#include "disp_buf.h"
+#include "disp_trace.h"
+#include "disp_aod.h"
+#include "sim_lcd_sh8601.h"
+
+static const char *TAG = "flush_bench";
+
+static lv_disp_drv_t disp_drv;
+static sim_lcd_handle_t sim;
+static const char *png_dir;
+static int frame_no;
+static const char *engine_mode;
+static disp_flush_handle_t engine;
+static uint32_t render_ns_per_px;
+static bool use_regions;
+static disp_region_config_t region_config;
+static void (*port_flush_cb)(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map);
+static void (*sw_wait_for_finish)(lv_draw_ctx_t *draw_ctx);
+static bool render_charged;
+static bool use_fb;
+static disp_fb_handle_t fb;
+static uint32_t te_period_us;
+static bool te_sync;
+static disp_te_handle_t te;
+static int rotation;
+static disp_rotate_handle_t rotate;
+static int64_t frames_cpu_us;
+static int failures;
+static lv_point_t touch_point;
+static const char *buf_strategy;
+static bool buf_sweep;
+static disp_buf_handle_t buf_mgr;
+static uint32_t internal_kb;
+static int psram_rows;
+static const char *trace_path;
+static disp_trace_handle_t trace;
+static uint32_t psram_ns_per_px;
+static int aod_hours;
+static int aod_minute;
+
+typedef struct {
+    const char *name;
+    lv_obj_t **screen;
+    void (*init)(void);
+} bench_screen_t;
+
+static const bench_screen_t screens[] = {
+    {"Screen1", &ui_Screen1, ui_Screen1_screen_init},
+    {"Screen2", &ui_Screen2, ui_Screen2_screen_init},
+    {"Screen3", &ui_Screen3, ui_Screen3_screen_init},
+    {"Screen4", &ui_Screen4, ui_Screen4_screen_init},
+    {"Screen5", &ui_Screen5, ui_Screen5_screen_init},
+    {"Screen6", &ui_Screen6, ui_Screen6_screen_init},
+};
+
+// Charge the modelled target drawing time of an area once, the first time LVGL waits for its drawing to finish.
+// The last such wait is right before draw_buf_flush blocks on the other buffer, so the cost lands where the
+// rendering would be on the watch.
+static void bench_wait_for_finish(lv_draw_ctx_t *draw_ctx)
+{
+    sw_wait_for_finish(draw_ctx);
+    if (render_charged) {
+        return;
+    }
+    render_charged = true;
+    // The clip area is the rendered area, the buffer area is the whole screen in direct mode
+    uint32_t ns_per_px = render_ns_per_px;
+    if (buf_mgr) {
+        disp_buf_info_t info;
+        disp_buf_get_info(buf_mgr, &info);
+        ns_per_px += info.strategy == DISP_BUF_PSRAM_BOUNCE ? psram_ns_per_px : 0;
+    }
+    const int64_t until = esp_timer_get_time() + (int64_t)lv_area_get_size(draw_ctx->clip_area) * ns_per_px / 1000;
+    while (esp_timer_get_time() < until) {
+        // Let the bus thread run on single-core hosts, the watch has a DMA engine for that
+        sched_yield();
+    }
+}
+
+static void bench_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    render_charged = false;
+    port_flush_cb(drv, area, color_map);
+}
+
+// Without an engine LVGL spins on `flushing`, let the bus thread run on single-core hosts
+static void bench_wait_cb(lv_disp_drv_t *drv)
+{
+    sched_yield();
+}
+
+static void bench_te_cb(void *user_ctx)
+{
+    if (te) {
+        disp_te_notify_edge(te);
+    }
+}
+
+// Strategy named as in the logs, -1 if unknown
+static int bench_buf_strategy(const char *name)
+{
+    for (int s = DISP_BUF_AUTO; s <= DISP_BUF_PSRAM_BOUNCE; s++) {
+        if (!strcmp(name, disp_buf_strategy_name(s))) {
+            return s;
+        }
+    }
+    return -1;
+}
+
+static void bench_disp_init(void)
+{
+    static lv_disp_draw_buf_t disp_buf;
+    esp_lcd_panel_handle_t panel_handle = NULL;
+    const sim_lcd_config_t sim_config = {
+        .h_res = EXAMPLE_LCD_H_RES,
+        .v_res = EXAMPLE_LCD_V_RES,
+        .bits_per_pixel = LCD_BIT_PER_PIXEL,
+        .trans_overhead_ns = 5000,
+        .on_color_trans_done = example_notify_lvgl_flush_ready,
+        .user_ctx = &disp_drv,
+        .realtime_bus = engine_mode != NULL || te_period_us != 0 || buf_sweep,
+        .te_period_us = te_period_us,
+    };
+    ESP_ERROR_CHECK(sim_lcd_new_panel_sh8601(&sim_config, &panel_handle, &sim));
+    ESP_ERROR_CHECK(esp_lcd_panel_reset(panel_handle));
+    ESP_ERROR_CHECK(esp_lcd_panel_init(panel_handle));
+    ESP_ERROR_CHECK(esp_lcd_panel_disp_on_off(panel_handle, true));
+
+    lv_init();
+    if (use_fb) {
+        lv_color_t *frame = heap_caps_malloc(EXAMPLE_LCD_H_RES * EXAMPLE_LCD_V_RES * sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
+        assert(frame);
+        lv_disp_draw_buf_init(&disp_buf, frame, NULL, EXAMPLE_LCD_H_RES * EXAMPLE_LCD_V_RES);
+    } else if (!buf_strategy) {
+        lv_color_t *buf1 = heap_caps_malloc(EXAMPLE_LCD_H_RES * EXAMPLE_LVGL_BUF_HEIGHT * sizeof(lv_color_t), MALLOC_CAP_DMA);
+        lv_color_t *buf2 = heap_caps_malloc(EXAMPLE_LCD_H_RES * EXAMPLE_LVGL_BUF_HEIGHT * sizeof(lv_color_t), MALLOC_CAP_DMA);
+        assert(buf1 && buf2);
+        lv_disp_draw_buf_init(&disp_buf, buf1, buf2, EXAMPLE_LCD_H_RES * EXAMPLE_LVGL_BUF_HEIGHT);
+    }
+
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = EXAMPLE_LCD_H_RES;
+    disp_drv.ver_res = EXAMPLE_LCD_V_RES;
+    disp_drv.flush_cb = example_lvgl_flush_cb;
+    disp_drv.rounder_cb = example_lvgl_rounder_cb;
+    disp_drv.draw_buf = &disp_buf;
+    disp_drv.user_data = panel_handle;
+    if (engine_mode) {
+        const disp_flush_config_t flush_config = {
+            .panel = panel_handle,
+            .io = sim_lcd_get_io(sim),
+            .serialized = !strcmp(engine_mode, "serialized"),
+            .task_priority = 3,
+            .task_core = tskNO_AFFINITY,
+        };
+        ESP_ERROR_CHECK(disp_flush_new(&flush_config, &engine));
+        ESP_ERROR_CHECK(disp_flush_attach(engine, &disp_drv));
+    } else if (use_fb) {
+        const disp_fb_config_t fb_config = {
+            .panel = panel_handle,
+            .io = sim_lcd_get_io(sim),
+        };
+        disp_drv.direct_mode = 1;
+        ESP_ERROR_CHECK(disp_fb_new(&fb_config, &fb));
+        ESP_ERROR_CHECK(disp_fb_attach(fb, &disp_drv));
+    }
+    if (buf_strategy) {
+        const disp_buf_config_t buf_config = {
+            .panel = panel_handle,
+            .engine = engine,
+            .max_rows = EXAMPLE_LVGL_BUF_HEIGHT,
+            .psram_rows = psram_rows,
+        };
+        ESP_ERROR_CHECK(disp_buf_new(&buf_config, &buf_mgr));
+        ESP_ERROR_CHECK(disp_buf_attach(buf_mgr, &disp_drv, bench_buf_strategy(buf_strategy)));
+    }
+    if (rotation) {
+        const disp_rotate_config_t rotate_config = {
+            .panel = panel_handle,
+            .engine = engine,
+        };
+        ESP_ERROR_CHECK(disp_rotate_new(&rotate_config, &rotate));
+        ESP_ERROR_CHECK(disp_rotate_attach(rotate, &disp_drv));
+    }
+    if (sim_config.realtime_bus && !engine) {
+        disp_drv.wait_cb = bench_wait_cb;
+    }
+    if (render_ns_per_px) {
+        port_flush_cb = disp_drv.flush_cb;
+        disp_drv.flush_cb = bench_flush_cb;
+    }
+    if (trace_path) {
+        const disp_trace_config_t trace_config = {0};
+        ESP_ERROR_CHECK(disp_trace_new(&trace_config, &trace));
+        ESP_ERROR_CHECK(disp_trace_attach(trace, &disp_drv));
+    }
+    lv_disp_t *disp = lv_disp_drv_register(&disp_drv);
+    if (rotation) {
+        lv_disp_set_rotation(disp, rotation / 90);
+    }
+    if (use_regions) {
+        ESP_ERROR_CHECK(disp_region_attach(disp, &region_config));
+    }
+    if (te_period_us) {
+        ESP_ERROR_CHECK(sim_lcd_set_te_cb(sim, bench_te_cb, NULL));
+    }
+    if (te_sync) {
+        const disp_te_config_t te_config = {
+            .source = DISP_TE_SOURCE_EXTERNAL,
+            .period_us = te_period_us,
+        };
+        ESP_ERROR_CHECK(disp_te_new(&te_config, &te));
+        ESP_ERROR_CHECK(disp_te_attach(te, disp));
+    }
+    if (render_ns_per_px) {
+        sw_wait_for_finish = disp_drv.draw_ctx->wait_for_finish;
+        disp_drv.draw_ctx->wait_for_finish = bench_wait_for_finish;
+    }
+}
+
+// One pass of the LVGL task: plan and refresh, bracketed like lv_timer_handler on the watch for the frame trace
+static void bench_pass(void)
+{
+    if (trace) {
+        disp_trace_begin(trace);
+    }
+    // lv_refr_now bypasses the refresh timer the planner is hooked into
+    disp_region_plan(lv_disp_get_default());
+    lv_refr_now(NULL);
+    if (trace) {
+        disp_trace_end(trace);
+    }
+}
+
+// Refresh without measuring, e.g. to settle a screen before the measured change
+static void bench_refresh(void)
+{
+    bench_pass();
+    if (engine) {
+        disp_flush_wait_idle(engine, portMAX_DELAY);
+    }
+    sim_lcd_end_frame(sim, NULL, NULL);
+}
+
+// Run one refresh and print the bus statistics of everything it sent
+static void bench_frame(const char *label)
+{
+    sim_lcd_stats_t st;
+    sim_lcd_end_frame(sim, NULL, NULL);
+    int64_t t0 = esp_timer_get_time();
+    bench_pass();
+    int64_t t1 = esp_timer_get_time();
+    if (engine) {
+        disp_flush_wait_idle(engine, portMAX_DELAY);
+    }
+    sim_lcd_end_frame(sim, &st, NULL);
+    frames_cpu_us += t1 - t0;
+
+    printf("%-5d %-10s %6u %7u %7u %10llu %8.3f %8.3f %5u", frame_no, label, st.ramwr, st.window_switches,
+           st.transactions, (unsigned long long)st.bytes, st.bus_time_ns / 1e6, (t1 - t0) / 1e3, st.protocol_errors);
+    if (engine) {
+        disp_flush_stats_t fs;
+        disp_flush_get_stats(engine, &fs, NULL);
+        printf(" %9.3f %8.3f %8.3f %10.3f", fs.render_us / 1e3, fs.transfer_us / 1e3, fs.wall_us / 1e3,
+               fs.overlap_us / 1e3);
+    }
+    printf("\n");
+
+    if (png_dir) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/frame_%04d_%s.png", png_dir, frame_no, label);
+        if (sim_lcd_dump_png(sim, path) != ESP_OK) {
+            ESP_LOGW(TAG, "cannot write %s", path);
+        }
+    }
+    frame_no++;
+}
+
+static void bench_anim_full(int n)
+{
+    lv_arc_set_value(ui_Arc1, 46 + n % 50);
+    lv_obj_invalidate(ui_Screen1);
+}
+
+static void bench_anim_arcs(int n)
+{
+    lv_arc_set_value(ui_Arc1, 46 + n % 50);
+    lv_arc_set_value(ui_Arc3, 807 + n * 7 % 700);
+    lv_arc_set_value(ui_Arc7, 6841 + n * 91 % 20000);
+}
+
+// Run an animation of `frames` refreshes and print its frame rate, tears and, with --te-sync, TE deadlines
+static void bench_anim(const char *label, int frames, void (*step)(int n))
+{
+    sim_lcd_stats_t st;
+    disp_te_stats_t ts = {0};
+    lv_disp_load_scr(ui_Screen1);
+    bench_refresh();
+    if (te) {
+        disp_te_get_stats(te, &ts, true);
+    }
+    sim_lcd_end_frame(sim, NULL, NULL);
+    const int64_t t0 = esp_timer_get_time();
+    for (int n = 0; n < frames; n++) {
+        step(n);
+        if (te) {
+            while (!disp_te_wait(te, 100)) {
+            }
+            if (trace) {
+                disp_trace_begin(trace);
+            }
+            disp_te_refresh(te);
+            if (trace) {
+                disp_trace_end(trace);
+            }
+        } else {
+            bench_pass();
+        }
+    }
+    if (engine) {
+        disp_flush_wait_idle(engine, portMAX_DELAY);
+    }
+    sim_lcd_end_frame(sim, &st, NULL);
+    const int64_t t1 = esp_timer_get_time();
+    printf("%-10s %6d %7.1f %6u", label, frames, frames * 1e6 / (t1 - t0), st.tears);
+    if (te) {
+        disp_te_get_stats(te, &ts, false);
+        printf(" %6u %6u %6u %8.3f %8.3f", ts.edges, ts.missed, ts.dropped_edges,
+               ts.frames ? ts.start_delay_us / 1e3 / ts.frames : 0.0, ts.max_start_delay_us / 1e3);
+    }
+    printf("\n");
+}
+
+// Redraw every screen with every buffer strategy and print the frame rate next to the RAM it takes
+static void bench_buf_sweep(void)
+{
+    static const disp_buf_strategy_t strategies[] = {DISP_BUF_SRAM_DOUBLE, DISP_BUF_SRAM_SINGLE, DISP_BUF_PSRAM_BOUNCE,
+                                                     DISP_BUF_AUTO};
+    const int frames = 10;
+    printf("\n%-13s %4s %7s %8s", "strategy", "rows", "int_kb", "psram_kb");
+    for (size_t s = 0; s < sizeof(screens) / sizeof(screens[0]); s++) {
+        printf(" %8s", screens[s].name);
+    }
+    printf("\n");
+    for (size_t i = 0; i < sizeof(strategies) / sizeof(strategies[0]); i++) {
+        if (disp_buf_apply(buf_mgr, strategies[i]) != ESP_OK) {
+            continue;
+        }
+        disp_buf_info_t info;
+        disp_buf_get_info(buf_mgr, &info);
+        printf("%-13s %4d %7.1f %8.1f", strategies[i] == DISP_BUF_AUTO ? "auto" : disp_buf_strategy_name(info.strategy),
+               info.rows, info.internal_bytes / 1024.0, info.psram_bytes / 1024.0);
+        for (size_t s = 0; s < sizeof(screens) / sizeof(screens[0]); s++) {
+            lv_disp_load_scr(*screens[s].screen);
+            bench_refresh();
+            const int64_t t0 = esp_timer_get_time();
+            for (int n = 0; n < frames; n++) {
+                lv_obj_invalidate(*screens[s].screen);
+                bench_refresh();
+            }
+            printf(" %8.1f", frames * 1e6 / (esp_timer_get_time() - t0));
+        }
+        printf("\n");
+    }
+}
+
+static void bench_touch_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    data->point = touch_point;
+    data->state = LV_INDEV_STATE_PRESSED;
+}
+
+// Draw a marker at logical points of the rotated screen, then check that it is on the glass where
+// disp_rotate_point says and that a touch there comes back from LVGL, and from disp_rotate_touch_point as the
+// gesture recognizer gets it, at the logical point
+static void bench_rotate_check(void)
+{
+    static lv_indev_drv_t indev_drv;
+    lv_indev_drv_init(&indev_drv);
+    indev_drv.type = LV_INDEV_TYPE_POINTER;
+    indev_drv.read_cb = bench_touch_read_cb;
+    lv_indev_t *indev = lv_indev_drv_register(&indev_drv);
+    lv_timer_pause(indev->driver->read_timer);
+
+    const lv_coord_t hor = lv_disp_get_hor_res(NULL);
+    const lv_coord_t ver = lv_disp_get_ver_res(NULL);
+    // Corners and edges, but clear of the bottom right corner where the performance monitor sits when enabled
+    const lv_point_t points[] = {{10, 20}, {hor - 12, 30}, {40, ver - 10}, {hor - 3, 5},
+                                 {3, ver - 5}, {hor - 3, ver / 2}, {hor / 2, ver / 3}};
+    lv_obj_t *marker = lv_obj_create(lv_layer_top());
+    lv_obj_remove_style_all(marker);
+    lv_obj_set_size(marker, 1, 1);
+    lv_obj_set_style_bg_color(marker, lv_color_make(0xff, 0x00, 0x00), 0);
+    lv_obj_set_style_bg_opa(marker, LV_OPA_COVER, 0);
+    int bad = 0;
+    for (size_t i = 0; i < sizeof(points) / sizeof(points[0]); i++) {
+        lv_obj_set_pos(marker, points[i].x, points[i].y);
+        lv_obj_invalidate(lv_scr_act());
+        bench_refresh();
+        lv_coord_t px, py;
+        disp_rotate_point(&disp_drv, points[i].x, points[i].y, &px, &py);
+        const uint8_t *rgb = sim_lcd_get_frame(sim) + ((size_t)py * EXAMPLE_LCD_H_RES + px) * 3;
+        touch_point.x = px;
+        touch_point.y = py;
+        lv_indev_read_timer_cb(indev->driver->read_timer);
+        lv_point_t back;
+        lv_indev_get_point(indev, &back);
+        lv_coord_t gx, gy;
+        disp_rotate_touch_point(&disp_drv, px, py, &gx, &gy);
+        if (rgb[0] != 0xff || rgb[1] != 0x00 || rgb[2] != 0x00 || back.x != points[i].x || back.y != points[i].y ||
+            gx != points[i].x || gy != points[i].y) {
+            printf("rotate check: logical %d,%d -> panel %d,%d has %02x%02x%02x, touch maps back to %d,%d (%d,%d)\n",
+                   points[i].x, points[i].y, px, py, rgb[0], rgb[1], rgb[2], back.x, back.y, gx, gy);
+            bad++;
+        }
+    }
+    lv_obj_del(marker);
+    lv_indev_delete(indev);
+    printf("rotate check: %d of %zu markers wrong\n", bad, sizeof(points) / sizeof(points[0]));
+    failures += bad;
+}
+
+// Attach the planner a second time, as a reconfiguration would, and refresh through the refresh timer it wraps:
+// the wrapper must still reach LVGL's refresh and plan the areas with the new cost model
+static void bench_region_reattach_check(void)
+{
+    lv_disp_t *disp = lv_disp_get_default();
+    ESP_ERROR_CHECK(disp_region_attach(disp, &region_config));
+    lv_obj_invalidate(lv_scr_act());
+    disp->refr_timer->timer_cb(disp->refr_timer);
+    if (engine) {
+        disp_flush_wait_idle(engine, portMAX_DELAY);
+    }
+    sim_lcd_end_frame(sim, NULL, NULL);
+    disp_region_stats_t rs;
+    disp_region_get_stats(disp, &rs, false);
+    printf("regions reattached: %u frames planned by the refresh timer\n", rs.frames);
+    if (rs.frames != 1 || disp->inv_p != 0) {
+        ESP_LOGE(TAG, "refresh after attaching the planner again: %u frames planned, %u areas left",
+                 rs.frames, disp->inv_p);
+        failures++;
+    }
+}
+
+// Face text from the virtual clock, starting at 17:23 like the watch face
+static void bench_aod_text_cb(char *buf, size_t len, void *user_ctx)
+{
+    const int t = 17 * 60 + 23 + aod_minute;
+    snprintf(buf, len, "%02d:%02d", t / 60 % 24, t % 60);
+}
+
+// Non-black pixels of the frame memory outside rows y1..y2
+static uint32_t bench_lit_outside(int y1, int y2)
+{
+    const uint8_t *frame = sim_lcd_get_frame(sim);
+    uint32_t lit = 0;
+    for (int y = 0; y < EXAMPLE_LCD_V_RES; y++) {
+        if (y >= y1 && y <= y2) {
+            continue;
+        }
+        const uint8_t *row = frame + (size_t)y * EXAMPLE_LCD_H_RES * 3;
+        for (int i = 0; i < EXAMPLE_LCD_H_RES * 3; i++) {
+            lit += row[i] != 0;
+        }
+    }
+    return lit;
+}
+
+// Always-on display: one update per virtual minute, as the LVGL task does in disp_aod_wait
+static void bench_aod(int hours)
+{
+    const size_t frame_bytes = (size_t)EXAMPLE_LCD_H_RES * EXAMPLE_LCD_V_RES * 3;
+    uint8_t *before = malloc(frame_bytes);
+    ESP_ERROR_CHECK(before ? ESP_OK : ESP_ERR_NO_MEM);
+    lv_disp_load_scr(ui_Screen1);
+    lv_obj_invalidate(ui_Screen1);
+    bench_refresh();
+    memcpy(before, sim_lcd_get_frame(sim), frame_bytes);
+    sim_lcd_glass_t normal;
+    sim_lcd_get_glass(sim, &normal);
+
+    const disp_aod_config_t aod_config = {
+        .io = sim_lcd_get_io(sim),
+        .engine = engine,
+        .idle_mode = true,
+        .external_clock = true,
+        .text_cb = bench_aod_text_cb,
+    };
+    disp_aod_handle_t aod;
+    ESP_ERROR_CHECK(disp_aod_new(&aod_config, &aod));
+    if (trace) {
+        ESP_ERROR_CHECK(disp_trace_set_screen_name(trace, disp_aod_get_screen(aod), "AOD"));
+    }
+
+    sim_lcd_stats_t enter, st, sum = {0};
+    ESP_ERROR_CHECK(disp_aod_enter(aod, lv_disp_get_default()));
+    sim_lcd_end_frame(sim, &enter, NULL);
+    sim_lcd_glass_t glass;
+    sim_lcd_get_glass(sim, &glass);
+    if (png_dir) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/aod.png", png_dir);
+        sim_lcd_dump_png(sim, path);
+    }
+    uint32_t outside = 0, lit = 0;
+    disp_aod_stats_t as;
+    disp_aod_get_stats(aod, &as, true);
+    for (int m = 0; m < hours * 60; m++) {
+        aod_minute++;
+        disp_aod_notify_tick(aod);
+        if (disp_aod_wait(aod, 0) != DISP_AOD_EVENT_TICK) {
+            printf("aod: minute %d did not wake the LVGL task\n", m);
+            failures++;
+            continue;
+        }
+        disp_aod_tick(aod);
+        sim_lcd_end_frame(sim, &st, NULL);
+        sum.ramwr += st.ramwr;
+        sum.transactions += st.transactions;
+        sum.bytes += st.bytes;
+        sum.pixels += st.pixels;
+        sum.bus_time_ns += st.bus_time_ns;
+        sum.protocol_errors += st.protocol_errors;
+        outside += bench_lit_outside(glass.partial_rows[0], glass.partial_rows[1]);
+        sim_lcd_glass_t g;
+        sim_lcd_get_glass(sim, &g);
+        lit += g.lit_pixels;
+    }
+    disp_aod_get_stats(aod, &as, false);
+
+    disp_aod_wake(aod);
+    if (disp_aod_wait(aod, 0) != DISP_AOD_EVENT_WAKE) {
+        printf("aod: wake request lost\n");
+        failures++;
+    }
+    ESP_ERROR_CHECK(disp_aod_exit(aod));
+    bench_refresh();
+    sim_lcd_glass_t back;
+    sim_lcd_get_glass(sim, &back);
+    const bool same = memcmp(before, sim_lcd_get_frame(sim), frame_bytes) == 0;
+    free(before);
+
+    printf("\naod: rows %d..%d, idle %d, brightness 0x%02x; entry %u areas, %llu bytes, %.3f ms bus\n",
+           glass.partial_rows[0], glass.partial_rows[1], glass.idle, glass.brightness, enter.ramwr,
+           (unsigned long long)enter.bytes, enter.bus_time_ns / 1e6);
+    printf("aod: per hour %.0f wakeups, %.0f renders, %.0f areas, %.0f transactions, %.0f bytes, %.3f ms bus, "
+           "%.3f ms cpu (max %.3f ms per update, duty %.5f%%)\n",
+           (double)as.wakeups / hours, (double)as.renders / hours, (double)sum.ramwr / hours,
+           (double)sum.transactions / hours, (double)sum.bytes / hours, sum.bus_time_ns / 1e6 / hours,
+           as.busy_us / 1e3 / hours, as.max_busy_us / 1e3, 100.0 * as.busy_us / (hours * 3600e6));
+    printf("aod: lit pixels %u in normal mode, %.0f in AOD (%.2f%%), %u lit outside the partial area; "
+           "after exit normal mode %d, face %s\n",
+           normal.lit_pixels, (double)lit / (hours * 60), 100.0 * lit / (hours * 60) / normal.lit_pixels, outside,
+           !back.partial && !back.idle && back.brightness == 0xff, same ? "restored" : "differs");
+    if (outside || !same || back.partial || back.idle || as.renders != (uint32_t)hours * 60) {
+        failures++;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int frames = 1;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--png") && i + 1 < argc) {
+            png_dir = argv[++i];
+        } else if (!strcmp(argv[i], "--engine") && i + 1 < argc &&
+                   (!strcmp(argv[i + 1], "serialized") || !strcmp(argv[i + 1], "pipelined"))) {
+            engine_mode = argv[++i];
+        } else if (!strcmp(argv[i], "--regions")) {
+            use_regions = true;
+        } else if (!strcmp(argv[i], "--area-cost-ns") && i + 1 < argc) {
+            region_config.area_cost_ns = strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--pixel-cost-ns") && i + 1 < argc) {
+            region_config.pixel_cost_ns = strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--te") && i + 1 < argc) {
+            te_period_us = strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--te-sync")) {
+            te_sync = true;
+        } else if (!strcmp(argv[i], "--fb")) {
+            use_fb = true;
+        } else if (!strcmp(argv[i], "--rotate") && i + 1 < argc &&
+                   (!strcmp(argv[i + 1], "90") || !strcmp(argv[i + 1], "180") || !strcmp(argv[i + 1], "270"))) {
+            rotation = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--buf") && i + 1 < argc) {
+            buf_strategy = argv[++i];
+        } else if (!strcmp(argv[i], "--buf-sweep")) {
+            buf_sweep = true;
+        } else if (!strcmp(argv[i], "--internal-kb") && i + 1 < argc) {
+            internal_kb = strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (!strcmp(argv[i], "--psram-rows") && i + 1 < argc) {
+            psram_rows = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--psram-ns-per-px") && i + 1 < argc) {
+            psram_ns_per_px = strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--aod") && i + 1 < argc) {
+            aod_hours = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--render-ns-per-px") && i + 1 < argc) {
+            render_ns_per_px = strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr, "usage: %s [--frames N] [--png DIR] [--engine serialized|pipelined] [--render-ns-per-px N]\n"
+                    "       [--regions [--area-cost-ns N] [--pixel-cost-ns N]] [--fb] [--te US [--te-sync]]\n"
+                    "       [--rotate 90|180|270] [--buf STRATEGY | --buf-sweep] [--internal-kb N]\n"
+                    "       [--psram-rows N] [--psram-ns-per-px N] [--trace FILE] [--aod HOURS]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (use_fb && engine_mode) {
+        fprintf(stderr, "--fb and --engine are exclusive\n");
+        return 1;
+    }
+    if (use_fb && rotation) {
+        fprintf(stderr, "--fb and --rotate are exclusive\n");
+        return 1;
+    }
+    if (use_fb && (buf_strategy || buf_sweep)) {
+        fprintf(stderr, "--fb and --buf are exclusive\n");
+        return 1;
+    }
+    if (buf_strategy && bench_buf_strategy(buf_strategy) < 0) {
+        fprintf(stderr, "--buf takes auto, sram-double, sram-single or psram-bounce\n");
+        return 1;
+    }
+    if (buf_sweep && !buf_strategy) {
+        buf_strategy = "auto";
+    }
+    if (internal_kb) {
+        heap_caps_sim_set_total_size(MALLOC_CAP_INTERNAL, internal_kb * 1024);
+    }
+    if (te_sync && !te_period_us) {
+        fprintf(stderr, "--te-sync needs --te\n");
+        return 1;
+    }
+
+    bench_disp_init();
+    ui_init();
+    // Every screen is drawn, build them all now so the build cost stays out of the frames
+    for (size_t s = 0; s < sizeof(screens) / sizeof(screens[0]); s++) {
+        _ui_screen_build(screens[s].screen, screens[s].init);
+        if (trace) {
+            ESP_ERROR_CHECK(disp_trace_set_screen_name(trace, *screens[s].screen, screens[s].name));
+        }
+    }
+
+    printf("%-5s %-10s %6s %7s %7s %10s %8s %8s %5s", "frame", "scene", "areas", "windows", "trans",
+           "bytes", "bus_ms", "cpu_ms", "errs");
+    if (engine) {
+        printf(" %9s %8s %8s %10s", "render_ms", "xfer_ms", "wall_ms", "overlap_ms");
+    }
+    printf("\n");
+    for (int n = 0; n < frames; n++) {
+        // Full redraw of every screen
+        for (size_t s = 0; s < sizeof(screens) / sizeof(screens[0]); s++) {
+            lv_disp_load_scr(*screens[s].screen);
+            lv_obj_invalidate(*screens[s].screen);
+            bench_frame(screens[s].name);
+        }
+        // The most common frame on the watch: the clock label changes
+        lv_disp_load_scr(ui_Screen1);
+        bench_refresh();
+        lv_label_set_text_fmt(ui_Label10, "17:%02d", (24 + n) % 60);
+        bench_frame("clock");
+        // The three activity arcs move together
+        lv_arc_set_value(ui_Arc1, 46 + n % 50);
+        lv_arc_set_value(ui_Arc3, 807 + n * 7 % 700);
+        lv_arc_set_value(ui_Arc7, 6841 + n * 91 % 20000);
+        bench_frame("arcs");
+    }
+
+    if (te_period_us) {
+        printf("\n%-10s %6s %7s %6s", "anim", "frames", "fps", "tears");
+        if (te) {
+            printf(" %6s %6s %6s %8s %8s", "edges", "missed", "drop", "delay_ms", "max_ms");
+        }
+        printf("\n");
+        bench_anim("full", 60, bench_anim_full);
+        bench_anim("arcs", 60, bench_anim_arcs);
+    }
+
+    if (buf_sweep) {
+        bench_buf_sweep();
+    }
+    if (aod_hours > 0) {
+        bench_aod(aod_hours);
+    }
+    if (rotate) {
+        disp_rotate_stats_t rt;
+        disp_rotate_get_stats(rotate, &rt, false);
+        printf("rotate %d: %u areas, %u bands, %llu px, rotate %.3f ms (%.1f%% of frame cpu time, %.2f ns/px), send %.3f ms\n",
+               rotation, rt.areas, rt.bands, (unsigned long long)rt.pixels, rt.rotate_us / 1e3,
+               frames_cpu_us ? 100.0 * rt.rotate_us / frames_cpu_us : 0.0, rt.pixels ? rt.rotate_us * 1e3 / rt.pixels : 0.0,
+               rt.send_us / 1e3);
+        bench_rotate_check();
+    }
+
+    if (trace) {
+        FILE *f = fopen(trace_path, "w");
+        if (f == NULL || disp_trace_dump(trace, disp_trace_write_file, f) != ESP_OK) {
+            ESP_LOGE(TAG, "cannot write %s", trace_path);
+            failures++;
+        }
+        if (f) {
+            fclose(f);
+        }
+        disp_trace_stats_t ts;
+        disp_trace_get_stats(trace, &ts);
+        printf("trace: %u frames recorded, %u dumped to %s, %u lost\n", ts.recorded, ts.dumped, trace_path, ts.lost);
+    }
+
+    sim_lcd_stats_t total;
+    sim_lcd_end_frame(sim, NULL, &total);
+    if (use_regions) {
+        disp_region_stats_t rs;
+        disp_region_get_stats(lv_disp_get_default(), &rs, false);
+        printf("regions: %u -> %u areas (%u merged, %u split), %llu -> %llu px, %u transactions saved\n", rs.areas_in,
+               rs.areas_out, rs.merges, rs.splits, (unsigned long long)rs.px_in, (unsigned long long)rs.px_out,
+               rs.trans_saved);
+        bench_region_reattach_check();
+    }
+    if (fb) {
+        disp_fb_stats_t bt;
+        disp_fb_get_stats(fb, &bt, false);
+        printf("fb: %u frames, %llu px redrawn, %llu px changed, %llu px sent in %u windows, hash %.3f ms, send %.3f ms\n",
+               bt.frames, (unsigned long long)bt.px_rendered, (unsigned long long)bt.px_changed,
+               (unsigned long long)bt.px_sent, bt.rects, bt.hash_us / 1e3, bt.send_us / 1e3);
+    }
+    if (engine) {
+        disp_flush_stats_t ft;
+        disp_flush_get_stats(engine, NULL, &ft);
+        printf("%s: %u frames, render %.3f ms, transfer %.3f ms, wall %.3f ms, overlap %.3f ms (%.1f%% of transfer)\n",
+               engine_mode, ft.frames, ft.render_us / 1e3, ft.transfer_us / 1e3, ft.wall_us / 1e3, ft.overlap_us / 1e3,
+               ft.transfer_us ? 100.0 * ft.overlap_us / ft.transfer_us : 0.0);
+    }
+    printf("total: %llu bytes, %u transactions, %u window switches, %.3f ms bus, %u protocol errors, %u tears\n",
+           (unsigned long long)total.bytes, total.transactions, total.window_switches, total.bus_time_ns / 1e6,
+           total.protocol_errors, total.tears);
+    return total.protocol_errors || failures ? 2 : 0;
+}
@@ -0,0 +1,424 @@
+/*
+ * Font subset and glyph cache benchmark: the SquareLine screens drawn with the Montserrat fonts cut down by
+ * tools/font_subset.py, as the firmware builds them with UI_FONT_SUBSET, through the disp_glyph cache.
+ *
+ *   font_bench [--rounds N] [--budget N]
+ *
+ * Every glyph of the cut-down fonts must be the glyph of the full font: same metrics, same bitmap, same kerning
+ * against every other kept glyph, and every character the screens draw must be in its font: label texts, the
+ * day names and numbers of the calendar, the month names of its header in every month, its arrow symbols and the
+ * chart tick values. The
+ * bench prints the constant data of each font, full and cut down. It then draws every screen 10 times without
+ * the cache, which gives the reference frames, with it, and with a --budget byte cache (default 256) small enough
+ * to evict, printing the average frame time; every frame must match. Last, it sets the clock label of the watch face to a new time --rounds times (default
+ * 5000) and prints the time spent drawing the label, from its draw begin to its draw end event, and the whole
+ * refresh, without and with the cache, the best of 5 runs each.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lvgl.h"
+#include "draw/sw/lv_draw_sw.h"
+#include "ui.h"
+
+#include "disp_glyph.h"
+
+#define BENCH_H_RES             368
+#define BENCH_V_RES             448
+// Code points searched for glyphs, the Montserrat fonts stop at the symbols of the private use area
+#define BENCH_MAX_LETTER        0xFFFF
+// Frames drawn per screen and walk
+#define BENCH_WALK_FRAMES       10
+// Runs of the clock redraws per setting, the fastest one is printed
+#define BENCH_CLOCK_RUNS        5
+
+static const char *TAG = "font_bench";
+
+// Generated by tools/font_subset.py, the screens of ui_subset use them under the names of the full fonts
+extern const lv_font_t ui_font_montserrat_12;
+extern const lv_font_t ui_font_montserrat_14;
+extern const lv_font_t ui_font_montserrat_16;
+
+static const struct {
+    const char *name;
+    const lv_font_t *full;
+    const lv_font_t *subset;
+} fonts[] = {
+    {"montserrat_12", &lv_font_montserrat_12, &ui_font_montserrat_12},
+    {"montserrat_14", &lv_font_montserrat_14, &ui_font_montserrat_14},
+    {"montserrat_16", &lv_font_montserrat_16, &ui_font_montserrat_16},
+};
+#define BENCH_FONTS (sizeof(fonts) / sizeof(fonts[0]))
+
+typedef struct {
+    const char *name;
+    lv_obj_t **scr;
+    void (*init)(void);
+} bench_screen_t;
+
+static const bench_screen_t screens[] = {
+    {"Screen1", &ui_Screen1, ui_Screen1_screen_init},
+    {"Screen2", &ui_Screen2, ui_Screen2_screen_init},
+    {"Screen3", &ui_Screen3, ui_Screen3_screen_init},
+    {"Screen4", &ui_Screen4, ui_Screen4_screen_init},
+    {"Screen5", &ui_Screen5, ui_Screen5_screen_init},
+    {"Screen6", &ui_Screen6, ui_Screen6_screen_init},
+};
+#define BENCH_SCREENS (sizeof(screens) / sizeof(screens[0]))
+
+static lv_color_t frame[BENCH_H_RES * BENCH_V_RES];
+static lv_color_t ref[BENCH_SCREENS][BENCH_H_RES * BENCH_V_RES];
+static int64_t label_t0;
+static uint64_t label_us;
+
+static void bench_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    const int32_t w = lv_area_get_width(area);
+    for (int32_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&frame[y * BENCH_H_RES + area->x1], color_map, w * sizeof(lv_color_t));
+        color_map += w;
+    }
+    lv_disp_flush_ready(drv);
+}
+
+static void bench_label_draw_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) == LV_EVENT_DRAW_MAIN_BEGIN) {
+        label_t0 = esp_timer_get_time();
+    } else {
+        label_us += esp_timer_get_time() - label_t0;
+    }
+}
+
+static uint32_t bench_glyph_count(const lv_font_fmt_txt_dsc_t *dsc)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < dsc->cmap_num; i++) {
+        const lv_font_fmt_txt_cmap_t *cmap = &dsc->cmaps[i];
+        const uint32_t end = cmap->glyph_id_start + (cmap->type == LV_FONT_FMT_TXT_CMAP_FORMAT0_TINY ||
+                                                     cmap->type == LV_FONT_FMT_TXT_CMAP_FORMAT0_FULL ?
+                                                     cmap->range_length : cmap->list_length);
+        count = end > count ? end : count;
+    }
+    return count;
+}
+
+// Constant data of a font from lv_font_conv, as its C file lays it out
+static size_t bench_font_bytes(const lv_font_t *font)
+{
+    const lv_font_fmt_txt_dsc_t *dsc = font->dsc;
+    const uint32_t glyphs = bench_glyph_count(dsc);
+    size_t bitmap = 0;
+    for (uint32_t id = 1; id < glyphs; id++) {
+        const lv_font_fmt_txt_glyph_dsc_t *g = &dsc->glyph_dsc[id];
+        const size_t end = g->bitmap_index + (g->box_w * g->box_h * dsc->bpp + 7) / 8;
+        bitmap = end > bitmap ? end : bitmap;
+    }
+    size_t bytes = bitmap + glyphs * sizeof(lv_font_fmt_txt_glyph_dsc_t) + dsc->cmap_num * sizeof(lv_font_fmt_txt_cmap_t);
+    for (uint32_t i = 0; i < dsc->cmap_num; i++) {
+        bytes += dsc->cmaps[i].unicode_list ? dsc->cmaps[i].list_length * sizeof(uint16_t) : 0;
+    }
+    if (dsc->kern_dsc && dsc->kern_classes) {
+        const lv_font_fmt_txt_kern_classes_t *kern = dsc->kern_dsc;
+        bytes += 2 * glyphs + kern->left_class_cnt * kern->right_class_cnt;
+    }
+    return bytes;
+}
+
+// Every glyph of `subset` against `full`; returns the mismatches
+static int bench_check_glyphs(const char *name, const lv_font_t *full, const lv_font_t *subset, uint32_t *kept)
+{
+    static uint32_t letters[BENCH_MAX_LETTER + 1];
+    uint32_t count = 0;
+    int mismatches = 0;
+    // Below the space only the tab, drawn as spaces
+    for (uint32_t letter = 0x20; letter <= BENCH_MAX_LETTER; letter++) {
+        lv_font_glyph_dsc_t s;
+        lv_font_glyph_dsc_t f;
+        if (!lv_font_get_glyph_dsc(subset, &s, letter, 0)) {
+            continue;
+        }
+        letters[count++] = letter;
+        if (!lv_font_get_glyph_dsc(full, &f, letter, 0) || s.adv_w != f.adv_w || s.box_w != f.box_w ||
+            s.box_h != f.box_h || s.ofs_x != f.ofs_x || s.ofs_y != f.ofs_y || s.bpp != f.bpp) {
+            ESP_LOGE(TAG, "%s: glyph of U+%04X differs", name, (unsigned)letter);
+            mismatches++;
+            continue;
+        }
+        const size_t size = (s.box_w * s.box_h * s.bpp + 7) / 8;
+        const uint8_t *sb = lv_font_get_glyph_bitmap(subset, letter);
+        const uint8_t *fb = lv_font_get_glyph_bitmap(full, letter);
+        if (size && (!sb || !fb || memcmp(sb, fb, size))) {
+            ESP_LOGE(TAG, "%s: bitmap of U+%04X differs", name, (unsigned)letter);
+            mismatches++;
+        }
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        for (uint32_t j = 0; j < count; j++) {
+            lv_font_glyph_dsc_t s;
+            lv_font_glyph_dsc_t f;
+            lv_font_get_glyph_dsc(subset, &s, letters[i], letters[j]);
+            lv_font_get_glyph_dsc(full, &f, letters[i], letters[j]);
+            if (s.adv_w != f.adv_w) {
+                ESP_LOGE(TAG, "%s: kerning of U+%04X U+%04X differs", name, (unsigned)letters[i],
+                         (unsigned)letters[j]);
+                mismatches++;
+            }
+        }
+    }
+    *kept = count;
+    return mismatches;
+}
+
+// Every character of `text` must be in `font`; returns the missing ones
+static int bench_check_text(const char *screen, const lv_font_t *font, const char *text)
+{
+    // Widgets left to the theme use LVGL's default font, which here is the full one; on the watch it is cut down
+    for (size_t f = 0; f < BENCH_FONTS; f++) {
+        if (font == fonts[f].full) {
+            font = fonts[f].subset;
+        }
+    }
+    int missing = 0;
+    uint32_t i = 0;
+    while (text[i]) {
+        const uint32_t letter = _lv_txt_encoded_next(text, &i);
+        lv_font_glyph_dsc_t g;
+        if (letter >= 0x20 && !lv_font_get_glyph_dsc(font, &g, letter, 0)) {
+            ESP_LOGE(TAG, "%s: no glyph for U+%04X of \"%s\"", screen, (unsigned)letter, text);
+            missing++;
+        }
+    }
+    return missing;
+}
+
+static int bench_check_children(const char *screen, lv_obj_t *obj);
+
+// Every character the objects under `obj` draw must be in their font: label texts, button matrix texts (the days
+// of a calendar), symbols drawn as background images (the arrows of a calendar header) and chart tick values;
+// returns the missing ones
+static int bench_check_labels(const char *screen, lv_obj_t *obj)
+{
+    int missing = 0;
+    if (lv_obj_check_type(obj, &lv_label_class)) {
+        missing += bench_check_text(screen, lv_obj_get_style_text_font(obj, LV_PART_MAIN), lv_label_get_text(obj));
+    }
+    if (lv_obj_check_type(obj, &lv_btnmatrix_class)) {
+        const lv_font_t *font = lv_obj_get_style_text_font(obj, LV_PART_ITEMS);
+        for (const char **map = lv_btnmatrix_get_map(obj); map && **map; map++) {
+            missing += bench_check_text(screen, font, *map);
+        }
+    }
+    if (lv_obj_check_type(obj, &lv_chart_class)) {
+        missing += bench_check_text(screen, lv_obj_get_style_text_font(obj, LV_PART_TICKS), "-0123456789");
+    }
+    const void *img = lv_obj_get_style_bg_img_src(obj, LV_PART_MAIN);
+    if (img && lv_img_src_get_type(img) == LV_IMG_SRC_SYMBOL) {
+        missing += bench_check_text(screen, lv_obj_get_style_text_font(obj, LV_PART_MAIN), img);
+    }
+    if (lv_obj_check_type(obj, &lv_calendar_class)) {
+        // The header shows the other months once its arrows are pressed
+        const lv_calendar_date_t shown = *lv_calendar_get_showed_date(obj);
+        for (int month = 1; month <= 12; month++) {
+            lv_calendar_set_showed_date(obj, shown.year, month);
+            missing += bench_check_children(screen, obj);
+        }
+        lv_calendar_set_showed_date(obj, shown.year, shown.month);
+        return missing;
+    }
+    return missing + bench_check_children(screen, obj);
+}
+
+static int bench_check_children(const char *screen, lv_obj_t *obj)
+{
+    int missing = 0;
+    for (uint32_t i = 0; i < lv_obj_get_child_cnt(obj); i++) {
+        missing += bench_check_labels(screen, lv_obj_get_child(obj, i));
+    }
+    return missing;
+}
+
+// Draw every screen, recording the frames or comparing against them; returns the frames that differ
+static int bench_walk(bool record, uint64_t *frame_us)
+{
+    int mismatches = 0;
+    *frame_us = 0;
+    for (size_t s = 0; s < BENCH_SCREENS; s++) {
+        lv_disp_load_scr(*screens[s].scr);
+        for (int f = 0; f < BENCH_WALK_FRAMES; f++) {
+            lv_obj_invalidate(*screens[s].scr);
+            const int64_t t = esp_timer_get_time();
+            lv_refr_now(NULL);
+            *frame_us += esp_timer_get_time() - t;
+            if (record) {
+                memcpy(ref[s], frame, sizeof(frame));
+            } else if (memcmp(ref[s], frame, sizeof(frame))) {
+                ESP_LOGE(TAG, "%s: frame differs from the one drawn without the cache", screens[s].name);
+                mismatches++;
+            }
+        }
+    }
+    return mismatches;
+}
+
+// Set the clock label to a new time `rounds` times
+static void bench_clock(int rounds, uint64_t *refr_us)
+{
+    lv_disp_load_scr(ui_Screen1);
+    lv_refr_now(NULL);
+    label_us = 0;
+    *refr_us = 0;
+    for (int r = 0; r < rounds; r++) {
+        lv_label_set_text_fmt(ui_Label10, "%02d:%02d", (r / 60) % 24, r % 60);
+        const int64_t t = esp_timer_get_time();
+        lv_refr_now(NULL);
+        *refr_us += esp_timer_get_time() - t;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = 5000;
+    size_t budget = 256;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--rounds") && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--budget") && i + 1 < argc) {
+            budget = (size_t)atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--rounds N] [--budget N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (rounds < 1) {
+        rounds = 1;
+    }
+    if (budget < 1) {
+        budget = 1;
+    }
+
+    lv_init();
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf1[BENCH_H_RES * BENCH_V_RES];
+    lv_disp_draw_buf_init(&draw_buf, buf1, NULL, BENCH_H_RES * BENCH_V_RES);
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = BENCH_H_RES;
+    disp_drv.ver_res = BENCH_V_RES;
+    disp_drv.flush_cb = bench_flush_cb;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_t *disp = lv_disp_drv_register(&disp_drv);
+
+    int failures = 0;
+    printf("%-14s %7s %7s %9s %9s %6s\n", "font", "glyphs", "kept", "full_B", "subset_B", "saved");
+    size_t full_total = 0;
+    size_t subset_total = 0;
+    for (size_t i = 0; i < BENCH_FONTS; i++) {
+        uint32_t kept = 0;
+        failures += bench_check_glyphs(fonts[i].name, fonts[i].full, fonts[i].subset, &kept) ? 1 : 0;
+        const size_t full = bench_font_bytes(fonts[i].full);
+        const size_t subset = bench_font_bytes(fonts[i].subset);
+        full_total += full;
+        subset_total += subset;
+        printf("%-14s %7u %7u %9u %9u %5.1f%%\n", fonts[i].name,
+               (unsigned)bench_glyph_count(fonts[i].full->dsc) - 1, (unsigned)kept, (unsigned)full, (unsigned)subset,
+               100.0 * (full - subset) / full);
+    }
+    printf("%-14s %7s %7s %9u %9u %5.1f%%\n", "all", "", "", (unsigned)full_total, (unsigned)subset_total,
+           100.0 * (full_total - subset_total) / full_total);
+
+    ui_init();
+    for (size_t s = 0; s < BENCH_SCREENS; s++) {
+        _ui_screen_build(screens[s].scr, screens[s].init);
+        failures += bench_check_labels(screens[s].name, *screens[s].scr) ? 1 : 0;
+    }
+
+    disp_glyph_handle_t glyph = NULL;
+    const disp_glyph_config_t config = {0};
+    ESP_ERROR_CHECK(disp_glyph_new(&config, &glyph));
+    ESP_ERROR_CHECK(disp_glyph_attach(glyph, disp));
+    disp_glyph_stats_t st;
+    uint64_t frame_us;
+
+    // The first walk lays the screens out too, the second is timed
+    disp_glyph_set_enabled(glyph, false);
+    bench_walk(true, &frame_us);
+    failures += bench_walk(false, &frame_us) ? 1 : 0;
+    printf("%-12s %7s %7s %7s %9s %6s %8s %9s\n", "walk", "letters", "hits", "misses", "fallbacks", "evict",
+           "cached_B", "frame_us");
+    printf("%-12s %7s %7s %7s %9s %6s %8s %9llu\n", "no cache", "", "", "", "", "", "",
+           (unsigned long long)(frame_us / (BENCH_SCREENS * BENCH_WALK_FRAMES)));
+    disp_glyph_set_enabled(glyph, true);
+    for (int pass = 0; pass < 2; pass++) {
+        failures += bench_walk(false, &frame_us) ? 1 : 0;
+        disp_glyph_get_stats(glyph, &st, true);
+        printf("%-12s %7u %7u %7u %9u %6u %8u %9llu\n", pass ? "cache" : "cache, cold", st.letters, st.hits,
+               st.misses, st.fallbacks, st.evictions, (unsigned)st.cached_bytes,
+               (unsigned long long)(frame_us / (BENCH_SCREENS * BENCH_WALK_FRAMES)));
+    }
+    if (st.misses || st.evictions || st.fallbacks) {
+        ESP_LOGE(TAG, "warm walk: %u misses, %u evictions, %u drawn by LVGL", st.misses, st.evictions,
+                 st.fallbacks);
+        failures++;
+    }
+    disp_glyph_del(glyph);
+
+    // A cache too small for the screens evicts, and must still draw the same
+    const disp_glyph_config_t small = {.cache_bytes = budget};
+    ESP_ERROR_CHECK(disp_glyph_new(&small, &glyph));
+    ESP_ERROR_CHECK(disp_glyph_attach(glyph, disp));
+    for (int pass = 0; pass < 2; pass++) {
+        failures += bench_walk(false, &frame_us) ? 1 : 0;
+    }
+    disp_glyph_get_stats(glyph, &st, true);
+    char name[16];
+    snprintf(name, sizeof(name), "%u B", (unsigned)budget);
+    printf("%-12s %7u %7u %7u %9u %6u %8u %9llu\n", name, st.letters, st.hits, st.misses, st.fallbacks,
+           st.evictions, (unsigned)st.cached_bytes, (unsigned long long)(frame_us / (BENCH_SCREENS * BENCH_WALK_FRAMES)));
+    if (st.cached_bytes > budget) {
+        ESP_LOGE(TAG, "%u bytes cached in a %u byte budget", (unsigned)st.cached_bytes, (unsigned)budget);
+        failures++;
+    }
+    disp_glyph_del(glyph);
+    if (disp->driver->draw_ctx->draw_letter != lv_draw_sw_letter) {
+        ESP_LOGE(TAG, "letters not given back to LVGL");
+        failures++;
+    }
+
+    ESP_ERROR_CHECK(disp_glyph_new(&config, &glyph));
+    ESP_ERROR_CHECK(disp_glyph_attach(glyph, disp));
+    label_us = 0;
+    lv_obj_add_event_cb(ui_Label10, bench_label_draw_cb, LV_EVENT_DRAW_MAIN_BEGIN, NULL);
+    lv_obj_add_event_cb(ui_Label10, bench_label_draw_cb, LV_EVENT_DRAW_MAIN_END, NULL);
+    printf("%-12s %9s %9s  (clock label, best of %d runs of %d redraws)\n", "clock", "label_us", "refr_us",
+           BENCH_CLOCK_RUNS, rounds);
+    // Runs with and without the cache take turns, so both see the same load of the host
+    uint64_t best_label[2] = {UINT64_MAX, UINT64_MAX};
+    uint64_t best_refr[2] = {UINT64_MAX, UINT64_MAX};
+    for (int run = 0; run < BENCH_CLOCK_RUNS; run++) {
+        for (int on = 0; on < 2; on++) {
+            uint64_t refr_us;
+            disp_glyph_set_enabled(glyph, on);
+            bench_clock(rounds, &refr_us);
+            best_label[on] = label_us < best_label[on] ? label_us : best_label[on];
+            best_refr[on] = refr_us < best_refr[on] ? refr_us : best_refr[on];
+        }
+    }
+    for (int on = 0; on < 2; on++) {
+        printf("%-12s %9.2f %9.2f\n", on ? "cache" : "no cache", (double)best_label[on] / rounds,
+               (double)best_refr[on] / rounds);
+    }
+    printf("%-12s %8.2fx\n", "speedup", (double)best_label[0] / best_label[1]);
+    disp_glyph_get_stats(glyph, &st, true);
+    if (st.fallbacks) {
+        ESP_LOGE(TAG, "clock: %u letters drawn by LVGL", st.fallbacks);
+        failures++;
+    }
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,356 @@
+/*
+ * Gesture benchmark: scripted finger traces on the watch face (Screen1) of ui.c, recognized once by LVGL's
+ * gesture detection, which raises LV_EVENT_GESTURE after LV_INDEV_DEF_GESTURE_LIMIT (50 px) of travel summed over
+ * reads that each moved at least LV_INDEV_DEF_GESTURE_MIN_VELOCITY (3 px), and once by disp_gesture, which fits
+ * the velocity to the samples, locks the direction after 12 px and drags the snapshot transition with the finger.
+ *
+ *   gesture_bench [--cpu-scale N] [--bus-ns-per-byte N] [--sample-ms N]
+ *
+ * The traces are sampled every --sample-ms (default 12, the FT5x06 active scan period) and handed to LVGL the way
+ * disp_touch does: each sample once it is due, the last one again on the reads in between. LVGL reads every
+ * CONFIG_LV_INDEV_DEF_READ_PERIOD (4 ms) as in main.c; the "lvgl/scan" mode reads once per sample instead, the
+ * best case for LVGL's detection, whose sum starts over on every read that did not move. Rendering and the bus
+ * are charged as by trans_bench (--cpu-scale default 10, --bus-ns-per-byte default 50). For every trace and mode
+ * it prints the time from the first sample that moved to the end of the first flushed frame that moved
+ * (transition progress above zero, or another screen), the same from touch down, from the first move to the end
+ * of the screen change, and the screen shown at the end. With disp_gesture every trace must end on its screen.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lvgl.h"
+#include "ui.h"
+
+#include "disp_gesture.h"
+#include "disp_trans.h"
+
+#define BENCH_H_RES             368
+#define BENCH_V_RES             448
+#define BENCH_BUF_ROWS          (BENCH_V_RES / 4)
+// Most key points of a trace
+#define BENCH_TRACE_POINTS      4
+// Idle time before a trace and longest run after its release
+#define BENCH_LEAD_MS           20
+#define BENCH_TAIL_MS           1000
+
+static const char *TAG = "gesture_bench";
+
+typedef struct {
+    uint16_t t_ms;              // since touch down
+    lv_coord_t x;
+    lv_coord_t y;
+} bench_point_t;
+
+typedef struct {
+    const char *name;
+    bench_point_t points[BENCH_TRACE_POINTS];   // finger moves straight between them, lifts at the last one
+    size_t count;
+    lv_obj_t **expect;          // screen shown at the end with disp_gesture
+} bench_trace_t;
+
+static const bench_trace_t traces[] = {
+    {"flick left", {{0, 300, 224}, {60, 120, 224}}, 2, &ui_Screen2},
+    {"swipe left", {{0, 300, 224}, {250, 80, 224}}, 2, &ui_Screen2},
+    {"slow drag left", {{0, 330, 224}, {600, 100, 224}, {700, 100, 224}}, 3, &ui_Screen2},
+    {"swipe right", {{0, 60, 224}, {250, 280, 224}}, 2, &ui_Screen3},
+    {"swipe down", {{0, 184, 80}, {250, 184, 300}}, 2, &ui_Screen4},
+    {"swipe up", {{0, 184, 380}, {250, 184, 150}}, 2, &ui_Screen5},
+    {"drag and back", {{0, 300, 224}, {300, 150, 224}, {600, 290, 224}, {650, 290, 224}}, 4, &ui_Screen1},
+    {"tap", {{0, 184, 224}, {80, 184, 224}}, 2, &ui_Screen1},
+};
+#define BENCH_TRACES (sizeof(traces) / sizeof(traces[0]))
+
+typedef enum {
+    BENCH_LVGL,                 // LVGL gestures, read every LV_INDEV_DEF_READ_PERIOD
+    BENCH_LVGL_SCAN,            // LVGL gestures, one read per sample
+    BENCH_ENGINE,               // disp_gesture
+    BENCH_MODES,
+} bench_mode_t;
+
+static const char *const mode_names[BENCH_MODES] = {"lvgl", "lvgl/scan", "engine"};
+
+static const struct {
+    const char *name;
+    lv_obj_t **scr;
+} screen_names[] = {
+    {"Screen1", &ui_Screen1}, {"Screen2", &ui_Screen2}, {"Screen3", &ui_Screen3},
+    {"Screen4", &ui_Screen4}, {"Screen5", &ui_Screen5}, {"Screen6", &ui_Screen6},
+};
+
+typedef struct {
+    int64_t move_to_frame_us;   // -1 when nothing moved
+    int64_t down_to_frame_us;
+    int64_t move_to_done_us;    // -1 when the screen did not change
+    lv_obj_t *scr;
+} bench_result_t;
+
+static uint32_t bus_ns_per_byte = 50;
+static uint32_t cpu_scale = 10;
+static uint32_t sample_ms = 12;
+static uint64_t flush_bytes;
+
+static disp_trans_handle_t trans;
+static disp_gesture_handle_t gesture;
+static bench_mode_t mode;
+
+// Trace being played
+static const bench_trace_t *trace;
+static int64_t trace_t0;        // touch down
+static uint32_t next_sample;    // index of the next sample to hand over
+static uint32_t release_sample; // index of the lift sample
+static bool shown_pressed;
+static lv_coord_t shown_x, shown_y;
+static bool frame_moved;        // the frame just rendered moved
+
+static void bench_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    flush_bytes += lv_area_get_size(area) * sizeof(lv_color_t);
+    lv_disp_flush_ready(drv);
+}
+
+static bool bench_moved(void)
+{
+    if (disp_trans_is_running(trans)) {
+        return disp_trans_get_progress(trans) > 0;
+    }
+    return lv_scr_act() != ui_Screen1;
+}
+
+static void bench_monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    frame_moved = bench_moved();
+}
+
+// Where the finger is `t_ms` after touch down
+static void bench_trace_point(const bench_trace_t *tr, uint32_t t_ms, lv_coord_t *x, lv_coord_t *y)
+{
+    for (size_t i = 1; i < tr->count; i++) {
+        const bench_point_t *a = &tr->points[i - 1], *b = &tr->points[i];
+        if (t_ms <= b->t_ms) {
+            const int32_t span = b->t_ms - a->t_ms;
+            *x = a->x + (span ? (b->x - a->x) * (int32_t)(t_ms - a->t_ms) / span : 0);
+            *y = a->y + (span ? (b->y - a->y) * (int32_t)(t_ms - a->t_ms) / span : 0);
+            return;
+        }
+    }
+    *x = tr->points[tr->count - 1].x;
+    *y = tr->points[tr->count - 1].y;
+}
+
+// Input device read: every sample once it is due, as disp_touch hands over its queue
+static void bench_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    const int64_t now = esp_timer_get_time();
+    const int64_t t_us = trace_t0 + (int64_t)next_sample * sample_ms * 1000;
+    if (trace && next_sample <= release_sample && t_us <= now) {
+        shown_pressed = next_sample < release_sample;
+        if (shown_pressed) {
+            bench_trace_point(trace, next_sample * sample_ms, &shown_x, &shown_y);
+        }
+        next_sample++;
+        if (mode == BENCH_ENGINE) {
+            disp_gesture_feed(gesture, shown_x, shown_y, shown_pressed, t_us);
+        }
+        data->continue_reading = next_sample <= release_sample && t_us + sample_ms * 1000 <= now;
+    }
+    data->point.x = shown_x;
+    data->point.y = shown_y;
+    data->state = shown_pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+}
+
+// Hold the loop for what `host_us` of work and `bytes` on the bus take on the watch
+static void bench_charge(uint64_t host_us, uint64_t bytes)
+{
+    const uint64_t us = host_us * (cpu_scale - 1) + bytes * bus_ns_per_byte / 1000;
+    if (us) {
+        usleep(us);
+    }
+}
+
+// One pass of the LVGL loop of main.c; true if it flushed a frame that moved
+static bool bench_pass(void)
+{
+    frame_moved = false;
+    flush_bytes = 0;
+    const int64_t t0 = esp_timer_get_time();
+    const uint32_t next_ms = lv_timer_handler();
+    bench_charge(esp_timer_get_time() - t0, flush_bytes);
+    if (flush_bytes == 0) {
+        usleep(next_ms < 1 ? 100 : 1000);
+    }
+    return frame_moved;
+}
+
+// Play a trace from the watch face and run the loop until the screen change is over
+static void bench_trace(const bench_trace_t *tr, bench_result_t *res)
+{
+    lv_disp_t *disp = lv_disp_get_default();
+    lv_disp_load_scr(ui_Screen1);
+    lv_refr_now(disp);
+
+    // First sample off the touch down point
+    uint32_t first_move = 0;
+    for (uint32_t i = 1; first_move == 0 && i * sample_ms < tr->points[tr->count - 1].t_ms; i++) {
+        lv_coord_t x, y;
+        bench_trace_point(tr, i * sample_ms, &x, &y);
+        first_move = (x != tr->points[0].x || y != tr->points[0].y) ? i : 0;
+    }
+    trace = tr;
+    next_sample = 0;
+    release_sample = (tr->points[tr->count - 1].t_ms + sample_ms - 1) / sample_ms;
+    trace_t0 = esp_timer_get_time() + BENCH_LEAD_MS * 1000;
+    const int64_t move_us = trace_t0 + (int64_t)first_move * sample_ms * 1000;
+    const int64_t end_us = trace_t0 + (int64_t)release_sample * sample_ms * 1000 + BENCH_TAIL_MS * 1000;
+    res->move_to_frame_us = -1;
+    res->down_to_frame_us = -1;
+    res->move_to_done_us = -1;
+    while (esp_timer_get_time() < end_us) {
+        const bool moved = bench_pass();
+        const int64_t now = esp_timer_get_time();
+        if (moved && res->move_to_frame_us < 0) {
+            res->move_to_frame_us = now - move_us;
+            res->down_to_frame_us = now - trace_t0;
+        }
+        const bool settled = !disp_trans_is_running(trans) && !disp->scr_to_load && !disp->prev_scr;
+        if (settled && res->move_to_done_us < 0 && lv_scr_act() != ui_Screen1) {
+            res->move_to_done_us = now - move_us;
+        }
+        if (settled && next_sample > release_sample && (res->move_to_done_us >= 0 || now > end_us - BENCH_TAIL_MS * 500)) {
+            break;
+        }
+    }
+    trace = NULL;
+    res->scr = lv_scr_act();
+}
+
+static const char *bench_screen_name(lv_obj_t *scr)
+{
+    for (size_t i = 0; i < sizeof(screen_names) / sizeof(screen_names[0]); i++) {
+        if (*screen_names[i].scr == scr) {
+            return screen_names[i].name;
+        }
+    }
+    return "other";
+}
+
+static void bench_print_ms(int64_t us)
+{
+    if (us < 0) {
+        printf(" %8s", "-");
+    } else {
+        printf(" %8.1f", us / 1000.0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--cpu-scale") && i + 1 < argc) {
+            cpu_scale = (uint32_t)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--bus-ns-per-byte") && i + 1 < argc) {
+            bus_ns_per_byte = (uint32_t)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--sample-ms") && i + 1 < argc) {
+            sample_ms = (uint32_t)atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--cpu-scale N] [--bus-ns-per-byte N] [--sample-ms N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (cpu_scale == 0) {
+        cpu_scale = 1;
+    }
+    if (sample_ms == 0) {
+        sample_ms = 1;
+    }
+
+    lv_init();
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf1[BENCH_H_RES * BENCH_BUF_ROWS];
+    lv_disp_draw_buf_init(&draw_buf, buf1, NULL, BENCH_H_RES * BENCH_BUF_ROWS);
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = BENCH_H_RES;
+    disp_drv.ver_res = BENCH_V_RES;
+    disp_drv.flush_cb = bench_flush_cb;
+    disp_drv.monitor_cb = bench_monitor_cb;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_t *disp = lv_disp_drv_register(&disp_drv);
+
+    static lv_indev_drv_t indev_drv;
+    lv_indev_drv_init(&indev_drv);
+    indev_drv.type = LV_INDEV_TYPE_POINTER;
+    indev_drv.disp = disp;
+    indev_drv.read_cb = bench_read_cb;
+    lv_indev_t *indev = lv_indev_drv_register(&indev_drv);
+
+    ui_init();
+    _ui_screen_build(&ui_Screen2, ui_Screen2_screen_init);
+    _ui_screen_build(&ui_Screen3, ui_Screen3_screen_init);
+    _ui_screen_build(&ui_Screen4, ui_Screen4_screen_init);
+    _ui_screen_build(&ui_Screen5, ui_Screen5_screen_init);
+    _ui_screen_build(&ui_Screen6, ui_Screen6_screen_init);
+
+    const disp_trans_config_t trans_config = {0};
+    ESP_ERROR_CHECK(disp_trans_new(&trans_config, disp, &trans));
+    const disp_gesture_config_t gesture_config = {
+        .trans = trans,
+    };
+    ESP_ERROR_CHECK(disp_gesture_new(&gesture_config, &gesture));
+
+    printf("cpu x%u, bus %u ns/byte, sample every %u ms, LVGL read every %u ms\n", cpu_scale, bus_ns_per_byte,
+           sample_ms, LV_INDEV_DEF_READ_PERIOD);
+    printf("%-14s %-9s %8s %8s %8s %s\n", "trace", "mode", "move_ms", "down_ms", "done_ms", "screen");
+    int failures = 0;
+    int64_t sum_us[BENCH_MODES] = {0};
+    int moved[BENCH_MODES] = {0};
+    for (size_t i = 0; i < BENCH_TRACES; i++) {
+        for (mode = 0; mode < BENCH_MODES; mode++) {
+            lv_timer_set_period(indev->driver->read_timer, mode == BENCH_LVGL_SCAN ? sample_ms : LV_INDEV_DEF_READ_PERIOD);
+            if (mode == BENCH_ENGINE) {
+                ESP_ERROR_CHECK(disp_gesture_attach(gesture, indev));
+                _ui_screen_set_load_cb(disp_gesture_load, gesture);
+            } else {
+                indev->driver->gesture_limit = LV_INDEV_DEF_GESTURE_LIMIT;
+                indev->driver->gesture_min_velocity = LV_INDEV_DEF_GESTURE_MIN_VELOCITY;
+                _ui_screen_set_load_cb(disp_trans_load, trans);
+            }
+            bench_result_t res;
+            bench_trace(&traces[i], &res);
+            printf("%-14s %-9s", traces[i].name, mode_names[mode]);
+            bench_print_ms(res.move_to_frame_us);
+            bench_print_ms(res.down_to_frame_us);
+            bench_print_ms(res.move_to_done_us);
+            printf(" %s\n", bench_screen_name(res.scr));
+            if (res.move_to_frame_us >= 0 && res.scr != ui_Screen1) {
+                sum_us[mode] += res.move_to_frame_us;
+                moved[mode]++;
+            }
+            if (mode == BENCH_ENGINE && res.scr != *traces[i].expect) {
+                ESP_LOGE(TAG, "%s: %s on display, expected %s", traces[i].name, bench_screen_name(res.scr),
+                         bench_screen_name(*traces[i].expect));
+                failures++;
+            }
+        }
+    }
+    for (mode = 0; mode < BENCH_MODES; mode++) {
+        printf("%-9s %d of %u traces changed screen, first move to first moved frame avg %.1f ms\n",
+               mode_names[mode], moved[mode], (unsigned)BENCH_TRACES, moved[mode] ? sum_us[mode] / 1000.0 / moved[mode] : 0.0);
+    }
+
+    disp_gesture_stats_t st;
+    disp_gesture_get_stats(gesture, &st, false);
+    printf("engine: %u touches, %u locks (avg %.1f ms after touch down), %u drags, %u flicks, %u committed, "
+           "%u cancelled\n", st.touches, st.locks, st.locks ? st.lock_us / 1000.0 / st.locks : 0.0, st.drags, st.flicks,
+           st.commits, st.cancels);
+    if (st.cancels != 1) {
+        ESP_LOGE(TAG, "%u drags cancelled, expected 1", st.cancels);
+        failures++;
+    }
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
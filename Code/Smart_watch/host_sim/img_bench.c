@@ -0,0 +1,238 @@
+/*
+ * Compressed image benchmark: what the SquareLine images take in flash and cost to draw, once as the raw
+ * RGB565 + A8 arrays SquareLine exports and once run-length compressed by tools/img_conv.py and decoded row by
+ * row by disp_img, as the firmware builds them with UI_COMPRESSED_IMAGES.
+ *
+ *   img_bench [--iterations N] [--cpu-scale N] [--flash-ns-per-byte N]
+ *
+ * Every image is checked twice: each of its rows decoded by disp_img_read_line, whole and from a few offsets,
+ * must give the raw pixels (the color of fully transparent pixels is not kept), and LVGL drawing it centered on
+ * a grey screen must give the same frame from both sources. Then the screen is redrawn --iterations times
+ * (default 20) from each source; per image the bench prints both sizes, the layout img_conv.py picked, the
+ * draw time of the two and the time disp_img_read_line alone takes for the whole image.
+ *
+ * The host hides what the watch pays for the arrays: they are read through the 32 kB flash cache, which the large
+ * images overflow on every frame. The estimate columns charge the draw time --cpu-scale (default 10) times, a
+ * rough ESP32-S3 at 240 MHz, plus --flash-ns-per-byte (default 25, 80 MHz quad SPI flash) for every byte of
+ * the image read while drawing it.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lvgl.h"
+
+#include "disp_img.h"
+
+#define BENCH_H_RES             368
+#define BENCH_V_RES             448
+#define BENCH_BG                0x404040
+
+static const char *TAG = "img_bench";
+
+// Generated by tools/img_conv.py --table ui_images, the same images in both forms
+extern const lv_img_dsc_t *const ui_images_raw[];
+extern const lv_img_dsc_t *const ui_images_rle[];
+extern const char *const ui_images_names[];
+extern const size_t ui_images_count;
+
+static uint32_t cpu_scale = 10;
+static uint32_t flash_ns_per_byte = 25;
+static lv_color_t frame[BENCH_H_RES * BENCH_V_RES];
+
+static void bench_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    const int32_t w = lv_area_get_width(area);
+    for (int32_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&frame[y * BENCH_H_RES + area->x1], color_map, w * sizeof(lv_color_t));
+        color_map += w;
+    }
+    lv_disp_flush_ready(drv);
+}
+
+// Every row of `rle` against the pixels of `raw`, whole and from a few offsets; returns the mismatches
+static int bench_check_rows(const lv_img_dsc_t *raw, const lv_img_dsc_t *rle, const char *name)
+{
+    const lv_coord_t w = raw->header.w;
+    const size_t px_size = rle->data[9] & DISP_IMG_FLAG_ALPHA ? LV_IMG_PX_SIZE_ALPHA_BYTE : sizeof(lv_color_t);
+    uint8_t *row = malloc(w * LV_IMG_PX_SIZE_ALPHA_BYTE);
+    uint8_t *part = malloc(w * LV_IMG_PX_SIZE_ALPHA_BYTE);
+    int failures = 0;
+    for (lv_coord_t y = 0; y < raw->header.h && !failures; y++) {
+        if (disp_img_read_line(rle, 0, y, w, row) != ESP_OK) {
+            ESP_LOGE(TAG, "%s: row %d not decoded", name, y);
+            failures++;
+            break;
+        }
+        const uint8_t *ref = raw->data + (size_t)y * w * LV_IMG_PX_SIZE_ALPHA_BYTE;
+        for (lv_coord_t x = 0; x < w; x++) {
+            const uint8_t *r = ref + x * LV_IMG_PX_SIZE_ALPHA_BYTE;
+            const uint8_t *d = row + x * px_size;
+            const uint8_t a = px_size == LV_IMG_PX_SIZE_ALPHA_BYTE ? d[2] : LV_OPA_COVER;
+            if (a != r[2] || (a != LV_OPA_TRANSP && (d[0] != r[0] || d[1] != r[1]))) {
+                ESP_LOGE(TAG, "%s: pixel %d,%d decoded %02x%02x/%02x, raw %02x%02x/%02x", name, x, y, d[0], d[1], a,
+                         r[0], r[1], r[2]);
+                failures++;
+                break;
+            }
+        }
+        // Part of a row, as LVGL reads it when the image is clipped
+        const lv_coord_t offsets[] = {1, w / 3, w / 2, w - 1};
+        for (size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]) && !failures; i++) {
+            const lv_coord_t x = offsets[i];
+            const lv_coord_t len = (w - x) / 2 + 1;
+            if (x >= w || disp_img_read_line(rle, x, y, len, part) != ESP_OK ||
+                memcmp(part, row + x * px_size, len * px_size)) {
+                ESP_LOGE(TAG, "%s: row %d from %d differs from the whole row", name, y, x);
+                failures++;
+            }
+        }
+    }
+    free(part);
+    free(row);
+    return failures;
+}
+
+// Redraw the screen holding only `img` with `src`; returns the average host time of a frame
+static uint64_t bench_draw(lv_obj_t *img, const lv_img_dsc_t *src, int iterations)
+{
+    lv_img_set_src(img, src);
+    lv_obj_center(img);
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);
+    uint64_t total_us = 0;
+    for (int i = 0; i < iterations; i++) {
+        lv_obj_invalidate(lv_scr_act());
+        const int64_t t = esp_timer_get_time();
+        lv_refr_now(NULL);
+        total_us += esp_timer_get_time() - t;
+    }
+    return iterations ? total_us / iterations : 0;
+}
+
+// disp_img_read_line over the whole image, `iterations` times; returns the average
+static uint64_t bench_decode(const lv_img_dsc_t *rle, int iterations)
+{
+    uint8_t *row = malloc(rle->header.w * LV_IMG_PX_SIZE_ALPHA_BYTE);
+    const int64_t t = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        for (lv_coord_t y = 0; y < rle->header.h; y++) {
+            disp_img_read_line(rle, 0, y, rle->header.w, row);
+        }
+    }
+    const int64_t us = esp_timer_get_time() - t;
+    free(row);
+    return iterations ? us / iterations : 0;
+}
+
+static uint64_t bench_estimate_us(uint64_t host_us, size_t flash_bytes)
+{
+    return host_us * cpu_scale + (uint64_t)flash_bytes * flash_ns_per_byte / 1000;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = 20;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--cpu-scale") && i + 1 < argc) {
+            cpu_scale = (uint32_t)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--flash-ns-per-byte") && i + 1 < argc) {
+            flash_ns_per_byte = (uint32_t)atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--iterations N] [--cpu-scale N] [--flash-ns-per-byte N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (iterations < 1) {
+        iterations = 1;
+    }
+    if (cpu_scale == 0) {
+        cpu_scale = 1;
+    }
+
+    lv_init();
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf1[BENCH_H_RES * BENCH_V_RES];
+    lv_disp_draw_buf_init(&draw_buf, buf1, NULL, BENCH_H_RES * BENCH_V_RES);
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = BENCH_H_RES;
+    disp_drv.ver_res = BENCH_V_RES;
+    disp_drv.flush_cb = bench_flush_cb;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_drv_register(&disp_drv);
+
+    // No cache, every draw decodes its rows
+    const disp_img_config_t img_config = {0};
+    disp_img_handle_t decoder = NULL;
+    ESP_ERROR_CHECK(disp_img_new(&img_config, &decoder));
+
+    lv_obj_t *scr = lv_obj_create(NULL);
+    lv_obj_set_style_bg_color(scr, lv_color_hex(BENCH_BG), 0);
+    lv_obj_t *img = lv_img_create(scr);
+    lv_disp_load_scr(scr);
+    static lv_color_t ref[BENCH_H_RES * BENCH_V_RES];
+
+    printf("cpu x%u, flash %u ns/byte, %d iterations\n", cpu_scale, flash_ns_per_byte, iterations);
+    printf("%-42s %7s %7s %7s %6s %8s %8s %8s %9s %8s %8s\n", "image", "size", "raw_B", "rle_B", "ratio", "layout",
+           "raw_us", "rle_us", "decode_us", "est_raw", "est_rle");
+    int failures = 0;
+    size_t raw_total = 0, rle_total = 0;
+    uint64_t raw_us_total = 0, rle_us_total = 0, est_raw_total = 0, est_rle_total = 0;
+    for (size_t i = 0; i < ui_images_count; i++) {
+        const lv_img_dsc_t *raw = ui_images_raw[i];
+        const lv_img_dsc_t *rle = ui_images_rle[i];
+        const char *name = ui_images_names[i];
+        const bool compressed = disp_img_is_compressed(rle);
+        if (compressed) {
+            failures += bench_check_rows(raw, rle, name);
+        }
+
+        // Same frame from both sources
+        bench_draw(img, raw, 0);
+        memcpy(ref, frame, sizeof(frame));
+        bench_draw(img, rle, 0);
+        if (memcmp(ref, frame, sizeof(frame))) {
+            ESP_LOGE(TAG, "%s: frame differs from the raw image", name);
+            failures++;
+        }
+
+        const uint64_t raw_us = bench_draw(img, raw, iterations);
+        const uint64_t rle_us = bench_draw(img, rle, iterations);
+        const uint64_t decode_us = compressed ? bench_decode(rle, iterations) : 0;
+        const uint64_t est_raw = bench_estimate_us(raw_us, raw->data_size);
+        const uint64_t est_rle = bench_estimate_us(rle_us, rle->data_size);
+        const char *layout = !compressed ? "raw" : rle->data[8] == DISP_IMG_MODE_INDEXED ? "indexed" : "planes";
+        char size[16];
+        snprintf(size, sizeof(size), "%dx%d", raw->header.w, raw->header.h);
+        printf("%-42s %7s %7u %7u %5.1f%% %8s %8llu %8llu %9llu %8llu %8llu\n", name, size,
+               (unsigned)raw->data_size, (unsigned)rle->data_size, 100.0 * rle->data_size / raw->data_size, layout,
+               (unsigned long long)raw_us, (unsigned long long)rle_us, (unsigned long long)decode_us,
+               (unsigned long long)est_raw, (unsigned long long)est_rle);
+        raw_total += raw->data_size;
+        rle_total += rle->data_size;
+        raw_us_total += raw_us;
+        rle_us_total += rle_us;
+        est_raw_total += est_raw;
+        est_rle_total += est_rle;
+    }
+    printf("%u images: %u -> %u bytes of flash (%.1f%%), draw %llu -> %llu us, estimate %llu -> %llu us\n",
+           (unsigned)ui_images_count, (unsigned)raw_total, (unsigned)rle_total, 100.0 * rle_total / raw_total,
+           (unsigned long long)raw_us_total, (unsigned long long)rle_us_total, (unsigned long long)est_raw_total,
+           (unsigned long long)est_rle_total);
+
+    disp_img_stats_t st;
+    disp_img_get_stats(decoder, &st, false);
+    printf("decoder: %u opened, %u lines, %llu px, %u errors\n", st.opens, st.lines, (unsigned long long)st.px,
+           st.errors);
+    if (st.errors) {
+        failures++;
+    }
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
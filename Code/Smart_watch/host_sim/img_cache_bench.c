@@ -0,0 +1,345 @@
+/*
+ * Decoded image cache benchmark: the SquareLine screens drawn from the compressed images, as the firmware builds
+ * them with UI_COMPRESSED_IMAGES, through the disp_img decoder with a range of cache budgets.
+ *
+ *   img_cache_bench [--budget-kb N]... [--rounds N] [--frames N]
+ *
+ * The screens are built as on the watch, then every image widget is pointed at the compressed copy of its image.
+ * A walk goes from the watch face to each other screen and back, drawing --frames full frames (default 3) per
+ * visit, --rounds times (default 3). It runs once without a cache, which gives the reference frames, then once
+ * per --budget-kb (default 64, 128, 256 and 512) with the watch face images pinned. Per budget the bench prints
+ * the opens the cache served, the ones it decoded, the ones drawn line by line, the evictions, the bytes decoded
+ * and the average frame time. Every frame must match the one drawn without a cache, and the cache must give
+ * its PSRAM back when deleted. The walks go through disp_trace as on the watch: the hits, misses and decoded
+ * bytes of the dumped frames must add up to the decoder's own counters, less what pinning decoded, unless a walk
+ * is longer than the trace ring.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lvgl.h"
+#include "ui.h"
+
+#include "disp_img.h"
+#include "disp_trace.h"
+
+#define BENCH_H_RES             368
+#define BENCH_V_RES             448
+#define BENCH_MAX_BUDGETS       8
+
+static const char *TAG = "img_cache_bench";
+
+// Generated by tools/img_conv.py --table ui_images, the same images in both forms
+extern const lv_img_dsc_t *const ui_images_raw[];
+extern const lv_img_dsc_t *const ui_images_rle[];
+extern const char *const ui_images_names[];
+extern const size_t ui_images_count;
+
+typedef struct {
+    const char *name;
+    lv_obj_t **scr;
+    void (*init)(void);
+} bench_screen_t;
+
+static const bench_screen_t screens[] = {
+    {"Screen1", &ui_Screen1, ui_Screen1_screen_init},
+    {"Screen2", &ui_Screen2, ui_Screen2_screen_init},
+    {"Screen3", &ui_Screen3, ui_Screen3_screen_init},
+    {"Screen4", &ui_Screen4, ui_Screen4_screen_init},
+    {"Screen5", &ui_Screen5, ui_Screen5_screen_init},
+    {"Screen6", &ui_Screen6, ui_Screen6_screen_init},
+};
+#define BENCH_SCREENS (sizeof(screens) / sizeof(screens[0]))
+
+// Images of Screen1, pinned as main.c does
+static const lv_img_dsc_t *const watch_face_images[] = {
+    &ui_img_duoyun_png,
+    &ui_img_heartsmall_png,
+    &ui_img_kaluli_png,
+    &ui_img_shandian_png,
+    &ui_img_zuji_png,
+};
+
+static lv_color_t frame[BENCH_H_RES * BENCH_V_RES];
+static lv_color_t ref[BENCH_SCREENS][BENCH_H_RES * BENCH_V_RES];
+
+static void bench_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    const int32_t w = lv_area_get_width(area);
+    for (int32_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&frame[y * BENCH_H_RES + area->x1], color_map, w * sizeof(lv_color_t));
+        color_map += w;
+    }
+    lv_disp_flush_ready(drv);
+}
+
+static const lv_img_dsc_t *bench_compressed(const void *src)
+{
+    for (size_t i = 0; i < ui_images_count; i++) {
+        if (ui_images_raw[i] == src || ui_images_rle[i] == src) {
+            return ui_images_rle[i];
+        }
+    }
+    return NULL;
+}
+
+// Sums the image counters of the dumped frames
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t bytes;
+} bench_trace_sum_t;
+
+static esp_err_t bench_trace_write(const char *line, size_t len, void *user_ctx)
+{
+    bench_trace_sum_t *sum = (bench_trace_sum_t *)user_ctx;
+    // trace,seq,t_ms,screen,timer_us,render_us,flush_us,bytes,areas,img_hits,img_misses,img_bytes
+    unsigned hits, misses;
+    unsigned long long bytes;
+    if (sscanf(line, "trace,%*u,%*u,%*[^,],%*u,%*u,%*u,%*u,%*u,%u,%u,%llu", &hits, &misses, &bytes) == 3) {
+        sum->hits += hits;
+        sum->misses += misses;
+        sum->bytes += bytes;
+    }
+    return ESP_OK;
+}
+
+// Point the image widgets under `obj` at the compressed images; returns how many
+static int bench_use_compressed(lv_obj_t *obj)
+{
+    int swapped = 0;
+    if (lv_obj_check_type(obj, &lv_img_class)) {
+        const lv_img_dsc_t *rle = bench_compressed(lv_img_get_src(obj));
+        if (rle) {
+            lv_img_set_src(obj, rle);
+            swapped++;
+        }
+    } else if (lv_obj_check_type(obj, &lv_imgbtn_class)) {
+        const lv_imgbtn_t *btn = (const lv_imgbtn_t *)obj;
+        const lv_img_dsc_t *rle = bench_compressed(btn->img_src_mid[LV_IMGBTN_STATE_RELEASED]);
+        if (rle) {
+            lv_imgbtn_set_src(obj, LV_IMGBTN_STATE_RELEASED, NULL, rle, NULL);
+            swapped++;
+        }
+    }
+    for (uint32_t i = 0; i < lv_obj_get_child_cnt(obj); i++) {
+        swapped += bench_use_compressed(lv_obj_get_child(obj, i));
+    }
+    return swapped;
+}
+
+typedef struct {
+    uint64_t frame_us;
+    uint32_t frames;
+    uint32_t mismatches;
+} bench_walk_t;
+
+// Draw screen `s` `frames` times, against its reference frame unless `record`
+static void bench_visit(size_t s, int frames, bool record, bench_walk_t *walk)
+{
+    lv_disp_load_scr(*screens[s].scr);
+    for (int f = 0; f < frames; f++) {
+        lv_obj_invalidate(*screens[s].scr);
+        const int64_t t = esp_timer_get_time();
+        lv_refr_now(NULL);
+        walk->frame_us += esp_timer_get_time() - t;
+        walk->frames++;
+        if (record) {
+            memcpy(ref[s], frame, sizeof(frame));
+        } else if (memcmp(ref[s], frame, sizeof(frame))) {
+            if (walk->mismatches++ == 0) {
+                ESP_LOGE(TAG, "%s: frame differs from the one drawn without a cache", screens[s].name);
+            }
+        }
+    }
+}
+
+// The watch face, then every other screen and back to the watch face, `rounds` times
+static void bench_walk(int rounds, int frames, bool record, bench_walk_t *walk)
+{
+    memset(walk, 0, sizeof(*walk));
+    for (int r = 0; r < rounds; r++) {
+        for (size_t s = 1; s < BENCH_SCREENS; s++) {
+            bench_visit(0, frames, record, walk);
+            bench_visit(s, frames, record, walk);
+        }
+    }
+    bench_visit(0, frames, record, walk);
+}
+
+// The error cases of disp_img_pin; returns the failures
+static int bench_check_pin_errors(void)
+{
+    int failures = 0;
+    const disp_img_config_t no_cache = {0};
+    disp_img_handle_t img = NULL;
+    ESP_ERROR_CHECK(disp_img_new(&no_cache, &img));
+    const esp_err_t no_cache_err = disp_img_pin(img, bench_compressed(watch_face_images[0]));
+    disp_img_del(img);
+
+    // Room for the smallest watch face image only
+    size_t smallest = SIZE_MAX;
+    for (size_t i = 0; i < sizeof(watch_face_images) / sizeof(watch_face_images[0]); i++) {
+        const lv_img_dsc_t *rle = bench_compressed(watch_face_images[i]);
+        const size_t px_size = rle->data[9] & DISP_IMG_FLAG_ALPHA ? LV_IMG_PX_SIZE_ALPHA_BYTE : sizeof(lv_color_t);
+        const size_t size = (size_t)rle->header.w * rle->header.h * px_size;
+        smallest = size < smallest ? size : smallest;
+    }
+    const disp_img_config_t small = {.cache_bytes = smallest};
+    ESP_ERROR_CHECK(disp_img_new(&small, &img));
+    const esp_err_t raw_err = disp_img_pin(img, watch_face_images[0]);
+    esp_err_t full_err = ESP_OK;
+    for (size_t i = 0; i < sizeof(watch_face_images) / sizeof(watch_face_images[0]) && full_err == ESP_OK; i++) {
+        full_err = disp_img_pin(img, bench_compressed(watch_face_images[i]));
+    }
+    disp_img_del(img);
+
+    const struct {
+        const char *what;
+        esp_err_t err;
+        esp_err_t expected;
+    } cases[] = {
+        {"pin without a cache", no_cache_err, ESP_ERR_INVALID_STATE},
+        {"pin a raw image", raw_err, ESP_ERR_INVALID_ARG},
+        {"pin past the budget", full_err, ESP_ERR_NO_MEM},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        printf("%-20s %s\n", cases[i].what, esp_err_to_name(cases[i].err));
+        if (cases[i].err != cases[i].expected) {
+            ESP_LOGE(TAG, "%s: expected %s", cases[i].what, esp_err_to_name(cases[i].expected));
+            failures++;
+        }
+    }
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = 3;
+    int frames = 3;
+    size_t budgets_kb[BENCH_MAX_BUDGETS];
+    size_t budget_count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--budget-kb") && i + 1 < argc && budget_count < BENCH_MAX_BUDGETS) {
+            budgets_kb[budget_count++] = (size_t)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--rounds") && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--budget-kb N]... [--rounds N] [--frames N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (budget_count == 0) {
+        const size_t defaults[] = {64, 128, 256, 512};
+        for (size_t i = 0; i < sizeof(defaults) / sizeof(defaults[0]); i++) {
+            budgets_kb[budget_count++] = defaults[i];
+        }
+    }
+    if (rounds < 1) {
+        rounds = 1;
+    }
+    if (frames < 1) {
+        frames = 1;
+    }
+
+    lv_init();
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf1[BENCH_H_RES * BENCH_V_RES];
+    lv_disp_draw_buf_init(&draw_buf, buf1, NULL, BENCH_H_RES * BENCH_V_RES);
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = BENCH_H_RES;
+    disp_drv.ver_res = BENCH_V_RES;
+    disp_drv.flush_cb = bench_flush_cb;
+    disp_drv.draw_buf = &draw_buf;
+    static disp_trace_handle_t trace = NULL;
+    const disp_trace_config_t trace_config = {0};
+    ESP_ERROR_CHECK(disp_trace_new(&trace_config, &trace));
+    ESP_ERROR_CHECK(disp_trace_attach(trace, &disp_drv));
+    lv_disp_drv_register(&disp_drv);
+
+    // The decoder must be there before a widget reads the header of a compressed image
+    const disp_img_config_t no_cache = {0};
+    disp_img_handle_t img = NULL;
+    ESP_ERROR_CHECK(disp_img_new(&no_cache, &img));
+    ui_init();
+    int swapped = 0;
+    for (size_t s = 0; s < BENCH_SCREENS; s++) {
+        _ui_screen_build(screens[s].scr, screens[s].init);
+        swapped += bench_use_compressed(*screens[s].scr);
+    }
+
+    bench_walk_t walk;
+    disp_img_stats_t st;
+    bench_walk(rounds, frames, true, &walk);
+    disp_img_get_stats(img, &st, true);
+    disp_img_del(img);
+    printf("%d images on %u screens, %u frames per walk\n", swapped, (unsigned)BENCH_SCREENS, walk.frames);
+    printf("%-9s %6s %6s %6s %8s %6s %9s %9s %9s %9s %8s\n", "budget", "opens", "hits", "misses", "uncached",
+           "evict", "hit_rate", "decode_kB", "decode_ms", "cached_kB", "frame_us");
+    printf("%-9s %6u %6u %6u %8u %6u %8.1f%% %9u %9u %9u %8llu\n", "none", st.opens, st.hits, st.misses,
+           st.uncached, st.evictions, 0.0, 0u, 0u, 0u, (unsigned long long)(walk.frame_us / walk.frames));
+
+    int failures = 0;
+    const size_t psram_free = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    for (size_t b = 0; b < budget_count; b++) {
+        const disp_img_config_t config = {
+            .cache_bytes = budgets_kb[b] * 1024,
+            .cache_caps = MALLOC_CAP_SPIRAM,
+        };
+        ESP_ERROR_CHECK(disp_img_new(&config, &img));
+        size_t pinned = 0;
+        for (size_t i = 0; i < sizeof(watch_face_images) / sizeof(watch_face_images[0]); i++) {
+            pinned += disp_img_pin(img, bench_compressed(watch_face_images[i])) == ESP_OK;
+        }
+        disp_img_stats_t pins;
+        disp_img_get_stats(img, &pins, false);
+        // Frames of the walks before go out first
+        bench_trace_sum_t traced = {0};
+        disp_trace_dump(trace, bench_trace_write, &traced);
+        memset(&traced, 0, sizeof(traced));
+        disp_trace_stats_t ts;
+        disp_trace_get_stats(trace, &ts);
+        const uint32_t lost = ts.lost;
+        ESP_ERROR_CHECK(disp_trace_set_images(trace, img));
+        bench_walk(rounds, frames, false, &walk);
+        disp_trace_dump(trace, bench_trace_write, &traced);
+        ESP_ERROR_CHECK(disp_trace_set_images(trace, NULL));
+        disp_img_get_stats(img, &st, true);
+        char budget[16];
+        snprintf(budget, sizeof(budget), "%ukB", (unsigned)budgets_kb[b]);
+        printf("%-9s %6u %6u %6u %8u %6u %8.1f%% %9u %9u %9u %8llu  (%u pinned)\n", budget, st.opens, st.hits,
+               st.misses, st.uncached, st.evictions, 100.0 * st.hits / st.opens, (unsigned)(st.decoded_bytes / 1024),
+               (unsigned)(st.decode_us / 1000), (unsigned)(st.cached_bytes / 1024),
+               (unsigned long long)(walk.frame_us / walk.frames), (unsigned)pinned);
+        failures += walk.mismatches ? 1 : 0;
+        if (st.cached_bytes > config.cache_bytes || st.errors) {
+            ESP_LOGE(TAG, "%s: %u bytes cached, %u errors", budget, (unsigned)st.cached_bytes, st.errors);
+            failures++;
+        }
+        disp_trace_get_stats(trace, &ts);
+        if (ts.lost == lost && (traced.hits != st.hits || traced.misses != st.misses ||
+                                traced.bytes != st.decoded_bytes - pins.decoded_bytes)) {
+            ESP_LOGE(TAG, "%s: trace counted %llu hits, %llu misses, %llu bytes", budget,
+                     (unsigned long long)traced.hits, (unsigned long long)traced.misses,
+                     (unsigned long long)traced.bytes);
+            failures++;
+        }
+        disp_img_del(img);
+        if (heap_caps_get_free_size(MALLOC_CAP_SPIRAM) != psram_free) {
+            ESP_LOGE(TAG, "%s: PSRAM not given back", budget);
+            failures++;
+        }
+    }
+
+    failures += bench_check_pin_errors();
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
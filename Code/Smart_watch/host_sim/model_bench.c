@@ -0,0 +1,385 @@
+/*
+ * Data model benchmark: a minute of sensor readings shown on the watch face, once posted as label texts and arc
+ * values to the disp_update queue and once set in a disp_model whose values are bound to the widgets.
+ *
+ *   model_bench [--seconds N] [--fps N] [--mode queue|model|both]
+ *
+ * The readings are those of a resting wearer: heart rate at 5 Hz, mostly the same beat count; steps at 2 Hz with
+ * the calories derived from them; battery and the clock once a second. Time is simulated, --fps frames per second
+ * (default 30) for --seconds (default 60), each frame applying what was posted or set during it and rendering
+ * what that invalidated. Per mode it prints the label updates LVGL got, the allocations LVGL made while applying
+ * and while rendering, the frames that rendered something, the pixels they rendered and the time spent applying
+ * per frame. The texts on display must match the last readings. The model part ends by deleting the watch face
+ * with values still being set, building it again and checking the new labels show the current values, then
+ * setting step counts past the range of their arc, which must stay full.
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lvgl.h"
+#include "ui.h"
+
+#include "disp_model.h"
+#include "disp_update.h"
+
+#define BENCH_H_RES             368
+#define BENCH_V_RES             448
+#define BENCH_BUF_ROWS          (BENCH_V_RES / 4)
+
+static const char *TAG = "model_bench";
+
+// The readings, as disp_model ids in the order they are added
+enum {
+    BENCH_TIME,
+    BENCH_DATE,
+    BENCH_STEPS,
+    BENCH_KCAL,
+    BENCH_HEART_RATE,
+    BENCH_BATTERY,
+    BENCH_VALUES,
+};
+
+static const char *const value_names[BENCH_VALUES] = {"time", "date", "steps", "kcal", "heart rate", "battery"};
+static const int32_t initial[BENCH_VALUES] = {17 * 60 + 23, 423, 6750, 800, 80, 45};
+
+typedef struct {
+    const char *mode;
+    uint32_t readings;
+    uint32_t label_updates;     // texts LVGL was given
+    uint32_t apply_allocs;      // LVGL allocations while applying the updates
+    uint32_t render_allocs;     // LVGL allocations while rendering
+    uint32_t frames;            // frames that rendered something
+    uint64_t px;                // pixels rendered
+    uint64_t apply_us;
+} bench_result_t;
+
+static uint32_t frames;
+static uint64_t rendered_px;
+static uint32_t rng = 12345;
+
+static void bench_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    lv_disp_flush_ready(drv);
+}
+
+static void bench_monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    frames++;
+    rendered_px += px;
+}
+
+static uint32_t bench_rand(uint32_t n)
+{
+    rng = rng * 1103515245 + 12345;
+    return (rng >> 16) % n;
+}
+
+static void format_time(int32_t value, char *buf, size_t size, void *user_ctx)
+{
+    snprintf(buf, size, "%" PRId32 ":%02" PRId32, value / 60, value % 60);
+}
+
+static void format_date(int32_t value, char *buf, size_t size, void *user_ctx)
+{
+    snprintf(buf, size, "%" PRId32 "/%" PRId32, value / 100, value % 100);
+}
+
+// Text a reading shows as, on the watch face label bound to it
+static void bench_text(int id, int32_t value, char *buf, size_t size)
+{
+    switch (id) {
+    case BENCH_TIME:
+        format_time(value, buf, size, NULL);
+        break;
+    case BENCH_DATE:
+        format_date(value, buf, size, NULL);
+        break;
+    case BENCH_BATTERY:
+        snprintf(buf, size, "%" PRId32 "%%", value);
+        break;
+    default:
+        snprintf(buf, size, "%" PRId32, value);
+        break;
+    }
+}
+
+static lv_obj_t *bench_label(int id)
+{
+    lv_obj_t *labels[BENCH_VALUES] = {ui_Label10, ui_Label14, ui_Label6, ui_Label13, ui_Label12, ui_Label11};
+    return labels[id];
+}
+
+static lv_obj_t *bench_arc(int id)
+{
+    switch (id) {
+    case BENCH_STEPS:
+        return ui_Arc7;
+    case BENCH_KCAL:
+        return ui_Arc3;
+    case BENCH_BATTERY:
+        return ui_Arc1;
+    default:
+        return NULL;
+    }
+}
+
+// The watch face bindings of main.c
+static void bench_bind(disp_model_handle_t model)
+{
+    ESP_ERROR_CHECK(disp_model_bind_label_cb(model, BENCH_TIME, ui_Label10, format_time, NULL));
+    ESP_ERROR_CHECK(disp_model_bind_label_cb(model, BENCH_DATE, ui_Label14, format_date, NULL));
+    ESP_ERROR_CHECK(disp_model_bind_label(model, BENCH_STEPS, ui_Label6, "%" PRId32));
+    ESP_ERROR_CHECK(disp_model_bind_value(model, BENCH_STEPS, ui_Arc7));
+    ESP_ERROR_CHECK(disp_model_bind_label(model, BENCH_KCAL, ui_Label13, "%" PRId32));
+    ESP_ERROR_CHECK(disp_model_bind_value(model, BENCH_KCAL, ui_Arc3));
+    ESP_ERROR_CHECK(disp_model_bind_label(model, BENCH_HEART_RATE, ui_Label12, "%" PRId32));
+    ESP_ERROR_CHECK(disp_model_bind_label(model, BENCH_BATTERY, ui_Label11, "%" PRId32 "%%"));
+    ESP_ERROR_CHECK(disp_model_bind_value(model, BENCH_BATTERY, ui_Arc1));
+}
+
+// The readings of `frame`, set in the model or posted to the queue; returns how many
+static uint32_t bench_readings(int frame, int fps, int32_t *values, disp_model_handle_t model,
+                               disp_update_handle_t queue)
+{
+    int32_t now[BENCH_VALUES];
+    bool due[BENCH_VALUES] = {0};
+    memcpy(now, values, sizeof(now));
+    const int ms = frame * 1000 / fps;
+    const int prev_ms = (frame - 1) * 1000 / fps;
+    // Due when a period boundary falls in this frame
+#define BENCH_DUE(period_ms) (frame > 0 && ms / (period_ms) != prev_ms / (period_ms))
+    if (BENCH_DUE(200)) {
+        const int32_t hr = now[BENCH_HEART_RATE] + (int32_t)bench_rand(5) - 2;
+        now[BENCH_HEART_RATE] = bench_rand(4) ? now[BENCH_HEART_RATE] : hr;
+        due[BENCH_HEART_RATE] = true;
+    }
+    if (BENCH_DUE(500)) {
+        now[BENCH_STEPS] += bench_rand(3);
+        now[BENCH_KCAL] = 800 + (now[BENCH_STEPS] - 6750) / 25;
+        due[BENCH_STEPS] = due[BENCH_KCAL] = true;
+    }
+    if (BENCH_DUE(1000)) {
+        // Starts at 17:23:30, the minute changes after 30 s; the battery drops every 40 s
+        now[BENCH_TIME] = 17 * 60 + 23 + (ms / 1000 + 30) / 60;
+        now[BENCH_BATTERY] = 45 - ms / 40000;
+        due[BENCH_TIME] = due[BENCH_DATE] = due[BENCH_BATTERY] = true;
+    }
+#undef BENCH_DUE
+
+    uint32_t readings = 0;
+    for (int id = 0; id < BENCH_VALUES; id++) {
+        if (!due[id]) {
+            continue;
+        }
+        readings++;
+        values[id] = now[id];
+        if (model) {
+            disp_model_set(model, id, now[id]);
+            continue;
+        }
+        // What a sensor task does without the model: post the text and the arc value of every reading
+        char text[DISP_UPDATE_TEXT_LEN];
+        bench_text(id, now[id], text, sizeof(text));
+        disp_update_label_text(queue, bench_label(id), text);
+        if (bench_arc(id)) {
+            disp_update_arc_value(queue, bench_arc(id), now[id]);
+        }
+    }
+    return readings;
+}
+
+// The labels must show the last readings
+static int bench_check_texts(const char *mode, const int32_t *values)
+{
+    int failures = 0;
+    for (int id = 0; id < BENCH_VALUES; id++) {
+        char text[DISP_MODEL_TEXT_LEN];
+        bench_text(id, values[id], text, sizeof(text));
+        if (strcmp(lv_label_get_text(bench_label(id)), text)) {
+            ESP_LOGE(TAG, "%s: %s shows \"%s\", expected \"%s\"", mode, value_names[id],
+                     lv_label_get_text(bench_label(id)), text);
+            failures++;
+        }
+        if (bench_arc(id) && lv_arc_get_value(bench_arc(id)) != values[id]) {
+            ESP_LOGE(TAG, "%s: %s arc at %d, expected %" PRId32, mode, value_names[id],
+                     lv_arc_get_value(bench_arc(id)), values[id]);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+static void bench_screen_new(void)
+{
+    _ui_screen_build(&ui_Screen1, ui_Screen1_screen_init);
+    lv_disp_load_scr(ui_Screen1);
+    lv_refr_now(NULL);
+}
+
+// Everything shown at the initial values, then `seconds` of readings; returns the failures
+static int bench_run(bool use_model, int seconds, int fps, bench_result_t *res)
+{
+    int32_t values[BENCH_VALUES];
+    memcpy(values, initial, sizeof(values));
+    rng = 12345;
+    // Neither has a delete, they stay for the run; the queue run comes first
+    static disp_model_handle_t model;
+    static disp_update_handle_t queue;
+    if (use_model) {
+        const disp_model_config_t config = {0};
+        ESP_ERROR_CHECK(disp_model_new(&config, &model));
+        for (int id = 0; id < BENCH_VALUES; id++) {
+            disp_model_id_t ret_id;
+            ESP_ERROR_CHECK(disp_model_add(model, value_names[id], initial[id], &ret_id));
+        }
+        bench_bind(model);
+    } else {
+        const disp_update_config_t config = {0};
+        ESP_ERROR_CHECK(disp_update_new(&config, &queue));
+    }
+    lv_refr_now(NULL);
+
+    memset(res, 0, sizeof(*res));
+    res->mode = use_model ? "model" : "queue";
+    frames = 0;
+    rendered_px = 0;
+    for (int f = 0; f < seconds * fps; f++) {
+        res->readings += bench_readings(f, fps, values, model, queue);
+        const uint32_t allocs0 = heap_caps_sim_get_alloc_count();
+        const int64_t t0 = esp_timer_get_time();
+        if (model) {
+            disp_model_apply(model);
+        } else {
+            disp_update_apply(queue);
+        }
+        res->apply_us += esp_timer_get_time() - t0;
+        const uint32_t allocs1 = heap_caps_sim_get_alloc_count();
+        lv_refr_now(NULL);
+        res->apply_allocs += allocs1 - allocs0;
+        res->render_allocs += heap_caps_sim_get_alloc_count() - allocs1;
+    }
+    res->frames = frames;
+    res->px = rendered_px;
+    if (model) {
+        disp_model_stats_t st;
+        disp_model_get_stats(model, &st, false);
+        res->label_updates = st.label_updates;
+    } else {
+        disp_update_stats_t st;
+        disp_update_get_stats(queue, &st, false);
+        // Every text message applied was an lv_label_set_text; the arcs skip equal values themselves
+        res->label_updates = st.applied;
+    }
+
+    int failures = bench_check_texts(res->mode, values);
+    if (!model) {
+        return failures;
+    }
+
+    // The watch face deleted, e.g. by the screen manager, while the sensors keep setting values
+    disp_model_stats_t before;
+    disp_model_get_stats(model, &before, false);
+    lv_obj_t *blank = lv_obj_create(NULL);
+    lv_disp_load_scr(blank);
+    _ui_screen_delete(&ui_Screen1);
+    values[BENCH_HEART_RATE] = 99;
+    values[BENCH_STEPS] += 100;
+    disp_model_set(model, BENCH_HEART_RATE, values[BENCH_HEART_RATE]);
+    disp_model_set(model, BENCH_STEPS, values[BENCH_STEPS]);
+    disp_model_apply(model);
+    disp_model_stats_t st;
+    disp_model_get_stats(model, &st, false);
+    if (st.bindings != 0 || st.label_updates != before.label_updates) {
+        ESP_LOGE(TAG, "%" PRIu32 " bindings left after the watch face was deleted", st.bindings);
+        failures++;
+    }
+    bench_screen_new();
+    bench_bind(model);
+    lv_obj_del(blank);
+    failures += bench_check_texts("model rebuilt", values);
+
+    // A step count past the range of its arc, and past int16_t, keeps the arc full
+    const int32_t steps_max = lv_arc_get_max_value(ui_Arc7);
+    const int32_t steps[] = {steps_max + 1, INT16_MAX + 1, steps_max};
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        disp_model_set(model, BENCH_STEPS, steps[i]);
+        disp_model_apply(model);
+        if (lv_arc_get_value(ui_Arc7) != steps_max) {
+            ESP_LOGE(TAG, "%" PRId32 " steps show the arc at %d, expected it full at %" PRId32, steps[i],
+                     lv_arc_get_value(ui_Arc7), steps_max);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    int seconds = 60;
+    int fps = 30;
+    const char *mode = "both";
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+            seconds = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--fps") && i + 1 < argc) {
+            fps = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--mode") && i + 1 < argc) {
+            mode = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--seconds N] [--fps N] [--mode queue|model|both]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (fps < 1) {
+        fps = 1;
+    }
+
+    lv_init();
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf1[BENCH_H_RES * BENCH_BUF_ROWS];
+    lv_disp_draw_buf_init(&draw_buf, buf1, NULL, BENCH_H_RES * BENCH_BUF_ROWS);
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = BENCH_H_RES;
+    disp_drv.ver_res = BENCH_V_RES;
+    disp_drv.flush_cb = bench_flush_cb;
+    disp_drv.monitor_cb = bench_monitor_cb;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_drv_register(&disp_drv);
+    ui_init();
+    lv_disp_load_scr(ui_Screen1);
+
+    int failures = 0;
+    int runs = 0;
+    bench_result_t res[2];
+    if (!strcmp(mode, "queue") || !strcmp(mode, "both")) {
+        failures += bench_run(false, seconds, fps, &res[runs++]);
+    }
+    if (!strcmp(mode, "model") || !strcmp(mode, "both")) {
+        // From the SquareLine texts again
+        lv_obj_t *blank = lv_obj_create(NULL);
+        lv_disp_load_scr(blank);
+        _ui_screen_delete(&ui_Screen1);
+        bench_screen_new();
+        lv_obj_del(blank);
+        failures += bench_run(true, seconds, fps, &res[runs++]);
+    }
+
+    printf("%d s at %d fps\n", seconds, fps);
+    printf("%-6s %8s %13s %12s %13s %7s %10s %9s\n", "mode", "readings", "label_updates", "apply_allocs",
+           "render_allocs", "frames", "px/frame", "apply_us");
+    for (int i = 0; i < runs; i++) {
+        printf("%-6s %8" PRIu32 " %13" PRIu32 " %12" PRIu32 " %13" PRIu32 " %7" PRIu32 " %10.0f %9.1f\n",
+               res[i].mode, res[i].readings, res[i].label_updates, res[i].apply_allocs, res[i].render_allocs,
+               res[i].frames,
+               res[i].frames ? (double)res[i].px / res[i].frames : 0.0,
+               (double)res[i].apply_us / (seconds * fps));
+    }
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
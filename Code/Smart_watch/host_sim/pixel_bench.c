@@ -0,0 +1,228 @@
+/*
+ * Pixel kernel benchmark: compares the pixel_conv kernels with the per-pixel loops they replace,
+ * checks that both produce the same bytes and reports the cost per pixel. The rotations are timed
+ * on a block 368 pixels wide, as tall as --pixels allows.
+ *
+ *   pixel_bench [--pixels N] [--iterations N]
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_timer.h"
+#include "pixel_conv.h"
+
+// One LVGL draw buffer, EXAMPLE_LCD_H_RES * EXAMPLE_LVGL_BUF_HEIGHT
+#define BENCH_DEFAULT_PIXELS (368 * 112)
+// Width of the rotated block, EXAMPLE_LCD_H_RES
+#define BENCH_ROTATE_WIDTH 368
+
+static size_t pixels = BENCH_DEFAULT_PIXELS;
+static int iterations = 200;
+static int failures;
+
+// The loop example_lvgl_flush_cb used for 24-bit panels, one byte store per channel
+static void ref_xrgb8888_to_rgb888(uint8_t *dst, const uint32_t *src, size_t n)
+{
+    const uint8_t *in = (const uint8_t *)src;
+    for (size_t i = 0; i < n; i++) {
+        const uint8_t b = in[i * 4], g = in[i * 4 + 1], r = in[i * 4 + 2];
+        dst[i * 3] = r;
+        dst[i * 3 + 1] = g;
+        dst[i * 3 + 2] = b;
+    }
+}
+
+static void ref_rgb565_swap(uint16_t *dst, const uint16_t *src, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = (uint16_t)((src[i] << 8) | (src[i] >> 8));
+    }
+}
+
+static void ref_rgb565_to_rgb666(uint8_t *dst, const uint16_t *src, size_t n, bool src_swapped)
+{
+    for (size_t i = 0; i < n; i++) {
+        uint16_t v = src_swapped ? (uint16_t)((src[i] << 8) | (src[i] >> 8)) : src[i];
+        uint8_t r = (v >> 11) & 0x1f, g = (v >> 5) & 0x3f, b = v & 0x1f;
+        dst[i * 3] = (uint8_t)(((r << 1) | (r >> 4)) << 2);
+        dst[i * 3 + 1] = (uint8_t)(g << 2);
+        dst[i * 3 + 2] = (uint8_t)(((b << 1) | (b >> 4)) << 2);
+    }
+}
+
+// The loops of LVGL's draw_buf_rotate_90/180, one pixel at a time along the destination rows
+static void ref_rotate_rgb565(uint16_t *dst, const uint16_t *src, size_t stride, size_t w, size_t h, pixel_conv_rotation_t rot)
+{
+    const size_t out_w = (rot == PIXEL_CONV_ROTATE_90 || rot == PIXEL_CONV_ROTATE_270) ? h : w;
+    const size_t out_h = w * h / out_w;
+    for (size_t r = 0; r < out_h; r++) {
+        for (size_t c = 0; c < out_w; c++) {
+            size_t sx = c, sy = r;
+            switch (rot) {
+            case PIXEL_CONV_ROTATE_90:
+                sx = w - 1 - r;
+                sy = c;
+                break;
+            case PIXEL_CONV_ROTATE_180:
+                sx = w - 1 - c;
+                sy = h - 1 - r;
+                break;
+            case PIXEL_CONV_ROTATE_270:
+                sx = r;
+                sy = h - 1 - c;
+                break;
+            default:
+                break;
+            }
+            dst[r * out_w + c] = src[sy * stride + sx];
+        }
+    }
+}
+
+static void check(const char *name, const void *a, const void *b, size_t len)
+{
+    if (memcmp(a, b, len) != 0) {
+        printf("MISMATCH in %s\n", name);
+        failures++;
+    }
+}
+
+static void report(const char *name, int64_t ref_us, int64_t kern_us, size_t px, size_t bytes_out)
+{
+    const double n = (double)px * iterations;
+    printf("%-22s %9.2f %9.2f %8.2fx %10.1f\n", name, ref_us * 1e3 / n, kern_us * 1e3 / n,
+           kern_us ? (double)ref_us / kern_us : 0.0, kern_us ? bytes_out * (double)iterations / kern_us : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--pixels") && i + 1 < argc) {
+            pixels = strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--pixels N] [--iterations N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    uint32_t *src32 = malloc(pixels * 4);
+    uint32_t *work32 = malloc(pixels * 4);
+    uint16_t *src16 = malloc(pixels * 2);
+    uint8_t *ref = malloc(pixels * 4);
+    uint8_t *out = malloc(pixels * 4);
+    if (!src32 || !work32 || !src16 || !ref || !out) {
+        return 1;
+    }
+    srand(1);
+    for (size_t i = 0; i < pixels; i++) {
+        src32[i] = (uint32_t)rand() ^ ((uint32_t)rand() << 16);
+        src16[i] = (uint16_t)rand();
+    }
+
+    printf("backend: %s, %zu pixels x %d iterations\n", pixel_conv_backend(), pixels, iterations);
+    printf("%-22s %9s %9s %9s %10s\n", "kernel", "ref_ns/px", "ns/px", "speedup", "MB/s out");
+
+    // Correctness, including unaligned heads and odd tails
+    for (size_t off = 0; off < 4; off++) {
+        const size_t n = pixels - off - 3;
+        ref_xrgb8888_to_rgb888(ref, src32 + off, n);
+        pixel_conv_xrgb8888_to_rgb888(out + off, src32 + off, n);
+        check("xrgb8888_to_rgb888", ref, out + off, n * 3);
+        memcpy(work32, src32, pixels * 4);
+        pixel_conv_xrgb8888_to_rgb888((uint8_t *)(work32 + off), work32 + off, n);
+        check("xrgb8888_to_rgb888 in place", ref, work32 + off, n * 3);
+
+        ref_rgb565_swap((uint16_t *)ref, src16 + off, n);
+        pixel_conv_rgb565_swap((uint16_t *)out, src16 + off, n);
+        check("rgb565_swap", ref, out, n * 2);
+
+        for (int sw = 0; sw < 2; sw++) {
+            ref_rgb565_to_rgb666(ref, src16 + off, n, sw);
+            pixel_conv_rgb565_to_rgb666(out + off, src16 + off, n, sw);
+            check("rgb565_to_rgb666", ref, out + off, n * 3);
+        }
+    }
+
+    // Rotations of odd, even and strided blocks, from aligned and unaligned starts
+    static const size_t rot_sizes[][2] = {{2, 2}, {16, 16}, {46, 112}, {368, 34}, {17, 33}, {5, 1}, {40, 7}};
+    static const char *rot_names[] = {"rotate_0", "rotate_90", "rotate_180", "rotate_270"};
+    for (size_t s = 0; s < sizeof(rot_sizes) / sizeof(rot_sizes[0]); s++) {
+        for (size_t off = 0; off < 2; off++) {
+            const size_t w = rot_sizes[s][0], h = rot_sizes[s][1], stride = w + 6 * off;
+            for (int rot = PIXEL_CONV_ROTATE_0; rot <= PIXEL_CONV_ROTATE_270; rot++) {
+                ref_rotate_rgb565((uint16_t *)ref, src16 + off, stride, w, h, rot);
+                pixel_conv_rotate_rgb565((uint16_t *)out, src16 + off, stride, w, h, rot);
+                check(rot_names[rot], ref, out, w * h * 2);
+            }
+        }
+    }
+
+    int64_t t0, ref_us, kern_us;
+
+    t0 = esp_timer_get_time();
+    for (int it = 0; it < iterations; it++) {
+        ref_xrgb8888_to_rgb888(out, src32, pixels);
+    }
+    ref_us = esp_timer_get_time() - t0;
+    t0 = esp_timer_get_time();
+    for (int it = 0; it < iterations; it++) {
+        pixel_conv_xrgb8888_to_rgb888(out, src32, pixels);
+    }
+    kern_us = esp_timer_get_time() - t0;
+    report("xrgb8888_to_rgb888", ref_us, kern_us, pixels, pixels * 3);
+
+    t0 = esp_timer_get_time();
+    for (int it = 0; it < iterations; it++) {
+        ref_rgb565_swap((uint16_t *)out, src16, pixels);
+    }
+    ref_us = esp_timer_get_time() - t0;
+    t0 = esp_timer_get_time();
+    for (int it = 0; it < iterations; it++) {
+        pixel_conv_rgb565_swap((uint16_t *)out, src16, pixels);
+    }
+    kern_us = esp_timer_get_time() - t0;
+    report("rgb565_swap", ref_us, kern_us, pixels, pixels * 2);
+
+    t0 = esp_timer_get_time();
+    for (int it = 0; it < iterations; it++) {
+        ref_rgb565_to_rgb666(out, src16, pixels, true);
+    }
+    ref_us = esp_timer_get_time() - t0;
+    t0 = esp_timer_get_time();
+    for (int it = 0; it < iterations; it++) {
+        pixel_conv_rgb565_to_rgb666(out, src16, pixels, true);
+    }
+    kern_us = esp_timer_get_time() - t0;
+    report("rgb565_to_rgb666", ref_us, kern_us, pixels, pixels * 3);
+
+    const size_t rot_h = (pixels / BENCH_ROTATE_WIDTH) & ~(size_t)1;
+    const size_t rot_px = BENCH_ROTATE_WIDTH * rot_h;
+    for (int rot = PIXEL_CONV_ROTATE_90; rot <= PIXEL_CONV_ROTATE_270 && rot_px; rot++) {
+        t0 = esp_timer_get_time();
+        for (int it = 0; it < iterations; it++) {
+            ref_rotate_rgb565((uint16_t *)out, src16, BENCH_ROTATE_WIDTH, BENCH_ROTATE_WIDTH, rot_h, rot);
+        }
+        ref_us = esp_timer_get_time() - t0;
+        t0 = esp_timer_get_time();
+        for (int it = 0; it < iterations; it++) {
+            pixel_conv_rotate_rgb565((uint16_t *)out, src16, BENCH_ROTATE_WIDTH, BENCH_ROTATE_WIDTH, rot_h, rot);
+        }
+        kern_us = esp_timer_get_time() - t0;
+        report(rot_names[rot], ref_us, kern_us, rot_px, rot_px * 2);
+    }
+
+    free(src32);
+    free(work32);
+    free(src16);
+    free(ref);
+    free(out);
+    if (failures) {
+        printf("%d mismatches\n", failures);
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,189 @@
+/*
+ * Render benchmark: runs the lv_demo_benchmark scenes through disp_bench, once with LVGL blending
+ * on its own and once with disp_par splitting the large blends with a worker task.
+ *
+ *   render_bench [--scene N] [--count N] [--min-px N] [--check]
+ *
+ * Prints the refreshes per second of refresh time of every scene in both modes, the gain and the
+ * share of the blended pixels that were split. The host has no second core to give the worker, so the
+ * timing shows the hand-over overhead rather than the speedup the ESP32-S3 gets.
+ * --check renders every scene once on one core and once split, with its animations stopped, and
+ * compares the two frames pixel by pixel; it exits non-zero if any differs.
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lvgl.h"
+#include "benchmark/lv_demo_benchmark.h"
+
+#include "disp_bench.h"
+#include "disp_par.h"
+
+#define BENCH_H_RES             368
+#define BENCH_V_RES             448
+#define BENCH_BUF_ROWS          (BENCH_V_RES / 4)
+
+static const char *TAG = "render_bench";
+
+static lv_color_t frame[BENCH_H_RES * BENCH_V_RES];
+static bool bench_done;
+static int bench_status;
+
+static void bench_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    const int w = lv_area_get_width(area);
+    for (int y = area->y1; y <= area->y2; y++) {
+        memcpy(&frame[y * BENCH_H_RES + area->x1], color_map, w * sizeof(lv_color_t));
+        color_map += w;
+    }
+    lv_disp_flush_ready(drv);
+}
+
+static uint32_t fps(const disp_bench_result_t *res, int mode)
+{
+    return res->refr_us[mode] ? (uint32_t)(res->frames[mode] * 1000000ULL / res->refr_us[mode]) : 0;
+}
+
+static void bench_done_cb(const disp_bench_result_t *results, size_t count, void *user_ctx)
+{
+    printf("\n%-5s %-34s %7s %9s %7s %9s %6s %7s\n", "scene", "name", "frames", "fps_1core", "frames",
+           "fps_split", "gain", "split%");
+    uint64_t us[2] = {0};
+    uint64_t frames[2] = {0};
+    for (size_t i = 0; i < count; i++) {
+        const disp_bench_result_t *res = &results[i];
+        const uint32_t fps0 = fps(res, 0);
+        const uint32_t fps1 = fps(res, 1);
+        printf("%-5d %-34s %7" PRIu32 " %9" PRIu32 " %7" PRIu32 " %9" PRIu32 " %+5.1f%% %6" PRIu32 "%%\n",
+               res->scene, res->name, res->frames[0], fps0, res->frames[1], fps1,
+               fps0 ? (fps1 - (double)fps0) * 100.0 / fps0 : 0.0, res->split_pct);
+        for (int m = 0; m < 2; m++) {
+            us[m] += res->refr_us[m];
+            frames[m] += res->frames[m];
+        }
+    }
+    printf("%-5s %-34s %7" PRIu64 " %9" PRIu64 " %7" PRIu64 " %9" PRIu64 "\n", "all", "", frames[0],
+           us[0] ? frames[0] * 1000000 / us[0] : 0, frames[1], us[1] ? frames[1] * 1000000 / us[1] : 0);
+    bench_status = count > 0 ? 0 : 1;
+    bench_done = true;
+}
+
+// Refresh the whole screen right away
+static void refresh_all(lv_disp_t *disp)
+{
+    lv_obj_invalidate(lv_disp_get_scr_act(disp));
+    lv_refr_now(disp);
+}
+
+// Render every scene on one core and split, and compare the frames
+static int run_check(lv_disp_t *disp, disp_par_handle_t par, int first, int count)
+{
+    static lv_color_t single[BENCH_H_RES * BENCH_V_RES];
+    int failed = 0;
+    int checked = 0;
+    lv_disp_load_scr(lv_obj_create(NULL));
+    for (int scene = first; count == 0 || scene < first + count; scene++) {
+        lv_demo_benchmark_run_scene(scene);
+        lv_obj_t *title = lv_obj_get_child(lv_disp_get_scr_act(disp), 0);
+        int n = 0;
+        int total = 0;
+        char name[DISP_BENCH_NAME_LEN];
+        if (title == NULL || sscanf(lv_label_get_text(title), "%d/%d: %39[^\n]", &n, &total, name) != 3) {
+            lv_demo_benchmark_close();
+            break;
+        }
+        // lv_refr_now runs the animations too, stop them so both renders see the same frame
+        lv_anim_del(NULL, NULL);
+
+        disp_par_set_enabled(par, false);
+        refresh_all(disp);
+        memcpy(single, frame, sizeof(frame));
+        disp_par_set_enabled(par, true);
+        disp_par_stats_t st;
+        disp_par_get_stats(par, &st, true);
+        refresh_all(disp);
+        disp_par_get_stats(par, &st, true);
+        lv_demo_benchmark_close();
+
+        uint32_t diff = 0;
+        for (size_t i = 0; i < sizeof(frame) / sizeof(frame[0]); i++) {
+            diff += single[i].full != frame[i].full;
+        }
+        printf("%-5d %-34s %6" PRIu32 " split of %6" PRIu32 " blends, %3" PRIu64 "%% px, %s\n", scene, name,
+               st.split, st.blends, st.px ? st.split_px * 100 / st.px : 0, diff ? "DIFFERENT" : "same");
+        if (diff) {
+            printf("      %" PRIu32 " pixels differ\n", diff);
+            failed++;
+        }
+        checked++;
+    }
+    printf("%d scenes checked, %d different\n", checked, failed);
+    return failed || checked == 0 ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    int first = 0;
+    int count = 0;
+    uint32_t min_px = 0;
+    bool check = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--scene") && i + 1 < argc) {
+            first = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--count") && i + 1 < argc) {
+            count = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--min-px") && i + 1 < argc) {
+            min_px = strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--check")) {
+            check = true;
+        } else {
+            fprintf(stderr, "usage: %s [--scene N] [--count N] [--min-px N] [--check]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    lv_init();
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf1[BENCH_H_RES * BENCH_BUF_ROWS];
+    static lv_color_t buf2[BENCH_H_RES * BENCH_BUF_ROWS];
+    lv_disp_draw_buf_init(&draw_buf, buf1, buf2, BENCH_H_RES * BENCH_BUF_ROWS);
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = BENCH_H_RES;
+    disp_drv.ver_res = BENCH_V_RES;
+    disp_drv.flush_cb = bench_flush_cb;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_t *disp = lv_disp_drv_register(&disp_drv);
+
+    const disp_par_config_t par_config = {
+        .min_px = min_px,
+        .task_priority = 3,
+        .task_core = 1,
+    };
+    disp_par_handle_t par = NULL;
+    ESP_ERROR_CHECK(disp_par_new(&par_config, &par));
+    ESP_ERROR_CHECK(disp_par_attach(par, disp));
+
+    if (check) {
+        return run_check(disp, par, first, count);
+    }
+
+    const disp_bench_config_t bench_config = {
+        .par = par,
+        .first_scene = first,
+        .scene_count = count,
+        .on_done = bench_done_cb,
+    };
+    ESP_ERROR_CHECK(disp_bench_start(&bench_config, disp));
+    while (!bench_done) {
+        const uint32_t ms = lv_timer_handler();
+        usleep((ms == LV_NO_TIMER_READY ? 1 : ms) * 1000);
+    }
+    ESP_LOGI(TAG, "done");
+    return bench_status;
+}
@@ -0,0 +1,241 @@
+/*
+ * Screen build benchmark: what the SquareLine UI costs at boot and in RAM, once with every screen built up front
+ * and kept (EXAMPLE_USE_SCREEN_MANAGER 0) and once with screens built on their first load through disp_screens,
+ * which deletes the least recently shown ones past a heap budget.
+ *
+ *   screen_bench [--budget-kb N] [--rounds N]
+ *
+ * LVGL allocates from the modelled heaps of the shim, so the sizes are what the widgets, their styles and
+ * LVGL's own buffers take (the allocator overhead of the watch is not modelled). The eager part prints the
+ * build time and heap of every screen, then deletes them all with _ui_screen_delete and checks their heap comes
+ * back. The lazy part boots with --budget-kb (default DISP_SCREENS_DEFAULT_BUDGET) and walks --rounds times
+ * (default 3) through the screens along the gestures of ui.c, with their load animations: it prints the
+ * builds, evictions and loads per screen, the highest resident heap and how long a screen change takes when it
+ * has to build the screen and when the screen is still there.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lvgl.h"
+#include "ui.h"
+
+#include "disp_screens.h"
+
+#define BENCH_H_RES             368
+#define BENCH_V_RES             448
+#define BENCH_BUF_ROWS          (BENCH_V_RES / 4)
+// Heap a screen deleted may not give back, LVGL keeps some of it in caches (e.g. the last image header)
+#define BENCH_LEAK_TOLERANCE    256
+
+static const char *TAG = "screen_bench";
+
+typedef struct {
+    const char *name;
+    lv_obj_t **scr;
+    void (*init)(void);
+    lv_scr_load_anim_t anim;    // of the gesture that leads to the screen
+} bench_screen_t;
+
+static const bench_screen_t screens[] = {
+    {"Screen1", &ui_Screen1, ui_Screen1_screen_init, LV_SCR_LOAD_ANIM_OVER_RIGHT},
+    {"Screen2", &ui_Screen2, ui_Screen2_screen_init, LV_SCR_LOAD_ANIM_OVER_LEFT},
+    {"Screen3", &ui_Screen3, ui_Screen3_screen_init, LV_SCR_LOAD_ANIM_OVER_RIGHT},
+    {"Screen4", &ui_Screen4, ui_Screen4_screen_init, LV_SCR_LOAD_ANIM_OVER_BOTTOM},
+    {"Screen5", &ui_Screen5, ui_Screen5_screen_init, LV_SCR_LOAD_ANIM_OVER_TOP},
+    {"Screen6", &ui_Screen6, ui_Screen6_screen_init, LV_SCR_LOAD_ANIM_OVER_RIGHT},
+};
+#define BENCH_SCREENS (sizeof(screens) / sizeof(screens[0]))
+
+// One round on the watch: each side screen from the watch face and back, Screen6 through Screen4
+static const int walk[] = {1, 0, 2, 0, 3, 5, 3, 0, 4, 0};
+
+static void bench_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    lv_disp_flush_ready(drv);
+}
+
+static size_t bench_heap_used(void)
+{
+    return heap_caps_get_total_size(MALLOC_CAP_INTERNAL) - heap_caps_get_free_size(MALLOC_CAP_INTERNAL) +
+           heap_caps_get_total_size(MALLOC_CAP_SPIRAM) - heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+}
+
+// Run LVGL until the screen load animation is over and the deletions it queued are done
+static void bench_settle(void)
+{
+    lv_disp_t *disp = lv_disp_get_default();
+    do {
+        lv_timer_handler();
+    } while (disp->scr_to_load || disp->prev_scr);
+    lv_timer_handler();
+}
+
+// Every screen built at boot, as SquareLine generates it; returns the failures
+static int bench_eager(void)
+{
+    int failures = 0;
+    printf("eager: every screen built at boot\n");
+    printf("%-8s %9s %9s\n", "screen", "build_us", "heap_kb");
+    const size_t heap0 = bench_heap_used();
+    const int64_t t0 = esp_timer_get_time();
+    ui_init();
+    for (size_t i = 0; i < BENCH_SCREENS; i++) {
+        const size_t heap = bench_heap_used();
+        const int64_t t = esp_timer_get_time();
+        _ui_screen_build(screens[i].scr, screens[i].init);
+        // ui_init built Screen1 already
+        if (i > 0) {
+            printf("%-8s %9lld %9.1f\n", screens[i].name, (long long)(esp_timer_get_time() - t),
+                   (bench_heap_used() - heap) / 1024.0);
+        }
+    }
+    const int64_t boot_us = esp_timer_get_time() - t0;
+    const size_t boot_heap = bench_heap_used() - heap0;
+    printf("eager boot: %lld us, %.1f kB of heap (Screen1 with ui_init)\n", (long long)boot_us, boot_heap / 1024.0);
+
+    // Back to nothing and round again: a screen built and deleted must give all its heap back
+    lv_obj_t *blank = lv_obj_create(NULL);
+    lv_disp_load_scr(blank);
+    size_t heap_deleted = 0;
+    for (int cycle = 0; cycle < 2; cycle++) {
+        const size_t heap_built = bench_heap_used();
+        for (size_t i = 0; i < BENCH_SCREENS; i++) {
+            _ui_screen_delete(screens[i].scr);
+            if (*screens[i].scr != NULL) {
+                ESP_LOGE(TAG, "_ui_screen_delete left %s", screens[i].name);
+                failures++;
+            }
+        }
+        lv_timer_handler();
+        if (cycle == 0) {
+            heap_deleted = bench_heap_used();
+            printf("deleted all screens: %.1f kB freed\n", (heap_built - heap_deleted) / 1024.0);
+            for (size_t i = 0; i < BENCH_SCREENS; i++) {
+                _ui_screen_build(screens[i].scr, screens[i].init);
+            }
+        } else if (bench_heap_used() > heap_deleted + BENCH_LEAK_TOLERANCE) {
+            ESP_LOGE(TAG, "building and deleting every screen leaks %u bytes",
+                     (unsigned)(bench_heap_used() - heap_deleted));
+            failures++;
+        }
+    }
+    // `blank` stays on display until the lazy part loads Screen1
+    return failures;
+}
+
+// Screens built on their first load and deleted past the budget; returns the failures
+static int bench_lazy(size_t budget_bytes, int rounds)
+{
+    int failures = 0;
+    disp_screens_handle_t mgr = NULL;
+    const disp_screens_config_t config = {
+        .budget_bytes = budget_bytes,
+    };
+    ESP_ERROR_CHECK(disp_screens_new(&config, &mgr));
+    for (size_t i = 0; i < BENCH_SCREENS; i++) {
+        ESP_ERROR_CHECK(disp_screens_add(mgr, screens[i].name, screens[i].scr));
+    }
+    _ui_screen_set_build_cb(disp_screens_build, mgr);
+
+    printf("\nlazy: screens built on their first load, budget %.1f kB\n", budget_bytes / 1024.0);
+    const size_t heap0 = bench_heap_used();
+    const int64_t t0 = esp_timer_get_time();
+    _ui_screen_build(&ui_Screen1, ui_Screen1_screen_init);
+    lv_disp_load_scr(ui_Screen1);
+    const int64_t boot_us = esp_timer_get_time() - t0;
+    printf("lazy boot: %lld us, %.1f kB of heap\n", (long long)boot_us, (bench_heap_used() - heap0) / 1024.0);
+    bench_settle();
+
+    uint64_t cold_us = 0, warm_us = 0;
+    uint32_t cold = 0, warm = 0, max_cold_us = 0, max_warm_us = 0;
+    size_t max_heap = 0;
+    for (int r = 0; r < rounds; r++) {
+        for (size_t w = 0; w < sizeof(walk) / sizeof(walk[0]); w++) {
+            const bench_screen_t *s = &screens[walk[w]];
+            const bool built = *s->scr != NULL;
+            const int64_t t = esp_timer_get_time();
+            _ui_screen_change(s->scr, s->anim, 100, 10, s->init);
+            const uint32_t us = (uint32_t)(esp_timer_get_time() - t);
+            if (built) {
+                warm++;
+                warm_us += us;
+                max_warm_us = us > max_warm_us ? us : max_warm_us;
+            } else {
+                cold++;
+                cold_us += us;
+                max_cold_us = us > max_cold_us ? us : max_cold_us;
+            }
+            bench_settle();
+            if (lv_scr_act() != *s->scr) {
+                ESP_LOGE(TAG, "%s is not on display", s->name);
+                failures++;
+            }
+            const size_t heap = bench_heap_used() - heap0;
+            max_heap = heap > max_heap ? heap : max_heap;
+            // Once the load is over, only the screen on display may take the built ones over the budget
+            disp_screens_stats_t st;
+            disp_screens_get_stats(mgr, &st, false);
+            if (st.resident_bytes > budget_bytes && st.resident_bytes > st.screens[walk[w]].heap_bytes) {
+                ESP_LOGE(TAG, "on %s: %u bytes resident, budget %u", s->name, (unsigned)st.resident_bytes,
+                         (unsigned)budget_bytes);
+                failures++;
+            }
+        }
+    }
+
+    disp_screens_stats_t st;
+    disp_screens_get_stats(mgr, &st, false);
+    printf("%-8s %6s %6s %9s %6s %9s %9s\n", "screen", "loads", "builds", "evictions", "built", "build_us", "heap_kb");
+    for (size_t i = 0; i < st.count; i++) {
+        const disp_screens_screen_t *s = &st.screens[i];
+        printf("%-8s %6u %6u %9u %6s %9u %9.1f\n", s->name, s->loads, s->builds, s->evictions, s->built ? "yes" : "no",
+               s->max_build_us, s->heap_bytes / 1024.0);
+    }
+    printf("resident: %.1f kB now, %.1f kB at most (heap %.1f kB at most)\n", st.resident_bytes / 1024.0,
+           st.max_resident_bytes / 1024.0, max_heap / 1024.0);
+    printf("screen change: %u building, avg %.0f us (max %u), %u found built, avg %.0f us (max %u)\n", cold,
+           cold ? (double)cold_us / cold : 0.0, max_cold_us, warm, warm ? (double)warm_us / warm : 0.0, max_warm_us);
+    _ui_screen_set_build_cb(NULL, NULL);
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    size_t budget_bytes = DISP_SCREENS_DEFAULT_BUDGET;
+    int rounds = 3;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--budget-kb") && i + 1 < argc) {
+            budget_bytes = (size_t)atoi(argv[++i]) * 1024;
+        } else if (!strcmp(argv[i], "--rounds") && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--budget-kb N] [--rounds N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (budget_bytes == 0) {
+        budget_bytes = 1;
+    }
+
+    lv_init();
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf1[BENCH_H_RES * BENCH_BUF_ROWS];
+    lv_disp_draw_buf_init(&draw_buf, buf1, NULL, BENCH_H_RES * BENCH_BUF_ROWS);
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = BENCH_H_RES;
+    disp_drv.ver_res = BENCH_V_RES;
+    disp_drv.flush_cb = bench_flush_cb;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_drv_register(&disp_drv);
+
+    int failures = bench_eager();
+    failures += bench_lazy(budget_bytes, rounds);
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
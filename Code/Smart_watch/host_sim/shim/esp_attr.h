@@ -0,0 +1,19 @@
+/*
+ * Host shim for esp_attr.h, placement attributes have no meaning on the host.
+ */
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define EXT_RAM_BSS_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
+
+#ifndef BIT
+#define BIT(nr) (1UL << (nr))
+#endif
+
+#ifndef BIT64
+#define BIT64(nr) (1ULL << (nr))
+#endif
@@ -0,0 +1,50 @@
+/*
+ * Host shim for esp_heap_caps.h. Allocations come from the libc heap but are charged to one of two
+ * modelled heaps, PSRAM for MALLOC_CAP_SPIRAM and internal RAM otherwise, so code that sizes its
+ * buffers from the free memory sees the budget of the watch. Fragmentation is not modelled: the
+ * largest free block is the free size.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MALLOC_CAP_EXEC             (1 << 0)
+#define MALLOC_CAP_32BIT            (1 << 1)
+#define MALLOC_CAP_8BIT             (1 << 2)
+#define MALLOC_CAP_DMA              (1 << 3)
+#define MALLOC_CAP_SPIRAM           (1 << 10)
+#define MALLOC_CAP_INTERNAL         (1 << 11)
+#define MALLOC_CAP_DEFAULT          (1 << 12)
+
+void *heap_caps_malloc(size_t size, uint32_t caps);
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps);
+void *heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps);
+void heap_caps_free(void *ptr);
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+size_t heap_caps_get_total_size(uint32_t caps);
+
+// Default modelled heaps: internal RAM left to the application after boot, and the 8 MB octal PSRAM
+#define HEAP_CAPS_SIM_INTERNAL_SIZE (320 * 1024)
+#define HEAP_CAPS_SIM_SPIRAM_SIZE (8 * 1024 * 1024)
+
+// Host only: resize the modelled heap `caps` selects, e.g. to benchmark with less internal RAM
+void heap_caps_sim_set_total_size(uint32_t caps, size_t size);
+
+// Host only: malloc of the watch (CONFIG_SPIRAM_USE_MALLOC) charged to the modelled heaps, LVGL allocates with
+// it so the memory the widgets take shows in the free sizes. Blocks up to CONFIG_SPIRAM_MALLOC_ALWAYSINTERNAL
+// bytes come from internal RAM, larger ones from PSRAM, each falling back to the other heap.
+void *heap_caps_sim_malloc(size_t size);
+void *heap_caps_sim_realloc(void *ptr, size_t size);
+// Host only: heap_caps_sim_malloc and heap_caps_sim_realloc calls so far, e.g. to count what LVGL allocates
+uint32_t heap_caps_sim_get_alloc_count(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,32 @@
+/*
+ * Host shim for esp_lcd_panel_vendor.h
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_lcd_types.h"
+#include "esp_lcd_panel_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int reset_gpio_num;
+    union {
+        lcd_rgb_element_order_t color_space;
+        lcd_rgb_element_order_t rgb_endian;
+        lcd_rgb_element_order_t rgb_ele_order;
+    };
+    uint32_t bits_per_pixel;
+    struct {
+        unsigned int reset_active_high: 1;
+    } flags;
+    void *vendor_config;
+} esp_lcd_panel_dev_config_t;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,46 @@
+/*
+ * Host shim for esp_log.h, prints to stderr. Debug and verbose levels are compiled out.
+ */
+#pragma once
+
+#include <stdio.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+int esp_log_level_enabled(esp_log_level_t level);
+
+#define ESP_LOG_SHIM_(lvl, c, tag, fmt, ...) do {                                   \
+        if (esp_log_level_enabled(lvl)) {                                           \
+            fprintf(stderr, c " (%s) " fmt "\n", tag, ##__VA_ARGS__);               \
+        }                                                                           \
+    } while (0)
+
+#define ESP_LOGE(tag, fmt, ...) ESP_LOG_SHIM_(ESP_LOG_ERROR, "E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) ESP_LOG_SHIM_(ESP_LOG_WARN, "W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) ESP_LOG_SHIM_(ESP_LOG_INFO, "I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) ESP_LOG_SHIM_(ESP_LOG_DEBUG, "D", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...) ESP_LOG_SHIM_(ESP_LOG_VERBOSE, "V", tag, fmt, ##__VA_ARGS__)
+
+#define ESP_EARLY_LOGE ESP_LOGE
+#define ESP_EARLY_LOGW ESP_LOGW
+#define ESP_EARLY_LOGI ESP_LOGI
+#define ESP_DRAM_LOGE  ESP_LOGE
+#define ESP_DRAM_LOGW  ESP_LOGW
+
+#ifdef __cplusplus
+}
+#endif
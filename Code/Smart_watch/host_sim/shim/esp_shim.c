@@ -0,0 +1,628 @@
+/*
+ * Host implementations behind the ESP-IDF shim headers.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_lcd_panel_io_interface.h"
+#include "esp_lcd_panel_interface.h"
+#include "esp_lcd_panel_ops.h"
+#include "driver/gpio.h"
+
+static esp_log_level_t s_log_level = ESP_LOG_INFO;
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_CRC: return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_INVALID_VERSION: return "ESP_ERR_INVALID_VERSION";
+    default: return "UNKNOWN ERROR";
+    }
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    // Per-tag levels are not modelled, "*" sets the global level
+    if (strcmp(tag, "*") == 0) {
+        s_log_level = level;
+    }
+}
+
+int esp_log_level_enabled(esp_log_level_t level)
+{
+    return level <= s_log_level;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    static int64_t s_start_us = -1;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    int64_t now = (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    if (s_start_us < 0) {
+        s_start_us = now;
+    }
+    return now - s_start_us;
+}
+
+struct esp_timer {
+    esp_timer_create_args_t args;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool armed;
+    bool periodic;
+    bool quit;
+    uint64_t period_us;
+    int64_t deadline_us;
+    uint32_t generation;    // bumped by start/stop so a sleeping thread notices the change
+};
+
+static void esp_timer_abs_time(int64_t us, struct timespec *ts)
+{
+    // esp_timer_get_time counts from its first call, convert back to CLOCK_MONOTONIC
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const int64_t delta = us - esp_timer_get_time();
+    int64_t ns = (int64_t)now.tv_nsec + delta * 1000;
+    ts->tv_sec = now.tv_sec + ns / 1000000000;
+    ns %= 1000000000;
+    if (ns < 0) {
+        ns += 1000000000;
+        ts->tv_sec--;
+    }
+    ts->tv_nsec = ns;
+}
+
+static void *esp_timer_thread(void *arg)
+{
+    esp_timer_handle_t timer = arg;
+    pthread_mutex_lock(&timer->lock);
+    while (!timer->quit) {
+        if (!timer->armed) {
+            pthread_cond_wait(&timer->cond, &timer->lock);
+            continue;
+        }
+        const uint32_t generation = timer->generation;
+        struct timespec ts;
+        esp_timer_abs_time(timer->deadline_us, &ts);
+        if (pthread_cond_timedwait(&timer->cond, &timer->lock, &ts) != ETIMEDOUT || generation != timer->generation ||
+                !timer->armed) {
+            continue;
+        }
+        if (timer->periodic) {
+            timer->deadline_us += timer->period_us;
+            if (timer->args.skip_unhandled_events && timer->deadline_us < esp_timer_get_time()) {
+                timer->deadline_us = esp_timer_get_time() + timer->period_us;
+            }
+        } else {
+            timer->armed = false;
+        }
+        pthread_mutex_unlock(&timer->lock);
+        timer->args.callback(timer->args.arg);
+        pthread_mutex_lock(&timer->lock);
+    }
+    pthread_mutex_unlock(&timer->lock);
+    return NULL;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if (!create_args || !create_args->callback || !out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_timer_handle_t timer = calloc(1, sizeof(*timer));
+    if (!timer) {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->args = *create_args;
+    pthread_mutex_init(&timer->lock, NULL);
+    // Deadlines are CLOCK_MONOTONIC (esp_timer_abs_time), so must the wait be
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&timer->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    if (pthread_create(&timer->thread, NULL, esp_timer_thread, timer) != 0) {
+        free(timer);
+        return ESP_ERR_NO_MEM;
+    }
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+static esp_err_t esp_timer_arm(esp_timer_handle_t timer, uint64_t us, bool periodic)
+{
+    pthread_mutex_lock(&timer->lock);
+    if (timer->armed) {
+        pthread_mutex_unlock(&timer->lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed = true;
+    timer->periodic = periodic;
+    timer->period_us = us;
+    timer->deadline_us = esp_timer_get_time() + us;
+    timer->generation++;
+    pthread_cond_signal(&timer->cond);
+    pthread_mutex_unlock(&timer->lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return esp_timer_arm(timer, timeout_us, false);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    return esp_timer_arm(timer, period, true);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    pthread_mutex_lock(&timer->lock);
+    const bool armed = timer->armed;
+    timer->armed = false;
+    timer->generation++;
+    pthread_cond_signal(&timer->cond);
+    pthread_mutex_unlock(&timer->lock);
+    return armed ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    pthread_mutex_lock(&timer->lock);
+    timer->quit = true;
+    pthread_cond_signal(&timer->cond);
+    pthread_mutex_unlock(&timer->lock);
+    pthread_join(timer->thread, NULL);
+    pthread_cond_destroy(&timer->cond);
+    pthread_mutex_destroy(&timer->lock);
+    free(timer);
+    return ESP_OK;
+}
+
+// Modelled heaps, [0] internal RAM and [1] PSRAM
+static struct {
+    size_t total;
+    size_t used;
+} s_heaps[2] = {{HEAP_CAPS_SIM_INTERNAL_SIZE, 0}, {HEAP_CAPS_SIM_SPIRAM_SIZE, 0}};
+static pthread_mutex_t s_heap_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Stored right before every allocation
+typedef struct {
+    void *base;
+    size_t size;
+    int heap;
+} heap_caps_hdr_t;
+
+static int heap_caps_select(uint32_t caps)
+{
+    return (caps & MALLOC_CAP_SPIRAM) ? 1 : 0;
+}
+
+void *heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps)
+{
+    const int heap = heap_caps_select(caps);
+    if (alignment < sizeof(void *)) {
+        alignment = sizeof(void *);
+    }
+    pthread_mutex_lock(&s_heap_lock);
+    if (s_heaps[heap].used + size > s_heaps[heap].total) {
+        pthread_mutex_unlock(&s_heap_lock);
+        return NULL;
+    }
+    s_heaps[heap].used += size;
+    pthread_mutex_unlock(&s_heap_lock);
+
+    uint8_t *base = malloc(sizeof(heap_caps_hdr_t) + alignment + size);
+    if (!base) {
+        pthread_mutex_lock(&s_heap_lock);
+        s_heaps[heap].used -= size;
+        pthread_mutex_unlock(&s_heap_lock);
+        return NULL;
+    }
+    uintptr_t ptr = (uintptr_t)base + sizeof(heap_caps_hdr_t);
+    ptr = (ptr + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    heap_caps_hdr_t *hdr = (heap_caps_hdr_t *)ptr - 1;
+    hdr->base = base;
+    hdr->size = size;
+    hdr->heap = heap;
+    return (void *)ptr;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    return heap_caps_aligned_alloc(16, size, caps);
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    void *ptr = heap_caps_malloc(n * size, caps);
+    if (ptr) {
+        memset(ptr, 0, n * size);
+    }
+    return ptr;
+}
+
+void heap_caps_free(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+    heap_caps_hdr_t *hdr = (heap_caps_hdr_t *)ptr - 1;
+    pthread_mutex_lock(&s_heap_lock);
+    s_heaps[hdr->heap].used -= hdr->size;
+    pthread_mutex_unlock(&s_heap_lock);
+    free(hdr->base);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    const int heap = heap_caps_select(caps);
+    pthread_mutex_lock(&s_heap_lock);
+    const size_t free_size = s_heaps[heap].total - s_heaps[heap].used;
+    pthread_mutex_unlock(&s_heap_lock);
+    return free_size;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    return heap_caps_get_free_size(caps);
+}
+
+size_t heap_caps_get_total_size(uint32_t caps)
+{
+    return s_heaps[heap_caps_select(caps)].total;
+}
+
+static _Atomic uint32_t s_sim_allocs;
+
+void *heap_caps_sim_malloc(size_t size)
+{
+    atomic_fetch_add(&s_sim_allocs, 1);
+#ifdef CONFIG_SPIRAM_MALLOC_ALWAYSINTERNAL
+    const bool internal = size <= CONFIG_SPIRAM_MALLOC_ALWAYSINTERNAL;
+#else
+    const bool internal = true;
+#endif
+    void *ptr = heap_caps_malloc(size, internal ? MALLOC_CAP_INTERNAL : MALLOC_CAP_SPIRAM);
+    return ptr ? ptr : heap_caps_malloc(size, internal ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL);
+}
+
+void *heap_caps_sim_realloc(void *ptr, size_t size)
+{
+    if (!ptr) {
+        return heap_caps_sim_malloc(size);
+    }
+    if (size == 0) {
+        heap_caps_free(ptr);
+        return NULL;
+    }
+    void *new_ptr = heap_caps_sim_malloc(size);
+    if (new_ptr) {
+        const heap_caps_hdr_t *hdr = (const heap_caps_hdr_t *)ptr - 1;
+        memcpy(new_ptr, ptr, hdr->size < size ? hdr->size : size);
+        heap_caps_free(ptr);
+    }
+    return new_ptr;
+}
+
+uint32_t heap_caps_sim_get_alloc_count(void)
+{
+    return atomic_load(&s_sim_allocs);
+}
+
+void heap_caps_sim_set_total_size(uint32_t caps, size_t size)
+{
+    pthread_mutex_lock(&s_heap_lock);
+    s_heaps[heap_caps_select(caps)].total = size;
+    pthread_mutex_unlock(&s_heap_lock);
+}
+
+// Partitions backed by files
+#define ESP_PARTITION_SIM_MAX 4
+static struct {
+    esp_partition_t part;
+    int fd;
+} s_partitions[ESP_PARTITION_SIM_MAX];
+static size_t s_partition_count;
+
+// Mappings by handle - 1
+#define ESP_PARTITION_SIM_MAPS 8
+static struct {
+    void *ptr;
+    size_t size;
+} s_maps[ESP_PARTITION_SIM_MAPS];
+
+esp_err_t esp_partition_sim_add_file(const char *label, esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                     const char *path)
+{
+    if (!label || !path || strlen(label) >= sizeof(s_partitions[0].part.label)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_partition_count == ESP_PARTITION_SIM_MAX) {
+        return ESP_ERR_NO_MEM;
+    }
+    const int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_partition_t *part = &s_partitions[s_partition_count].part;
+    memset(part, 0, sizeof(*part));
+    part->type = type;
+    part->subtype = subtype;
+    part->size = (uint32_t)st.st_size;
+    part->erase_size = 4096;
+    part->readonly = true;
+    strcpy(part->label, label);
+    s_partitions[s_partition_count++].fd = fd;
+    return ESP_OK;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    for (size_t i = 0; i < s_partition_count && i < ESP_PARTITION_SIM_MAX; i++) {
+        const esp_partition_t *part = &s_partitions[i].part;
+        if ((type == ESP_PARTITION_TYPE_ANY || part->type == type) &&
+            (subtype == ESP_PARTITION_SUBTYPE_ANY || part->subtype == subtype) &&
+            (!label || !strcmp(part->label, label))) {
+            return part;
+        }
+    }
+    return NULL;
+}
+
+static int esp_partition_sim_fd(const esp_partition_t *partition)
+{
+    for (size_t i = 0; i < s_partition_count; i++) {
+        if (&s_partitions[i].part == partition) {
+            return s_partitions[i].fd;
+        }
+    }
+    return -1;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    const int fd = esp_partition_sim_fd(partition);
+    if (fd < 0 || !dst || src_offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return pread(fd, dst, size, (off_t)src_offset) == (ssize_t)size ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t *partition, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void **out_ptr,
+                             esp_partition_mmap_handle_t *out_handle)
+{
+    const int fd = esp_partition_sim_fd(partition);
+    if (fd < 0 || !out_ptr || !out_handle || size == 0 || offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < ESP_PARTITION_SIM_MAPS; i++) {
+        if (s_maps[i].ptr) {
+            continue;
+        }
+        // Like the MMU, map whole pages and point into them
+        const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        const size_t base = offset / page * page;
+        void *ptr = mmap(NULL, size + offset - base, PROT_READ, MAP_PRIVATE, fd, (off_t)base);
+        if (ptr == MAP_FAILED) {
+            return ESP_ERR_NO_MEM;
+        }
+        s_maps[i].ptr = ptr;
+        s_maps[i].size = size + offset - base;
+        *out_ptr = (const uint8_t *)ptr + offset - base;
+        *out_handle = (esp_partition_mmap_handle_t)(i + 1);
+        return ESP_OK;
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+void esp_partition_munmap(esp_partition_mmap_handle_t handle)
+{
+    if (handle == 0 || handle > ESP_PARTITION_SIM_MAPS || !s_maps[handle - 1].ptr) {
+        return;
+    }
+    munmap(s_maps[handle - 1].ptr, s_maps[handle - 1].size);
+    s_maps[handle - 1].ptr = NULL;
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, uint8_t const *buf, uint32_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+esp_err_t gpio_config(const gpio_config_t *cfg)
+{
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    return 0;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num)
+{
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags)
+{
+    return ESP_OK;
+}
+
+// ISR handlers by GPIO, called by simulated devices
+#define GPIO_SIM_PINS 49
+static struct {
+    gpio_isr_t handler;
+    void *arg;
+    bool enabled;
+} s_gpio_isr[GPIO_SIM_PINS];
+static pthread_mutex_t s_gpio_lock = PTHREAD_MUTEX_INITIALIZER;
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args)
+{
+    if (gpio_num < 0 || gpio_num >= GPIO_SIM_PINS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_gpio_lock);
+    s_gpio_isr[gpio_num].handler = isr_handler;
+    s_gpio_isr[gpio_num].arg = args;
+    pthread_mutex_unlock(&s_gpio_lock);
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num)
+{
+    return gpio_isr_handler_add(gpio_num, NULL, NULL);
+}
+
+static esp_err_t gpio_sim_set_intr(gpio_num_t gpio_num, bool enabled)
+{
+    if (gpio_num < 0 || gpio_num >= GPIO_SIM_PINS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_gpio_lock);
+    s_gpio_isr[gpio_num].enabled = enabled;
+    pthread_mutex_unlock(&s_gpio_lock);
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num)
+{
+    return gpio_sim_set_intr(gpio_num, true);
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num)
+{
+    return gpio_sim_set_intr(gpio_num, false);
+}
+
+void gpio_sim_raise_isr(gpio_num_t gpio_num)
+{
+    if (gpio_num < 0 || gpio_num >= GPIO_SIM_PINS) {
+        return;
+    }
+    pthread_mutex_lock(&s_gpio_lock);
+    const gpio_isr_t handler = s_gpio_isr[gpio_num].enabled ? s_gpio_isr[gpio_num].handler : NULL;
+    void *arg = s_gpio_isr[gpio_num].arg;
+    pthread_mutex_unlock(&s_gpio_lock);
+    if (handler) {
+        handler(arg);
+    }
+}
+
+esp_err_t esp_lcd_panel_io_rx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, void *param, size_t param_size)
+{
+    return io->rx_param ? io->rx_param(io, lcd_cmd, param, param_size) : ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_lcd_panel_io_tx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *param, size_t param_size)
+{
+    return io->tx_param(io, lcd_cmd, param, param_size);
+}
+
+esp_err_t esp_lcd_panel_io_tx_color(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *color, size_t color_size)
+{
+    return io->tx_color(io, lcd_cmd, color, color_size);
+}
+
+esp_err_t esp_lcd_panel_io_del(esp_lcd_panel_io_handle_t io)
+{
+    return io->del(io);
+}
+
+esp_err_t esp_lcd_panel_io_register_event_callbacks(esp_lcd_panel_io_handle_t io, const esp_lcd_panel_io_callbacks_t *cbs, void *user_ctx)
+{
+    return io->register_event_callbacks(io, cbs, user_ctx);
+}
+
+esp_err_t esp_lcd_panel_reset(esp_lcd_panel_handle_t panel)
+{
+    return panel->reset(panel);
+}
+
+esp_err_t esp_lcd_panel_init(esp_lcd_panel_handle_t panel)
+{
+    return panel->init(panel);
+}
+
+esp_err_t esp_lcd_panel_del(esp_lcd_panel_handle_t panel)
+{
+    return panel->del(panel);
+}
+
+esp_err_t esp_lcd_panel_draw_bitmap(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end, const void *color_data)
+{
+    return panel->draw_bitmap(panel, x_start, y_start, x_end, y_end, color_data);
+}
+
+esp_err_t esp_lcd_panel_mirror(esp_lcd_panel_handle_t panel, bool mirror_x, bool mirror_y)
+{
+    return panel->mirror ? panel->mirror(panel, mirror_x, mirror_y) : ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_lcd_panel_swap_xy(esp_lcd_panel_handle_t panel, bool swap_axes)
+{
+    return panel->swap_xy ? panel->swap_xy(panel, swap_axes) : ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_lcd_panel_set_gap(esp_lcd_panel_handle_t panel, int x_gap, int y_gap)
+{
+    return panel->set_gap ? panel->set_gap(panel, x_gap, y_gap) : ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_lcd_panel_invert_color(esp_lcd_panel_handle_t panel, bool invert_color_data)
+{
+    return panel->invert_color ? panel->invert_color(panel, invert_color_data) : ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_lcd_panel_disp_on_off(esp_lcd_panel_handle_t panel, bool on_off)
+{
+    return panel->disp_on_off ? panel->disp_on_off(panel, on_off) : ESP_ERR_NOT_SUPPORTED;
+}
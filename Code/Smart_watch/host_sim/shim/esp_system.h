@@ -0,0 +1,9 @@
+/*
+ * Host shim for esp_system.h. The touch drivers include it and then use heap_caps_calloc, which on target
+ * comes in through the FreeRTOS port headers.
+ */
+#pragma once
+
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
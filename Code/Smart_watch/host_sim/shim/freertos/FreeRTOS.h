@@ -0,0 +1,60 @@
+/*
+ * Host shim for FreeRTOS.h, ticks are milliseconds (CONFIG_FREERTOS_HZ=1000).
+ * Tasks are pthreads, queues and semaphores are mutex + condition variable objects;
+ * priorities are recorded but not enforced by the host scheduler.
+ */
+#pragma once
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_attr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE             0
+#define pdTRUE              1
+#define pdPASS              pdTRUE
+#define pdFAIL              pdFALSE
+#define errQUEUE_FULL       0
+#define portMAX_DELAY       ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ  1000
+#define portTICK_PERIOD_MS  ((TickType_t)1)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+#define pdTICKS_TO_MS(t)    ((uint32_t)(t))
+#define tskNO_AFFINITY      (0x7fffffff)
+#define portNUM_PROCESSORS  2
+#define configMAX_PRIORITIES 25
+
+#define portYIELD_FROM_ISR(x)   ((void)(x))
+#define portYIELD()             sched_yield_shim()
+
+void sched_yield_shim(void);
+
+// Critical sections guard data shared with ISRs; on the host the "ISRs" are threads, so a mutex does.
+// A zeroed portMUX_TYPE is an unlocked mutex, so drivers that only set `owner` work unchanged.
+typedef struct {
+    pthread_mutex_t mutex;
+    uint32_t owner;
+} portMUX_TYPE;
+
+#define portMUX_FREE_VAL                0xB33FFFFF
+
+#define portMUX_INITIALIZER_UNLOCKED    {PTHREAD_MUTEX_INITIALIZER, portMUX_FREE_VAL}
+#define portMUX_INITIALIZE(mux)         pthread_mutex_init(&(mux)->mutex, NULL)
+#define portENTER_CRITICAL(mux)         pthread_mutex_lock(&(mux)->mutex)
+#define portEXIT_CRITICAL(mux)          pthread_mutex_unlock(&(mux)->mutex)
+#define portENTER_CRITICAL_ISR(mux)     portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux)      portEXIT_CRITICAL(mux)
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,471 @@
+/*
+ * Host implementations behind the FreeRTOS shim headers.
+ *
+ * Every queue, semaphore and mutex is one `shim_queue_t`: a ring of fixed-size items protected by
+ * a pthread mutex with two condition variables. Semaphores use zero-size items, so only the count
+ * matters. Tasks are detached pthreads; "ISR" variants are the non-blocking calls.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+struct shim_task_t {
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+    char name[16];
+    UBaseType_t priority;
+    BaseType_t core_id;
+    pthread_mutex_t notify_lock;
+    pthread_cond_t notify_cond;
+    uint32_t notify_value;
+};
+
+struct shim_queue_t {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    uint8_t *storage;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t count;
+    UBaseType_t head;
+    bool is_mutex;
+    TaskHandle_t holder;
+};
+
+static __thread TaskHandle_t s_current_task;
+
+void sched_yield_shim(void)
+{
+    sched_yield();
+}
+
+static void cond_init_monotonic(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static void ticks_to_deadline(TickType_t ticks, struct timespec *deadline)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += ticks / 1000;
+    deadline->tv_nsec += (long)(ticks % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+// Wait on `cond` until `ready(q)` holds; called and returns with `lock` held
+static bool wait_until(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks, bool (*ready)(const void *), const void *obj)
+{
+    if (ready(obj)) {
+        return true;
+    }
+    if (ticks == 0) {
+        return false;
+    }
+    struct timespec deadline;
+    ticks_to_deadline(ticks, &deadline);
+    while (!ready(obj)) {
+        if (ticks == portMAX_DELAY) {
+            pthread_cond_wait(cond, lock);
+        } else if (pthread_cond_timedwait(cond, lock, &deadline) == ETIMEDOUT) {
+            return ready(obj);
+        }
+    }
+    return true;
+}
+
+/* Tasks */
+
+static TaskHandle_t task_self(void)
+{
+    if (!s_current_task) {
+        // Threads not created through xTaskCreate (e.g. main) get a handle on first use
+        TaskHandle_t task = calloc(1, sizeof(struct shim_task_t));
+        assert(task);
+        task->thread = pthread_self();
+        strcpy(task->name, "main");
+        task->priority = 1;
+        task->core_id = 0;
+        pthread_mutex_init(&task->notify_lock, NULL);
+        cond_init_monotonic(&task->notify_cond);
+        s_current_task = task;
+    }
+    return s_current_task;
+}
+
+static void *task_trampoline(void *arg)
+{
+    TaskHandle_t task = arg;
+    s_current_task = task;
+    task->fn(task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *created_task, BaseType_t core_id)
+{
+    (void)stack_depth;
+    TaskHandle_t task = calloc(1, sizeof(struct shim_task_t));
+    if (!task) {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    strncpy(task->name, name ? name : "", sizeof(task->name) - 1);
+    task->priority = priority;
+    task->core_id = core_id == tskNO_AFFINITY ? 0 : core_id;
+    pthread_mutex_init(&task->notify_lock, NULL);
+    cond_init_monotonic(&task->notify_cond);
+    if (created_task) {
+        *created_task = task;
+    }
+    if (pthread_create(&task->thread, NULL, task_trampoline, task) != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *created_task)
+{
+    return xTaskCreatePinnedToCore(fn, name, stack_depth, arg, priority, created_task, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    // Only self-deletion is supported, which is the only form used by the firmware; the handle is freed as
+    // FreeRTOS frees the TCB
+    if (task == NULL || task == s_current_task) {
+        task = s_current_task;
+        s_current_task = NULL;
+        if (task) {
+            pthread_mutex_destroy(&task->notify_lock);
+            pthread_cond_destroy(&task->notify_cond);
+            free(task);
+        }
+        pthread_exit(NULL);
+    }
+}
+
+void vTaskDelay(const TickType_t ticks_to_delay)
+{
+    struct timespec ts = {
+        .tv_sec = ticks_to_delay / 1000,
+        .tv_nsec = (long)(ticks_to_delay % 1000) * 1000000L,
+    };
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return task_self();
+}
+
+char *pcTaskGetName(TaskHandle_t task)
+{
+    return (task ? task : task_self())->name;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+    return (task ? task : task_self())->priority;
+}
+
+BaseType_t xPortGetCoreID(void)
+{
+    return task_self()->core_id;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->notify_lock);
+    task->notify_value++;
+    pthread_cond_signal(&task->notify_cond);
+    pthread_mutex_unlock(&task->notify_lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_prio_task_woken)
+{
+    xTaskNotifyGive(task);
+    if (higher_prio_task_woken) {
+        *higher_prio_task_woken = pdTRUE;
+    }
+}
+
+static bool notify_ready(const void *obj)
+{
+    return ((const struct shim_task_t *)obj)->notify_value != 0;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+    TaskHandle_t self = task_self();
+    pthread_mutex_lock(&self->notify_lock);
+    wait_until(&self->notify_cond, &self->notify_lock, ticks_to_wait, notify_ready, self);
+    uint32_t value = self->notify_value;
+    if (value) {
+        self->notify_value = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&self->notify_lock);
+    return value;
+}
+
+/* Queues */
+
+static bool queue_not_empty(const void *obj)
+{
+    return ((const struct shim_queue_t *)obj)->count > 0;
+}
+
+static bool queue_not_full(const void *obj)
+{
+    const struct shim_queue_t *q = obj;
+    return q->count < q->length;
+}
+
+static QueueHandle_t queue_create(UBaseType_t length, UBaseType_t item_size, UBaseType_t initial_count)
+{
+    QueueHandle_t q = calloc(1, sizeof(struct shim_queue_t));
+    if (!q) {
+        return NULL;
+    }
+    if (item_size) {
+        q->storage = calloc(length, item_size);
+        if (!q->storage) {
+            free(q);
+            return NULL;
+        }
+    }
+    pthread_mutex_init(&q->lock, NULL);
+    cond_init_monotonic(&q->not_empty);
+    cond_init_monotonic(&q->not_full);
+    q->length = length;
+    q->item_size = item_size;
+    q->count = initial_count;
+    return q;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    return queue_create(length, item_size, 0);
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    if (!queue) {
+        return;
+    }
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_cond_destroy(&queue->not_full);
+    free(queue->storage);
+    free(queue);
+}
+
+static BaseType_t queue_send(QueueHandle_t q, const void *item, TickType_t ticks, bool to_front)
+{
+    pthread_mutex_lock(&q->lock);
+    if (!wait_until(&q->not_full, &q->lock, ticks, queue_not_full, q)) {
+        pthread_mutex_unlock(&q->lock);
+        return errQUEUE_FULL;
+    }
+    if (q->item_size) {
+        UBaseType_t slot;
+        if (to_front) {
+            q->head = (q->head + q->length - 1) % q->length;
+            slot = q->head;
+        } else {
+            slot = (q->head + q->count) % q->length;
+        }
+        memcpy(q->storage + slot * q->item_size, item, q->item_size);
+    }
+    q->count++;
+    if (q->is_mutex) {
+        q->holder = NULL;
+    }
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+    return pdPASS;
+}
+
+static BaseType_t queue_receive(QueueHandle_t q, void *item, TickType_t ticks, bool peek)
+{
+    pthread_mutex_lock(&q->lock);
+    if (!wait_until(&q->not_empty, &q->lock, ticks, queue_not_empty, q)) {
+        pthread_mutex_unlock(&q->lock);
+        return pdFALSE;
+    }
+    if (q->item_size && item) {
+        memcpy(item, q->storage + q->head * q->item_size, q->item_size);
+    }
+    if (!peek) {
+        if (q->item_size) {
+            q->head = (q->head + 1) % q->length;
+        }
+        q->count--;
+        if (q->is_mutex) {
+            q->holder = task_self();
+        }
+        pthread_cond_signal(&q->not_full);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+    return queue_send(queue, item, ticks_to_wait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+    return queue_send(queue, item, ticks_to_wait, true);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+    return queue_receive(queue, item, ticks_to_wait, false);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+    return queue_receive(queue, item, ticks_to_wait, true);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *higher_prio_task_woken)
+{
+    BaseType_t ret = queue_send(queue, item, 0, false);
+    if (higher_prio_task_woken && ret == pdPASS) {
+        *higher_prio_task_woken = pdTRUE;
+    }
+    return ret;
+}
+
+BaseType_t xQueueReceiveFromISR(QueueHandle_t queue, void *item, BaseType_t *higher_prio_task_woken)
+{
+    BaseType_t ret = queue_receive(queue, item, 0, false);
+    if (higher_prio_task_woken && ret == pdTRUE) {
+        *higher_prio_task_woken = pdTRUE;
+    }
+    return ret;
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item)
+{
+    pthread_mutex_lock(&queue->lock);
+    if (queue->count == 0) {
+        queue->count = 1;
+    }
+    if (queue->item_size) {
+        memcpy(queue->storage + queue->head * queue->item_size, item, queue->item_size);
+    }
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    queue->count = 0;
+    queue->head = 0;
+    pthread_cond_broadcast(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t spaces = queue->length - queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return spaces;
+}
+
+/* Semaphores */
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return queue_create(1, 0, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+    return queue_create(max_count, 0, initial_count);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t mutex = queue_create(1, 0, 1);
+    if (mutex) {
+        mutex->is_mutex = true;
+    }
+    return mutex;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks_to_wait)
+{
+    return queue_receive(sem, NULL, ticks_to_wait, false);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    return queue_send(sem, NULL, 0, false);
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *higher_prio_task_woken)
+{
+    return xQueueSendFromISR(sem, NULL, higher_prio_task_woken);
+}
+
+BaseType_t xSemaphoreTakeFromISR(SemaphoreHandle_t sem, BaseType_t *higher_prio_task_woken)
+{
+    return xQueueReceiveFromISR(sem, NULL, higher_prio_task_woken);
+}
+
+TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t mutex)
+{
+    pthread_mutex_lock(&mutex->lock);
+    TaskHandle_t holder = mutex->holder;
+    pthread_mutex_unlock(&mutex->lock);
+    return holder;
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t sem)
+{
+    return uxQueueMessagesWaiting(sem);
+}
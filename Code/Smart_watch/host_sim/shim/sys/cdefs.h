@@ -0,0 +1,12 @@
+/*
+ * Host shim: newlib's sys/cdefs.h provides __containerof, glibc's does not.
+ */
+#pragma once
+
+#include_next <sys/cdefs.h>
+
+#include <stddef.h>
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+#endif
@@ -0,0 +1,600 @@
+/*
+ * Host-side SH8601 AMOLED simulator.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_check.h"
+#include "esp_lcd_panel_io_interface.h"
+#include "esp_lcd_panel_commands.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_sh8601.h"
+
+#include "sim_lcd_sh8601.h"
+#include "sim_png.h"
+
+#define SIM_OPCODE_WRITE_CMD        (0x02)
+#define SIM_OPCODE_WRITE_COLOR      (0x32)
+#define SIM_DEFAULT_PCLK_HZ         (40 * 1000 * 1000)
+// SH8601 brightness register
+#define SIM_CMD_BRIGHTNESS          (0x51)
+// Command and 24 bit address phase, always on one data line
+#define SIM_CMD_PHASE_CLOCKS        (32)
+
+static const char *TAG = "sim_sh8601";
+
+typedef struct sim_lcd_t {
+    esp_lcd_panel_io_t base;
+    int h_res;
+    int v_res;
+    uint32_t pclk_hz;
+    uint32_t trans_overhead_ns;
+    esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done;
+    void *user_ctx;
+    pthread_mutex_t lock;
+    // Realtime bus: one color transfer in flight, completed by bus_thread at its deadline
+    bool realtime_bus;
+    bool bus_stop;
+    bool inflight;
+    struct timespec inflight_deadline;
+    pthread_cond_t bus_cond;
+    pthread_t bus_thread;
+    // TE: the scan line restarts at row 0 every te_period_ns, counted from te_epoch_ns
+    uint64_t te_period_ns;
+    int64_t te_epoch_ns;
+    sim_lcd_te_cb_t te_cb;
+    void *te_ctx;
+    pthread_t te_thread;
+    // Controller state decoded from the command stream
+    uint8_t madctl;
+    uint8_t colmod;
+    int caset[2];
+    int raset[2];
+    int win[4];             // x1, y1, x2, y2 latched by the last RAMWR
+    bool win_valid;
+    int wr_x;
+    int wr_y;
+    uint8_t partial_pixel[3];
+    int partial_len;
+    bool partial;           // PTLON: only rows ptlar[0]..ptlar[1] are lit
+    bool idle;              // IDMON: 8 colors, each channel reduced to its MSB
+    int ptlar[2];
+    uint8_t brightness;
+    uint8_t *frame;         // RGB888 frame memory, the glass in normal mode
+    uint8_t *glass;         // RGB888 as lit on the glass, built on demand
+    sim_lcd_stats_t cur;
+    sim_lcd_stats_t total;
+} sim_lcd_t;
+
+static uint64_t sim_account(sim_lcd_t *sim, uint64_t bytes, uint64_t clocks)
+{
+    uint64_t ns = clocks * 1000000000ULL / sim->pclk_hz + sim->trans_overhead_ns;
+    sim->cur.transactions++;
+    sim->cur.bytes += bytes;
+    sim->cur.bus_time_ns += ns;
+    return ns;
+}
+
+static int64_t sim_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void sim_deadline_after(struct timespec *ts, uint64_t ns)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += ns / 1000000000ULL;
+    ts->tv_nsec += ns % 1000000000ULL;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+// Wait for the color transfer in flight, called with the lock held
+static void sim_bus_wait_idle(sim_lcd_t *sim)
+{
+    while (sim->inflight) {
+        pthread_cond_wait(&sim->bus_cond, &sim->lock);
+    }
+}
+
+// Parameter writes are polling transactions, the caller is busy for the whole transfer
+static void sim_bus_busy_wait(uint64_t ns)
+{
+    struct timespec deadline, now;
+    sim_deadline_after(&deadline, ns);
+    do {
+        sched_yield();
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    } while (now.tv_sec < deadline.tv_sec || (now.tv_sec == deadline.tv_sec && now.tv_nsec < deadline.tv_nsec));
+}
+
+static void *sim_bus_thread(void *arg)
+{
+    sim_lcd_t *sim = arg;
+    pthread_mutex_lock(&sim->lock);
+    while (1) {
+        while (!sim->inflight && !sim->bus_stop) {
+            pthread_cond_wait(&sim->bus_cond, &sim->lock);
+        }
+        if (sim->bus_stop) {
+            break;
+        }
+        struct timespec deadline = sim->inflight_deadline;
+        esp_lcd_panel_io_color_trans_done_cb_t cb = sim->on_color_trans_done;
+        void *ctx = sim->user_ctx;
+        pthread_mutex_unlock(&sim->lock);
+
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+        }
+        // Like the SPI ISR, the callback runs before the next transaction can start
+        if (cb) {
+            cb(&sim->base, NULL, ctx);
+        }
+
+        pthread_mutex_lock(&sim->lock);
+        sim->inflight = false;
+        pthread_cond_broadcast(&sim->bus_cond);
+    }
+    pthread_mutex_unlock(&sim->lock);
+    return NULL;
+}
+
+static void *sim_te_thread(void *arg)
+{
+    sim_lcd_t *sim = arg;
+    for (uint64_t n = 1;; n++) {
+        const int64_t edge = sim->te_epoch_ns + (int64_t)(n * sim->te_period_ns);
+        const struct timespec ts = {.tv_sec = edge / 1000000000LL, .tv_nsec = edge % 1000000000LL};
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        }
+        pthread_mutex_lock(&sim->lock);
+        const bool stop = sim->bus_stop;
+        sim_lcd_te_cb_t cb = sim->te_cb;
+        void *ctx = sim->te_ctx;
+        pthread_mutex_unlock(&sim->lock);
+        if (stop) {
+            break;
+        }
+        if (cb) {
+            cb(ctx);
+        }
+    }
+    return NULL;
+}
+
+// The writer moves linearly from row w0 at t0 to row w1 at t1, the scan line from row 0 to v_res every TE period.
+// Rows are shown half old, half new when the two lines cross while the transfer is in progress.
+static bool sim_te_crossed(const sim_lcd_t *sim, int64_t t0, int64_t t1, double w0, double w1)
+{
+    const int64_t period = (int64_t)sim->te_period_ns;
+    if (t0 < sim->te_epoch_ns || t1 <= t0) {
+        return false;
+    }
+    for (int64_t t = t0; t < t1;) {
+        const int64_t k = (t - sim->te_epoch_ns) / period;
+        const int64_t refresh = sim->te_epoch_ns + k * period;
+        const int64_t end = refresh + period < t1 ? refresh + period : t1;
+        const double b0 = (double)(t - refresh) * sim->v_res / period;
+        const double b1 = (double)(end - refresh) * sim->v_res / period;
+        const double wa = w0 + (w1 - w0) * (t - t0) / (t1 - t0);
+        const double wb = w0 + (w1 - w0) * (end - t0) / (t1 - t0);
+        if ((b0 < wa) != (b1 < wb)) {
+            return true;
+        }
+        t = end;
+    }
+    return false;
+}
+
+static int sim_pixel_bytes(const sim_lcd_t *sim)
+{
+    // COLMOD 0x55 is RGB565, 0x66 and 0x77 use three bytes per pixel
+    return (sim->colmod & 0x0f) == 0x05 ? 2 : 3;
+}
+
+static void sim_put_pixel(sim_lcd_t *sim, const uint8_t *px)
+{
+    uint8_t r, g, b;
+    if (sim_pixel_bytes(sim) == 2) {
+        // RGB565 goes over the wire high byte first
+        uint16_t v = (px[0] << 8) | px[1];
+        r = ((v >> 11) & 0x1f) * 255 / 31;
+        g = ((v >> 5) & 0x3f) * 255 / 63;
+        b = (v & 0x1f) * 255 / 31;
+    } else {
+        r = px[0];
+        g = px[1];
+        b = px[2];
+        if ((sim->colmod & 0x0f) == 0x06) {
+            // RGB666 keeps the six high bits of every byte
+            r &= 0xfc;
+            g &= 0xfc;
+            b &= 0xfc;
+        }
+    }
+    if (sim->madctl & LCD_CMD_BGR_BIT) {
+        uint8_t t = r;
+        r = b;
+        b = t;
+    }
+
+    if (sim->wr_y > sim->win[3]) {
+        // The controller wraps to the window start, the host most likely sent too much data
+        sim->cur.protocol_errors++;
+        sim->wr_y = sim->win[1];
+    }
+    int x = sim->wr_x;
+    int y = sim->wr_y;
+    if (sim->madctl & LCD_CMD_MX_BIT) {
+        x = sim->h_res - 1 - x;
+    }
+    if (x >= 0 && x < sim->h_res && y >= 0 && y < sim->v_res) {
+        uint8_t *dst = sim->frame + ((size_t)y * sim->h_res + x) * 3;
+        dst[0] = r;
+        dst[1] = g;
+        dst[2] = b;
+        sim->cur.pixels++;
+    } else {
+        sim->cur.protocol_errors++;
+    }
+    if (++sim->wr_x > sim->win[2]) {
+        sim->wr_x = sim->win[0];
+        sim->wr_y++;
+    }
+}
+
+static int sim_decode_cmd(sim_lcd_t *sim, int lcd_cmd, int expected_opcode)
+{
+    int opcode = (lcd_cmd >> 24) & 0xff;
+    if (opcode != expected_opcode || (lcd_cmd & 0xff) != 0) {
+        ESP_LOGW(TAG, "unexpected command word 0x%08x", lcd_cmd);
+        sim->cur.protocol_errors++;
+    }
+    return (lcd_cmd >> 8) & 0xff;
+}
+
+static void sim_start_ram_write(sim_lcd_t *sim, bool restart)
+{
+    int win[4] = {sim->caset[0], sim->raset[0], sim->caset[1], sim->raset[1]};
+    if (!restart) {
+        // RAMWRC continues where the previous write stopped
+        return;
+    }
+    if (!sim->win_valid || memcmp(win, sim->win, sizeof(win)) != 0) {
+        sim->cur.window_switches++;
+    }
+    memcpy(sim->win, win, sizeof(win));
+    sim->win_valid = true;
+    sim->wr_x = win[0];
+    sim->wr_y = win[1];
+    sim->partial_len = 0;
+    sim->cur.ramwr++;
+}
+
+static esp_err_t sim_io_tx_param(esp_lcd_panel_io_t *io, int lcd_cmd, const void *param, size_t param_size)
+{
+    sim_lcd_t *sim = __containerof(io, sim_lcd_t, base);
+    const uint8_t *p = param;
+
+    pthread_mutex_lock(&sim->lock);
+    sim_bus_wait_idle(sim);
+    uint64_t ns = sim_account(sim, 4 + param_size, SIM_CMD_PHASE_CLOCKS + param_size * 8);
+    sim->cur.param_transactions++;
+    int cmd = sim_decode_cmd(sim, lcd_cmd, SIM_OPCODE_WRITE_CMD);
+    switch (cmd) {
+    case LCD_CMD_CASET:
+    case LCD_CMD_RASET:
+        if (param_size != 4) {
+            sim->cur.protocol_errors++;
+            break;
+        }
+        if (cmd == LCD_CMD_CASET) {
+            sim->caset[0] = (p[0] << 8) | p[1];
+            sim->caset[1] = (p[2] << 8) | p[3];
+        } else {
+            sim->raset[0] = (p[0] << 8) | p[1];
+            sim->raset[1] = (p[2] << 8) | p[3];
+        }
+        break;
+    case LCD_CMD_MADCTL:
+        if (param_size >= 1) {
+            sim->madctl = p[0];
+        }
+        break;
+    case LCD_CMD_COLMOD:
+        if (param_size >= 1) {
+            sim->colmod = p[0];
+        }
+        break;
+    case LCD_CMD_PTLAR:
+        if (param_size != 4) {
+            sim->cur.protocol_errors++;
+            break;
+        }
+        sim->ptlar[0] = (p[0] << 8) | p[1];
+        sim->ptlar[1] = (p[2] << 8) | p[3];
+        break;
+    case LCD_CMD_PTLON:
+    case LCD_CMD_NORON:
+        sim->partial = cmd == LCD_CMD_PTLON;
+        break;
+    case LCD_CMD_IDMON:
+    case LCD_CMD_IDMOFF:
+        sim->idle = cmd == LCD_CMD_IDMON;
+        break;
+    case SIM_CMD_BRIGHTNESS:
+        if (param_size >= 1) {
+            sim->brightness = p[0];
+        }
+        break;
+    case LCD_CMD_RAMWR:
+    case LCD_CMD_RAMWRC:
+        // Memory writes without payload through the parameter path only move the pointer
+        sim_start_ram_write(sim, cmd == LCD_CMD_RAMWR);
+        break;
+    default:
+        break;
+    }
+    const bool realtime = sim->realtime_bus;
+    pthread_mutex_unlock(&sim->lock);
+
+    if (realtime) {
+        sim_bus_busy_wait(ns);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sim_io_tx_color(esp_lcd_panel_io_t *io, int lcd_cmd, const void *color, size_t color_size)
+{
+    sim_lcd_t *sim = __containerof(io, sim_lcd_t, base);
+    const uint8_t *p = color;
+
+    pthread_mutex_lock(&sim->lock);
+    sim_bus_wait_idle(sim);
+    uint64_t ns = sim_account(sim, 4 + color_size, SIM_CMD_PHASE_CLOCKS + color_size * 2);
+    sim->cur.color_transactions++;
+    sim->cur.pixel_bytes += color_size;
+    int cmd = sim_decode_cmd(sim, lcd_cmd, SIM_OPCODE_WRITE_COLOR);
+    if (cmd == LCD_CMD_RAMWR || cmd == LCD_CMD_RAMWRC) {
+        sim_start_ram_write(sim, cmd == LCD_CMD_RAMWR);
+        const int row_start = sim->wr_y;
+        const int bpp = sim_pixel_bytes(sim);
+        for (size_t i = 0; i < color_size; i++) {
+            sim->partial_pixel[sim->partial_len++] = p[i];
+            if (sim->partial_len == bpp) {
+                sim_put_pixel(sim, sim->partial_pixel);
+                sim->partial_len = 0;
+            }
+        }
+        if (sim->realtime_bus && sim->te_period_ns) {
+            // The bus starts now that the previous transfer is done, and ends `ns` later
+            const int64_t t0 = sim_now_ns();
+            if (sim_te_crossed(sim, t0, t0 + (int64_t)ns, row_start, sim->wr_x == sim->win[0] ? sim->wr_y : sim->wr_y + 1)) {
+                sim->cur.tears++;
+            }
+        }
+    } else {
+        sim->cur.protocol_errors++;
+    }
+    if (sim->realtime_bus) {
+        // Queued like a DMA transaction, the bus thread reports completion once the modelled time has passed
+        sim->inflight = true;
+        sim_deadline_after(&sim->inflight_deadline, ns);
+        pthread_cond_broadcast(&sim->bus_cond);
+        pthread_mutex_unlock(&sim->lock);
+        return ESP_OK;
+    }
+    esp_lcd_panel_io_color_trans_done_cb_t cb = sim->on_color_trans_done;
+    void *ctx = sim->user_ctx;
+    pthread_mutex_unlock(&sim->lock);
+
+    // The transfer is complete as soon as it is decoded, report it like the SPI ISR would
+    if (cb) {
+        cb(&sim->base, NULL, ctx);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sim_io_register_event_callbacks(esp_lcd_panel_io_t *io, const esp_lcd_panel_io_callbacks_t *cbs, void *user_ctx)
+{
+    sim_lcd_t *sim = __containerof(io, sim_lcd_t, base);
+    pthread_mutex_lock(&sim->lock);
+    sim->on_color_trans_done = cbs->on_color_trans_done;
+    sim->user_ctx = user_ctx;
+    pthread_mutex_unlock(&sim->lock);
+    return ESP_OK;
+}
+
+static esp_err_t sim_io_del(esp_lcd_panel_io_t *io)
+{
+    sim_lcd_t *sim = __containerof(io, sim_lcd_t, base);
+    if (sim->realtime_bus) {
+        pthread_mutex_lock(&sim->lock);
+        sim_bus_wait_idle(sim);
+        sim->bus_stop = true;
+        pthread_cond_broadcast(&sim->bus_cond);
+        pthread_mutex_unlock(&sim->lock);
+        pthread_join(sim->bus_thread, NULL);
+        if (sim->te_period_ns) {
+            pthread_join(sim->te_thread, NULL);
+        }
+    }
+    pthread_cond_destroy(&sim->bus_cond);
+    pthread_mutex_destroy(&sim->lock);
+    free(sim->glass);
+    free(sim->frame);
+    free(sim);
+    return ESP_OK;
+}
+
+esp_err_t sim_lcd_new_panel_sh8601(const sim_lcd_config_t *config, esp_lcd_panel_handle_t *ret_panel, sim_lcd_handle_t *ret_sim)
+{
+    esp_err_t ret = ESP_OK;
+    sim_lcd_t *sim = NULL;
+    ESP_RETURN_ON_FALSE(config && ret_panel && ret_sim && config->h_res > 0 && config->v_res > 0,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    sim = calloc(1, sizeof(sim_lcd_t));
+    ESP_GOTO_ON_FALSE(sim, ESP_ERR_NO_MEM, err, TAG, "no mem for simulator");
+    sim->frame = calloc((size_t)config->h_res * config->v_res, 3);
+    ESP_GOTO_ON_FALSE(sim->frame, ESP_ERR_NO_MEM, err, TAG, "no mem for frame memory");
+    sim->glass = calloc((size_t)config->h_res * config->v_res, 3);
+    ESP_GOTO_ON_FALSE(sim->glass, ESP_ERR_NO_MEM, err, TAG, "no mem for glass");
+    pthread_mutex_init(&sim->lock, NULL);
+    pthread_cond_init(&sim->bus_cond, NULL);
+    sim->h_res = config->h_res;
+    sim->v_res = config->v_res;
+    sim->pclk_hz = config->pclk_hz ? config->pclk_hz : SIM_DEFAULT_PCLK_HZ;
+    sim->trans_overhead_ns = config->trans_overhead_ns;
+    sim->on_color_trans_done = config->on_color_trans_done;
+    sim->user_ctx = config->user_ctx;
+    sim->colmod = 0x55;
+    sim->brightness = 0xff;
+    sim->caset[1] = config->h_res - 1;
+    sim->raset[1] = config->v_res - 1;
+    sim->base.tx_param = sim_io_tx_param;
+    sim->base.tx_color = sim_io_tx_color;
+    sim->base.del = sim_io_del;
+    sim->base.register_event_callbacks = sim_io_register_event_callbacks;
+
+    sh8601_vendor_config_t vendor_config = {
+        .flags = {
+            .use_qspi_interface = 1,
+        },
+    };
+    const esp_lcd_panel_dev_config_t panel_config = {
+        .reset_gpio_num = -1,
+        .rgb_ele_order = LCD_RGB_ELEMENT_ORDER_RGB,
+        .bits_per_pixel = config->bits_per_pixel,
+        .vendor_config = &vendor_config,
+    };
+    ESP_GOTO_ON_ERROR(esp_lcd_new_panel_sh8601(&sim->base, &panel_config, ret_panel), err, TAG, "create panel failed");
+    if (config->realtime_bus) {
+        ESP_GOTO_ON_FALSE(pthread_create(&sim->bus_thread, NULL, sim_bus_thread, sim) == 0, ESP_FAIL, err, TAG,
+                          "create bus thread failed");
+        sim->realtime_bus = true;
+        if (config->te_period_us) {
+            sim->te_period_ns = (uint64_t)config->te_period_us * 1000;
+            sim->te_epoch_ns = sim_now_ns();
+            ESP_GOTO_ON_FALSE(pthread_create(&sim->te_thread, NULL, sim_te_thread, sim) == 0, ESP_FAIL, err, TAG,
+                              "create TE thread failed");
+        }
+    }
+    *ret_sim = sim;
+    return ESP_OK;
+
+err:
+    if (sim) {
+        free(sim->glass);
+        free(sim->frame);
+        free(sim);
+    }
+    return ret;
+}
+
+esp_lcd_panel_io_handle_t sim_lcd_get_io(sim_lcd_handle_t sim)
+{
+    return &sim->base;
+}
+
+esp_err_t sim_lcd_set_te_cb(sim_lcd_handle_t sim, sim_lcd_te_cb_t cb, void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(sim->te_period_ns, ESP_ERR_INVALID_STATE, TAG, "no TE configured");
+    pthread_mutex_lock(&sim->lock);
+    sim->te_cb = cb;
+    sim->te_ctx = user_ctx;
+    pthread_mutex_unlock(&sim->lock);
+    return ESP_OK;
+}
+
+static void sim_stats_add(sim_lcd_stats_t *dst, const sim_lcd_stats_t *src)
+{
+    dst->transactions += src->transactions;
+    dst->param_transactions += src->param_transactions;
+    dst->color_transactions += src->color_transactions;
+    dst->ramwr += src->ramwr;
+    dst->window_switches += src->window_switches;
+    dst->protocol_errors += src->protocol_errors;
+    dst->bytes += src->bytes;
+    dst->pixel_bytes += src->pixel_bytes;
+    dst->pixels += src->pixels;
+    dst->bus_time_ns += src->bus_time_ns;
+    dst->tears += src->tears;
+}
+
+void sim_lcd_end_frame(sim_lcd_handle_t sim, sim_lcd_stats_t *frame, sim_lcd_stats_t *total)
+{
+    pthread_mutex_lock(&sim->lock);
+    sim_bus_wait_idle(sim);
+    sim_stats_add(&sim->total, &sim->cur);
+    if (frame) {
+        *frame = sim->cur;
+    }
+    if (total) {
+        *total = sim->total;
+    }
+    memset(&sim->cur, 0, sizeof(sim->cur));
+    pthread_mutex_unlock(&sim->lock);
+}
+
+const uint8_t *sim_lcd_get_frame(sim_lcd_handle_t sim)
+{
+    return sim->frame;
+}
+
+// Frame memory through the display modes: dark outside the partial area, MSB only per channel in idle mode
+static uint32_t sim_build_glass(sim_lcd_t *sim)
+{
+    uint32_t lit = 0;
+    for (int y = 0; y < sim->v_res; y++) {
+        const size_t row = (size_t)y * sim->h_res * 3;
+        const bool on = !sim->partial || (y >= sim->ptlar[0] && y <= sim->ptlar[1]);
+        for (int i = 0; i < sim->h_res * 3; i += 3) {
+            const uint8_t *src = sim->frame + row + i;
+            uint8_t *dst = sim->glass + row + i;
+            for (int c = 0; c < 3; c++) {
+                uint8_t v = on ? src[c] : 0;
+                if (sim->idle) {
+                    v = (v & 0x80) ? 0xff : 0;
+                }
+                dst[c] = v;
+            }
+            lit += (dst[0] | dst[1] | dst[2]) != 0;
+        }
+    }
+    return lit;
+}
+
+void sim_lcd_get_glass(sim_lcd_handle_t sim, sim_lcd_glass_t *glass)
+{
+    pthread_mutex_lock(&sim->lock);
+    glass->partial = sim->partial;
+    glass->idle = sim->idle;
+    glass->partial_rows[0] = sim->ptlar[0];
+    glass->partial_rows[1] = sim->ptlar[1];
+    glass->brightness = sim->brightness;
+    glass->lit_pixels = sim_build_glass(sim);
+    pthread_mutex_unlock(&sim->lock);
+}
+
+esp_err_t sim_lcd_dump_png(sim_lcd_handle_t sim, const char *path)
+{
+    pthread_mutex_lock(&sim->lock);
+    sim_build_glass(sim);
+    esp_err_t ret = sim_png_write_rgb888(path, sim->glass, sim->h_res, sim->v_res);
+    pthread_mutex_unlock(&sim->lock);
+    return ret;
+}
+
+esp_err_t sim_lcd_del(sim_lcd_handle_t sim)
+{
+    return sim_io_del(&sim->base);
+}
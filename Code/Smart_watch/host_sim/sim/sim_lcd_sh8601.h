@@ -0,0 +1,132 @@
+/*
+ * Host-side SH8601 AMOLED simulator.
+ *
+ * The simulator is a panel IO that decodes the QSPI command stream (opcode 0x02 for parameters,
+ * 0x32 for pixel data) into an in-memory frame memory. `sim_lcd_new_panel_sh8601` puts the real
+ * `esp_lcd_sh8601.c` driver on top of it, so the returned `esp_lcd_panel_handle_t` is a drop-in
+ * replacement for the panel created in `lv_lcdtouch_init` and everything from
+ * `example_lvgl_flush_cb` down to `tx_color` runs unchanged on Linux.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_lcd_panel_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sim_lcd_t *sim_lcd_handle_t;
+
+/**
+ * @brief Simulator configuration
+ */
+typedef struct {
+    int h_res;                          /*!< Horizontal resolution of the frame memory */
+    int v_res;                          /*!< Vertical resolution of the frame memory */
+    int bits_per_pixel;                 /*!< Pixel format sent by the host, 16 (RGB565) or 24 (RGB888) */
+    uint32_t pclk_hz;                   /*!< QSPI clock used by the bus time model, 0 selects 40 MHz */
+    uint32_t trans_overhead_ns;         /*!< Fixed driver + CS cost per SPI transaction in the bus time model */
+    esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done; /*!< Same role as in `esp_lcd_panel_io_spi_config_t` */
+    void *user_ctx;                     /*!< Passed to `on_color_trans_done` */
+    bool realtime_bus;                  /*!< Deliver `on_color_trans_done` from a bus thread after the modelled transfer
+                                             time instead of inline; `tx_param`/`tx_color` then wait for the transfer
+                                             in flight like the IDF SPI panel IO does */
+    uint32_t te_period_us;              /*!< Panel refresh period, 0 for no TE. With `realtime_bus` a TE thread raises the
+                                             callback set by `sim_lcd_set_te_cb` at every vertical blanking, and color
+                                             transfers the scan line runs through while they are written count as tears */
+} sim_lcd_config_t;
+
+/**
+ * @brief Called from the TE thread at the start of every panel refresh, like the TE GPIO interrupt
+ */
+typedef void (*sim_lcd_te_cb_t)(void *user_ctx);
+
+/**
+ * @brief Bus statistics, either for the current frame or since creation
+ */
+typedef struct {
+    uint32_t transactions;              /*!< SPI transactions, parameter and pixel */
+    uint32_t param_transactions;        /*!< Transactions with opcode 0x02 */
+    uint32_t color_transactions;        /*!< Transactions with opcode 0x32 */
+    uint32_t ramwr;                     /*!< RAMWR commands, i.e. areas drawn */
+    uint32_t window_switches;           /*!< RAMWR into a different CASET/RASET window than the previous one */
+    uint32_t protocol_errors;           /*!< Malformed commands, wrong opcodes, writes outside the window */
+    uint64_t bytes;                     /*!< Bytes on the bus including command and address phases */
+    uint64_t pixel_bytes;               /*!< Pixel payload bytes */
+    uint64_t pixels;                    /*!< Pixels written into the frame memory */
+    uint64_t bus_time_ns;               /*!< Modelled time the QSPI bus was busy */
+    uint32_t tears;                     /*!< Color transfers the scan line crossed while they were written */
+} sim_lcd_stats_t;
+
+/**
+ * @brief Display mode decoded from PTLAR/PTLON/NORON, IDMON/IDMOFF and the brightness register (0x51)
+ */
+typedef struct {
+    bool partial;                       /*!< Partial mode, rows outside `partial_rows` are dark */
+    bool idle;                          /*!< Idle mode, 8 colors */
+    int partial_rows[2];                /*!< First and last row of the partial area */
+    uint8_t brightness;                 /*!< Last brightness written, 0xff after reset */
+    uint32_t lit_pixels;                /*!< Pixels on the glass that are not black, the AMOLED power goes with them */
+} sim_lcd_glass_t;
+
+/**
+ * @brief Create the simulated panel: simulated QSPI IO plus the SH8601 panel driver
+ *
+ * @param[in]  config    Simulator configuration
+ * @param[out] ret_panel Panel handle to use with the `esp_lcd_panel_*` API
+ * @param[out] ret_sim   Simulator handle for statistics and frame dumps
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Bad configuration
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t sim_lcd_new_panel_sh8601(const sim_lcd_config_t *config, esp_lcd_panel_handle_t *ret_panel, sim_lcd_handle_t *ret_sim);
+
+/**
+ * @brief Return the panel IO of the simulator, e.g. to register event callbacks later
+ */
+esp_lcd_panel_io_handle_t sim_lcd_get_io(sim_lcd_handle_t sim);
+
+/**
+ * @brief Set the TE callback, requires `te_period_us` and `realtime_bus`
+ */
+esp_err_t sim_lcd_set_te_cb(sim_lcd_handle_t sim, sim_lcd_te_cb_t cb, void *user_ctx);
+
+/**
+ * @brief Copy the statistics accumulated since the last call and start a new frame
+ *
+ * With `realtime_bus` the call first waits for the color transfer in flight.
+ *
+ * @param[in]  sim   Simulator handle
+ * @param[out] frame Statistics of the frame that just ended (may be NULL)
+ * @param[out] total Statistics since creation (may be NULL)
+ */
+void sim_lcd_end_frame(sim_lcd_handle_t sim, sim_lcd_stats_t *frame, sim_lcd_stats_t *total);
+
+/**
+ * @brief Frame memory, RGB888, `h_res * v_res * 3` bytes; what the glass shows in normal mode
+ */
+const uint8_t *sim_lcd_get_frame(sim_lcd_handle_t sim);
+
+/**
+ * @brief Get the display mode and count the lit pixels
+ */
+void sim_lcd_get_glass(sim_lcd_handle_t sim, sim_lcd_glass_t *glass);
+
+/**
+ * @brief Write the glass to a PNG file: the frame memory through partial and idle mode
+ */
+esp_err_t sim_lcd_dump_png(sim_lcd_handle_t sim, const char *path);
+
+/**
+ * @brief Delete the panel IO (the panel itself is deleted with `esp_lcd_panel_del`)
+ */
+esp_err_t sim_lcd_del(sim_lcd_handle_t sim);
+
+#ifdef __cplusplus
+}
+#endif
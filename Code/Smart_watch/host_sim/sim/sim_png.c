@@ -0,0 +1,142 @@
+/*
+ * Minimal PNG writer for simulator frame dumps.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "sim_png.h"
+
+static uint32_t crc_table[256];
+
+static void crc_init(void)
+{
+    if (crc_table[1]) {
+        return;
+    }
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crc_table[n] = c;
+    }
+}
+
+static uint32_t crc_update(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc = crc_table[(crc ^ buf[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static void put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+// Chunks are streamed: header, then payload pieces, then the CRC of type + payload
+typedef struct {
+    FILE *fp;
+    uint32_t crc;
+} png_chunk_t;
+
+static void chunk_begin(png_chunk_t *chunk, FILE *fp, const char *type, uint32_t len)
+{
+    uint8_t hdr[8];
+    put_be32(hdr, len);
+    memcpy(hdr + 4, type, 4);
+    fwrite(hdr, 1, 8, fp);
+    chunk->fp = fp;
+    chunk->crc = crc_update(0xffffffffu, (const uint8_t *)type, 4);
+}
+
+static void chunk_write(png_chunk_t *chunk, const uint8_t *data, size_t len)
+{
+    fwrite(data, 1, len, chunk->fp);
+    chunk->crc = crc_update(chunk->crc, data, len);
+}
+
+static void chunk_end(png_chunk_t *chunk)
+{
+    uint8_t crc[4];
+    put_be32(crc, chunk->crc ^ 0xffffffffu);
+    fwrite(crc, 1, 4, chunk->fp);
+}
+
+esp_err_t sim_png_write_rgb888(const char *path, const uint8_t *rgb, int width, int height)
+{
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    const size_t row_bytes = (size_t)width * 3 + 1;
+    const size_t raw_bytes = row_bytes * height;
+    const size_t block_max = 65535;
+    const size_t blocks = (raw_bytes + block_max - 1) / block_max;
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        return ESP_FAIL;
+    }
+    crc_init();
+    fwrite(signature, 1, sizeof(signature), fp);
+
+    png_chunk_t chunk;
+    uint8_t ihdr[13];
+    put_be32(ihdr, width);
+    put_be32(ihdr + 4, height);
+    ihdr[8] = 8;    // bit depth
+    ihdr[9] = 2;    // color type: truecolor
+    ihdr[10] = 0;   // deflate
+    ihdr[11] = 0;   // adaptive filtering
+    ihdr[12] = 0;   // no interlace
+    chunk_begin(&chunk, fp, "IHDR", sizeof(ihdr));
+    chunk_write(&chunk, ihdr, sizeof(ihdr));
+    chunk_end(&chunk);
+
+    // zlib stream: 2 byte header, stored blocks with 5 byte headers, adler32
+    chunk_begin(&chunk, fp, "IDAT", (uint32_t)(2 + blocks * 5 + raw_bytes + 4));
+    const uint8_t zlib_hdr[2] = {0x78, 0x01};
+    chunk_write(&chunk, zlib_hdr, 2);
+    uint32_t adler_a = 1, adler_b = 0;
+    size_t pos = 0;     // position in the virtual filtered image
+    for (size_t b = 0; b < blocks; b++) {
+        size_t len = raw_bytes - pos < block_max ? raw_bytes - pos : block_max;
+        uint8_t blk_hdr[5] = {
+            b == blocks - 1 ? 1 : 0,
+            len & 0xff, (len >> 8) & 0xff,
+            ~len & 0xff, (~len >> 8) & 0xff,
+        };
+        chunk_write(&chunk, blk_hdr, sizeof(blk_hdr));
+        size_t end = pos + len;
+        while (pos < end) {
+            size_t row = pos / row_bytes;
+            size_t col = pos % row_bytes;
+            const uint8_t filter = 0;
+            const uint8_t *src = &filter;
+            size_t n = 1;
+            if (col != 0) {
+                src = rgb + row * (row_bytes - 1) + (col - 1);
+                n = row_bytes - col;
+                if (n > end - pos) {
+                    n = end - pos;
+                }
+            }
+            chunk_write(&chunk, src, n);
+            for (size_t i = 0; i < n; i++) {
+                adler_a = (adler_a + src[i]) % 65521;
+                adler_b = (adler_b + adler_a) % 65521;
+            }
+            pos += n;
+        }
+    }
+    uint8_t adler[4];
+    put_be32(adler, (adler_b << 16) | adler_a);
+    chunk_write(&chunk, adler, 4);
+    chunk_end(&chunk);
+
+    chunk_begin(&chunk, fp, "IEND", 0);
+    chunk_end(&chunk);
+
+    return fclose(fp) == 0 ? ESP_OK : ESP_FAIL;
+}
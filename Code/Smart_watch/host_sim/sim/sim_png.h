@@ -0,0 +1,29 @@
+/*
+ * Minimal PNG writer for simulator frame dumps (RGB888, stored deflate blocks, no zlib dependency).
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Write an RGB888 image to a PNG file
+ *
+ * @param[in] path   Output file path
+ * @param[in] rgb    Pixel data, 3 bytes per pixel, rows packed back to back
+ * @param[in] width  Image width in pixels
+ * @param[in] height Image height in pixels
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_FAIL: The file could not be written
+ */
+esp_err_t sim_png_write_rgb888(const char *path, const uint8_t *rgb, int width, int height);
+
+#ifdef __cplusplus
+}
+#endif
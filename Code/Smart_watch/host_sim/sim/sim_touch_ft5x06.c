@@ -0,0 +1,245 @@
+/*
+ * Host-side FT5x06 touch controller simulator.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "driver/gpio.h"
+#include "esp_check.h"
+#include "esp_lcd_panel_io_interface.h"
+#include "esp_timer.h"
+
+#include "sim_touch_ft5x06.h"
+
+#define SIM_TOUCH_DEFAULT_I2C_HZ        (200 * 1000)
+#define SIM_TOUCH_DEFAULT_PERIOD_MS     12
+// Register file up to the vendor registers at 0xA0..0xAF
+#define SIM_TOUCH_REGS                  0xB0
+#define SIM_TOUCH_REG_TD_STATUS         0x02
+#define SIM_TOUCH_REG_P1_XH             0x03
+#define SIM_TOUCH_REG_P1_WEIGHT         0x07
+#define SIM_TOUCH_REG_P1_MISC           0x08
+// Event flag in the top bits of XH
+#define SIM_TOUCH_EVENT_DOWN            0
+#define SIM_TOUCH_EVENT_UP              1
+#define SIM_TOUCH_EVENT_CONTACT         2
+// Reports kept to time them against what LVGL sees
+#define SIM_TOUCH_HISTORY               64
+
+static const char *TAG = "sim_ft5x06";
+
+typedef struct sim_touch_t {
+    esp_lcd_panel_io_t base;
+    sim_touch_config_t cfg;
+    pthread_mutex_t lock;
+    pthread_t thread;
+    bool stop;
+    // Finger as set by the bench, latched into the registers at the next scan
+    bool finger_down;
+    uint16_t finger_x;
+    uint16_t finger_y;
+    bool reported_down;     // the last report had a point
+    uint8_t regs[SIM_TOUCH_REGS];
+    struct {
+        uint16_t x;
+        uint16_t y;
+        int64_t t_us;
+    } history[SIM_TOUCH_HISTORY];
+    uint32_t reports;
+    sim_touch_stats_t stats;
+} sim_touch_t;
+
+// Bytes on the bus with their ACK: a write is START, address, register, data, STOP; a register read is START,
+// address, register, repeated START, address, data, STOP
+static uint64_t sim_touch_account(sim_touch_t *sim, size_t data_bytes, bool read)
+{
+    const size_t bytes = (read ? 3 : 2) + data_bytes;
+    const uint64_t clocks = 9 * bytes + (read ? 3 : 2);
+    const uint64_t ns = clocks * 1000000000ULL / sim->cfg.i2c_hz + sim->cfg.trans_overhead_ns;
+    sim->stats.transactions++;
+    sim->stats.reads += read;
+    sim->stats.bytes += bytes;
+    sim->stats.bus_time_ns += ns;
+    return ns;
+}
+
+// The IDF I2C driver blocks the calling task for the transfer, so the host thread sleeps instead of spinning
+static void sim_touch_sleep(uint64_t ns)
+{
+    struct timespec ts = {.tv_sec = ns / 1000000000ULL, .tv_nsec = ns % 1000000000ULL};
+    while (nanosleep(&ts, &ts) == EINTR) {
+    }
+}
+
+static esp_err_t sim_touch_rx_param(esp_lcd_panel_io_t *io, int lcd_cmd, void *param, size_t param_size)
+{
+    sim_touch_t *sim = __containerof(io, sim_touch_t, base);
+    ESP_RETURN_ON_FALSE(lcd_cmd >= 0 && lcd_cmd + param_size <= SIM_TOUCH_REGS, ESP_ERR_INVALID_ARG, TAG,
+                        "read 0x%02x+%u out of the register map", lcd_cmd, (unsigned)param_size);
+    pthread_mutex_lock(&sim->lock);
+    const uint64_t ns = sim_touch_account(sim, param_size, true);
+    memcpy(param, sim->regs + lcd_cmd, param_size);
+    pthread_mutex_unlock(&sim->lock);
+    sim_touch_sleep(ns);
+    return ESP_OK;
+}
+
+static esp_err_t sim_touch_tx_param(esp_lcd_panel_io_t *io, int lcd_cmd, const void *param, size_t param_size)
+{
+    sim_touch_t *sim = __containerof(io, sim_touch_t, base);
+    ESP_RETURN_ON_FALSE(lcd_cmd >= 0 && lcd_cmd + param_size <= SIM_TOUCH_REGS, ESP_ERR_INVALID_ARG, TAG,
+                        "write 0x%02x+%u out of the register map", lcd_cmd, (unsigned)param_size);
+    pthread_mutex_lock(&sim->lock);
+    const uint64_t ns = sim_touch_account(sim, param_size, false);
+    memcpy(sim->regs + lcd_cmd, param, param_size);
+    pthread_mutex_unlock(&sim->lock);
+    sim_touch_sleep(ns);
+    return ESP_OK;
+}
+
+static esp_err_t sim_touch_io_del(esp_lcd_panel_io_t *io)
+{
+    // Freed with sim_touch_del
+    return ESP_OK;
+}
+
+// One scan, called with the lock held: update the point registers, return whether INT pulses
+static bool sim_touch_scan_locked(sim_touch_t *sim)
+{
+    uint8_t *p = sim->regs + SIM_TOUCH_REG_P1_XH;
+    if (sim->finger_down) {
+        const int event = sim->reported_down ? SIM_TOUCH_EVENT_CONTACT : SIM_TOUCH_EVENT_DOWN;
+        sim->regs[SIM_TOUCH_REG_TD_STATUS] = 1;
+        p[0] = (event << 6) | ((sim->finger_x >> 8) & 0x0f);
+        p[1] = sim->finger_x & 0xff;
+        p[2] = (0 << 4) | ((sim->finger_y >> 8) & 0x0f);
+        p[3] = sim->finger_y & 0xff;
+        sim->regs[SIM_TOUCH_REG_P1_WEIGHT] = 0x20;
+        sim->regs[SIM_TOUCH_REG_P1_MISC] = 0x10;
+        const int64_t now = esp_timer_get_time();
+        sim->history[sim->reports % SIM_TOUCH_HISTORY].x = sim->finger_x;
+        sim->history[sim->reports % SIM_TOUCH_HISTORY].y = sim->finger_y;
+        sim->history[sim->reports % SIM_TOUCH_HISTORY].t_us = now;
+        sim->reports++;
+        sim->reported_down = true;
+    } else if (sim->reported_down) {
+        // Lift: one last report with the up event and no point left
+        sim->regs[SIM_TOUCH_REG_TD_STATUS] = 0;
+        p[0] = (SIM_TOUCH_EVENT_UP << 6) | (p[0] & 0x0f);
+        sim->reported_down = false;
+    } else {
+        return false;
+    }
+    sim->stats.reports++;
+    return true;
+}
+
+static void *sim_touch_thread(void *arg)
+{
+    sim_touch_t *sim = arg;
+    const struct timespec period = {.tv_sec = sim->cfg.report_period_ms / 1000,
+                                    .tv_nsec = (sim->cfg.report_period_ms % 1000) * 1000000L};
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (;;) {
+        next.tv_sec += period.tv_sec;
+        next.tv_nsec += period.tv_nsec;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000L;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR) {
+        }
+        pthread_mutex_lock(&sim->lock);
+        if (sim->stop) {
+            pthread_mutex_unlock(&sim->lock);
+            break;
+        }
+        const bool pulse = sim_touch_scan_locked(sim);
+        pthread_mutex_unlock(&sim->lock);
+        if (pulse && sim->cfg.int_gpio >= 0) {
+            gpio_sim_raise_isr(sim->cfg.int_gpio);
+        }
+    }
+    return NULL;
+}
+
+esp_err_t sim_touch_new_ft5x06(const sim_touch_config_t *config, esp_lcd_panel_io_handle_t *ret_io, sim_touch_handle_t *ret_sim)
+{
+    ESP_RETURN_ON_FALSE(config && ret_io && ret_sim, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    sim_touch_t *sim = calloc(1, sizeof(sim_touch_t));
+    ESP_RETURN_ON_FALSE(sim, ESP_ERR_NO_MEM, TAG, "no mem for touch simulator");
+    sim->cfg = *config;
+    if (sim->cfg.i2c_hz == 0) {
+        sim->cfg.i2c_hz = SIM_TOUCH_DEFAULT_I2C_HZ;
+    }
+    if (sim->cfg.report_period_ms == 0) {
+        sim->cfg.report_period_ms = SIM_TOUCH_DEFAULT_PERIOD_MS;
+    }
+    pthread_mutex_init(&sim->lock, NULL);
+    sim->base.rx_param = sim_touch_rx_param;
+    sim->base.tx_param = sim_touch_tx_param;
+    sim->base.del = sim_touch_io_del;
+    if (pthread_create(&sim->thread, NULL, sim_touch_thread, sim) != 0) {
+        pthread_mutex_destroy(&sim->lock);
+        free(sim);
+        ESP_RETURN_ON_FALSE(false, ESP_FAIL, TAG, "create scan thread failed");
+    }
+    *ret_io = &sim->base;
+    *ret_sim = sim;
+    return ESP_OK;
+}
+
+void sim_touch_set_finger(sim_touch_handle_t sim, bool down, uint16_t x, uint16_t y)
+{
+    pthread_mutex_lock(&sim->lock);
+    sim->finger_down = down;
+    if (down) {
+        sim->finger_x = x;
+        sim->finger_y = y;
+    }
+    pthread_mutex_unlock(&sim->lock);
+}
+
+bool sim_touch_get_report_time(sim_touch_handle_t sim, uint16_t x, uint16_t y, int64_t *t_us)
+{
+    bool found = false;
+    pthread_mutex_lock(&sim->lock);
+    const uint32_t n = sim->reports < SIM_TOUCH_HISTORY ? sim->reports : SIM_TOUCH_HISTORY;
+    for (uint32_t i = 1; i <= n; i++) {
+        const uint32_t slot = (sim->reports - i) % SIM_TOUCH_HISTORY;
+        if (sim->history[slot].x == x && sim->history[slot].y == y) {
+            // Walk back to the first report of this run of reports at x, y
+            *t_us = sim->history[slot].t_us;
+            found = true;
+        } else if (found) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&sim->lock);
+    return found;
+}
+
+void sim_touch_get_stats(sim_touch_handle_t sim, sim_touch_stats_t *stats, bool reset)
+{
+    pthread_mutex_lock(&sim->lock);
+    *stats = sim->stats;
+    if (reset) {
+        memset(&sim->stats, 0, sizeof(sim->stats));
+    }
+    pthread_mutex_unlock(&sim->lock);
+}
+
+esp_err_t sim_touch_del(sim_touch_handle_t sim)
+{
+    pthread_mutex_lock(&sim->lock);
+    sim->stop = true;
+    pthread_mutex_unlock(&sim->lock);
+    pthread_join(sim->thread, NULL);
+    pthread_mutex_destroy(&sim->lock);
+    free(sim);
+    return ESP_OK;
+}
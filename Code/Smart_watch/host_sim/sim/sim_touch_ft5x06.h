@@ -0,0 +1,86 @@
+/*
+ * Host-side FT5x06 touch controller simulator.
+ *
+ * The simulator is an I2C panel IO serving the FT5x06 register map, so the real
+ * `esp_lcd_touch_ft5x06.c` driver runs on top of it unchanged. A finger set with
+ * `sim_touch_set_finger` is scanned every report period like the controller in active mode; every
+ * report updates the touch registers and pulses INT (trigger mode) through the GPIO shim. Register
+ * reads and writes take their modelled I2C time, during which the calling thread sleeps like a task
+ * blocked in the IDF I2C driver.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_lcd_panel_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sim_touch_t *sim_touch_handle_t;
+
+/**
+ * @brief Simulator configuration
+ */
+typedef struct {
+    int int_gpio;                       /*!< GPIO whose ISR handler is raised on every report, -1 for none */
+    uint32_t i2c_hz;                    /*!< I2C clock used by the bus time model, 0 selects 200 kHz */
+    uint32_t trans_overhead_ns;         /*!< Fixed driver cost per I2C transaction in the bus time model */
+    uint32_t report_period_ms;          /*!< Scan period while touched, 0 selects 12 ms (ID_G_PERIODACTIVE set by the driver) */
+} sim_touch_config_t;
+
+/**
+ * @brief I2C statistics since creation or the last reset
+ */
+typedef struct {
+    uint32_t transactions;              /*!< I2C transactions, reads and writes */
+    uint32_t reads;                     /*!< Register reads */
+    uint64_t bytes;                     /*!< Bytes on the bus including address and register bytes */
+    uint64_t bus_time_ns;               /*!< Modelled time the I2C bus was busy */
+    uint32_t reports;                   /*!< Scans that produced a report and an INT pulse */
+} sim_touch_stats_t;
+
+/**
+ * @brief Create the simulated controller
+ *
+ * @param[in]  config  Simulator configuration
+ * @param[out] ret_io  Panel IO to pass to `esp_lcd_touch_new_i2c_ft5x06`
+ * @param[out] ret_sim Simulator handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Bad configuration
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t sim_touch_new_ft5x06(const sim_touch_config_t *config, esp_lcd_panel_io_handle_t *ret_io, sim_touch_handle_t *ret_sim);
+
+/**
+ * @brief Put the finger down at x, y, move it there, or lift it (`down` false); seen at the next scan
+ */
+void sim_touch_set_finger(sim_touch_handle_t sim, bool down, uint16_t x, uint16_t y);
+
+/**
+ * @brief Time of the first of the latest reports of a pressed point at x, y, in `esp_timer_get_time` microseconds
+ *
+ * A finger resting on a point is reported at every scan; the time returned is the one of the scan that first
+ * reported it, i.e. when LVGL could have seen it at the earliest.
+ *
+ * @return false when no recent report has these coordinates
+ */
+bool sim_touch_get_report_time(sim_touch_handle_t sim, uint16_t x, uint16_t y, int64_t *t_us);
+
+/**
+ * @brief Copy the I2C statistics and optionally clear them
+ */
+void sim_touch_get_stats(sim_touch_handle_t sim, sim_touch_stats_t *stats, bool reset);
+
+/**
+ * @brief Stop the scan thread and free the simulator, after `esp_lcd_touch_del`
+ */
+esp_err_t sim_touch_del(sim_touch_handle_t sim);
+
+#ifdef __cplusplus
+}
+#endif
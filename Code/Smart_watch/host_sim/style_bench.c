@@ -0,0 +1,233 @@
+/*
+ * Shared style benchmark: the local styles SquareLine gives every object swapped for the shared styles of
+ * disp_style, screen by screen, in heap and in style lookup time.
+ *
+ *   style_bench [--rounds N]
+ *
+ * Every screen is built twice, once left as SquareLine builds it and once with its styles shared right after the
+ * build, as the firmware does with EXAMPLE_USE_SHARED_STYLES. The bench prints the local styles found, how many
+ * had their properties in the table already and how many put them there, the heap of the build and the heap the
+ * sharing gave back, then the cost of lv_obj_get_style_prop over the properties the widgets read while
+ * drawing, --rounds passes (default 1000) of both copies, the best of 5 runs each, and the frame time of both.
+ * Both copies must draw the same frame. The screens are then deleted and built again, as the screen manager does
+ * after evicting them, with the table filled by the first builds. Last, a value set on an object after sharing
+ * must change that object alone.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lvgl.h"
+#include "ui.h"
+
+#include "disp_style.h"
+
+#define BENCH_H_RES             368
+#define BENCH_V_RES             448
+// Runs of the lookup passes and of the frames per copy, the fastest one is printed
+#define BENCH_RUNS              5
+
+static const char *TAG = "style_bench";
+
+typedef struct {
+    const char *name;
+    lv_obj_t **scr;
+    void (*init)(void);
+} bench_screen_t;
+
+static const bench_screen_t screens[] = {
+    {"Screen1", &ui_Screen1, ui_Screen1_screen_init},
+    {"Screen2", &ui_Screen2, ui_Screen2_screen_init},
+    {"Screen3", &ui_Screen3, ui_Screen3_screen_init},
+    {"Screen4", &ui_Screen4, ui_Screen4_screen_init},
+    {"Screen5", &ui_Screen5, ui_Screen5_screen_init},
+    {"Screen6", &ui_Screen6, ui_Screen6_screen_init},
+};
+#define BENCH_SCREENS (sizeof(screens) / sizeof(screens[0]))
+
+static lv_color_t frame[BENCH_H_RES * BENCH_V_RES];
+static lv_color_t ref[BENCH_H_RES * BENCH_V_RES];
+
+static void bench_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    const int32_t w = lv_area_get_width(area);
+    for (int32_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&frame[y * BENCH_H_RES + area->x1], color_map, w * sizeof(lv_color_t));
+        color_map += w;
+    }
+    lv_disp_flush_ready(drv);
+}
+
+static size_t bench_heap_used(void)
+{
+    return heap_caps_get_total_size(MALLOC_CAP_INTERNAL) - heap_caps_get_free_size(MALLOC_CAP_INTERNAL) +
+           heap_caps_get_total_size(MALLOC_CAP_SPIRAM) - heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+}
+
+// Build a screen, SquareLine style; returns it and the heap it took
+static lv_obj_t *bench_build(size_t s, size_t *heap)
+{
+    *screens[s].scr = NULL;
+    const size_t before = bench_heap_used();
+    _ui_screen_build(screens[s].scr, screens[s].init);
+    *heap = bench_heap_used() - before;
+    return *screens[s].scr;
+}
+
+// Draw `scr` as a whole; returns the frame time
+static int64_t bench_draw(lv_obj_t *scr)
+{
+    lv_disp_load_scr(scr);
+    lv_obj_invalidate(scr);
+    const int64_t t = esp_timer_get_time();
+    lv_refr_now(NULL);
+    return esp_timer_get_time() - t;
+}
+
+static const disp_style_screen_t *bench_screen_stats(const disp_style_stats_t *st, const char *name)
+{
+    for (size_t i = 0; i < st->count; i++) {
+        if (!strcmp(st->screens[i].name, name)) {
+            return &st->screens[i];
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = 1000;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--rounds") && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--rounds N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (rounds < 1) {
+        rounds = 1;
+    }
+
+    lv_init();
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf1[BENCH_H_RES * BENCH_V_RES];
+    lv_disp_draw_buf_init(&draw_buf, buf1, NULL, BENCH_H_RES * BENCH_V_RES);
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = BENCH_H_RES;
+    disp_drv.ver_res = BENCH_V_RES;
+    disp_drv.flush_cb = bench_flush_cb;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_drv_register(&disp_drv);
+
+    ui_init();
+    // Off the screens, so any of them can be deleted
+    lv_disp_load_scr(ui____initial_actions0);
+    _ui_screen_delete(&ui_Screen1);
+
+    // Static as on the watch, the screens use its styles until the end
+    static disp_style_handle_t styles = NULL;
+    const disp_style_config_t config = {.lookup_rounds = 1};
+    ESP_ERROR_CHECK(disp_style_new(&config, &styles));
+    disp_style_stats_t st;
+
+    int failures = 0;
+    lv_obj_t *local[BENCH_SCREENS];
+    lv_obj_t *shared[BENCH_SCREENS];
+    printf("%-8s %7s %6s %6s %5s %4s %7s %7s %7s %9s %9s %8s %8s\n", "screen", "objects", "local", "reused", "added",
+           "kept", "heap_B", "saved_B", "lookups", "local_ns", "shared_ns", "local_us", "shared_us");
+    size_t heap_total = 0;
+    int32_t saved_total = 0;
+    for (size_t s = 0; s < BENCH_SCREENS; s++) {
+        size_t heap;
+        local[s] = bench_build(s, &heap);
+        size_t heap_shared;
+        shared[s] = bench_build(s, &heap_shared);
+        (void)heap_shared;
+        ESP_ERROR_CHECK(disp_style_share(styles, shared[s], screens[s].name));
+        disp_style_get_stats(styles, &st, false);
+        const disp_style_screen_t *ss = bench_screen_stats(&st, screens[s].name);
+
+        // The first draw lays the screen out, the rest are timed; runs of both copies take turns, so both see
+        // the same load of the host
+        int64_t best_frame[2] = {INT64_MAX, INT64_MAX};
+        uint32_t best_lookup[2] = {UINT32_MAX, UINT32_MAX};
+        uint32_t lookups = 0;
+        bench_draw(local[s]);
+        memcpy(ref, frame, sizeof(frame));
+        bench_draw(shared[s]);
+        if (memcmp(ref, frame, sizeof(frame))) {
+            ESP_LOGE(TAG, "%s: frame differs once the styles are shared", screens[s].name);
+            failures++;
+        }
+        for (int run = 0; run < BENCH_RUNS; run++) {
+            for (int on = 0; on < 2; on++) {
+                lv_obj_t *scr = on ? shared[s] : local[s];
+                const int64_t frame_us = bench_draw(scr);
+                best_frame[on] = frame_us < best_frame[on] ? frame_us : best_frame[on];
+                const uint32_t us = disp_style_time_lookups(scr, rounds, &lookups);
+                best_lookup[on] = us < best_lookup[on] ? us : best_lookup[on];
+            }
+        }
+        heap_total += heap;
+        saved_total += ss->saved_bytes;
+        printf("%-8s %7u %6u %6u %5u %4u %7u %7d %7u %9.1f %9.1f %8lld %8lld\n", screens[s].name, ss->objects,
+               ss->local_styles, ss->reused, ss->added, ss->kept, (unsigned)heap, (int)ss->saved_bytes,
+               lookups, 1000.0 * best_lookup[0] / ((double)rounds * lookups),
+               1000.0 * best_lookup[1] / ((double)rounds * lookups), (long long)best_frame[0],
+               (long long)best_frame[1]);
+        if (ss->reused + ss->added + ss->kept != ss->local_styles || ss->lookups != lookups) {
+            ESP_LOGE(TAG, "%s: %u local styles but %u reused, %u added, %u kept, %u lookups timed", screens[s].name,
+                     ss->local_styles, ss->reused, ss->added, ss->kept, ss->lookups);
+            failures++;
+        }
+    }
+    disp_style_get_stats(styles, &st, true);
+    printf("%-8s %7s %6s %6s %5s %4s %7u %7d  (%u shared styles of %u)\n", "all", "", "", "", "", "",
+           (unsigned)heap_total, (int)saved_total, (unsigned)st.styles, (unsigned)st.max_styles);
+
+    // As the screen manager does after evicting them: the table has every style the screens need
+    printf("%-8s %7s %6s %6s %5s %4s %7s %7s\n", "rebuild", "objects", "local", "reused", "added", "kept", "heap_B",
+           "saved_B");
+    const size_t table_styles = st.styles;
+    saved_total = 0;
+    for (size_t s = 0; s < BENCH_SCREENS; s++) {
+        lv_obj_del(local[s]);
+        lv_obj_del(shared[s]);
+        size_t heap;
+        shared[s] = bench_build(s, &heap);
+        ESP_ERROR_CHECK(disp_style_share(styles, shared[s], screens[s].name));
+        disp_style_get_stats(styles, &st, false);
+        const disp_style_screen_t *ss = bench_screen_stats(&st, screens[s].name);
+        saved_total += ss->saved_bytes;
+        printf("%-8s %7u %6u %6u %5u %4u %7u %7d\n", screens[s].name, ss->objects, ss->local_styles, ss->reused,
+               ss->added, ss->kept, (unsigned)heap, (int)ss->saved_bytes);
+        if (ss->added || ss->shares != 1) {
+            ESP_LOGE(TAG, "%s: %u styles added on a rebuild", screens[s].name, ss->added);
+            failures++;
+        }
+    }
+    printf("%-8s %7s %6s %6s %5s %4s %7s %7d\n", "all", "", "", "", "", "", "", (int)saved_total);
+    if (st.styles != table_styles) {
+        ESP_LOGE(TAG, "table grew from %u to %u styles on the rebuilds", (unsigned)table_styles,
+                 (unsigned)st.styles);
+        failures++;
+    }
+
+    // A value set afterwards is local to its object again; Label12 and Label14 share their white text
+    const lv_color_t white = lv_obj_get_style_text_color(ui_Label14, LV_PART_MAIN);
+    lv_obj_set_style_text_color(ui_Label12, lv_color_hex(0xFF0000), LV_PART_MAIN | LV_STATE_DEFAULT);
+    if (lv_obj_get_style_text_color(ui_Label12, LV_PART_MAIN).full != lv_color_hex(0xFF0000).full ||
+        lv_obj_get_style_text_color(ui_Label14, LV_PART_MAIN).full != white.full) {
+        ESP_LOGE(TAG, "a text color set after sharing does not stay on its label");
+        failures++;
+    }
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
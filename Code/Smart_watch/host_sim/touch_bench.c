@@ -0,0 +1,393 @@
+/*
+ * Touch benchmark: drives the real FT5x06 driver on the simulated controller through a scripted
+ * finger and compares the polled LVGL input device of main.c with the interrupt-driven disp_touch path.
+ *
+ *   touch_bench [--i2c-hz N] [--trans-overhead-us N] [--mode poll|event|both]
+ *
+ * The script idles, swipes up over a scrollable column, lets the scroll throw settle, taps five
+ * times and idles again. For each mode it reports, separately for the idle and the touched phases,
+ * I2C transactions, bytes and bus time (from the simulator's bus model) and how often the LVGL loop
+ * and the touch reader woke up; then the latency from the controller report that first showed a point
+ * to the LVGL read that delivered it.
+ * --trans-overhead-us adds a fixed driver cost per I2C transaction to the bus model (default 40 us,
+ * about what the IDF I2C master driver spends around a short transfer).
+ */
+#include <pthread.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_lcd_touch_ft5x06.h"
+#include "lvgl.h"
+
+#include "disp_touch.h"
+#include "sim_touch_ft5x06.h"
+
+#define BENCH_H_RES             368
+#define BENCH_V_RES             448
+#define BENCH_TOUCH_INT_GPIO    21
+
+static const char *TAG = "touch_bench";
+
+enum {
+    PHASE_IDLE_BEFORE,
+    PHASE_SWIPE,
+    PHASE_TAPS,
+    PHASE_IDLE_AFTER,
+    PHASE_COUNT,
+};
+
+typedef struct {
+    int64_t us;
+    sim_touch_stats_t bus;
+    uint32_t loop_wakeups;
+    uint32_t reader_wakeups;
+    uint32_t reads;
+    uint64_t read_us;
+} bench_phase_t;
+
+static sim_touch_handle_t sim;
+static esp_lcd_touch_handle_t tp;
+static disp_touch_handle_t touch;
+static lv_indev_t *indev;
+static TaskHandle_t lvgl_task;
+
+static atomic_int phase;
+static atomic_bool script_done;
+static bench_phase_t phases[PHASE_COUNT];
+static atomic_uint loop_wakeups;
+// Controller reads of the polled version, disp_touch counts its own
+static atomic_uint poll_reads;
+static atomic_ullong poll_read_us;
+
+// Latency of the points LVGL was given, against the report that first showed them
+static void (*inner_read_cb)(lv_indev_drv_t *drv, lv_indev_data_t *data);
+static bool seen_pressed;
+static lv_point_t seen_point;
+static uint32_t lat_count;
+static uint32_t lat_missing;
+static int64_t lat_sum_us;
+static int64_t lat_max_us;
+
+static void bench_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    lv_disp_flush_ready(drv);
+}
+
+// The polled input device of main.c (example_lvgl_touch_cb): one controller read per LVGL read period
+static void bench_poll_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    uint16_t tp_x;
+    uint16_t tp_y;
+    uint8_t tp_cnt = 0;
+    const int64_t t0 = esp_timer_get_time();
+    esp_lcd_touch_read_data(tp);
+    bool tp_pressed = esp_lcd_touch_get_coordinates(tp, &tp_x, &tp_y, NULL, &tp_cnt, 1);
+    atomic_fetch_add(&poll_reads, 1);
+    atomic_fetch_add(&poll_read_us, esp_timer_get_time() - t0);
+    if (tp_pressed && tp_cnt > 0) {
+        data->point.x = tp_x;
+        data->point.y = tp_y;
+        data->state = LV_INDEV_STATE_PRESSED;
+    } else {
+        data->state = LV_INDEV_STATE_RELEASED;
+    }
+}
+
+static void bench_measure_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    inner_read_cb(drv, data);
+    const bool pressed = data->state == LV_INDEV_STATE_PRESSED;
+    if (pressed && (!seen_pressed || data->point.x != seen_point.x || data->point.y != seen_point.y)) {
+        int64_t t_us;
+        if (sim_touch_get_report_time(sim, data->point.x, data->point.y, &t_us)) {
+            const int64_t lat = esp_timer_get_time() - t_us;
+            lat_count++;
+            lat_sum_us += lat;
+            if (lat > lat_max_us) {
+                lat_max_us = lat;
+            }
+        } else {
+            lat_missing++;
+        }
+        seen_point = data->point;
+    }
+    seen_pressed = pressed;
+}
+
+static void bench_on_sample(void *user_ctx)
+{
+    xTaskNotifyGive(lvgl_task);
+}
+
+static void bench_sleep_ms(uint32_t ms)
+{
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+// Controller reads so far, and the time spent in them
+static void bench_reads(uint32_t *reads, uint64_t *read_us)
+{
+    if (!touch) {
+        *reads = atomic_load(&poll_reads);
+        *read_us = atomic_load(&poll_read_us);
+        return;
+    }
+    disp_touch_stats_t st;
+    disp_touch_get_stats(touch, &st, false);
+    *reads = st.reads;
+    *read_us = st.read_us;
+}
+
+static uint32_t reads_base;
+static uint64_t read_us_base;
+
+static void bench_phase_reset(void)
+{
+    bench_reads(&reads_base, &read_us_base);
+}
+
+// Close the current phase and start the next one
+static void bench_next_phase(int64_t *start_us)
+{
+    const int p = atomic_load(&phase);
+    const int64_t now = esp_timer_get_time();
+    phases[p].us = now - *start_us;
+    sim_touch_get_stats(sim, &phases[p].bus, true);
+    phases[p].loop_wakeups = atomic_exchange(&loop_wakeups, 0);
+    uint32_t reads;
+    uint64_t read_us;
+    bench_reads(&reads, &read_us);
+    phases[p].reads = reads - reads_base;
+    phases[p].read_us = read_us - read_us_base;
+    // Every read of disp_touch is a wakeup of its reader task
+    phases[p].reader_wakeups = touch ? phases[p].reads : 0;
+    reads_base = reads;
+    read_us_base = read_us;
+    *start_us = now;
+    atomic_store(&phase, p + 1);
+}
+
+static void *bench_script(void *arg)
+{
+    // Let the previous run settle (scroll bar fade, button transitions)
+    bench_sleep_ms(500);
+    int64_t start_us = esp_timer_get_time();
+    sim_touch_get_stats(sim, &phases[0].bus, true);
+    atomic_store(&loop_wakeups, 0);
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        memset(&phases[p], 0, sizeof(phases[p]));
+    }
+    bench_phase_reset();
+
+    bench_sleep_ms(1500);
+    bench_next_phase(&start_us);
+
+    // Swipe up 300 px in 600 ms; the finger moves between every two scans so each report has its own point
+    for (int y = 400; y > 100; y--) {
+        sim_touch_set_finger(sim, true, 184, y);
+        bench_sleep_ms(2);
+    }
+    sim_touch_set_finger(sim, false, 0, 0);
+    // Scroll throw
+    bench_sleep_ms(700);
+    bench_next_phase(&start_us);
+
+    // Taps resting 100 ms on a point
+    for (int i = 0; i < 5; i++) {
+        sim_touch_set_finger(sim, true, 100 + 30 * i, 200);
+        bench_sleep_ms(100);
+        sim_touch_set_finger(sim, false, 0, 0);
+        bench_sleep_ms(250);
+    }
+    bench_next_phase(&start_us);
+
+    bench_sleep_ms(1500);
+    bench_next_phase(&start_us);
+    atomic_store(&script_done, true);
+    xTaskNotifyGive(lvgl_task);
+    return NULL;
+}
+
+static void bench_print_row(const char *mode, const char *name, int first, int last)
+{
+    bench_phase_t sum = {0};
+    for (int p = first; p <= last; p++) {
+        sum.us += phases[p].us;
+        sum.bus.transactions += phases[p].bus.transactions;
+        sum.bus.bytes += phases[p].bus.bytes;
+        sum.bus.bus_time_ns += phases[p].bus.bus_time_ns;
+        sum.bus.reports += phases[p].bus.reports;
+        sum.loop_wakeups += phases[p].loop_wakeups;
+        sum.reader_wakeups += phases[p].reader_wakeups;
+        sum.reads += phases[p].reads;
+        sum.read_us += phases[p].read_us;
+    }
+    const double s = sum.us / 1e6;
+    printf("%-6s %-6s %6.2f %8.1f %9.0f %8.2f %6.2f %9.1f %9.1f\n", mode, name, s,
+           sum.bus.transactions / s, sum.bus.bytes / s, sum.bus.bus_time_ns / 1e6 / s,
+           sum.bus.bus_time_ns / 1e7 / s, sum.loop_wakeups / s, sum.reader_wakeups / s);
+}
+
+// Cost of one controller read while touched: what a sample costs the bus and the reading task
+static void bench_print_per_read(const char *mode)
+{
+    bench_phase_t sum = {0};
+    for (int p = PHASE_SWIPE; p <= PHASE_TAPS; p++) {
+        sum.bus.transactions += phases[p].bus.transactions;
+        sum.bus.bytes += phases[p].bus.bytes;
+        sum.bus.bus_time_ns += phases[p].bus.bus_time_ns;
+        sum.reads += phases[p].reads;
+        sum.read_us += phases[p].read_us;
+    }
+    if (sum.reads == 0) {
+        return;
+    }
+    printf("%-6s per read while touched: %" PRIu32 " reads, %.2f transactions, %.1f bytes, bus %.0f us, "
+           "read latency %.0f us\n", mode, sum.reads, (double)sum.bus.transactions / sum.reads,
+           (double)sum.bus.bytes / sum.reads, sum.bus.bus_time_ns / 1e3 / sum.reads, (double)sum.read_us / sum.reads);
+}
+
+static void bench_run(const char *mode)
+{
+    const bool event = !strcmp(mode, "event");
+    if (event) {
+        const disp_touch_config_t touch_config = {
+            .tp = tp,
+            .task_priority = 3,
+            .task_core = tskNO_AFFINITY,
+            .on_sample = bench_on_sample,
+        };
+        ESP_ERROR_CHECK(disp_touch_new(&touch_config, &touch));
+        ESP_ERROR_CHECK(disp_touch_attach(touch, indev));
+    } else {
+        indev->driver->read_cb = bench_poll_read_cb;
+    }
+    inner_read_cb = indev->driver->read_cb;
+    indev->driver->read_cb = bench_measure_read_cb;
+    lat_count = lat_missing = 0;
+    lat_sum_us = lat_max_us = 0;
+    seen_pressed = false;
+
+    atomic_store(&phase, PHASE_IDLE_BEFORE);
+    atomic_store(&script_done, false);
+    pthread_t script;
+    pthread_create(&script, NULL, bench_script, NULL);
+
+    // The LVGL task of main.c: it sleeps until the timer deadline lv_timer_handler returns, forever when no timer
+    // runs; the event version is also woken up by the touch reader
+    while (!atomic_load(&script_done)) {
+        if (touch) {
+            disp_touch_process(touch);
+        }
+        const uint32_t task_delay_ms = lv_timer_handler();
+        atomic_fetch_add(&loop_wakeups, 1);
+        const TickType_t ticks = task_delay_ms == LV_NO_TIMER_READY
+                                     ? portMAX_DELAY
+                                     : (TickType_t)(((uint64_t)task_delay_ms * configTICK_RATE_HZ + 999) / 1000);
+        ulTaskNotifyTake(pdTRUE, ticks);
+    }
+    pthread_join(script, NULL);
+
+    bench_print_row(mode, "idle", PHASE_IDLE_BEFORE, PHASE_IDLE_BEFORE);
+    bench_print_row(mode, "touch", PHASE_SWIPE, PHASE_TAPS);
+    bench_print_row(mode, "idle", PHASE_IDLE_AFTER, PHASE_IDLE_AFTER);
+    bench_print_per_read(mode);
+    printf("%-6s latency: %" PRIu32 " points, avg %.2f ms, max %.2f ms", mode, lat_count,
+           lat_count ? lat_sum_us / 1e3 / lat_count : 0.0, lat_max_us / 1e3);
+    if (lat_missing) {
+        printf(", %" PRIu32 " not found in the report history", lat_missing);
+    }
+    printf("\n");
+    if (touch) {
+        disp_touch_stats_t st;
+        disp_touch_get_stats(touch, &st, false);
+        printf("%-6s disp_touch: %" PRIu32 " edges, %" PRIu32 " reads (%" PRIu32 " lift timeouts), %" PRIu32
+               " samples, %" PRIu32 " dropped, %" PRIu32 " delivered, avg %.2f ms, max %.2f ms edge to LVGL, %"
+               PRIu32 " LVGL polls\n", mode, st.edges, st.reads, st.lift_timeouts, st.samples, st.dropped,
+               st.delivered, st.delivered ? st.latency_us / 1e3 / st.delivered : 0.0, st.max_latency_us / 1e3,
+               st.lvgl_polls);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    sim_touch_config_t sim_config = {
+        .int_gpio = BENCH_TOUCH_INT_GPIO,
+        .trans_overhead_ns = 40 * 1000,
+    };
+    const char *mode = "both";
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--i2c-hz") && i + 1 < argc) {
+            sim_config.i2c_hz = strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--trans-overhead-us") && i + 1 < argc) {
+            sim_config.trans_overhead_ns = strtoul(argv[++i], NULL, 0) * 1000;
+        } else if (!strcmp(argv[i], "--mode") && i + 1 < argc &&
+                   (!strcmp(argv[i + 1], "poll") || !strcmp(argv[i + 1], "event") || !strcmp(argv[i + 1], "both"))) {
+            mode = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--i2c-hz N] [--trans-overhead-us N] [--mode poll|event|both]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    esp_lcd_panel_io_handle_t tp_io = NULL;
+    ESP_ERROR_CHECK(sim_touch_new_ft5x06(&sim_config, &tp_io, &sim));
+    const esp_lcd_touch_config_t tp_cfg = {
+        .x_max = BENCH_H_RES,
+        .y_max = BENCH_V_RES,
+        .rst_gpio_num = -1,
+        .int_gpio_num = BENCH_TOUCH_INT_GPIO,
+    };
+    ESP_ERROR_CHECK(esp_lcd_touch_new_i2c_ft5x06(tp_io, &tp_cfg, &tp));
+
+    lv_init();
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf[BENCH_H_RES * 40];
+    lv_disp_draw_buf_init(&draw_buf, buf, NULL, BENCH_H_RES * 40);
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = BENCH_H_RES;
+    disp_drv.ver_res = BENCH_V_RES;
+    disp_drv.flush_cb = bench_flush_cb;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_t *disp = lv_disp_drv_register(&disp_drv);
+
+    static lv_indev_drv_t indev_drv;
+    lv_indev_drv_init(&indev_drv);
+    indev_drv.type = LV_INDEV_TYPE_POINTER;
+    indev_drv.disp = disp;
+    indev_drv.read_cb = bench_poll_read_cb;
+    indev = lv_indev_drv_register(&indev_drv);
+
+    // A column taller than the screen, so the swipe scrolls and throws
+    lv_obj_t *scr = lv_disp_get_scr_act(disp);
+    lv_obj_set_flex_flow(scr, LV_FLEX_FLOW_COLUMN);
+    for (int i = 0; i < 20; i++) {
+        lv_obj_t *btn = lv_btn_create(scr);
+        lv_obj_set_size(btn, LV_PCT(100), 80);
+        lv_obj_t *label = lv_label_create(btn);
+        lv_label_set_text_fmt(label, "Item %d", i);
+    }
+
+    lvgl_task = xTaskGetCurrentTaskHandle();
+
+    printf("%-6s %-6s %6s %8s %9s %8s %6s %9s %9s\n", "mode", "phase", "s", "trans/s", "bytes/s", "bus_ms/s",
+           "bus%", "loop/s", "reader/s");
+    if (strcmp(mode, "event")) {
+        bench_run("poll");
+    }
+    if (strcmp(mode, "poll")) {
+        lv_obj_scroll_to_y(scr, 0, LV_ANIM_OFF);
+        lv_refr_now(NULL);
+        bench_run("event");
+    }
+    ESP_LOGI(TAG, "done");
+    return 0;
+}
@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+"""Percentiles per screen of a frame trace dumped by main/display/disp_trace.c.
+
+Reads the "trace," lines of a console capture, an SD card file or a flush_bench --trace file, and
+ignores everything else, so a raw UART log works as is. Several dumps can be concatenated.
+
+    python3 host_sim/trace_report.py /tmp/trace.csv
+    python3 host_sim/trace_report.py uart.log --metric render_us --metric flush_us
+
+Dumps with image counters also get the image cache hits, misses and decoded bytes per second over the span
+of the frames read.
+"""
+import argparse
+import collections
+import math
+import sys
+
+METRICS = ("timer_us", "render_us", "flush_us", "bytes", "areas", "img_hits", "img_misses", "img_bytes")
+# Image cache counters, summed over the frames
+IMG_COUNTERS = ("img_hits", "img_misses", "img_bytes")
+PERCENTILES = (50, 90, 99)
+
+
+def percentile(values, p):
+    """Nearest-rank percentile of sorted values."""
+    rank = max(1, math.ceil(p / 100 * len(values)))
+    return values[rank - 1]
+
+
+def read_records(files):
+    columns = None
+    seen = set()
+    for f in files:
+        for line in f:
+            if not line.startswith("trace,"):
+                continue
+            fields = line.rstrip("\r\n").split(",")[1:]
+            if fields[0] == "seq":
+                columns = fields
+                continue
+            if columns is None or len(fields) != len(columns):
+                continue
+            rec = dict(zip(columns, fields))
+            # A record dumped twice (overlapping captures) counts once
+            if rec["seq"] in seen:
+                continue
+            seen.add(rec["seq"])
+            yield rec
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("files", nargs="*", help="trace dumps, stdin when none")
+    parser.add_argument("--metric", action="append", choices=METRICS,
+                        help="columns to report (default: all but the image counters)")
+    args = parser.parse_args()
+    metrics = args.metric or [m for m in METRICS if m not in IMG_COUNTERS]
+
+    files = [open(name, errors="replace") for name in args.files] or [sys.stdin]
+    samples = collections.defaultdict(lambda: collections.defaultdict(list))
+    seqs = []
+    t_ms = []
+    images = collections.Counter()
+    for rec in read_records(files):
+        seqs.append(int(rec["seq"]))
+        t_ms.append(int(rec["t_ms"]))
+        for screen in (rec["screen"], "all"):
+            # Dumps from before the image counters lack their columns
+            for m in (m for m in metrics if m in rec):
+                samples[screen][m].append(int(rec[m]))
+        for c in IMG_COUNTERS:
+            images[c] += int(rec.get(c, 0))
+    if not seqs:
+        sys.exit("no trace records found")
+
+    seqs.sort()
+    gaps = sum(b - a - 1 for a, b in zip(seqs, seqs[1:]) if b > a + 1)
+    print(f"{len(seqs)} frames, seq {seqs[0]}..{seqs[-1]}, {gaps} missing")
+    span_s = (max(t_ms) - min(t_ms)) / 1000
+    if images["img_hits"] + images["img_misses"] and span_s > 0:
+        opens = images["img_hits"] + images["img_misses"]
+        print(f"image cache: {images['img_hits'] / span_s:.1f} hits/s, {images['img_misses'] / span_s:.1f} misses/s"
+              f" ({100 * images['img_hits'] / opens:.1f}% hit), {images['img_bytes'] / span_s:.0f} B/s decoded")
+    header = f"{'screen':<10} {'metric':<10} {'frames':>6}" + "".join(f" {'p%d' % p:>9}" for p in PERCENTILES)
+    print(header + f" {'max':>9} {'mean':>9}")
+    for screen in sorted(samples, key=lambda s: (s == "all", s)):
+        for m in (m for m in metrics if samples[screen][m]):
+            values = sorted(samples[screen][m])
+            row = f"{screen:<10} {m:<10} {len(values):>6}"
+            row += "".join(f" {percentile(values, p):>9}" for p in PERCENTILES)
+            row += f" {values[-1]:>9} {sum(values) / len(values):>9.1f}"
+            print(row)
+
+
+if __name__ == "__main__":
+    main()
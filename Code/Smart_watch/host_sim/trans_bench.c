@@ -0,0 +1,243 @@
+/*
+ * Screen transition benchmark: every screen change of ui.c, once animated live by lv_scr_load_anim, which
+ * redraws both widget trees every frame, and once by disp_trans, which draws both screens once into snapshots
+ * and animates two images.
+ *
+ *   trans_bench [--cpu-scale N] [--bus-ns-per-byte N] [--rounds N]
+ *
+ * Every flushed byte holds the LVGL loop for --bus-ns-per-byte (default 50, 40 MHz QSPI on four lines) and
+ * every rendered frame, and the snapshots, for --cpu-scale (default 10) times what they took on this host, a
+ * rough ESP32-S3 at 240 MHz. For every gesture it prints, in both modes, the frames rendered from the screen
+ * change to the end of the animation, their average render time and the FPS over that span; for the snapshots
+ * also the time disp_trans_load took to draw them. Each gesture runs --rounds times (default 3), the numbers
+ * are the averages. After every gesture the target must be on display with no transition left running.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lvgl.h"
+#include "ui.h"
+
+#include "disp_trans.h"
+
+#define BENCH_H_RES             368
+#define BENCH_V_RES             448
+#define BENCH_BUF_ROWS          (BENCH_V_RES / 4)
+
+static const char *TAG = "trans_bench";
+
+static uint32_t bus_ns_per_byte = 50;
+static uint32_t cpu_scale = 10;
+static uint32_t frames;
+static uint64_t flush_bytes;
+
+typedef struct {
+    const char *name;           // source event in ui.c
+    lv_obj_t **from;
+    lv_obj_t **to;
+    lv_scr_load_anim_t anim;
+} bench_gesture_t;
+
+static const bench_gesture_t gestures[] = {
+    {"Screen1 left", &ui_Screen1, &ui_Screen2, LV_SCR_LOAD_ANIM_OVER_LEFT},
+    {"Screen2 right", &ui_Screen2, &ui_Screen1, LV_SCR_LOAD_ANIM_OVER_RIGHT},
+    {"Screen1 right", &ui_Screen1, &ui_Screen3, LV_SCR_LOAD_ANIM_OVER_RIGHT},
+    {"Screen3 left", &ui_Screen3, &ui_Screen1, LV_SCR_LOAD_ANIM_OVER_LEFT},
+    {"Screen1 down", &ui_Screen1, &ui_Screen4, LV_SCR_LOAD_ANIM_OVER_BOTTOM},
+    {"Screen4 left", &ui_Screen4, &ui_Screen6, LV_SCR_LOAD_ANIM_OVER_RIGHT},
+    {"Screen6 right", &ui_Screen6, &ui_Screen4, LV_SCR_LOAD_ANIM_OVER_LEFT},
+    {"Screen4 up", &ui_Screen4, &ui_Screen1, LV_SCR_LOAD_ANIM_OVER_BOTTOM},
+    {"Screen1 up", &ui_Screen1, &ui_Screen5, LV_SCR_LOAD_ANIM_OVER_TOP},
+    {"Screen5 down", &ui_Screen5, &ui_Screen1, LV_SCR_LOAD_ANIM_OVER_TOP},
+    {"ImgButton3", &ui_Screen4, &ui_Screen1, LV_SCR_LOAD_ANIM_FADE_ON},
+    {"Panel9 down", &ui_Screen5, &ui_Screen1, LV_SCR_LOAD_ANIM_FADE_ON},
+};
+#define BENCH_GESTURES (sizeof(gestures) / sizeof(gestures[0]))
+
+typedef struct {
+    uint32_t frames;
+    uint64_t render_us;         // scaled
+    uint64_t span_us;           // screen change to end of the animation
+    uint64_t setup_us;          // scaled time in the load call
+} bench_result_t;
+
+static void bench_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    flush_bytes += lv_area_get_size(area) * sizeof(lv_color_t);
+    lv_disp_flush_ready(drv);
+}
+
+static void bench_monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    frames++;
+}
+
+// Hold the loop for what `host_us` of work and `bytes` on the bus take on the watch
+static void bench_charge(uint64_t host_us, uint64_t bytes)
+{
+    const uint64_t us = host_us * (cpu_scale - 1) + bytes * bus_ns_per_byte / 1000;
+    if (us) {
+        usleep(us);
+    }
+}
+
+// One pass of the LVGL loop of main.c; returns the scaled render time if it rendered a frame, else 0
+static uint64_t bench_pass(void)
+{
+    const uint32_t frames0 = frames;
+    flush_bytes = 0;
+    const int64_t t0 = esp_timer_get_time();
+    const uint32_t next_ms = lv_timer_handler();
+    const uint64_t host_us = esp_timer_get_time() - t0;
+    if (frames == frames0) {
+        usleep(next_ms < 1 ? 100 : 1000);
+        return 0;
+    }
+    bench_charge(host_us, flush_bytes);
+    return host_us * cpu_scale;
+}
+
+static void bench_live_load(lv_obj_t *scr, lv_scr_load_anim_t anim, int time, int delay, void *user_ctx)
+{
+    lv_scr_load_anim(scr, anim, time, delay, false);
+}
+
+// Change screen as ui.c does and run the loop until the animation is over
+static int bench_gesture(const bench_gesture_t *g, disp_trans_handle_t trans, bench_result_t *res)
+{
+    lv_disp_t *disp = lv_disp_get_default();
+    lv_disp_load_scr(*g->from);
+    lv_refr_now(disp);
+
+    _ui_screen_set_load_cb(trans ? disp_trans_load : bench_live_load, trans);
+    const uint32_t frames0 = frames;
+    const int64_t t0 = esp_timer_get_time();
+    _ui_screen_change(g->to, g->anim, 100, 10, NULL);
+    const uint64_t setup_host_us = esp_timer_get_time() - t0;
+    bench_charge(setup_host_us, 0);
+    res->setup_us += setup_host_us * cpu_scale;
+    do {
+        res->render_us += bench_pass();
+    } while (disp->scr_to_load || disp->prev_scr || (trans && disp_trans_is_running(trans)) ||
+             lv_scr_act() != *g->to);
+    res->span_us += esp_timer_get_time() - t0;
+    res->frames += frames - frames0;
+    _ui_screen_set_load_cb(NULL, NULL);
+
+    if (lv_scr_act() != *g->to || (trans && disp_trans_is_running(trans))) {
+        ESP_LOGE(TAG, "%s: target not on display", g->name);
+        return 1;
+    }
+    return 0;
+}
+
+static void bench_print(const char *mode, const bench_result_t *r, int rounds)
+{
+    printf(" %6s %6.1f %9.2f %6.1f", mode, (double)r->frames / rounds,
+           r->frames ? r->render_us / 1000.0 / r->frames : 0.0, r->span_us ? r->frames * 1e6 / r->span_us : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = 3;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--cpu-scale") && i + 1 < argc) {
+            cpu_scale = (uint32_t)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--bus-ns-per-byte") && i + 1 < argc) {
+            bus_ns_per_byte = (uint32_t)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--rounds") && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--cpu-scale N] [--bus-ns-per-byte N] [--rounds N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (cpu_scale == 0) {
+        cpu_scale = 1;
+    }
+    if (rounds < 1) {
+        rounds = 1;
+    }
+
+    lv_init();
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf1[BENCH_H_RES * BENCH_BUF_ROWS];
+    lv_disp_draw_buf_init(&draw_buf, buf1, NULL, BENCH_H_RES * BENCH_BUF_ROWS);
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = BENCH_H_RES;
+    disp_drv.ver_res = BENCH_V_RES;
+    disp_drv.flush_cb = bench_flush_cb;
+    disp_drv.monitor_cb = bench_monitor_cb;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_drv_register(&disp_drv);
+
+    ui_init();
+    _ui_screen_build(&ui_Screen2, ui_Screen2_screen_init);
+    _ui_screen_build(&ui_Screen3, ui_Screen3_screen_init);
+    _ui_screen_build(&ui_Screen4, ui_Screen4_screen_init);
+    _ui_screen_build(&ui_Screen5, ui_Screen5_screen_init);
+    _ui_screen_build(&ui_Screen6, ui_Screen6_screen_init);
+
+    disp_trans_handle_t trans = NULL;
+    const disp_trans_config_t config = {0};
+    ESP_ERROR_CHECK(disp_trans_new(&config, lv_disp_get_default(), &trans));
+
+    printf("cpu x%u, bus %u ns/byte, %d rounds\n", cpu_scale, bus_ns_per_byte, rounds);
+    printf("%-14s %6s %6s %9s %6s %6s %6s %9s %6s %9s\n", "gesture", "mode", "frames", "render_ms", "fps", "mode",
+           "frames", "render_ms", "fps", "snap_ms");
+    int failures = 0;
+    bench_result_t live_all = {0}, snap_all = {0};
+    for (size_t i = 0; i < BENCH_GESTURES; i++) {
+        bench_result_t live = {0}, snap = {0};
+        for (int r = 0; r < rounds; r++) {
+            failures += bench_gesture(&gestures[i], NULL, &live);
+            failures += bench_gesture(&gestures[i], trans, &snap);
+        }
+        printf("%-14s", gestures[i].name);
+        bench_print("live", &live, rounds);
+        bench_print("snap", &snap, rounds);
+        printf(" %9.2f\n", snap.setup_us / 1000.0 / rounds);
+        live_all.frames += live.frames;
+        live_all.render_us += live.render_us;
+        live_all.span_us += live.span_us;
+        snap_all.frames += snap.frames;
+        snap_all.render_us += snap.render_us;
+        snap_all.span_us += snap.span_us;
+        snap_all.setup_us += snap.setup_us;
+    }
+    printf("%-14s", "all");
+    bench_print("live", &live_all, rounds * BENCH_GESTURES);
+    bench_print("snap", &snap_all, rounds * BENCH_GESTURES);
+    printf(" %9.2f\n", snap_all.setup_us / 1000.0 / (rounds * BENCH_GESTURES));
+
+    disp_trans_stats_t st;
+    disp_trans_get_stats(trans, &st, false);
+    if (st.transitions != rounds * BENCH_GESTURES || st.fallbacks) {
+        ESP_LOGE(TAG, "%u transitions, %u fallbacks", st.transitions, st.fallbacks);
+        failures++;
+    }
+
+    // A change during a transition ends it at its target and starts the next one from there
+    _ui_screen_set_load_cb(disp_trans_load, trans);
+    lv_disp_load_scr(ui_Screen1);
+    _ui_screen_change(&ui_Screen2, LV_SCR_LOAD_ANIM_OVER_LEFT, 100, 10, NULL);
+    bench_pass();
+    _ui_screen_change(&ui_Screen1, LV_SCR_LOAD_ANIM_OVER_RIGHT, 100, 10, NULL);
+    while (disp_trans_is_running(trans)) {
+        bench_pass();
+    }
+    disp_trans_get_stats(trans, &st, false);
+    if (lv_scr_act() != ui_Screen1 || st.interrupted != 1) {
+        ESP_LOGE(TAG, "interrupted transition: %u interrupted, Screen1 %s", st.interrupted,
+                 lv_scr_act() == ui_Screen1 ? "on display" : "not on display");
+        failures++;
+    }
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
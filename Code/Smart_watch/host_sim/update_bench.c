@@ -0,0 +1,333 @@
+/*
+ * UI update benchmark: sensor-like tasks update the watch face while the LVGL loop of main.c renders it,
+ * once by taking the LVGL lock around every widget call and once by posting to the disp_update queue.
+ *
+ *   update_bench [--seconds N] [--rate-hz N] [--depth N] [--bus-ns-per-byte N] [--mode lock|queue|both]
+ *
+ * Four producers run at --rate-hz each (default 50): the clock label text, an activity arc, a heart rate
+ * chart point and a status image. Every flushed byte holds the LVGL task for --bus-ns-per-byte (default 50,
+ * 40 MHz QSPI on four lines), so a render takes about as long as on the watch. Per mode it reports how long a
+ * producer was held up per update (waiting for the lock, or posting), the frames rendered and, for the
+ * queue, its depth, drops, coalesced updates and batch cost. The LVGL lock is a disp_lock in both modes;
+ * its table lists per task (the LVGL loop is "main") the holds, the longest one and the wait for the lock.
+ * Two last checks: an update posted to a label deleted before the batch must be skipped as stale, and a
+ * take that times out must name the task holding the lock.
+ */
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lvgl.h"
+#include "ui.h"
+
+#include "disp_lock.h"
+#include "disp_update.h"
+
+#define BENCH_H_RES             368
+#define BENCH_V_RES             448
+#define BENCH_BUF_ROWS          (BENCH_V_RES / 4)
+#define BENCH_PRODUCERS         4
+#define BENCH_CHART_POINTS      40
+
+static const char *TAG = "update_bench";
+
+static uint32_t bus_ns_per_byte = 50;
+static uint32_t rate_hz = 50;
+static disp_lock_handle_t lvgl_lock;
+static TaskHandle_t lvgl_task;
+static disp_update_handle_t updates;
+static bool use_queue;
+static atomic_bool running;
+static atomic_int producers_done;
+static atomic_uint frames;
+static lv_chart_series_t *chart_ser;
+
+typedef struct {
+    const char *name;
+    uint32_t updates;
+    uint64_t held_us;           // time the producer spent in the update call
+    uint32_t max_held_us;
+    uint32_t over_1ms;          // updates that held the producer for more than 1 ms
+} producer_t;
+
+static producer_t producers[BENCH_PRODUCERS] = {
+    {.name = "clock"}, {.name = "arc"}, {.name = "chart"}, {.name = "image"},
+};
+
+static void bench_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    const uint64_t bytes = lv_area_get_size(area) * sizeof(lv_color_t);
+    usleep(bytes * bus_ns_per_byte / 1000);
+    lv_disp_flush_ready(drv);
+}
+
+static void bench_monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    atomic_fetch_add(&frames, 1);
+}
+
+static void update_post_cb(void *user_ctx)
+{
+    xTaskNotifyGive(lvgl_task);
+}
+
+// One widget update, through the lock or the queue
+static void producer_update(int id, uint32_t n)
+{
+    if (use_queue) {
+        switch (id) {
+        case 0:
+            disp_update_label_text_fmt(updates, ui_Label10, "%02" PRIu32 ":%02" PRIu32, n / 60 % 24, n % 60);
+            break;
+        case 1:
+            disp_update_arc_value(updates, ui_Arc1, n % 100);
+            break;
+        case 2:
+            disp_update_chart_point(updates, ui_Chart2, chart_ser, 60 + n % 40);
+            break;
+        default:
+            disp_update_img_src(updates, ui_Image9, n & 1 ? &ui_img_heartsmall_png : &ui_img_zuji_png);
+            break;
+        }
+        return;
+    }
+    disp_lock_take(lvgl_lock, -1);
+    switch (id) {
+    case 0:
+        lv_label_set_text_fmt(ui_Label10, "%02" PRIu32 ":%02" PRIu32, n / 60 % 24, n % 60);
+        break;
+    case 1:
+        lv_arc_set_value(ui_Arc1, n % 100);
+        break;
+    case 2:
+        lv_chart_set_next_value(ui_Chart2, chart_ser, 60 + n % 40);
+        break;
+    default:
+        lv_img_set_src(ui_Image9, n & 1 ? &ui_img_heartsmall_png : &ui_img_zuji_png);
+        break;
+    }
+    disp_lock_give(lvgl_lock);
+    xTaskNotifyGive(lvgl_task);
+}
+
+static void producer_task(void *arg)
+{
+    const int id = (int)(intptr_t)arg;
+    producer_t *p = &producers[id];
+    const int64_t period_us = 1000000 / rate_hz;
+    // Spread the producers over the period, as independent sensors would be
+    int64_t next = esp_timer_get_time() + period_us * id / BENCH_PRODUCERS;
+    for (uint32_t n = 0; atomic_load(&running); n++) {
+        const int64_t now = esp_timer_get_time();
+        if (next > now) {
+            usleep(next - now);
+        }
+        next += period_us;
+        const int64_t t0 = esp_timer_get_time();
+        producer_update(id, n);
+        const uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+        p->updates++;
+        p->held_us += us;
+        p->max_held_us = us > p->max_held_us ? us : p->max_held_us;
+        p->over_1ms += us > 1000;
+    }
+    atomic_fetch_add(&producers_done, 1);
+    vTaskDelete(NULL);
+}
+
+// The LVGL task of main.c, for --seconds
+static void bench_run(const char *mode, uint32_t seconds)
+{
+    use_queue = !strcmp(mode, "queue");
+    memset(producers, 0, sizeof(producers));
+    producers[0].name = "clock";
+    producers[1].name = "arc";
+    producers[2].name = "chart";
+    producers[3].name = "image";
+    atomic_store(&frames, 0);
+    disp_update_stats_t st;
+    disp_update_get_stats(updates, &st, true);
+
+    disp_lock_stats_t lock_st;
+    disp_lock_get_stats(lvgl_lock, &lock_st, true);
+
+    atomic_store(&running, true);
+    atomic_store(&producers_done, 0);
+    for (int i = 0; i < BENCH_PRODUCERS; i++) {
+        xTaskCreate(producer_task, producers[i].name, 4096, (void *)(intptr_t)i, 3, NULL);
+    }
+    const int64_t end = esp_timer_get_time() + (int64_t)seconds * 1000000;
+    while (esp_timer_get_time() < end) {
+        uint32_t task_delay_ms = LV_NO_TIMER_READY;
+        disp_lock_take(lvgl_lock, -1);
+        if (use_queue) {
+            disp_update_apply(updates);
+        }
+        task_delay_ms = lv_timer_handler();
+        disp_lock_give(lvgl_lock);
+        const TickType_t ticks = task_delay_ms == LV_NO_TIMER_READY
+                                     ? pdMS_TO_TICKS(100)
+                                     : (TickType_t)(((uint64_t)task_delay_ms * configTICK_RATE_HZ + 999) / 1000);
+        ulTaskNotifyTake(pdTRUE, ticks);
+    }
+    atomic_store(&running, false);
+    while (atomic_load(&producers_done) < BENCH_PRODUCERS) {
+        usleep(1000);
+    }
+    // What was posted after the last pass
+    disp_update_apply(updates);
+    disp_update_get_stats(updates, &st, true);
+    disp_lock_get_stats(lvgl_lock, &lock_st, true);
+
+    for (int i = 0; i < BENCH_PRODUCERS; i++) {
+        const producer_t *p = &producers[i];
+        printf("%-6s %-6s %8" PRIu32 " %10.1f %10" PRIu32 " %9" PRIu32 "\n", mode, p->name, p->updates,
+               p->updates ? (double)p->held_us / p->updates : 0.0, p->max_held_us, p->over_1ms);
+    }
+    printf("%-6s %" PRIu32 " frames in %" PRIu32 " s", mode, atomic_load(&frames), seconds);
+    if (use_queue) {
+        printf(", queue: %" PRIu32 " posted, %" PRIu32 " dropped, max depth %" PRIu32 ", %" PRIu32
+               " batches (max %" PRIu32 "), %" PRIu32 " applied, %" PRIu32 " coalesced, avg batch %.1f us",
+               st.posted, st.dropped, st.max_depth, st.batches, st.max_batch, st.applied, st.coalesced,
+               st.batches ? (double)st.apply_us / st.batches : 0.0);
+    }
+    printf("\n");
+    printf("%-6s lock: %" PRIu32 " takes, %" PRIu32 " contended, %" PRIu32 " over budget, longest %" PRIu32 " us by %s\n",
+           mode, lock_st.takes, lock_st.contended, lock_st.over_budget, lock_st.max_hold_us, lock_st.max_hold_name);
+    for (size_t i = 0; i < lock_st.holder_count; i++) {
+        const disp_lock_holder_t *h = &lock_st.holders[i];
+        printf("%-6s   %-6s %6" PRIu32 " holds, max %6" PRIu32 " us, avg %6.1f us, max wait %6" PRIu32
+               " us, <1/2/4/8/16/32/64/+ ms %" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32
+               "/%" PRIu32 "/%" PRIu32 "\n", mode, h->name, h->holds, h->max_hold_us,
+               h->holds ? (double)h->hold_us / h->holds : 0.0, h->max_wait_us, h->hist[0], h->hist[1], h->hist[2],
+               h->hist[3], h->hist[4], h->hist[5], h->hist[6], h->hist[7]);
+    }
+}
+
+// An update for a widget deleted before the batch must not reach it
+static int bench_stale_check(void)
+{
+    lv_obj_t *label = lv_label_create(lv_scr_act());
+    disp_update_stats_t st;
+    disp_update_get_stats(updates, &st, true);
+    disp_update_label_text(updates, label, "gone");
+    lv_obj_del(label);
+    disp_update_apply(updates);
+    disp_update_get_stats(updates, &st, true);
+    printf("stale check: %" PRIu32 " stale, %" PRIu32 " applied: %s\n", st.stale, st.applied,
+           st.stale == 1 && st.applied == 0 ? "ok" : "FAILED");
+    return st.stale == 1 && st.applied == 0 ? 0 : 1;
+}
+
+// A take that times out must report the task holding the lock
+static atomic_bool timeout_result;
+static atomic_bool timeout_done;
+
+static void timeout_task(void *arg)
+{
+    atomic_store(&timeout_result, disp_lock_take(lvgl_lock, 5));
+    atomic_store(&timeout_done, true);
+    vTaskDelete(NULL);
+}
+
+static int bench_timeout_check(void)
+{
+    disp_lock_stats_t st;
+    disp_lock_get_stats(lvgl_lock, &st, true);
+    disp_lock_take(lvgl_lock, -1);
+    xTaskCreate(timeout_task, "waiter", 4096, NULL, 3, NULL);
+    while (!atomic_load(&timeout_done)) {
+        usleep(1000);
+    }
+    disp_lock_give(lvgl_lock);
+    disp_lock_get_stats(lvgl_lock, &st, true);
+    const bool ok = !atomic_load(&timeout_result) && st.timeouts == 1 && !strcmp(st.last_timeout_holder, "main");
+    printf("timeout check: %" PRIu32 " timeouts, held by %s: %s\n", st.timeouts, st.last_timeout_holder,
+           ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t seconds = 3;
+    size_t depth = 0;
+    const char *mode = "both";
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+            seconds = strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--rate-hz") && i + 1 < argc) {
+            rate_hz = strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--depth") && i + 1 < argc) {
+            depth = strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--bus-ns-per-byte") && i + 1 < argc) {
+            bus_ns_per_byte = strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--mode") && i + 1 < argc &&
+                   (!strcmp(argv[i + 1], "lock") || !strcmp(argv[i + 1], "queue") || !strcmp(argv[i + 1], "both"))) {
+            mode = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--seconds N] [--rate-hz N] [--depth N] [--bus-ns-per-byte N] "
+                    "[--mode lock|queue|both]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (rate_hz == 0) {
+        rate_hz = 1;
+    }
+
+    lv_init();
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf1[BENCH_H_RES * BENCH_BUF_ROWS];
+    lv_disp_draw_buf_init(&draw_buf, buf1, NULL, BENCH_H_RES * BENCH_BUF_ROWS);
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = BENCH_H_RES;
+    disp_drv.ver_res = BENCH_V_RES;
+    disp_drv.flush_cb = bench_flush_cb;
+    disp_drv.monitor_cb = bench_monitor_cb;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_drv_register(&disp_drv);
+
+    ui_init();
+    // The chart is on another screen than the clock; put it on the watch face so its points are drawn too
+    _ui_screen_build(&ui_Screen2, ui_Screen2_screen_init);
+    lv_obj_set_parent(ui_Chart2, ui_Screen1);
+    lv_obj_align(ui_Chart2, LV_ALIGN_BOTTOM_MID, 0, -20);
+    chart_ser = lv_chart_get_series_next(ui_Chart2, NULL);
+    // SquareLine gives the series external arrays of its 10 points, which LVGL does not grow with the count
+    static lv_coord_t chart_points[2][BENCH_CHART_POINTS];
+    lv_chart_set_point_count(ui_Chart2, BENCH_CHART_POINTS);
+    size_t ser_idx = 0;
+    for (lv_chart_series_t *ser = chart_ser; ser && ser_idx < sizeof(chart_points) / sizeof(chart_points[0]);
+         ser = lv_chart_get_series_next(ui_Chart2, ser)) {
+        lv_chart_set_ext_y_array(ui_Chart2, ser, chart_points[ser_idx++]);
+    }
+    lv_refr_now(NULL);
+
+    const disp_lock_config_t lock_config = {0};
+    ESP_ERROR_CHECK(disp_lock_new(&lock_config, &lvgl_lock));
+    lvgl_task = xTaskGetCurrentTaskHandle();
+    const disp_update_config_t update_config = {
+        .depth = depth,
+        .on_post = update_post_cb,
+    };
+    ESP_ERROR_CHECK(disp_update_new(&update_config, &updates));
+
+    printf("%-6s %-6s %8s %10s %10s %9s\n", "mode", "task", "updates", "avg_us", "max_us", ">1ms");
+    if (strcmp(mode, "queue")) {
+        bench_run("lock", seconds);
+    }
+    if (strcmp(mode, "lock")) {
+        bench_run("queue", seconds);
+    }
+    const int ret = bench_stale_check() | bench_timeout_check();
+    ESP_LOGI(TAG, "done");
+    return ret;
+}
@@ -0,0 +1,34 @@
+#include "esp_check.h"
+#include "esp_log.h"
+
+#include "UART_dev.h"
+
+static const char *TAG = "UART_dev";
+
+// Smallest RX buffer the driver accepts, nothing is read
+#define UART_DEV_RX_BUFFER (UART_HW_FIFO_LEN(0) * 2)
+
+esp_err_t UART_dev_init(uart_port_t port, int baud_rate, size_t tx_buffer)
+{
+    const uart_config_t uart_config = {
+        .baud_rate = baud_rate,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    ESP_RETURN_ON_ERROR(uart_param_config(port, &uart_config), TAG, "configure UART failed");
+    if (uart_is_driver_installed(port))
+    {
+        return ESP_OK;
+    }
+    ESP_RETURN_ON_ERROR(uart_driver_install(port, UART_DEV_RX_BUFFER, tx_buffer, 0, NULL, 0), TAG,
+                        "install UART driver failed");
+    return ESP_OK;
+}
+
+esp_err_t UART_dev_write(uart_port_t port, const void *data, size_t len)
+{
+    return uart_write_bytes(port, data, len) == (int)len ? ESP_OK : ESP_FAIL;
+}
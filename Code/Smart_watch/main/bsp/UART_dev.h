@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "driver/uart.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Install the UART driver with a TX ring buffer, so writes return before the bytes are on the wire
+ *
+ * On the console UART the log output keeps working next to the driver.
+ *
+ * @param[in] port      UART port
+ * @param[in] baud_rate Baud rate
+ * @param[in] tx_buffer TX ring buffer size, 0 makes every write wait for the wire
+ */
+esp_err_t UART_dev_init(uart_port_t port, int baud_rate, size_t tx_buffer);
+
+/**
+ * @brief Queue `len` bytes, blocking only while the TX ring buffer is full
+ */
+esp_err_t UART_dev_write(uart_port_t port, const void *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
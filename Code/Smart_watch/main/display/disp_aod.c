@@ -0,0 +1,382 @@
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "esp_lcd_panel_commands.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "disp_aod.h"
+
+// QSPI command word of the SH8601: write opcode in the first byte, command in the address phase
+#define DISP_AOD_QSPI_CMD(cmd) ((0x02 << 24) | ((cmd) << 8))
+// Brightness register of the SH8601
+#define DISP_AOD_CMD_BRIGHTNESS 0x51
+
+static const char *TAG = "disp_aod";
+
+struct disp_aod_t
+{
+    disp_aod_config_t cfg;
+    lv_obj_t *screen;               // black face screen
+    lv_obj_t *label;                // face text, centred in the partial area
+    char text[DISP_AOD_MAX_TEXT];   // text on the glass
+    lv_disp_t *disp;
+    lv_obj_t *prev_scr;             // active screen before disp_aod_enter
+    uint32_t updates;               // face updates since the last entry, drives the burn-in shift
+    SemaphoreHandle_t event;        // given on a due update and on a wake request
+    esp_timer_handle_t timer;       // one-shot, re-armed for the next period boundary
+    portMUX_TYPE lock;              // protects everything below, shared with the ISR callers
+    bool active;
+    bool tick_pending;
+    bool wake_pending;
+    int64_t enter_us;
+    disp_aod_stats_t stats;
+};
+
+static esp_err_t disp_aod_send(disp_aod_handle_t aod, int cmd, const uint8_t *param, size_t param_size)
+{
+    return esp_lcd_panel_io_tx_param(aod->cfg.io, DISP_AOD_QSPI_CMD(cmd), param, param_size);
+}
+
+// Let every area drawn so far reach the panel, before its mode changes or the update is timed
+static void disp_aod_drain(disp_aod_handle_t aod)
+{
+    if (aod->cfg.engine)
+    {
+        disp_flush_wait_idle(aod->cfg.engine, portMAX_DELAY);
+    }
+    while (aod->disp->driver->draw_buf->flushing)
+    {
+        vTaskDelay(1);
+    }
+}
+
+static void IRAM_ATTR disp_aod_post_isr(disp_aod_handle_t aod, bool wake)
+{
+    BaseType_t need_yield = pdFALSE;
+    portENTER_CRITICAL_ISR(&aod->lock);
+    if (wake)
+    {
+        aod->wake_pending = true;
+    }
+    else
+    {
+        aod->tick_pending = true;
+    }
+    portEXIT_CRITICAL_ISR(&aod->lock);
+    xSemaphoreGiveFromISR(aod->event, &need_yield);
+    portYIELD_FROM_ISR(need_yield);
+}
+
+static void disp_aod_timer_cb(void *arg)
+{
+    disp_aod_handle_t aod = (disp_aod_handle_t)arg;
+    portENTER_CRITICAL(&aod->lock);
+    aod->tick_pending = true;
+    portEXIT_CRITICAL(&aod->lock);
+    xSemaphoreGive(aod->event);
+}
+
+// Arm the timer for the next multiple of the period in wall clock time, so "17:23" appears at 17:23:00
+static void disp_aod_arm(disp_aod_handle_t aod)
+{
+    if (aod->cfg.external_clock)
+    {
+        return;
+    }
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    const uint64_t period_us = (uint64_t)aod->cfg.period_ms * 1000;
+    const uint64_t wall_us = (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+    esp_timer_stop(aod->timer);
+    esp_timer_start_once(aod->timer, period_us - wall_us % period_us);
+}
+
+// New text and burn-in position, the label only invalidates when something changed
+static void disp_aod_update_face(disp_aod_handle_t aod)
+{
+    char text[DISP_AOD_MAX_TEXT] = "";
+    aod->cfg.text_cb(text, sizeof(text), aod->cfg.user_ctx);
+    if (strcmp(text, aod->text) != 0)
+    {
+        strcpy(aod->text, text);
+        lv_label_set_text_static(aod->label, aod->text);
+    }
+    lv_coord_t shift = 0;
+    if (aod->cfg.shift_px > 0)
+    {
+        // Walk from -shift_px to +shift_px in 2 pixel steps and start over
+        const uint32_t steps = aod->cfg.shift_px + 1;
+        shift = (lv_coord_t)(aod->updates % steps) * 2 - aod->cfg.shift_px;
+    }
+    lv_obj_align(aod->label, LV_ALIGN_CENTER, shift, 0);
+    aod->updates++;
+}
+
+esp_err_t disp_aod_new(const disp_aod_config_t *config, disp_aod_handle_t *ret_aod)
+{
+    esp_err_t ret = ESP_OK;
+    disp_aod_handle_t aod = NULL;
+    ESP_RETURN_ON_FALSE(config && ret_aod && config->io && config->text_cb, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(config->rows >= 0 && config->shift_px >= -1, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    aod = calloc(1, sizeof(struct disp_aod_t));
+    ESP_RETURN_ON_FALSE(aod, ESP_ERR_NO_MEM, TAG, "no mem for AOD");
+    aod->cfg = *config;
+    if (aod->cfg.rows == 0)
+    {
+        aod->cfg.rows = DISP_AOD_DEFAULT_ROWS;
+    }
+    // The SH8601 takes partial areas on even rows
+    aod->cfg.rows = (aod->cfg.rows + 1) & ~1;
+    if (aod->cfg.brightness == 0)
+    {
+        aod->cfg.brightness = DISP_AOD_DEFAULT_BRIGHTNESS;
+    }
+    if (aod->cfg.normal_brightness == 0)
+    {
+        aod->cfg.normal_brightness = 0xFF;
+    }
+    if (aod->cfg.period_ms == 0)
+    {
+        aod->cfg.period_ms = DISP_AOD_DEFAULT_PERIOD_MS;
+    }
+    if (aod->cfg.shift_px == 0)
+    {
+        aod->cfg.shift_px = DISP_AOD_DEFAULT_SHIFT_PX;
+    }
+    portMUX_INITIALIZE(&aod->lock);
+    aod->event = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(aod->event, ESP_ERR_NO_MEM, err, TAG, "no mem for AOD semaphore");
+    if (!aod->cfg.external_clock)
+    {
+        const esp_timer_create_args_t timer_args = {
+            .callback = disp_aod_timer_cb,
+            .arg = aod,
+            .name = "disp_aod",
+        };
+        ESP_GOTO_ON_ERROR(esp_timer_create(&timer_args, &aod->timer), err, TAG, "create AOD timer failed");
+    }
+
+    aod->screen = lv_obj_create(NULL);
+    ESP_GOTO_ON_FALSE(aod->screen, ESP_ERR_NO_MEM, err, TAG, "no mem for AOD screen");
+    lv_obj_clear_flag(aod->screen, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_style_bg_color(aod->screen, lv_color_black(), 0);
+    lv_obj_set_style_bg_opa(aod->screen, LV_OPA_COVER, 0);
+    aod->label = lv_label_create(aod->screen);
+    ESP_GOTO_ON_FALSE(aod->label, ESP_ERR_NO_MEM, err, TAG, "no mem for AOD label");
+    lv_obj_set_style_text_color(aod->label, lv_color_white(), 0);
+#if LV_FONT_MONTSERRAT_16
+    lv_obj_set_style_text_font(aod->label, &lv_font_montserrat_16, 0);
+#endif
+    lv_label_set_text_static(aod->label, aod->text);
+    lv_obj_align(aod->label, LV_ALIGN_CENTER, 0, 0);
+
+    ESP_LOGI(TAG, "%d rows, brightness 0x%02x, idle mode %d, update every %" PRIu32 " ms", aod->cfg.rows,
+             aod->cfg.brightness, aod->cfg.idle_mode, aod->cfg.period_ms);
+    *ret_aod = aod;
+    return ESP_OK;
+
+err:
+    if (aod->screen)
+    {
+        lv_obj_del(aod->screen);
+    }
+    if (aod->timer)
+    {
+        esp_timer_delete(aod->timer);
+    }
+    if (aod->event)
+    {
+        vSemaphoreDelete(aod->event);
+    }
+    free(aod);
+    return ret;
+}
+
+lv_obj_t *disp_aod_get_screen(disp_aod_handle_t aod)
+{
+    return aod->screen;
+}
+
+esp_err_t disp_aod_enter(disp_aod_handle_t aod, lv_disp_t *disp)
+{
+    ESP_RETURN_ON_FALSE(aod && disp, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(!aod->active, ESP_ERR_INVALID_STATE, TAG, "already in AOD");
+    ESP_RETURN_ON_FALSE(lv_obj_get_disp(aod->screen) == disp, ESP_ERR_INVALID_ARG, TAG, "face is on another display");
+
+    // Partial area centred on the panel rows, which stay put whatever the LVGL rotation
+    const int v_res = disp->driver->ver_res;
+    const int rows = LV_MIN(aod->cfg.rows, v_res);
+    const int y1 = ((v_res - rows) / 2) & ~1;
+    const int y2 = y1 + rows - 1;
+
+    aod->disp = disp;
+    aod->prev_scr = lv_disp_get_scr_act(disp);
+    aod->updates = 0;
+    aod->text[0] = '\0';
+    disp_aod_update_face(aod);
+    // Without animation, so the face is complete in the one refresh drawn before partial mode
+    lv_disp_load_scr(aod->screen);
+    lv_refr_now(disp);
+    disp_aod_drain(aod);
+
+    const uint8_t ptlar[] = {y1 >> 8, y1 & 0xff, y2 >> 8, y2 & 0xff};
+    ESP_RETURN_ON_ERROR(disp_aod_send(aod, LCD_CMD_PTLAR, ptlar, sizeof(ptlar)), TAG, "send PTLAR failed");
+    ESP_RETURN_ON_ERROR(disp_aod_send(aod, LCD_CMD_PTLON, NULL, 0), TAG, "send PTLON failed");
+    if (aod->cfg.idle_mode)
+    {
+        ESP_RETURN_ON_ERROR(disp_aod_send(aod, LCD_CMD_IDMON, NULL, 0), TAG, "send IDMON failed");
+    }
+    ESP_RETURN_ON_ERROR(disp_aod_send(aod, DISP_AOD_CMD_BRIGHTNESS, &aod->cfg.brightness, 1), TAG,
+                        "send brightness failed");
+
+    portENTER_CRITICAL(&aod->lock);
+    aod->active = true;
+    aod->tick_pending = false;
+    aod->wake_pending = false;
+    aod->enter_us = esp_timer_get_time();
+    aod->stats.entries++;
+    portEXIT_CRITICAL(&aod->lock);
+    disp_aod_arm(aod);
+    ESP_LOGI(TAG, "enter, rows %d..%d", y1, y2);
+    return ESP_OK;
+}
+
+esp_err_t disp_aod_exit(disp_aod_handle_t aod)
+{
+    ESP_RETURN_ON_FALSE(aod, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(aod->active, ESP_ERR_INVALID_STATE, TAG, "not in AOD");
+
+    if (aod->timer)
+    {
+        esp_timer_stop(aod->timer);
+    }
+    disp_aod_drain(aod);
+    if (aod->cfg.idle_mode)
+    {
+        ESP_RETURN_ON_ERROR(disp_aod_send(aod, LCD_CMD_IDMOFF, NULL, 0), TAG, "send IDMOFF failed");
+    }
+    // The rows outside the partial area were drawn black on entry, they stay dark until the next refresh
+    ESP_RETURN_ON_ERROR(disp_aod_send(aod, LCD_CMD_NORON, NULL, 0), TAG, "send NORON failed");
+    ESP_RETURN_ON_ERROR(disp_aod_send(aod, DISP_AOD_CMD_BRIGHTNESS, &aod->cfg.normal_brightness, 1), TAG,
+                        "send brightness failed");
+
+    portENTER_CRITICAL(&aod->lock);
+    aod->active = false;
+    aod->tick_pending = false;
+    aod->wake_pending = false;
+    aod->stats.aod_us += esp_timer_get_time() - aod->enter_us;
+    portEXIT_CRITICAL(&aod->lock);
+    xSemaphoreTake(aod->event, 0);
+
+    if (aod->prev_scr && lv_obj_is_valid(aod->prev_scr))
+    {
+        lv_disp_load_scr(aod->prev_scr);
+    }
+    aod->prev_scr = NULL;
+    ESP_LOGI(TAG, "exit after %" PRIu32 " updates", aod->updates);
+    return ESP_OK;
+}
+
+bool disp_aod_is_active(disp_aod_handle_t aod)
+{
+    portENTER_CRITICAL(&aod->lock);
+    const bool active = aod->active;
+    portEXIT_CRITICAL(&aod->lock);
+    return active;
+}
+
+disp_aod_event_t disp_aod_wait(disp_aod_handle_t aod, uint32_t timeout_ms)
+{
+    const TickType_t ticks = timeout_ms == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    if (xSemaphoreTake(aod->event, ticks) != pdTRUE)
+    {
+        return DISP_AOD_EVENT_TIMEOUT;
+    }
+    disp_aod_event_t event = DISP_AOD_EVENT_TIMEOUT;
+    portENTER_CRITICAL(&aod->lock);
+    // A wake request wins, the update it overtook is moot
+    if (aod->wake_pending)
+    {
+        event = DISP_AOD_EVENT_WAKE;
+        aod->wake_pending = false;
+        aod->tick_pending = false;
+    }
+    else if (aod->tick_pending)
+    {
+        event = DISP_AOD_EVENT_TICK;
+        aod->tick_pending = false;
+    }
+    if (event != DISP_AOD_EVENT_TIMEOUT)
+    {
+        aod->stats.wakeups++;
+    }
+    portEXIT_CRITICAL(&aod->lock);
+    return event;
+}
+
+void disp_aod_tick(disp_aod_handle_t aod)
+{
+    if (!aod->active)
+    {
+        return;
+    }
+    const int64_t t0 = esp_timer_get_time();
+    disp_aod_update_face(aod);
+    lv_obj_update_layout(aod->screen);
+    const bool dirty = aod->disp->inv_p > 0;
+    if (dirty)
+    {
+        lv_refr_now(aod->disp);
+        disp_aod_drain(aod);
+    }
+    const uint32_t busy_us = (uint32_t)(esp_timer_get_time() - t0);
+    disp_aod_arm(aod);
+
+    portENTER_CRITICAL(&aod->lock);
+    aod->stats.renders += dirty;
+    aod->stats.busy_us += busy_us;
+    if (busy_us > aod->stats.max_busy_us)
+    {
+        aod->stats.max_busy_us = busy_us;
+    }
+    portEXIT_CRITICAL(&aod->lock);
+}
+
+void IRAM_ATTR disp_aod_wake(disp_aod_handle_t aod)
+{
+    disp_aod_post_isr(aod, true);
+}
+
+void IRAM_ATTR disp_aod_notify_tick(disp_aod_handle_t aod)
+{
+    disp_aod_post_isr(aod, false);
+}
+
+void disp_aod_get_stats(disp_aod_handle_t aod, disp_aod_stats_t *stats, bool reset)
+{
+    const int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&aod->lock);
+    *stats = aod->stats;
+    if (aod->active)
+    {
+        stats->aod_us += now - aod->enter_us;
+    }
+    if (reset)
+    {
+        memset(&aod->stats, 0, sizeof(aod->stats));
+        if (aod->active)
+        {
+            aod->enter_us = now;
+        }
+    }
+    portEXIT_CRITICAL(&aod->lock);
+}
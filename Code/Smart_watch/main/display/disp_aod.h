@@ -0,0 +1,141 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_lcd_panel_io.h"
+#include "lvgl.h"
+
+#include "disp_flush.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Rows of the partial area by default, enough for one line of montserrat 16 plus the burn-in shift
+#define DISP_AOD_DEFAULT_ROWS 64
+// Default face update period, the face shows minutes
+#define DISP_AOD_DEFAULT_PERIOD_MS 60000
+// Default SH8601 brightness (0x51) in AOD, about a fifth of full scale
+#define DISP_AOD_DEFAULT_BRIGHTNESS 0x30
+// Default burn-in shift: the face moves by up to this many pixels sideways, one step per update
+#define DISP_AOD_DEFAULT_SHIFT_PX 8
+// Longest face text, including the terminating NUL
+#define DISP_AOD_MAX_TEXT 24
+
+typedef struct disp_aod_t *disp_aod_handle_t;
+
+/**
+ * @brief Write the face text (e.g. "17:23") into `buf`, called before every AOD render
+ */
+typedef void (*disp_aod_text_cb_t)(char *buf, size_t len, void *user_ctx);
+
+/**
+ * @brief What woke the LVGL task up in AOD
+ */
+typedef enum {
+    DISP_AOD_EVENT_TIMEOUT,     /*!< Nothing happened before the timeout */
+    DISP_AOD_EVENT_TICK,        /*!< The face is due for an update, call `disp_aod_tick` */
+    DISP_AOD_EVENT_WAKE,        /*!< `disp_aod_wake` was called, call `disp_aod_exit` */
+} disp_aod_event_t;
+
+/**
+ * @brief AOD configuration
+ */
+typedef struct {
+    esp_lcd_panel_io_handle_t io;   /*!< IO of the panel, the partial and idle mode commands go through it */
+    disp_flush_handle_t engine;     /*!< Flush engine, drained before the panel mode changes (may be NULL) */
+    int rows;                       /*!< Height of the partial area, centred on the screen, 0 selects DISP_AOD_DEFAULT_ROWS */
+    uint8_t brightness;             /*!< Brightness in AOD, 0 selects DISP_AOD_DEFAULT_BRIGHTNESS */
+    uint8_t normal_brightness;      /*!< Brightness restored by `disp_aod_exit`, 0 selects 0xFF */
+    bool idle_mode;                 /*!< Also switch the panel to idle mode (8 colors, lower source driver power) */
+    uint32_t period_ms;             /*!< Face update period, 0 selects DISP_AOD_DEFAULT_PERIOD_MS; updates land on
+                                         multiples of the period in wall clock time */
+    int shift_px;                   /*!< Burn-in shift, 0 selects DISP_AOD_DEFAULT_SHIFT_PX, -1 disables it */
+    bool external_clock;            /*!< Updates are reported with `disp_aod_notify_tick` instead of a timer */
+    disp_aod_text_cb_t text_cb;     /*!< Face text */
+    void *user_ctx;                 /*!< Passed to `text_cb` */
+} disp_aod_config_t;
+
+/**
+ * @brief AOD counters since the last reset
+ */
+typedef struct {
+    uint32_t entries;           /*!< `disp_aod_enter` calls */
+    uint32_t wakeups;           /*!< Times the LVGL task returned from `disp_aod_wait` with an event */
+    uint32_t renders;           /*!< Face updates that drew something */
+    uint64_t busy_us;           /*!< CPU time of the face updates, from the text callback to the end of the transfer */
+    uint32_t max_busy_us;       /*!< Longest face update */
+    uint64_t aod_us;            /*!< Time spent in AOD, up to now when in it */
+} disp_aod_stats_t;
+
+/**
+ * @brief Create the AOD controller and its face screen (black, one label inside the partial area)
+ *
+ * Call with the LVGL lock held, after `lv_disp_drv_register`.
+ *
+ * @param[in]  config  Configuration
+ * @param[out] ret_aod Handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Bad configuration
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t disp_aod_new(const disp_aod_config_t *config, disp_aod_handle_t *ret_aod);
+
+/**
+ * @brief Face screen, e.g. to name it in the frame trace or to restyle the label
+ */
+lv_obj_t *disp_aod_get_screen(disp_aod_handle_t aod);
+
+/**
+ * @brief Switch `disp` to the face and the panel to partial (and idle) mode, call with the LVGL lock held
+ *
+ * The face is drawn once over the full screen, so the rows outside the partial area are black in the frame
+ * memory when the panel goes back to normal mode. The active screen is restored by `disp_aod_exit`.
+ */
+esp_err_t disp_aod_enter(disp_aod_handle_t aod, lv_disp_t *disp);
+
+/**
+ * @brief Back to normal mode, full brightness and the screen active before `disp_aod_enter`; call with the LVGL
+ *        lock held
+ */
+esp_err_t disp_aod_exit(disp_aod_handle_t aod);
+
+/**
+ * @brief Whether the panel is in AOD
+ */
+bool disp_aod_is_active(disp_aod_handle_t aod);
+
+/**
+ * @brief Block until a face update is due, `disp_aod_wake` or `timeout_ms`; call without the LVGL lock
+ */
+disp_aod_event_t disp_aod_wait(disp_aod_handle_t aod, uint32_t timeout_ms);
+
+/**
+ * @brief Update the face text and draw it right away, call with the LVGL lock held
+ *
+ * Draws with `lv_refr_now`, so neither the LVGL tick nor the refresh timer has to run in AOD.
+ */
+void disp_aod_tick(disp_aod_handle_t aod);
+
+/**
+ * @brief Ask the LVGL task to leave AOD, e.g. from the touch interrupt; safe from an ISR
+ */
+void disp_aod_wake(disp_aod_handle_t aod);
+
+/**
+ * @brief Report that a face update is due, for `external_clock`; safe from an ISR
+ */
+void disp_aod_notify_tick(disp_aod_handle_t aod);
+
+/**
+ * @brief Get the AOD counters and optionally clear them
+ */
+void disp_aod_get_stats(disp_aod_handle_t aod, disp_aod_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,229 @@
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+
+#include "disp_assets.h"
+
+static const char *TAG = "disp_assets";
+
+// magic, version, images, name hash, pack size, CRC, names offset, reserved
+#define DISP_ASSETS_HEADER_SIZE 32
+// offset, size, width, height, color format, reserved, name offset
+#define DISP_ASSETS_ENTRY_SIZE 16
+// lv_img_header_t holds 11-bit sizes and a 5-bit color format
+#define DISP_ASSETS_MAX_COORD 2047
+#define DISP_ASSETS_MAX_CF 31
+
+struct disp_assets_t
+{
+    disp_assets_config_t cfg;
+    const esp_partition_t *partition;
+    esp_partition_mmap_handle_t map;
+    const uint8_t *pack;            // mapped pack
+    const char *names;              // names section of the pack
+    uint32_t names_size;
+    lv_img_dsc_t *const *images;    // `cfg.images` or `own`
+    lv_img_dsc_t **own;             // descriptors allocated when none were given
+    lv_img_dsc_t *own_dscs;
+    disp_assets_info_t info;
+};
+
+// The pack is a byte array, read the fields a byte at a time
+static inline uint16_t disp_assets_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t disp_assets_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Point every descriptor at its entry
+static esp_err_t disp_assets_bind(disp_assets_handle_t assets, uint32_t pack_size)
+{
+    const uint32_t names_offset = disp_assets_u32(assets->pack + 20);
+    for (size_t i = 0; i < assets->info.count; i++)
+    {
+        const uint8_t *entry = assets->pack + DISP_ASSETS_HEADER_SIZE + i * DISP_ASSETS_ENTRY_SIZE;
+        const uint32_t offset = disp_assets_u32(entry);
+        const uint32_t size = disp_assets_u32(entry + 4);
+        const uint16_t w = disp_assets_u16(entry + 8);
+        const uint16_t h = disp_assets_u16(entry + 10);
+        const uint8_t cf = entry[12];
+        const uint16_t name = disp_assets_u16(entry + 14);
+        ESP_RETURN_ON_FALSE(offset >= names_offset + assets->names_size && offset <= pack_size &&
+                            size <= pack_size - offset && name < assets->names_size, ESP_ERR_INVALID_SIZE, TAG,
+                            "image %u out of the pack", (unsigned)i);
+        ESP_RETURN_ON_FALSE(w <= DISP_ASSETS_MAX_COORD && h <= DISP_ASSETS_MAX_COORD && cf <= DISP_ASSETS_MAX_CF, ESP_ERR_INVALID_VERSION,
+                            TAG, "image %u: unknown header", (unsigned)i);
+        lv_img_dsc_t *dsc = assets->images[i];
+        memset(dsc, 0, sizeof(*dsc));
+        dsc->header.w = w;
+        dsc->header.h = h;
+        dsc->header.cf = cf;
+        dsc->data_size = size;
+        dsc->data = assets->pack + offset;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t disp_assets_open(disp_assets_handle_t assets)
+{
+    const char *label = assets->cfg.label ? assets->cfg.label : DISP_ASSETS_DEFAULT_LABEL;
+    const int64_t t0 = esp_timer_get_time();
+    assets->partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                 (esp_partition_subtype_t)DISP_ASSETS_PARTITION_SUBTYPE, label);
+    ESP_RETURN_ON_FALSE(assets->partition, ESP_ERR_NOT_FOUND, TAG, "no asset partition \"%s\"", label);
+    assets->info.partition_bytes = assets->partition->size;
+
+    // The header says how much to map
+    uint8_t header[DISP_ASSETS_HEADER_SIZE];
+    ESP_RETURN_ON_FALSE(assets->partition->size >= sizeof(header), ESP_ERR_INVALID_SIZE, TAG, "partition too small");
+    ESP_RETURN_ON_ERROR(esp_partition_read(assets->partition, 0, header, sizeof(header)), TAG, "read header failed");
+    ESP_RETURN_ON_FALSE(disp_assets_u32(header) == DISP_ASSETS_MAGIC &&
+                        disp_assets_u16(header + 4) == DISP_ASSETS_VERSION, ESP_ERR_INVALID_VERSION, TAG,
+                        "no asset pack version %d in \"%s\", flash it with idf.py assets-flash", DISP_ASSETS_VERSION,
+                        label);
+    const size_t count = disp_assets_u16(header + 6);
+    const uint32_t hash = disp_assets_u32(header + 8);
+    const uint32_t pack_size = disp_assets_u32(header + 12);
+    const uint32_t names_offset = disp_assets_u32(header + 20);
+    ESP_RETURN_ON_FALSE(!assets->cfg.ids_hash || hash == assets->cfg.ids_hash, ESP_ERR_INVALID_VERSION, TAG,
+                        "pack images 0x%08" PRIx32 ", app built for 0x%08" PRIx32, hash, assets->cfg.ids_hash);
+    ESP_RETURN_ON_FALSE(!assets->cfg.images || count == assets->cfg.count, ESP_ERR_INVALID_VERSION, TAG,
+                        "pack has %u images, app %u", (unsigned)count, (unsigned)assets->cfg.count);
+    ESP_RETURN_ON_FALSE(pack_size <= assets->partition->size &&
+                        names_offset == DISP_ASSETS_HEADER_SIZE + count * DISP_ASSETS_ENTRY_SIZE &&
+                        names_offset <= pack_size, ESP_ERR_INVALID_SIZE, TAG,
+                        "pack of %" PRIu32 " bytes does not fit its partition", pack_size);
+    assets->info.count = count;
+    assets->info.pack_bytes = pack_size;
+
+    const void *pack = NULL;
+    ESP_RETURN_ON_ERROR(esp_partition_mmap(assets->partition, 0, pack_size, ESP_PARTITION_MMAP_DATA, &pack,
+                                           &assets->map), TAG, "map pack failed");
+    assets->pack = pack;
+    assets->names = (const char *)assets->pack + names_offset;
+    // Names end at the first image, past the last NUL
+    uint32_t names_end = pack_size;
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint32_t offset = disp_assets_u32(assets->pack + DISP_ASSETS_HEADER_SIZE + i * DISP_ASSETS_ENTRY_SIZE);
+        if (offset >= names_offset && offset < names_end)
+        {
+            names_end = offset;
+        }
+    }
+    assets->names_size = names_end - names_offset;
+    ESP_RETURN_ON_FALSE(count == 0 || (assets->names_size > 0 && assets->names[assets->names_size - 1] == '\0'),
+                        ESP_ERR_INVALID_SIZE, TAG, "names not terminated");
+
+    if (assets->cfg.verify)
+    {
+        const int64_t t = esp_timer_get_time();
+        const uint32_t crc = esp_rom_crc32_le(0, assets->pack + DISP_ASSETS_HEADER_SIZE,
+                                              pack_size - DISP_ASSETS_HEADER_SIZE);
+        assets->info.verify_us = (uint32_t)(esp_timer_get_time() - t);
+        ESP_RETURN_ON_FALSE(crc == disp_assets_u32(header + 16), ESP_ERR_INVALID_CRC, TAG,
+                            "pack CRC 0x%08" PRIx32 ", header says 0x%08" PRIx32, crc, disp_assets_u32(header + 16));
+    }
+
+    if (assets->cfg.images)
+    {
+        assets->images = assets->cfg.images;
+    }
+    else
+    {
+        assets->own = calloc(count ? count : 1, sizeof(lv_img_dsc_t *));
+        assets->own_dscs = calloc(count ? count : 1, sizeof(lv_img_dsc_t));
+        ESP_RETURN_ON_FALSE(assets->own && assets->own_dscs, ESP_ERR_NO_MEM, TAG, "no mem for descriptors");
+        for (size_t i = 0; i < count; i++)
+        {
+            assets->own[i] = &assets->own_dscs[i];
+        }
+        assets->images = assets->own;
+    }
+    ESP_RETURN_ON_ERROR(disp_assets_bind(assets, pack_size), TAG, "bad pack");
+    assets->info.map_us = (uint32_t)(esp_timer_get_time() - t0) - assets->info.verify_us;
+    ESP_LOGI(TAG, "%u images, %" PRIu32 " of %" PRIu32 " bytes of \"%s\" mapped in %" PRIu32 " us", (unsigned)count,
+             pack_size, assets->partition->size, label, assets->info.map_us);
+    return ESP_OK;
+}
+
+esp_err_t disp_assets_new(const disp_assets_config_t *config, disp_assets_handle_t *ret_assets)
+{
+    ESP_RETURN_ON_FALSE(config && ret_assets && (!config->images || config->count), ESP_ERR_INVALID_ARG, TAG,
+                        "invalid argument");
+    disp_assets_handle_t assets = calloc(1, sizeof(struct disp_assets_t));
+    ESP_RETURN_ON_FALSE(assets, ESP_ERR_NO_MEM, TAG, "no mem for asset pack");
+    assets->cfg = *config;
+    const esp_err_t ret = disp_assets_open(assets);
+    if (ret != ESP_OK)
+    {
+        disp_assets_del(assets);
+        return ret;
+    }
+    *ret_assets = assets;
+    return ESP_OK;
+}
+
+const lv_img_dsc_t *disp_assets_get(disp_assets_handle_t assets, size_t id)
+{
+    return id < assets->info.count ? assets->images[id] : NULL;
+}
+
+const char *disp_assets_get_name(disp_assets_handle_t assets, size_t id)
+{
+    if (id >= assets->info.count)
+    {
+        return NULL;
+    }
+    const uint8_t *entry = assets->pack + DISP_ASSETS_HEADER_SIZE + id * DISP_ASSETS_ENTRY_SIZE;
+    return assets->names + disp_assets_u16(entry + 14);
+}
+
+const lv_img_dsc_t *disp_assets_find(disp_assets_handle_t assets, const char *name)
+{
+    for (size_t i = 0; i < assets->info.count; i++)
+    {
+        if (!strcmp(disp_assets_get_name(assets, i), name))
+        {
+            return assets->images[i];
+        }
+    }
+    return NULL;
+}
+
+void disp_assets_get_info(disp_assets_handle_t assets, disp_assets_info_t *info)
+{
+    *info = assets->info;
+}
+
+void disp_assets_del(disp_assets_handle_t assets)
+{
+    if (!assets)
+    {
+        return;
+    }
+    if (assets->images)
+    {
+        for (size_t i = 0; i < assets->info.count; i++)
+        {
+            memset(assets->images[i], 0, sizeof(lv_img_dsc_t));
+        }
+    }
+    if (assets->pack)
+    {
+        esp_partition_munmap(assets->map);
+    }
+    free(assets->own_dscs);
+    free(assets->own);
+    free(assets);
+}
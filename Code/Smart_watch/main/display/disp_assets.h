@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// First word of an asset pack, "DAPK"
+#define DISP_ASSETS_MAGIC 0x4B504144
+// Layout version written by tools/asset_pack.py
+#define DISP_ASSETS_VERSION 1
+// Subtype of the data partition holding the pack, as in partitions.csv
+#define DISP_ASSETS_PARTITION_SUBTYPE 0x40
+// Default label of that partition
+#define DISP_ASSETS_DEFAULT_LABEL "assets"
+
+typedef struct disp_assets_t *disp_assets_handle_t;
+
+/**
+ * @brief Asset pack configuration
+ */
+typedef struct {
+    const char *label;              /*!< Data partition holding the pack, NULL selects DISP_ASSETS_DEFAULT_LABEL */
+    lv_img_dsc_t *const *images;    /*!< Descriptors to point at the pack, by ID (`ui_assets` of the generated
+                                         ui_assets.c); NULL allocates them */
+    size_t count;                   /*!< Entries of `images`, the pack must hold as many images */
+    uint32_t ids_hash;              /*!< UI_ASSETS_HASH the IDs were generated with, the pack must carry the same;
+                                         0 skips the check */
+    bool verify;                    /*!< Check the CRC of the whole pack before serving it */
+} disp_assets_config_t;
+
+/**
+ * @brief What opening the pack found and cost
+ */
+typedef struct {
+    size_t count;                   /*!< Images in the pack */
+    uint32_t pack_bytes;            /*!< Size of the pack, mapped as a whole */
+    uint32_t partition_bytes;       /*!< Size of the partition */
+    uint32_t map_us;                /*!< Finding the partition, mapping it and filling the descriptors */
+    uint32_t verify_us;             /*!< The CRC check, 0 without `verify` */
+} disp_assets_info_t;
+
+/**
+ * @brief Map the asset pack and serve its images
+ *
+ * Reads the pack header, maps the pack with esp_partition_mmap and points one `lv_img_dsc_t` per image at its
+ * data in flash: nothing is copied, the flash cache fetches the pixels as LVGL draws them. Images stored
+ * compressed by tools/asset_pack.py --compress need the disp_img decoder.
+ *
+ * @param[in]  config      Configuration
+ * @param[out] ret_assets  Handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NOT_FOUND: No such partition
+ *      - ESP_ERR_INVALID_VERSION: Not a pack, another layout version, or images other than the IDs expect
+ *      - ESP_ERR_INVALID_SIZE: The pack overflows the partition or an image the pack
+ *      - ESP_ERR_INVALID_CRC: The pack is corrupt, e.g. an interrupted update
+ *      - ESP_ERR_NO_MEM: Out of memory or of address space to map it
+ */
+esp_err_t disp_assets_new(const disp_assets_config_t *config, disp_assets_handle_t *ret_assets);
+
+/**
+ * @brief Image of an ID, NULL when out of the pack
+ */
+const lv_img_dsc_t *disp_assets_get(disp_assets_handle_t assets, size_t id);
+
+/**
+ * @brief Image of a name, e.g. "ui_img_watch_png", NULL when not in the pack
+ */
+const lv_img_dsc_t *disp_assets_find(disp_assets_handle_t assets, const char *name);
+
+/**
+ * @brief Name of an ID, NULL when out of the pack
+ */
+const char *disp_assets_get_name(disp_assets_handle_t assets, size_t id);
+
+/**
+ * @brief What opening the pack found and cost
+ */
+void disp_assets_get_info(disp_assets_handle_t assets, disp_assets_info_t *info);
+
+/**
+ * @brief Unmap the pack, once nothing draws its images any more
+ *
+ * The descriptors of `images` are emptied, so an image left behind draws nothing instead of reading unmapped
+ * flash. Delete it before writing a new pack to the partition, then create it again.
+ */
+void disp_assets_del(disp_assets_handle_t assets);
+
+#ifdef __cplusplus
+}
+#endif
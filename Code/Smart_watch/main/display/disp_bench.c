@@ -0,0 +1,265 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "disp_bench.h"
+
+#if LV_USE_DEMO_BENCHMARK
+#include "demos/benchmark/lv_demo_benchmark.h"
+#endif
+
+static const char *TAG = "disp_bench";
+
+#if LV_USE_DEMO_BENCHMARK
+
+typedef struct
+{
+    disp_bench_config_t cfg;
+    lv_disp_t *disp;
+    lv_obj_t *prev_scr;
+    lv_obj_t *scr;
+    lv_timer_t *timer;
+    void (*render_start_cb)(lv_disp_drv_t *drv);
+    void (*monitor_cb)(lv_disp_drv_t *drv, uint32_t time, uint32_t px);
+    void (*demo_monitor_cb)(lv_disp_drv_t *drv, uint32_t time, uint32_t px); // set again by every scene
+    int64_t render_start_us;
+    int scene;                      // scene being run
+    int last_scene;                 // last scene to run
+    int mode;                       // 0: one core, 1: parallel blend
+    disp_bench_result_t *results;
+    size_t count;
+} disp_bench_t;
+
+static disp_bench_t *s_bench;
+
+static void disp_bench_render_start_cb(lv_disp_drv_t *drv)
+{
+    if (s_bench->render_start_us == 0)
+    {
+        s_bench->render_start_us = esp_timer_get_time();
+    }
+    if (s_bench->render_start_cb)
+    {
+        s_bench->render_start_cb(drv);
+    }
+}
+
+static void disp_bench_monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    disp_bench_t *bench = s_bench;
+    if (bench->monitor_cb)
+    {
+        bench->monitor_cb(drv, time, px);
+    }
+    if (bench->demo_monitor_cb)
+    {
+        bench->demo_monitor_cb(drv, time, px);
+    }
+    if (bench->render_start_us && bench->count > 0)
+    {
+        disp_bench_result_t *res = &bench->results[bench->count - 1];
+        res->frames[bench->mode]++;
+        res->refr_us[bench->mode] += esp_timer_get_time() - bench->render_start_us;
+    }
+    bench->render_start_us = 0;
+}
+
+static uint32_t disp_bench_fps(const disp_bench_result_t *res, int mode)
+{
+    return res->refr_us[mode] ? (uint32_t)(res->frames[mode] * 1000000ULL / res->refr_us[mode]) : 0;
+}
+
+// Run `scene` in `mode`, false once the benchmark has no such scene
+static bool disp_bench_run(disp_bench_t *bench)
+{
+    if (bench->cfg.par)
+    {
+        disp_par_set_enabled(bench->cfg.par, bench->mode == 1);
+        disp_par_get_stats(bench->cfg.par, &(disp_par_stats_t){0}, true);
+    }
+    lv_demo_benchmark_run_scene(bench->scene);
+    // Every scene points the monitor at the benchmark's counters again
+    lv_disp_drv_t *drv = bench->disp->driver;
+    if (drv->monitor_cb != disp_bench_monitor_cb)
+    {
+        bench->demo_monitor_cb = drv->monitor_cb;
+        drv->monitor_cb = disp_bench_monitor_cb;
+    }
+    bench->render_start_us = 0;
+
+    if (bench->mode == 0)
+    {
+        // The title, the first child of the screen, is "<scene>/<scene count>: <name>", not set past the last scene
+        lv_obj_t *title = lv_obj_get_child(bench->scr, 0);
+        const char *text = title ? lv_label_get_text(title) : NULL;
+        disp_bench_result_t *res = &bench->results[bench->count];
+        int scene = 0;
+        int last = 0;
+        memset(res, 0, sizeof(*res));
+        if (text == NULL || sscanf(text, "%d/%d: %39[^\n]", &scene, &last, res->name) != 3)
+        {
+            return false;
+        }
+        res->scene = bench->scene;
+        if (bench->cfg.scene_count == 0)
+        {
+            bench->last_scene = last - 1;
+        }
+        bench->count++;
+    }
+    lv_disp_trig_activity(bench->disp);
+    return true;
+}
+
+static void disp_bench_finish(disp_bench_t *bench)
+{
+    lv_disp_drv_t *drv = bench->disp->driver;
+    drv->render_start_cb = bench->render_start_cb;
+    drv->monitor_cb = bench->monitor_cb;
+    lv_timer_del(bench->timer);
+    lv_disp_load_scr(bench->prev_scr);
+    lv_obj_del(bench->scr);
+    if (bench->cfg.par)
+    {
+        disp_par_set_enabled(bench->cfg.par, true);
+    }
+
+    uint64_t sum_us[2] = {0};
+    uint64_t sum_frames[2] = {0};
+    for (size_t i = 0; i < bench->count; i++)
+    {
+        const disp_bench_result_t *res = &bench->results[i];
+        for (int m = 0; m < 2; m++)
+        {
+            sum_us[m] += res->refr_us[m];
+            sum_frames[m] += res->frames[m];
+        }
+    }
+    ESP_LOGI(TAG, "%u scenes, %" PRIu64 " frames in %" PRIu64 " ms on one core, %" PRIu64 " frames in %" PRIu64
+             " ms with the parallel blend", (unsigned)bench->count, sum_frames[0], sum_us[0] / 1000, sum_frames[1],
+             sum_us[1] / 1000);
+    if (bench->cfg.on_done)
+    {
+        bench->cfg.on_done(bench->results, bench->count, bench->cfg.user_ctx);
+    }
+    s_bench = NULL;
+    free(bench->results);
+    free(bench);
+}
+
+static void disp_bench_timer_cb(lv_timer_t *timer)
+{
+    disp_bench_t *bench = (disp_bench_t *)timer->user_data;
+    // The benchmark has reported the scene by now, its report timer runs SCENE_TIME after the scene started
+    lv_demo_benchmark_close();
+
+    if (bench->count > 0)
+    {
+        disp_bench_result_t *res = &bench->results[bench->count - 1];
+        if (bench->cfg.par && bench->mode == 1)
+        {
+            disp_par_stats_t stats;
+            disp_par_get_stats(bench->cfg.par, &stats, true);
+            res->split_pct = stats.px ? (uint32_t)(stats.split_px * 100 / stats.px) : 0;
+        }
+        if (bench->mode == 1 || bench->cfg.par == NULL)
+        {
+            const uint32_t fps0 = disp_bench_fps(res, 0);
+            const uint32_t fps1 = disp_bench_fps(res, 1);
+            ESP_LOGI(TAG, "%2d %-32s %4" PRIu32 " FPS, %4" PRIu32 " FPS on two cores (%+" PRId32 "%%), %3" PRIu32
+                     "%% px split", res->scene, res->name, fps0, fps1,
+                     fps0 ? (int32_t)(((int64_t)fps1 - fps0) * 100 / fps0) : 0, res->split_pct);
+        }
+    }
+
+    if (bench->cfg.par && bench->mode == 0)
+    {
+        bench->mode = 1;
+    }
+    else
+    {
+        bench->mode = 0;
+        bench->scene++;
+    }
+    if (bench->scene > bench->last_scene || !disp_bench_run(bench))
+    {
+        lv_demo_benchmark_close();
+        disp_bench_finish(bench);
+    }
+}
+
+esp_err_t disp_bench_start(const disp_bench_config_t *config, lv_disp_t *disp)
+{
+    ESP_RETURN_ON_FALSE(config && disp && config->first_scene >= 0 && config->scene_count >= 0, ESP_ERR_INVALID_ARG,
+                        TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(s_bench == NULL, ESP_ERR_INVALID_STATE, TAG, "benchmark running");
+
+    // Two entries per scene, one of them the "+ opa" variant; the count is known once the first title is read
+    const size_t max_results = 128;
+    disp_bench_t *bench = calloc(1, sizeof(disp_bench_t));
+    ESP_RETURN_ON_FALSE(bench, ESP_ERR_NO_MEM, TAG, "no mem for benchmark");
+    bench->results = calloc(max_results, sizeof(disp_bench_result_t));
+    if (bench->results == NULL)
+    {
+        free(bench);
+        ESP_LOGE(TAG, "no mem for results");
+        return ESP_ERR_NO_MEM;
+    }
+    bench->cfg = *config;
+    bench->disp = disp;
+    bench->scene = config->first_scene;
+    bench->last_scene = config->scene_count ? config->first_scene + config->scene_count - 1 : INT32_MAX;
+    if (bench->last_scene >= config->first_scene + (int)max_results)
+    {
+        bench->last_scene = config->first_scene + (int)max_results - 1;
+    }
+
+    // The benchmark restyles and cleans the active screen, give it one of its own
+    bench->prev_scr = lv_disp_get_scr_act(disp);
+    bench->scr = lv_obj_create(NULL);
+    lv_disp_load_scr(bench->scr);
+
+    lv_disp_drv_t *drv = disp->driver;
+    bench->render_start_cb = drv->render_start_cb;
+    bench->monitor_cb = drv->monitor_cb;
+    drv->render_start_cb = disp_bench_render_start_cb;
+    s_bench = bench;
+
+    bench->timer = lv_timer_create(disp_bench_timer_cb, DISP_BENCH_SCENE_MS, bench);
+    ESP_LOGI(TAG, "Running lv_demo_benchmark from scene %d, %d ms per scene and mode", config->first_scene,
+             DISP_BENCH_SCENE_MS);
+    if (!disp_bench_run(bench))
+    {
+        lv_demo_benchmark_close();
+        disp_bench_finish(bench);
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+bool disp_bench_is_running(void)
+{
+    return s_bench != NULL;
+}
+
+#else
+
+esp_err_t disp_bench_start(const disp_bench_config_t *config, lv_disp_t *disp)
+{
+    (void)config;
+    (void)disp;
+    ESP_LOGW(TAG, "lv_demo_benchmark is not built, enable CONFIG_LV_USE_DEMO_BENCHMARK");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+bool disp_bench_is_running(void)
+{
+    return false;
+}
+
+#endif
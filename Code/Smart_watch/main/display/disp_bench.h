@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "lvgl.h"
+#include "disp_par.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Time each scene runs per mode; lv_demo_benchmark reports a scene after 1 s, the scene is closed after that
+#define DISP_BENCH_SCENE_MS 1100
+// Length of a scene name, " + opa" included
+#define DISP_BENCH_NAME_LEN 40
+
+/**
+ * @brief Result of one lv_demo_benchmark scene
+ */
+typedef struct {
+    int scene;                      /*!< Scene number of lv_demo_benchmark_run_scene, odd ones are the "+ opa" variants */
+    char name[DISP_BENCH_NAME_LEN]; /*!< Scene name as the benchmark titles it */
+    uint32_t frames[2];             /*!< Refreshes on one core [0] and with the parallel blend [1] */
+    uint64_t refr_us[2];            /*!< Time spent in those refreshes, from the first rendered area to the monitor */
+    uint32_t split_pct;             /*!< Share of the blended pixels that were split between the cores */
+} disp_bench_result_t;
+
+/**
+ * @brief Called once every scene ran, in the LVGL task
+ */
+typedef void (*disp_bench_done_cb_t)(const disp_bench_result_t *results, size_t count, void *user_ctx);
+
+/**
+ * @brief Benchmark configuration
+ */
+typedef struct {
+    disp_par_handle_t par;          /*!< Parallel blend to switch between the runs, NULL to run one core only */
+    int first_scene;                /*!< First scene to run */
+    int scene_count;                /*!< Number of scenes, 0 runs them all */
+    disp_bench_done_cb_t on_done;   /*!< Called with the results (may be NULL) */
+    void *user_ctx;                 /*!< Passed to `on_done` */
+} disp_bench_config_t;
+
+/**
+ * @brief Run the lv_demo_benchmark scenes one by one, on one core and then with the parallel blend
+ *
+ * Loads an empty screen, runs every scene for DISP_BENCH_SCENE_MS per mode from an LVGL timer and logs one line
+ * per scene with the FPS of both runs. FPS is what lv_demo_benchmark reports, refreshes per second of refresh
+ * time, so it does not depend on the TE or refresh period; it is measured in microseconds here. The previous
+ * screen comes back when all scenes ran. Needs CONFIG_LV_USE_DEMO_BENCHMARK. Call with the LVGL lock held.
+ *
+ * @return
+ *      - ESP_OK: Started
+ *      - ESP_ERR_INVALID_ARG: Bad configuration
+ *      - ESP_ERR_INVALID_STATE: A benchmark is running
+ *      - ESP_ERR_NO_MEM: Out of memory
+ *      - ESP_ERR_NOT_SUPPORTED: lv_demo_benchmark not built
+ */
+esp_err_t disp_bench_start(const disp_bench_config_t *config, lv_disp_t *disp);
+
+/**
+ * @brief Whether a benchmark is running, e.g. to keep the watch from dropping to the always-on face
+ */
+bool disp_bench_is_running(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,395 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+#include "disp_port.h"
+#include "disp_buf.h"
+
+static const char *TAG = "disp_buf";
+
+// Displays that can have a buffer manager at the same time
+#define DISP_BUF_MAX_DISPLAYS 2
+// Stripes and bounce bands are whole row pairs, so the SH8601 window start stays even and its end odd
+#define DISP_BUF_ROWS_ALIGN 2
+#define DISP_BUF_INTERNAL_CAPS (MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL)
+
+typedef struct
+{
+    disp_buf_strategy_t strategy;
+    int rows;
+} disp_buf_plan_t;
+
+struct disp_buf_t
+{
+    disp_buf_config_t cfg;
+    lv_disp_drv_t *drv;
+    void (*flush_cb)(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map);
+    lv_color_t *stripe[2];
+    uint8_t *bounce[2];
+    uint8_t bounce_idx;
+    bool engine_bounce;         // the flush engine copies the PSRAM stripes instead
+    bool tail_inflight;         // the last bounce band may still be on the bus
+    disp_buf_info_t info;
+    struct
+    {
+        lv_obj_t *scr;
+        disp_buf_strategy_t strategy;
+    } screens[DISP_BUF_MAX_SCREENS];
+};
+
+// `drv->user_data` keeps the panel handle for the other display callbacks, so the manager is looked up by driver
+static struct
+{
+    lv_disp_drv_t *drv;
+    disp_buf_handle_t buf;
+} s_attached[DISP_BUF_MAX_DISPLAYS];
+
+static disp_buf_handle_t disp_buf_from_drv(lv_disp_drv_t *drv)
+{
+    for (int i = 0; i < DISP_BUF_MAX_DISPLAYS; i++)
+    {
+        if (s_attached[i].drv == drv)
+        {
+            return s_attached[i].buf;
+        }
+    }
+    return NULL;
+}
+
+static size_t disp_buf_row_bytes(disp_buf_handle_t buf)
+{
+    return (size_t)buf->drv->hor_res * sizeof(lv_color_t);
+}
+
+static int disp_buf_align_rows(int rows)
+{
+    return rows - rows % DISP_BUF_ROWS_ALIGN;
+}
+
+// Without an engine, copy PSRAM stripes band by band into the internal bounce buffers, the panel DMA only
+// reads internal RAM
+static void disp_buf_lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    disp_buf_handle_t buf = disp_buf_from_drv(drv);
+    if (buf->info.strategy != DISP_BUF_PSRAM_BOUNCE || buf->engine_bounce)
+    {
+        buf->flush_cb(drv, area, color_map);
+        return;
+    }
+    example_lvgl_color_pack(area, color_map);
+
+    const size_t row_bytes = (size_t)lv_area_get_width(area) * LCD_BIT_PER_PIXEL / 8;
+    const int band_rows = disp_buf_align_rows(buf->cfg.bounce_bytes / row_bytes);
+    const uint8_t *src = (const uint8_t *)color_map;
+    for (int y = area->y1; y <= area->y2; y += band_rows)
+    {
+        const int n = LV_MIN(band_rows, area->y2 + 1 - y);
+        // draw_bitmap returns once the band before the previous one left the bus (the CASET of a new window
+        // waits for the color transfer in flight), so this bounce buffer is free to overwrite
+        uint8_t *dst = buf->bounce[buf->bounce_idx];
+        buf->bounce_idx ^= 1;
+        memcpy(dst, src, n * row_bytes);
+        src += n * row_bytes;
+        esp_err_t ret = esp_lcd_panel_draw_bitmap(buf->cfg.panel, area->x1, y, area->x2 + 1, y + n, dst);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "draw bitmap failed: %s", esp_err_to_name(ret));
+        }
+    }
+    buf->tail_inflight = true;
+
+    // Everything is in the bounce buffers, LVGL can draw into this stripe again
+    lv_disp_flush_ready(drv);
+}
+
+// Wait until nothing reads the current buffers any more
+static void disp_buf_drain(disp_buf_handle_t buf)
+{
+    if (buf->cfg.engine)
+    {
+        disp_flush_wait_idle(buf->cfg.engine, portMAX_DELAY);
+    }
+    while (buf->drv->draw_buf->flushing)
+    {
+        vTaskDelay(1);
+    }
+    if (buf->tail_inflight)
+    {
+        // Every parameter write waits for the color transfer in flight; DISPON again changes nothing
+        esp_lcd_panel_disp_on_off(buf->cfg.panel, true);
+        buf->tail_inflight = false;
+    }
+}
+
+static void disp_buf_release(disp_buf_handle_t buf)
+{
+    if (buf->engine_bounce)
+    {
+        disp_flush_set_bounce(buf->cfg.engine, 0);
+        buf->engine_bounce = false;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        heap_caps_free(buf->stripe[i]);
+        buf->stripe[i] = NULL;
+        heap_caps_free(buf->bounce[i]);
+        buf->bounce[i] = NULL;
+    }
+    buf->info.internal_bytes = 0;
+    buf->info.psram_bytes = 0;
+    buf->info.rows = 0;
+}
+
+// Pick the stripe height for `strategy` given the memory that would be free without the current buffers
+static bool disp_buf_plan(disp_buf_handle_t buf, disp_buf_strategy_t strategy, disp_buf_plan_t *plan)
+{
+    const size_t row_bytes = disp_buf_row_bytes(buf);
+    size_t internal = heap_caps_get_free_size(DISP_BUF_INTERNAL_CAPS) + buf->info.internal_bytes;
+    size_t largest = LV_MAX(heap_caps_get_largest_free_block(DISP_BUF_INTERNAL_CAPS), buf->info.internal_bytes / 2);
+    internal = internal > buf->cfg.internal_reserve ? internal - buf->cfg.internal_reserve : 0;
+    const size_t psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM) + buf->info.psram_bytes;
+
+    switch (strategy)
+    {
+    case DISP_BUF_AUTO:
+        return disp_buf_plan(buf, DISP_BUF_SRAM_DOUBLE, plan) || disp_buf_plan(buf, DISP_BUF_PSRAM_BOUNCE, plan) ||
+               disp_buf_plan(buf, DISP_BUF_SRAM_SINGLE, plan);
+    case DISP_BUF_SRAM_DOUBLE:
+    case DISP_BUF_SRAM_SINGLE:
+    {
+        const int count = strategy == DISP_BUF_SRAM_DOUBLE ? 2 : 1;
+        const int rows = disp_buf_align_rows(LV_MIN(LV_MIN(internal / count, largest) / row_bytes,
+                                                     (size_t)buf->cfg.max_rows));
+        plan->strategy = strategy;
+        plan->rows = rows;
+        return rows >= buf->cfg.min_rows;
+    }
+    case DISP_BUF_PSRAM_BOUNCE:
+        plan->strategy = strategy;
+        plan->rows = buf->cfg.psram_rows;
+        return internal >= 2 * buf->cfg.bounce_bytes && largest >= buf->cfg.bounce_bytes &&
+               psram >= 2 * (size_t)plan->rows * row_bytes;
+    }
+    return false;
+}
+
+static esp_err_t disp_buf_alloc(disp_buf_handle_t buf, const disp_buf_plan_t *plan)
+{
+    const size_t stripe_bytes = (size_t)plan->rows * disp_buf_row_bytes(buf);
+    const uint32_t caps = plan->strategy == DISP_BUF_PSRAM_BOUNCE ? MALLOC_CAP_SPIRAM : DISP_BUF_INTERNAL_CAPS;
+    const int count = plan->strategy == DISP_BUF_SRAM_SINGLE ? 1 : 2;
+    for (int i = 0; i < count; i++)
+    {
+        buf->stripe[i] = heap_caps_malloc(stripe_bytes, caps);
+        if (!buf->stripe[i])
+        {
+            disp_buf_release(buf);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (plan->strategy == DISP_BUF_PSRAM_BOUNCE && buf->cfg.engine)
+    {
+        // The engine copies in its own task, LVGL draws the next stripe meanwhile
+        if (disp_flush_set_bounce(buf->cfg.engine, buf->cfg.bounce_bytes) != ESP_OK)
+        {
+            disp_buf_release(buf);
+            return ESP_ERR_NO_MEM;
+        }
+        buf->engine_bounce = true;
+        buf->info.internal_bytes = 2 * buf->cfg.bounce_bytes;
+        buf->info.psram_bytes = count * stripe_bytes;
+    }
+    else if (plan->strategy == DISP_BUF_PSRAM_BOUNCE)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            buf->bounce[i] = heap_caps_malloc(buf->cfg.bounce_bytes, DISP_BUF_INTERNAL_CAPS);
+            if (!buf->bounce[i])
+            {
+                disp_buf_release(buf);
+                return ESP_ERR_NO_MEM;
+            }
+        }
+        buf->info.internal_bytes = 2 * buf->cfg.bounce_bytes;
+        buf->info.psram_bytes = count * stripe_bytes;
+    }
+    else
+    {
+        buf->info.internal_bytes = count * stripe_bytes;
+    }
+    buf->info.strategy = plan->strategy;
+    buf->info.rows = plan->rows;
+    lv_disp_draw_buf_init(buf->drv->draw_buf, buf->stripe[0], buf->stripe[1], (uint32_t)plan->rows * buf->drv->hor_res);
+    return ESP_OK;
+}
+
+esp_err_t disp_buf_apply(disp_buf_handle_t buf, disp_buf_strategy_t strategy)
+{
+    ESP_RETURN_ON_FALSE(buf && buf->drv, ESP_ERR_INVALID_STATE, TAG, "not attached");
+    disp_buf_plan_t plan;
+    if (!disp_buf_plan(buf, strategy, &plan) && !disp_buf_plan(buf, DISP_BUF_AUTO, &plan))
+    {
+        // Not even the fallback fits next to the reserve, take a minimal stripe out of it
+        plan.strategy = DISP_BUF_SRAM_SINGLE;
+        plan.rows = buf->cfg.min_rows;
+    }
+    if (buf->stripe[0] && plan.strategy == buf->info.strategy && plan.rows == buf->info.rows)
+    {
+        return ESP_OK;
+    }
+
+    disp_buf_drain(buf);
+    disp_buf_release(buf);
+    // The free size does not tell about fragmentation, lower the stripe until it is allocated
+    while (disp_buf_alloc(buf, &plan) != ESP_OK)
+    {
+        if (plan.strategy != DISP_BUF_PSRAM_BOUNCE && plan.rows > buf->cfg.min_rows)
+        {
+            plan.rows = LV_MAX(disp_buf_align_rows(plan.rows / 2), buf->cfg.min_rows);
+        }
+        else if (plan.strategy != DISP_BUF_SRAM_SINGLE)
+        {
+            plan.strategy = DISP_BUF_SRAM_SINGLE;
+            plan.rows = LV_MIN(buf->cfg.max_rows, 4 * buf->cfg.min_rows);
+        }
+        else
+        {
+            ESP_LOGE(TAG, "no memory for a %d row stripe", plan.rows);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    buf->info.switches++;
+    ESP_LOGI(TAG, "%s, %d rows, %u bytes internal, %u bytes PSRAM", disp_buf_strategy_name(plan.strategy), plan.rows,
+             (unsigned)buf->info.internal_bytes, (unsigned)buf->info.psram_bytes);
+    return ESP_OK;
+}
+
+static void disp_buf_screen_event_cb(lv_event_t *e)
+{
+    disp_buf_handle_t buf = (disp_buf_handle_t)lv_event_get_user_data(e);
+    lv_obj_t *scr = lv_event_get_target(e);
+    for (int i = 0; i < DISP_BUF_MAX_SCREENS; i++)
+    {
+        if (buf->screens[i].scr == scr)
+        {
+            if (lv_event_get_code(e) == LV_EVENT_DELETE)
+            {
+                // Frees the entry for screens built later
+                buf->screens[i].scr = NULL;
+                return;
+            }
+            disp_buf_apply(buf, buf->screens[i].strategy);
+            return;
+        }
+    }
+}
+
+esp_err_t disp_buf_set_screen_strategy(disp_buf_handle_t buf, lv_obj_t *scr, disp_buf_strategy_t strategy)
+{
+    ESP_RETURN_ON_FALSE(buf && scr, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    int slot = -1;
+    for (int i = DISP_BUF_MAX_SCREENS - 1; i >= 0; i--)
+    {
+        if (buf->screens[i].scr == scr || (slot < 0 && buf->screens[i].scr == NULL))
+        {
+            slot = i;
+        }
+    }
+    ESP_RETURN_ON_FALSE(slot >= 0, ESP_ERR_NO_MEM, TAG, "too many screens");
+    if (buf->screens[slot].scr != scr)
+    {
+        lv_obj_add_event_cb(scr, disp_buf_screen_event_cb, LV_EVENT_SCREEN_LOAD_START, buf);
+        lv_obj_add_event_cb(scr, disp_buf_screen_event_cb, LV_EVENT_DELETE, buf);
+    }
+    buf->screens[slot].scr = scr;
+    buf->screens[slot].strategy = strategy;
+    return ESP_OK;
+}
+
+esp_err_t disp_buf_new(const disp_buf_config_t *config, disp_buf_handle_t *ret_buf)
+{
+    ESP_RETURN_ON_FALSE(config && ret_buf && config->panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    disp_buf_handle_t buf = calloc(1, sizeof(struct disp_buf_t));
+    ESP_RETURN_ON_FALSE(buf, ESP_ERR_NO_MEM, TAG, "no mem for buffer manager");
+    buf->cfg = *config;
+    if (buf->cfg.internal_reserve == 0)
+    {
+        buf->cfg.internal_reserve = DISP_BUF_DEFAULT_INTERNAL_RESERVE;
+    }
+    if (buf->cfg.min_rows == 0)
+    {
+        buf->cfg.min_rows = DISP_BUF_DEFAULT_MIN_ROWS;
+    }
+    if (buf->cfg.bounce_bytes == 0)
+    {
+        buf->cfg.bounce_bytes = DISP_BUF_DEFAULT_BOUNCE_BYTES;
+    }
+    buf->cfg.min_rows = LV_MAX(disp_buf_align_rows(buf->cfg.min_rows), DISP_BUF_ROWS_ALIGN);
+    *ret_buf = buf;
+    return ESP_OK;
+}
+
+esp_err_t disp_buf_attach(disp_buf_handle_t buf, lv_disp_drv_t *drv, disp_buf_strategy_t strategy)
+{
+    ESP_RETURN_ON_FALSE(buf && drv && drv->draw_buf && drv->flush_cb, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(!drv->direct_mode && !drv->full_refresh, ESP_ERR_INVALID_ARG, TAG, "stripes only");
+    const size_t row_bytes = (size_t)LV_MAX(drv->hor_res, drv->ver_res) * LCD_BIT_PER_PIXEL / 8;
+    ESP_RETURN_ON_FALSE(buf->cfg.bounce_bytes >= DISP_BUF_ROWS_ALIGN * row_bytes, ESP_ERR_INVALID_ARG, TAG,
+                        "bounce buffer smaller than a row pair");
+    int slot = -1;
+    for (int i = DISP_BUF_MAX_DISPLAYS - 1; i >= 0; i--)
+    {
+        if (s_attached[i].drv == drv || (slot < 0 && s_attached[i].drv == NULL))
+        {
+            slot = i;
+        }
+    }
+    ESP_RETURN_ON_FALSE(slot >= 0, ESP_ERR_NO_MEM, TAG, "too many displays");
+
+    s_attached[slot].drv = drv;
+    s_attached[slot].buf = buf;
+    buf->drv = drv;
+    if (buf->cfg.max_rows == 0 || buf->cfg.max_rows > drv->ver_res)
+    {
+        buf->cfg.max_rows = drv->ver_res;
+    }
+    if (buf->cfg.psram_rows == 0 || buf->cfg.psram_rows > drv->ver_res)
+    {
+        // Short PSRAM stripes keep LVGL drawing while the engine copies, taller ones only save draw passes
+        buf->cfg.psram_rows = buf->cfg.max_rows;
+    }
+    buf->cfg.max_rows = disp_buf_align_rows(buf->cfg.max_rows);
+    buf->cfg.psram_rows = disp_buf_align_rows(buf->cfg.psram_rows);
+    if (drv->flush_cb != disp_buf_lvgl_flush_cb)
+    {
+        buf->flush_cb = drv->flush_cb;
+        drv->flush_cb = disp_buf_lvgl_flush_cb;
+    }
+    return disp_buf_apply(buf, strategy);
+}
+
+void disp_buf_get_info(disp_buf_handle_t buf, disp_buf_info_t *info)
+{
+    *info = buf->info;
+}
+
+const char *disp_buf_strategy_name(disp_buf_strategy_t strategy)
+{
+    switch (strategy)
+    {
+    case DISP_BUF_AUTO:
+        return "auto";
+    case DISP_BUF_SRAM_DOUBLE:
+        return "sram-double";
+    case DISP_BUF_SRAM_SINGLE:
+        return "sram-single";
+    case DISP_BUF_PSRAM_BOUNCE:
+        return "psram-bounce";
+    }
+    return "?";
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_lcd_panel_ops.h"
+#include "lvgl.h"
+
+#include "disp_flush.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Internal RAM left to the rest of the firmware (tasks, I2C, logging) when stripes are sized from free memory
+#define DISP_BUF_DEFAULT_INTERNAL_RESERVE (64 * 1024)
+// Lowest internal stripe height worth keeping: below that, LVGL redraws nested widgets in too many slices
+#define DISP_BUF_DEFAULT_MIN_ROWS 16
+// Default size of each of the two internal DMA bounce buffers PSRAM stripes are sent from
+#define DISP_BUF_DEFAULT_BOUNCE_BYTES (16 * 1024)
+// Most screens that can have their own strategy
+#define DISP_BUF_MAX_SCREENS 8
+
+typedef struct disp_buf_t *disp_buf_handle_t;
+
+/**
+ * @brief Where LVGL draws
+ */
+typedef enum {
+    DISP_BUF_AUTO,              /*!< Decide from the free memory at apply time: SRAM_DOUBLE, else PSRAM_BOUNCE, else SRAM_SINGLE */
+    DISP_BUF_SRAM_DOUBLE,       /*!< Two internal DMA stripes, LVGL draws one while the other is on the bus */
+    DISP_BUF_SRAM_SINGLE,       /*!< One internal DMA stripe, drawing waits for the bus */
+    DISP_BUF_PSRAM_BOUNCE,      /*!< Two PSRAM stripes, copied to the panel through small internal bounce buffers, by the
+                                     flush engine task when there is one */
+} disp_buf_strategy_t;
+
+/**
+ * @brief Buffer manager configuration
+ */
+typedef struct {
+    esp_lcd_panel_handle_t panel;   /*!< Panel PSRAM stripes are drawn to */
+    disp_flush_handle_t engine;     /*!< Flush engine sending the internal stripes, drained before buffers change (may be NULL) */
+    size_t internal_reserve;        /*!< Internal RAM to leave free, 0 selects DISP_BUF_DEFAULT_INTERNAL_RESERVE */
+    int min_rows;                   /*!< Lowest internal stripe height, 0 selects DISP_BUF_DEFAULT_MIN_ROWS */
+    int max_rows;                   /*!< Highest internal stripe height, 0 selects the screen height */
+    int psram_rows;                 /*!< PSRAM stripe height, 0 selects `max_rows` */
+    size_t bounce_bytes;            /*!< Size of each bounce buffer (two, also with an engine), 0 selects
+                                         DISP_BUF_DEFAULT_BOUNCE_BYTES */
+} disp_buf_config_t;
+
+/**
+ * @brief Buffers in use
+ */
+typedef struct {
+    disp_buf_strategy_t strategy;   /*!< Strategy applied, never DISP_BUF_AUTO */
+    int rows;                       /*!< Stripe height */
+    size_t internal_bytes;          /*!< Internal RAM held: stripes or bounce buffers */
+    size_t psram_bytes;             /*!< PSRAM held */
+    uint32_t switches;              /*!< Buffer reallocations since creation */
+} disp_buf_info_t;
+
+/**
+ * @brief Create a buffer manager
+ *
+ * @param[in]  config  Configuration
+ * @param[out] ret_buf Handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Bad configuration
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t disp_buf_new(const disp_buf_config_t *config, disp_buf_handle_t *ret_buf);
+
+/**
+ * @brief Allocate the draw buffers of `drv` with `strategy` and send PSRAM stripes through the bounce buffers
+ *
+ * Initializes `drv->draw_buf` (which must point to an `lv_disp_draw_buf_t` owned by the caller) and wraps
+ * `drv->flush_cb`, internal stripes still go to the `flush_cb` installed before. Call after `disp_flush_attach`,
+ * if used, before `disp_rotate_attach` and before `lv_disp_drv_register`.
+ */
+esp_err_t disp_buf_attach(disp_buf_handle_t buf, lv_disp_drv_t *drv, disp_buf_strategy_t strategy);
+
+/**
+ * @brief Switch to another strategy between two refreshes, call with the LVGL lock held
+ *
+ * Waits until no area is on the bus, frees the current buffers and allocates the new ones. When the
+ * strategy does not fit, the internal stripe height is lowered down to `min_rows`, then DISP_BUF_AUTO is
+ * tried. Nothing is done when the same strategy and height would be allocated again.
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_NO_MEM: Not even a single `min_rows` stripe fits, the display is left without buffers
+ */
+esp_err_t disp_buf_apply(disp_buf_handle_t buf, disp_buf_strategy_t strategy);
+
+/**
+ * @brief Apply `strategy` whenever `scr` starts loading (LV_EVENT_SCREEN_LOAD_START), until `scr` is deleted
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_NO_MEM: DISP_BUF_MAX_SCREENS screens already have a strategy
+ */
+esp_err_t disp_buf_set_screen_strategy(disp_buf_handle_t buf, lv_obj_t *scr, disp_buf_strategy_t strategy);
+
+/**
+ * @brief Get the buffers in use
+ */
+void disp_buf_get_info(disp_buf_handle_t buf, disp_buf_info_t *info);
+
+/**
+ * @brief Name of a strategy, for logs
+ */
+const char *disp_buf_strategy_name(disp_buf_strategy_t strategy);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,356 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "pixel_conv.h"
+
+#include "disp_port.h"
+#include "disp_fb.h"
+
+static const char *TAG = "disp_fb";
+
+// Displays that can be sent from a framebuffer at the same time
+#define DISP_FB_MAX_DISPLAYS 2
+// Row pairs keep the SH8601 window start even and its end odd
+#define DISP_FB_ROWS_PER_PAIR 2
+// Segments of a row pair are tracked in one mask word
+#define DISP_FB_MAX_SEGS 32
+
+struct disp_fb_t
+{
+    disp_fb_config_t cfg;
+    lv_disp_drv_t *drv;
+    const lv_color_t *fb;
+    int hor_res;
+    int ver_res;
+    int pairs;
+    int segs;
+    uint32_t *hashes;           // pairs * segs, hash of every segment as last sent
+    uint32_t *dirty;            // per row pair, segments LVGL redrew this frame, then those that changed
+    uint8_t *bounce[2];
+    uint8_t bounce_idx;
+    bool inflight;
+    bool hashes_valid;
+    SemaphoreHandle_t trans_done;   // given by the panel IO when a bounce buffer left the bus
+    disp_fb_stats_t stats;
+};
+
+// `drv->user_data` keeps the panel handle for the other display callbacks, so the sender is looked up by driver
+static struct
+{
+    lv_disp_drv_t *drv;
+    disp_fb_handle_t fb;
+} s_attached[DISP_FB_MAX_DISPLAYS];
+
+static disp_fb_handle_t disp_fb_from_drv(lv_disp_drv_t *drv)
+{
+    for (int i = 0; i < DISP_FB_MAX_DISPLAYS; i++)
+    {
+        if (s_attached[i].drv == drv)
+        {
+            return s_attached[i].fb;
+        }
+    }
+    return NULL;
+}
+
+static bool IRAM_ATTR disp_fb_on_trans_done(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    disp_fb_handle_t fb = (disp_fb_handle_t)user_ctx;
+    BaseType_t need_yield = pdFALSE;
+    xSemaphoreGiveFromISR(fb->trans_done, &need_yield);
+    return need_yield == pdTRUE;
+}
+
+// Mark the segments an LVGL invalid area covers
+static void disp_fb_mark(disp_fb_handle_t fb, const lv_area_t *area)
+{
+    const int s1 = area->x1 / DISP_FB_SEG_PX;
+    const int s2 = area->x2 / DISP_FB_SEG_PX;
+    const uint32_t mask = (s2 - s1 == 31 ? UINT32_MAX : (BIT(s2 - s1 + 1) - 1)) << s1;
+    for (int p = area->y1 / DISP_FB_ROWS_PER_PAIR; p <= area->y2 / DISP_FB_ROWS_PER_PAIR; p++)
+    {
+        fb->dirty[p] |= mask;
+    }
+}
+
+static uint32_t disp_fb_hash_row(uint32_t h, const lv_color_t *px, int n)
+{
+    // FNV-1a over 32-bit words: one multiply per word keeps the PSRAM read the bottleneck
+    const size_t bytes = (size_t)n * sizeof(lv_color_t);
+    const uint32_t *w = (const uint32_t *)px;
+    for (size_t i = 0; i < bytes / 4; i++)
+    {
+        h = (h ^ w[i]) * 0x01000193;
+    }
+    if (bytes & 2)
+    {
+        h = (h ^ ((const uint16_t *)px)[bytes / 2 - 1]) * 0x01000193;
+    }
+    return h;
+}
+
+// Hash the redrawn segments and keep in `dirty` only those that differ from what the panel shows
+static void disp_fb_diff(disp_fb_handle_t fb)
+{
+    for (int p = 0; p < fb->pairs; p++)
+    {
+        uint32_t mask = fb->dirty[p];
+        const int y = p * DISP_FB_ROWS_PER_PAIR;
+        const int rows = (y + DISP_FB_ROWS_PER_PAIR > fb->ver_res) ? fb->ver_res - y : DISP_FB_ROWS_PER_PAIR;
+        while (mask)
+        {
+            const int s = __builtin_ctz(mask);
+            mask &= mask - 1;
+            const int x = s * DISP_FB_SEG_PX;
+            const int w = (x + DISP_FB_SEG_PX > fb->hor_res) ? fb->hor_res - x : DISP_FB_SEG_PX;
+            uint32_t h = 0x811c9dc5;
+            for (int r = 0; r < rows; r++)
+            {
+                h = disp_fb_hash_row(h, fb->fb + (size_t)(y + r) * fb->hor_res + x, w);
+            }
+            fb->stats.px_rendered += w * rows;
+            uint32_t *stored = &fb->hashes[p * fb->segs + s];
+            if (fb->hashes_valid && *stored == h)
+            {
+                fb->dirty[p] &= ~BIT(s);
+                continue;
+            }
+            *stored = h;
+            fb->stats.px_changed += w * rows;
+        }
+    }
+    fb->hashes_valid = true;
+}
+
+static void disp_fb_wait_inflight(disp_fb_handle_t fb)
+{
+    if (fb->inflight)
+    {
+        xSemaphoreTake(fb->trans_done, portMAX_DELAY);
+        fb->inflight = false;
+    }
+}
+
+static void disp_fb_copy_row(uint8_t *dst, const lv_color_t *src, int n)
+{
+#if LCD_BIT_PER_PIXEL == 24
+    // lv_color32_t is B, G, R, A in memory, the panel expects R, G, B
+    pixel_conv_xrgb8888_to_rgb888(dst, (const uint32_t *)src, n);
+#elif LCD_BIT_PER_PIXEL == 16 && !LV_COLOR_16_SWAP
+    // The panel takes RGB565 high byte first, swap here when the renderer does not
+    pixel_conv_rgb565_swap((uint16_t *)dst, (const uint16_t *)src, n);
+#else
+    memcpy(dst, src, (size_t)n * sizeof(lv_color_t));
+#endif
+}
+
+// Send a window of the framebuffer in bounce-buffer bands; the next band is copied while the previous one is on the bus
+static void disp_fb_send_rect(disp_fb_handle_t fb, const lv_area_t *rect)
+{
+    const int w = lv_area_get_width(rect);
+    const size_t row_bytes = (size_t)w * LCD_BIT_PER_PIXEL / 8;
+    const int band_rows = fb->cfg.bounce_bytes / row_bytes;
+    for (int y = rect->y1; y <= rect->y2; y += band_rows)
+    {
+        const int y2 = (y + band_rows > rect->y2 + 1) ? rect->y2 + 1 : y + band_rows;
+        uint8_t *dst = fb->bounce[fb->bounce_idx];
+        for (int r = y; r < y2; r++)
+        {
+            disp_fb_copy_row(dst + (size_t)(r - y) * row_bytes, fb->fb + (size_t)r * fb->hor_res + rect->x1, w);
+        }
+        disp_fb_wait_inflight(fb);
+        esp_err_t ret = esp_lcd_panel_draw_bitmap(fb->cfg.panel, rect->x1, y, rect->x2 + 1, y2, dst);
+        if (ret == ESP_OK)
+        {
+            fb->inflight = true;
+        }
+        else
+        {
+            ESP_LOGE(TAG, "draw bitmap failed: %s", esp_err_to_name(ret));
+        }
+        fb->bounce_idx ^= 1;
+    }
+    fb->stats.rects++;
+    fb->stats.px_sent += lv_area_get_size(rect);
+}
+
+// Turn the changed segments into windows: runs of row pairs share a window while widening it costs less than a new one
+static void disp_fb_send_changed(disp_fb_handle_t fb)
+{
+    lv_area_t cur;
+    bool open = false;
+    for (int p = 0; p < fb->pairs; p++)
+    {
+        const uint32_t mask = fb->dirty[p];
+        fb->dirty[p] = 0;
+        if (!mask)
+        {
+            if (open)
+            {
+                disp_fb_send_rect(fb, &cur);
+                open = false;
+            }
+            continue;
+        }
+        const int x1 = __builtin_ctz(mask) * DISP_FB_SEG_PX;
+        const int x2 = LV_MIN((32 - __builtin_clz(mask)) * DISP_FB_SEG_PX, fb->hor_res) - 1;
+        const int y1 = p * DISP_FB_ROWS_PER_PAIR;
+        const int y2 = LV_MIN(y1 + DISP_FB_ROWS_PER_PAIR, fb->ver_res) - 1;
+        lv_area_t span;
+        lv_area_set(&span, x1, y1, x2, y2);
+        if (open)
+        {
+            lv_area_t joined;
+            _lv_area_join(&joined, &cur, &span);
+            const int32_t waste = (int32_t)lv_area_get_size(&joined) - (int32_t)lv_area_get_size(&cur) -
+                                  (int32_t)lv_area_get_size(&span);
+            if (waste <= DISP_FB_RECT_COST_PX)
+            {
+                cur = joined;
+                continue;
+            }
+            disp_fb_send_rect(fb, &cur);
+        }
+        cur = span;
+        open = true;
+    }
+    if (open)
+    {
+        disp_fb_send_rect(fb, &cur);
+    }
+}
+
+static void disp_fb_lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    // Direct mode passes the whole screen for every area, the framebuffer is checked once the frame is complete
+    if (!lv_disp_flush_is_last(drv))
+    {
+        lv_disp_flush_ready(drv);
+        return;
+    }
+    disp_fb_handle_t fb = disp_fb_from_drv(drv);
+    lv_disp_t *disp = _lv_refr_get_disp_refreshing();
+    for (uint16_t i = 0; i < disp->inv_p; i++)
+    {
+        if (!disp->inv_area_joined[i])
+        {
+            disp_fb_mark(fb, &disp->inv_areas[i]);
+        }
+    }
+
+    const int64_t t0 = esp_timer_get_time();
+    disp_fb_diff(fb);
+    const int64_t t1 = esp_timer_get_time();
+    disp_fb_send_changed(fb);
+    // LVGL draws the next frame into the framebuffer, it has to be on the glass first
+    disp_fb_wait_inflight(fb);
+    const int64_t t2 = esp_timer_get_time();
+
+    fb->stats.frames++;
+    fb->stats.hash_us += t1 - t0;
+    fb->stats.send_us += t2 - t1;
+    lv_disp_flush_ready(drv);
+}
+
+esp_err_t disp_fb_new(const disp_fb_config_t *config, disp_fb_handle_t *ret_fb)
+{
+    esp_err_t ret = ESP_OK;
+    disp_fb_handle_t fb = NULL;
+    ESP_RETURN_ON_FALSE(config && ret_fb && config->panel && config->io, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    fb = calloc(1, sizeof(struct disp_fb_t));
+    ESP_RETURN_ON_FALSE(fb, ESP_ERR_NO_MEM, TAG, "no mem for framebuffer sender");
+    fb->cfg = *config;
+    if (fb->cfg.bounce_bytes == 0)
+    {
+        fb->cfg.bounce_bytes = DISP_FB_DEFAULT_BOUNCE_BYTES;
+    }
+
+    // The panel DMA reads internal RAM, PSRAM would need cache write-backs and contiguous rows
+    for (int i = 0; i < 2; i++)
+    {
+        fb->bounce[i] = heap_caps_malloc(fb->cfg.bounce_bytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        ESP_GOTO_ON_FALSE(fb->bounce[i], ESP_ERR_NO_MEM, err, TAG, "no mem for bounce buffer");
+    }
+    fb->trans_done = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(fb->trans_done, ESP_ERR_NO_MEM, err, TAG, "no mem for semaphore");
+
+    *ret_fb = fb;
+    return ESP_OK;
+
+err:
+    heap_caps_free(fb->bounce[0]);
+    heap_caps_free(fb->bounce[1]);
+    free(fb);
+    return ret;
+}
+
+esp_err_t disp_fb_attach(disp_fb_handle_t fb, lv_disp_drv_t *drv)
+{
+    ESP_RETURN_ON_FALSE(fb && drv && drv->draw_buf, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(drv->direct_mode && drv->draw_buf->buf1 && !drv->draw_buf->buf2 &&
+                        drv->draw_buf->size == (uint32_t)drv->hor_res * drv->ver_res,
+                        ESP_ERR_INVALID_ARG, TAG, "needs direct mode with one full-screen buffer");
+    ESP_RETURN_ON_FALSE((drv->hor_res + DISP_FB_SEG_PX - 1) / DISP_FB_SEG_PX <= DISP_FB_MAX_SEGS, ESP_ERR_INVALID_ARG,
+                        TAG, "display too wide");
+    ESP_RETURN_ON_FALSE(fb->cfg.bounce_bytes >= (size_t)drv->hor_res * LCD_BIT_PER_PIXEL / 8, ESP_ERR_INVALID_ARG, TAG,
+                        "bounce buffer smaller than a row");
+    int slot = -1;
+    for (int i = DISP_FB_MAX_DISPLAYS - 1; i >= 0; i--)
+    {
+        if (s_attached[i].drv == drv || (slot < 0 && s_attached[i].drv == NULL))
+        {
+            slot = i;
+        }
+    }
+    ESP_RETURN_ON_FALSE(slot >= 0, ESP_ERR_NO_MEM, TAG, "too many displays");
+
+    fb->hor_res = drv->hor_res;
+    fb->ver_res = drv->ver_res;
+    fb->pairs = (fb->ver_res + DISP_FB_ROWS_PER_PAIR - 1) / DISP_FB_ROWS_PER_PAIR;
+    fb->segs = (fb->hor_res + DISP_FB_SEG_PX - 1) / DISP_FB_SEG_PX;
+    free(fb->hashes);
+    free(fb->dirty);
+    fb->hashes = calloc(fb->pairs * fb->segs, sizeof(uint32_t));
+    fb->dirty = calloc(fb->pairs, sizeof(uint32_t));
+    ESP_RETURN_ON_FALSE(fb->hashes && fb->dirty, ESP_ERR_NO_MEM, TAG, "no mem for row hashes");
+    fb->hashes_valid = false;
+
+    const esp_lcd_panel_io_callbacks_t cbs = {
+        .on_color_trans_done = disp_fb_on_trans_done,
+    };
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_io_register_event_callbacks(fb->cfg.io, &cbs, fb), TAG,
+                        "register IO callback failed");
+
+    s_attached[slot].drv = drv;
+    s_attached[slot].fb = fb;
+    fb->drv = drv;
+    fb->fb = drv->draw_buf->buf1;
+    drv->flush_cb = disp_fb_lvgl_flush_cb;
+    ESP_LOGI(TAG, "%dx%d framebuffer, %d x %d segments, 2 x %u byte bounce buffers", fb->hor_res, fb->ver_res,
+             fb->pairs, fb->segs, (unsigned)fb->cfg.bounce_bytes);
+    return ESP_OK;
+}
+
+void disp_fb_invalidate(disp_fb_handle_t fb)
+{
+    // Segments LVGL does not redraw next keep a zero hash, which practically never matches real content
+    memset(fb->hashes, 0, (size_t)fb->pairs * fb->segs * sizeof(uint32_t));
+    fb->hashes_valid = false;
+}
+
+void disp_fb_get_stats(disp_fb_handle_t fb, disp_fb_stats_t *stats, bool reset)
+{
+    *stats = fb->stats;
+    if (reset)
+    {
+        memset(&fb->stats, 0, sizeof(fb->stats));
+    }
+}
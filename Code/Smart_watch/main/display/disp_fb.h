@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_ops.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default size of each of the two internal DMA bounce buffers
+#define DISP_FB_DEFAULT_BOUNCE_BYTES (16 * 1024)
+// Width of the column segments a framebuffer row pair is hashed in, changed spans are sent at this granularity
+#define DISP_FB_SEG_PX 32
+// A new panel window (CASET + RASET + RAMWR, ~30 us) costs about as much as sending this many extra pixels
+#define DISP_FB_RECT_COST_PX 300
+
+typedef struct disp_fb_t *disp_fb_handle_t;
+
+/**
+ * @brief PSRAM framebuffer configuration
+ */
+typedef struct {
+    esp_lcd_panel_handle_t panel;   /*!< Panel the changed spans are drawn to */
+    esp_lcd_panel_io_handle_t io;   /*!< IO of the panel, its `on_color_trans_done` is taken over */
+    size_t bounce_bytes;            /*!< Size of each bounce buffer, 0 selects DISP_FB_DEFAULT_BOUNCE_BYTES */
+} disp_fb_config_t;
+
+/**
+ * @brief Framebuffer counters since the last reset
+ */
+typedef struct {
+    uint32_t frames;            /*!< Refreshes checked against the framebuffer hashes */
+    uint32_t rects;             /*!< Windows sent to the panel */
+    uint64_t px_rendered;       /*!< Pixels in the segments LVGL redrew */
+    uint64_t px_changed;        /*!< Pixels in the segments whose hash changed */
+    uint64_t px_sent;           /*!< Pixels sent to the panel, changed segments plus what merging windows added */
+    uint64_t hash_us;           /*!< Time spent hashing redrawn segments */
+    uint64_t send_us;           /*!< Time spent copying to the bounce buffers and sending */
+} disp_fb_stats_t;
+
+/**
+ * @brief Create a framebuffer sender and its bounce buffers
+ *
+ * @param[in]  config Configuration
+ * @param[out] ret_fb Handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Bad configuration
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t disp_fb_new(const disp_fb_config_t *config, disp_fb_handle_t *ret_fb);
+
+/**
+ * @brief Send the frames of an LVGL direct mode driver through the framebuffer sender
+ *
+ * `drv->draw_buf` must be a single full-screen buffer (the framebuffer, normally in PSRAM) and
+ * `drv->direct_mode` set. Every refresh, the segments LVGL redrew are hashed and only those that changed
+ * since the last frame are copied through the bounce buffers to the panel. Installs `flush_cb` and
+ * registers the panel IO `on_color_trans_done` callback. Call before `lv_disp_drv_register`.
+ */
+esp_err_t disp_fb_attach(disp_fb_handle_t fb, lv_disp_drv_t *drv);
+
+/**
+ * @brief Forget the framebuffer hashes, e.g. after the panel lost its content, so the next refresh sends
+ *        everything LVGL redraws; invalidate the screen as well to resend all of it
+ */
+void disp_fb_invalidate(disp_fb_handle_t fb);
+
+/**
+ * @brief Get the framebuffer counters and optionally clear them
+ */
+void disp_fb_get_stats(disp_fb_handle_t fb, disp_fb_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,559 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "disp_port.h"
+#include "disp_flush.h"
+
+static const char *TAG = "disp_flush";
+
+// Displays that can be routed through an engine at the same time
+#define DISP_FLUSH_MAX_DISPLAYS 2
+// The sub-transfer closes the LVGL area, the draw buffer can be handed back
+#define DISP_FLUSH_JOB_LAST_OF_AREA BIT(0)
+// The sub-transfer closes the frame
+#define DISP_FLUSH_JOB_LAST_OF_FRAME BIT(1)
+
+// One DMA-sized band of an LVGL area, pointing into the LVGL draw buffer
+typedef struct
+{
+    int16_t x1;
+    int16_t y1;
+    int16_t x2; // exclusive
+    int16_t y2; // exclusive
+    const void *data;
+    uint8_t flags;
+    uint8_t frame;
+} disp_flush_job_t;
+
+// A band handed to the panel IO whose transfer has not completed yet
+typedef struct
+{
+    disp_flush_job_t job;
+    int64_t sent_us;
+    int8_t bounce;                  // bounce buffer it is sent from, -1 for the draw buffer
+} disp_flush_inflight_t;
+
+// Book-keeping of a frame; two frames can be in flight, one rendering while the other drains
+typedef struct
+{
+    int64_t start_us;
+    int64_t render_end_us;
+    int64_t transfer_end_us;
+    bool render_done;
+    bool transfer_done;
+    disp_flush_stats_t st;
+} disp_flush_frame_t;
+
+struct disp_flush_t
+{
+    disp_flush_config_t cfg;
+    lv_disp_drv_t *drv;
+    QueueHandle_t jobs;
+    SemaphoreHandle_t trans_done;   // counts the sub-transfers that left the bus, given by the panel IO
+    SemaphoreHandle_t flush_done;   // given when an LVGL draw buffer is free again
+    SemaphoreHandle_t lock;         // protects frames, last, total and pending
+    TaskHandle_t task;
+    disp_flush_frame_t frames[2];
+    uint8_t frame_seq;
+    uint32_t pending;
+    disp_flush_inflight_t *inflight; // ring of queue_depth bands on the bus, oldest first; owned by the sender
+    size_t inflight_head;
+    size_t inflight_count;
+    int64_t bus_free_us;            // when the last retired band left the bus
+    uint8_t *bounce[2];             // internal copies of the bands, for draw buffers the DMA cannot read
+    uint8_t bounce_idx;
+    size_t bounce_bytes;
+    disp_flush_stats_t last;
+    disp_flush_stats_t total;
+};
+
+// `drv->user_data` keeps the panel handle for the other display callbacks, so the engine is looked up by driver
+static struct
+{
+    lv_disp_drv_t *drv;
+    disp_flush_handle_t engine;
+} s_attached[DISP_FLUSH_MAX_DISPLAYS];
+
+static disp_flush_handle_t disp_flush_from_drv(lv_disp_drv_t *drv)
+{
+    for (int i = 0; i < DISP_FLUSH_MAX_DISPLAYS; i++)
+    {
+        if (s_attached[i].drv == drv)
+        {
+            return s_attached[i].engine;
+        }
+    }
+    return NULL;
+}
+
+static bool IRAM_ATTR disp_flush_on_trans_done(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    disp_flush_handle_t engine = (disp_flush_handle_t)user_ctx;
+    BaseType_t need_yield = pdFALSE;
+    xSemaphoreGiveFromISR(engine->trans_done, &need_yield);
+    return need_yield == pdTRUE;
+}
+
+static void disp_flush_stats_add(disp_flush_stats_t *dst, const disp_flush_stats_t *src)
+{
+    dst->frames += src->frames;
+    dst->areas += src->areas;
+    dst->chunks += src->chunks;
+    dst->pixels += src->pixels;
+    dst->render_us += src->render_us;
+    dst->transfer_us += src->transfer_us;
+    dst->wall_us += src->wall_us;
+    dst->overlap_us += src->overlap_us;
+    dst->blocked_us += src->blocked_us;
+    if (src->max_queued > dst->max_queued)
+    {
+        dst->max_queued = src->max_queued;
+    }
+}
+
+// Close the frame once both rendering and transmission are done, called with the lock held
+static bool disp_flush_frame_try_finish(disp_flush_handle_t engine, disp_flush_frame_t *frame)
+{
+    if (!frame->render_done || !frame->transfer_done)
+    {
+        return false;
+    }
+    const int64_t end_us = frame->transfer_end_us > frame->render_end_us ? frame->transfer_end_us : frame->render_end_us;
+    frame->st.frames = 1;
+    frame->st.wall_us = end_us - frame->start_us;
+    const int64_t overlap = (int64_t)frame->st.render_us + (int64_t)frame->st.transfer_us - (int64_t)frame->st.wall_us;
+    frame->st.overlap_us = overlap > 0 ? overlap : 0;
+    engine->last = frame->st;
+    disp_flush_stats_add(&engine->total, &frame->st);
+    frame->render_done = false;
+    frame->transfer_done = false;
+    return true;
+}
+
+static void disp_flush_frame_finished(disp_flush_handle_t engine)
+{
+    if (engine->cfg.on_frame)
+    {
+        engine->cfg.on_frame(engine, &engine->last, engine->cfg.user_ctx);
+    }
+}
+
+// Account a sent band, hand the draw buffer back to LVGL at the end of an area
+static void disp_flush_complete(disp_flush_handle_t engine, const disp_flush_job_t *job, int64_t bus_us)
+{
+    bool finished = false;
+    xSemaphoreTake(engine->lock, portMAX_DELAY);
+    disp_flush_frame_t *frame = &engine->frames[job->frame];
+    frame->st.chunks++;
+    frame->st.pixels += (uint32_t)(job->x2 - job->x1) * (uint32_t)(job->y2 - job->y1);
+    frame->st.transfer_us += bus_us;
+    if (job->flags & DISP_FLUSH_JOB_LAST_OF_FRAME)
+    {
+        frame->transfer_end_us = esp_timer_get_time();
+        frame->transfer_done = true;
+        finished = disp_flush_frame_try_finish(engine, frame);
+    }
+    engine->pending--;
+    xSemaphoreGive(engine->lock);
+
+    if (job->flags & DISP_FLUSH_JOB_LAST_OF_AREA)
+    {
+        lv_disp_flush_ready(engine->drv);
+        xSemaphoreGive(engine->flush_done);
+    }
+    if (finished)
+    {
+        disp_flush_frame_finished(engine);
+    }
+}
+
+// Account the oldest band in flight once it left the bus, waiting up to `ticks_to_wait`; false if it did not
+static bool disp_flush_retire(disp_flush_handle_t engine, TickType_t ticks_to_wait)
+{
+    if (xSemaphoreTake(engine->trans_done, ticks_to_wait) != pdTRUE)
+    {
+        return false;
+    }
+    const int64_t now = esp_timer_get_time();
+    const disp_flush_inflight_t band = engine->inflight[engine->inflight_head];
+    engine->inflight_head = (engine->inflight_head + 1) % engine->cfg.queue_depth;
+    engine->inflight_count--;
+    // The bus time of a band starts when it was sent, or when the band before it was done if that was later
+    const int64_t from = band.sent_us > engine->bus_free_us ? band.sent_us : engine->bus_free_us;
+    engine->bus_free_us = now;
+    disp_flush_complete(engine, &band.job, now - from);
+    return true;
+}
+
+static bool disp_flush_bounce_in_flight(disp_flush_handle_t engine, int bounce)
+{
+    for (size_t i = 0; i < engine->inflight_count; i++)
+    {
+        if (engine->inflight[(engine->inflight_head + i) % engine->cfg.queue_depth].bounce == bounce)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Hand one band to the panel IO without waiting for its transfer, the following bands queue up behind it; waits
+// only for a free slot in the ring, or for the band sent from the bounce buffer this one is copied into
+static void disp_flush_send(disp_flush_handle_t engine, const disp_flush_job_t *job)
+{
+    if (engine->inflight_count == 0)
+    {
+        // Drop completions left by transfers that bypassed the engine, e.g. rotated areas from disp_rotate
+        while (xSemaphoreTake(engine->trans_done, 0) == pdTRUE)
+        {
+        }
+    }
+    while (engine->inflight_count == engine->cfg.queue_depth)
+    {
+        disp_flush_retire(engine, portMAX_DELAY);
+    }
+    disp_flush_inflight_t band = {
+        .job = *job,
+        .sent_us = esp_timer_get_time(),
+        .bounce = -1,
+    };
+    const void *data = job->data;
+    if (engine->bounce[0])
+    {
+        band.bounce = engine->bounce_idx;
+        engine->bounce_idx ^= 1;
+        while (disp_flush_bounce_in_flight(engine, band.bounce))
+        {
+            disp_flush_retire(engine, portMAX_DELAY);
+        }
+        const size_t bytes = (size_t)(job->x2 - job->x1) * (job->y2 - job->y1) * LCD_BIT_PER_PIXEL / 8;
+        memcpy(engine->bounce[band.bounce], data, bytes);
+        data = engine->bounce[band.bounce];
+    }
+    esp_err_t ret = esp_lcd_panel_draw_bitmap(engine->cfg.panel, job->x1, job->y1, job->x2, job->y2, data);
+    if (ret != ESP_OK)
+    {
+        // Nothing went on the bus, no completion will come; the bands before it are handed back first
+        ESP_LOGE(TAG, "draw bitmap failed: %s", esp_err_to_name(ret));
+        while (engine->inflight_count)
+        {
+            disp_flush_retire(engine, portMAX_DELAY);
+        }
+        disp_flush_complete(engine, job, esp_timer_get_time() - band.sent_us);
+        return;
+    }
+    engine->inflight[(engine->inflight_head + engine->inflight_count) % engine->cfg.queue_depth] = band;
+    engine->inflight_count++;
+    // The draw buffer goes back to LVGL as soon as the last band of its area is done, not once the ring drains
+    while (disp_flush_retire(engine, 0))
+    {
+    }
+}
+
+// Flush task: keeps the QSPI bus busy with the queued bands while LVGL renders the next area
+static void disp_flush_task(void *arg)
+{
+    disp_flush_handle_t engine = (disp_flush_handle_t)arg;
+    disp_flush_job_t job;
+    ESP_LOGI(TAG, "Starting flush task");
+    while (1)
+    {
+        // Bands already queued go to the panel IO right away; with none waiting the task blocks on the oldest band
+        // in flight, and with none in flight on the queue
+        if (xQueueReceive(engine->jobs, &job, engine->inflight_count ? 0 : portMAX_DELAY) == pdTRUE)
+        {
+            disp_flush_send(engine, &job);
+        }
+        else if (engine->inflight_count)
+        {
+            disp_flush_retire(engine, portMAX_DELAY);
+        }
+    }
+}
+
+static void disp_flush_lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    disp_flush_handle_t engine = disp_flush_from_drv(drv);
+    const int64_t t0 = esp_timer_get_time();
+
+    example_lvgl_color_pack(area, color_map);
+
+    // Split the area into bands of whole rows that fit one sub-transfer
+    const int width = lv_area_get_width(area);
+    const size_t row_bytes = (size_t)width * LCD_BIT_PER_PIXEL / 8;
+    int band_rows = (engine->bounce[0] ? engine->bounce_bytes : engine->cfg.chunk_bytes) / row_bytes;
+    if (band_rows < 1)
+    {
+        band_rows = 1;
+    }
+    const bool last_of_frame = lv_disp_flush_is_last(drv);
+    const uint8_t *data = (const uint8_t *)color_map;
+    disp_flush_job_t job = {
+        .x1 = area->x1,
+        .x2 = area->x2 + 1,
+        .frame = engine->frame_seq & 1,
+    };
+
+    xSemaphoreTake(engine->lock, portMAX_DELAY);
+    engine->frames[job.frame].st.areas++;
+    xSemaphoreGive(engine->lock);
+
+    for (int y = area->y1; y <= area->y2; y += band_rows)
+    {
+        job.y1 = y;
+        job.y2 = (y + band_rows > area->y2 + 1) ? area->y2 + 1 : y + band_rows;
+        job.data = data;
+        job.flags = 0;
+        if (job.y2 == area->y2 + 1)
+        {
+            job.flags |= DISP_FLUSH_JOB_LAST_OF_AREA;
+            if (last_of_frame)
+            {
+                job.flags |= DISP_FLUSH_JOB_LAST_OF_FRAME;
+            }
+        }
+        data += (size_t)(job.y2 - job.y1) * row_bytes;
+
+        if (engine->cfg.serialized)
+        {
+            // Reference mode: rendering stops until the band is on the glass
+            xSemaphoreTake(engine->lock, portMAX_DELAY);
+            engine->pending++;
+            xSemaphoreGive(engine->lock);
+            disp_flush_send(engine, &job);
+            while (engine->inflight_count)
+            {
+                disp_flush_retire(engine, portMAX_DELAY);
+            }
+            continue;
+        }
+
+        xSemaphoreTake(engine->lock, portMAX_DELAY);
+        engine->pending++;
+        xSemaphoreGive(engine->lock);
+        xQueueSend(engine->jobs, &job, portMAX_DELAY);
+        const uint32_t queued = uxQueueMessagesWaiting(engine->jobs);
+        xSemaphoreTake(engine->lock, portMAX_DELAY);
+        if (queued > engine->frames[job.frame].st.max_queued)
+        {
+            engine->frames[job.frame].st.max_queued = queued;
+        }
+        xSemaphoreGive(engine->lock);
+    }
+
+    if (engine->cfg.serialized)
+    {
+        xSemaphoreTake(engine->lock, portMAX_DELAY);
+        engine->frames[engine->frame_seq & 1].st.blocked_us += esp_timer_get_time() - t0;
+        xSemaphoreGive(engine->lock);
+    }
+}
+
+// LVGL waits here for the other draw buffer instead of spinning on `flushing`
+static void disp_flush_lvgl_wait_cb(lv_disp_drv_t *drv)
+{
+    disp_flush_handle_t engine = disp_flush_from_drv(drv);
+    const int64_t t0 = esp_timer_get_time();
+    xSemaphoreTake(engine->flush_done, pdMS_TO_TICKS(10));
+    xSemaphoreTake(engine->lock, portMAX_DELAY);
+    engine->frames[engine->frame_seq & 1].st.blocked_us += esp_timer_get_time() - t0;
+    xSemaphoreGive(engine->lock);
+}
+
+static void disp_flush_lvgl_render_start_cb(lv_disp_drv_t *drv)
+{
+    disp_flush_handle_t engine = disp_flush_from_drv(drv);
+    xSemaphoreTake(engine->lock, portMAX_DELAY);
+    engine->frame_seq++;
+    disp_flush_frame_t *frame = &engine->frames[engine->frame_seq & 1];
+    memset(frame, 0, sizeof(*frame));
+    frame->start_us = esp_timer_get_time();
+    xSemaphoreGive(engine->lock);
+}
+
+static void disp_flush_lvgl_monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    disp_flush_handle_t engine = disp_flush_from_drv(drv);
+    xSemaphoreTake(engine->lock, portMAX_DELAY);
+    disp_flush_frame_t *frame = &engine->frames[engine->frame_seq & 1];
+    frame->render_end_us = esp_timer_get_time();
+    const int64_t render_us = frame->render_end_us - frame->start_us - (int64_t)frame->st.blocked_us;
+    frame->st.render_us = render_us > 0 ? render_us : 0;
+    frame->render_done = true;
+    const bool finished = disp_flush_frame_try_finish(engine, frame);
+    xSemaphoreGive(engine->lock);
+    if (finished)
+    {
+        disp_flush_frame_finished(engine);
+    }
+}
+
+esp_err_t disp_flush_new(const disp_flush_config_t *config, disp_flush_handle_t *ret_engine)
+{
+    esp_err_t ret = ESP_OK;
+    disp_flush_handle_t engine = NULL;
+    ESP_RETURN_ON_FALSE(config && ret_engine && config->panel && config->io, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    engine = calloc(1, sizeof(struct disp_flush_t));
+    ESP_RETURN_ON_FALSE(engine, ESP_ERR_NO_MEM, TAG, "no mem for flush engine");
+    engine->cfg = *config;
+    if (engine->cfg.chunk_bytes == 0)
+    {
+        engine->cfg.chunk_bytes = DISP_FLUSH_DEFAULT_CHUNK_BYTES;
+    }
+    if (engine->cfg.queue_depth == 0)
+    {
+        engine->cfg.queue_depth = DISP_FLUSH_DEFAULT_QUEUE_DEPTH;
+    }
+    if (engine->cfg.task_stack == 0)
+    {
+        engine->cfg.task_stack = 3 * 1024;
+    }
+
+    engine->jobs = xQueueCreate(engine->cfg.queue_depth, sizeof(disp_flush_job_t));
+    engine->inflight = calloc(engine->cfg.queue_depth, sizeof(disp_flush_inflight_t));
+    engine->trans_done = xSemaphoreCreateCounting(engine->cfg.queue_depth, 0);
+    engine->flush_done = xSemaphoreCreateBinary();
+    engine->lock = xSemaphoreCreateMutex();
+    ESP_GOTO_ON_FALSE(engine->jobs && engine->inflight && engine->trans_done && engine->flush_done && engine->lock, ESP_ERR_NO_MEM, err, TAG,
+                      "no mem for flush queue");
+
+    if (!engine->cfg.serialized)
+    {
+        BaseType_t res = xTaskCreatePinnedToCore(disp_flush_task, "disp_flush", engine->cfg.task_stack, engine,
+                                                 engine->cfg.task_priority, &engine->task, engine->cfg.task_core);
+        ESP_GOTO_ON_FALSE(res == pdPASS, ESP_ERR_NO_MEM, err, TAG, "create flush task failed");
+    }
+
+    *ret_engine = engine;
+    return ESP_OK;
+
+err:
+    if (engine->jobs)
+    {
+        vQueueDelete(engine->jobs);
+    }
+    free(engine->inflight);
+    if (engine->trans_done)
+    {
+        vSemaphoreDelete(engine->trans_done);
+    }
+    if (engine->flush_done)
+    {
+        vSemaphoreDelete(engine->flush_done);
+    }
+    if (engine->lock)
+    {
+        vSemaphoreDelete(engine->lock);
+    }
+    free(engine);
+    return ret;
+}
+
+esp_err_t disp_flush_attach(disp_flush_handle_t engine, lv_disp_drv_t *drv)
+{
+    ESP_RETURN_ON_FALSE(engine && drv, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    int slot = -1;
+    for (int i = DISP_FLUSH_MAX_DISPLAYS - 1; i >= 0; i--)
+    {
+        if (s_attached[i].drv == drv || (slot < 0 && s_attached[i].drv == NULL))
+        {
+            slot = i;
+        }
+    }
+    ESP_RETURN_ON_FALSE(slot >= 0, ESP_ERR_NO_MEM, TAG, "too many displays");
+    const esp_lcd_panel_io_callbacks_t cbs = {
+        .on_color_trans_done = disp_flush_on_trans_done,
+    };
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_io_register_event_callbacks(engine->cfg.io, &cbs, engine), TAG,
+                        "register IO callback failed");
+
+    s_attached[slot].drv = drv;
+    s_attached[slot].engine = engine;
+    engine->drv = drv;
+    drv->flush_cb = disp_flush_lvgl_flush_cb;
+    drv->wait_cb = disp_flush_lvgl_wait_cb;
+    drv->render_start_cb = disp_flush_lvgl_render_start_cb;
+    drv->monitor_cb = disp_flush_lvgl_monitor_cb;
+    return ESP_OK;
+}
+
+esp_err_t disp_flush_set_bounce(disp_flush_handle_t engine, size_t bounce_bytes)
+{
+    ESP_RETURN_ON_FALSE(engine, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_ERROR(disp_flush_wait_idle(engine, portMAX_DELAY), TAG, "engine busy");
+    for (int i = 0; i < 2; i++)
+    {
+        heap_caps_free(engine->bounce[i]);
+        engine->bounce[i] = NULL;
+    }
+    engine->bounce_bytes = 0;
+    if (bounce_bytes)
+    {
+        // The panel DMA reads internal RAM; two, so a band is copied while the one before it is on the bus
+        for (int i = 0; i < 2; i++)
+        {
+            engine->bounce[i] = heap_caps_malloc(bounce_bytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+            if (!engine->bounce[i])
+            {
+                heap_caps_free(engine->bounce[0]);
+                engine->bounce[0] = NULL;
+                ESP_LOGE(TAG, "no mem for bounce buffer");
+                return ESP_ERR_NO_MEM;
+            }
+        }
+        engine->bounce_bytes = bounce_bytes;
+    }
+    return ESP_OK;
+}
+
+void disp_flush_get_stats(disp_flush_handle_t engine, disp_flush_stats_t *last, disp_flush_stats_t *total)
+{
+    xSemaphoreTake(engine->lock, portMAX_DELAY);
+    if (last)
+    {
+        *last = engine->last;
+    }
+    if (total)
+    {
+        *total = engine->total;
+    }
+    xSemaphoreGive(engine->lock);
+}
+
+void disp_flush_reset_stats(disp_flush_handle_t engine)
+{
+    xSemaphoreTake(engine->lock, portMAX_DELAY);
+    memset(&engine->total, 0, sizeof(engine->total));
+    xSemaphoreGive(engine->lock);
+}
+
+esp_err_t disp_flush_wait_idle(disp_flush_handle_t engine, TickType_t ticks_to_wait)
+{
+    const TickType_t start = xTaskGetTickCount();
+    while (1)
+    {
+        xSemaphoreTake(engine->lock, portMAX_DELAY);
+        const uint32_t pending = engine->pending;
+        xSemaphoreGive(engine->lock);
+        if (pending == 0)
+        {
+            return ESP_OK;
+        }
+        if (ticks_to_wait != portMAX_DELAY && xTaskGetTickCount() - start >= ticks_to_wait)
+        {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(1);
+    }
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_ops.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default size of one sub-transfer handed to the QSPI DMA
+#define DISP_FLUSH_DEFAULT_CHUNK_BYTES (32 * 1024)
+// Default number of sub-transfers that can wait for the flush task, and of those it keeps queued in the panel IO
+#define DISP_FLUSH_DEFAULT_QUEUE_DEPTH 16
+
+typedef struct disp_flush_t *disp_flush_handle_t;
+
+/**
+ * @brief Timing of one LVGL refresh, or the sum over all refreshes
+ *
+ * `render_us` is the time LVGL spent drawing (refresh time minus the time it was blocked on the
+ * bus), `transfer_us` the time the bus was busy with this frame, `wall_us` the time from the start
+ * of rendering to the end of the last transfer. Rendering and transmission overlap by
+ * `overlap_us = render_us + transfer_us - wall_us`; a fully serialized frame has zero overlap.
+ */
+typedef struct {
+    uint32_t frames;            /*!< Number of refreshes (1 for a single frame) */
+    uint32_t areas;             /*!< Areas flushed by LVGL */
+    uint32_t chunks;            /*!< Sub-transfers sent to the panel */
+    uint32_t pixels;            /*!< Pixels sent to the panel */
+    uint64_t render_us;         /*!< LVGL drawing time */
+    uint64_t transfer_us;       /*!< Bus busy time */
+    uint64_t wall_us;           /*!< Render start to last transfer done */
+    uint64_t overlap_us;        /*!< Rendering hidden behind transmission */
+    uint64_t blocked_us;        /*!< Time LVGL waited for a free draw buffer */
+    uint32_t max_queued;        /*!< Highest number of sub-transfers waiting for the bus */
+} disp_flush_stats_t;
+
+/**
+ * @brief Called once per frame, from whichever of the LVGL and flush tasks finishes it last
+ */
+typedef void (*disp_flush_frame_cb_t)(disp_flush_handle_t engine, const disp_flush_stats_t *frame, void *user_ctx);
+
+/**
+ * @brief Flush engine configuration
+ */
+typedef struct {
+    esp_lcd_panel_handle_t panel;       /*!< Panel the areas are drawn to */
+    esp_lcd_panel_io_handle_t io;       /*!< IO of the panel, its `on_color_trans_done` is taken over by the engine */
+    size_t chunk_bytes;                 /*!< Maximum size of one sub-transfer, 0 selects DISP_FLUSH_DEFAULT_CHUNK_BYTES */
+    size_t queue_depth;                 /*!< Sub-transfer queue length, and most sub-transfers handed to the panel IO
+                                             before the first of them is waited for; 0 selects
+                                             DISP_FLUSH_DEFAULT_QUEUE_DEPTH */
+    bool serialized;                    /*!< Reference mode: the flush callback waits until the area is on the glass */
+    uint32_t task_stack;                /*!< Flush task stack size in bytes */
+    UBaseType_t task_priority;          /*!< Flush task priority, should be above the LVGL task */
+    BaseType_t task_core;               /*!< Flush task core, or tskNO_AFFINITY */
+    disp_flush_frame_cb_t on_frame;     /*!< Optional per-frame statistics callback */
+    void *user_ctx;                     /*!< Passed to `on_frame` */
+} disp_flush_config_t;
+
+/**
+ * @brief Create the flush engine and its task
+ *
+ * @param[in]  config     Engine configuration
+ * @param[out] ret_engine Engine handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Bad configuration
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t disp_flush_new(const disp_flush_config_t *config, disp_flush_handle_t *ret_engine);
+
+/**
+ * @brief Route an LVGL display driver through the engine
+ *
+ * Installs `flush_cb`, `wait_cb`, `render_start_cb` and `monitor_cb` in the driver and registers
+ * the engine as the panel IO `on_color_trans_done` callback. Call before `lv_disp_drv_register`.
+ */
+esp_err_t disp_flush_attach(disp_flush_handle_t engine, lv_disp_drv_t *drv);
+
+/**
+ * @brief Copy every band into one of two internal bounce buffers before it is sent, for draw buffers in PSRAM
+ *
+ * Bands are cut to `bounce_bytes`; the copy runs in the flush task, so LVGL keeps drawing meanwhile, and a band
+ * is copied while the one before it is on the bus. Waits until the engine is idle. 0 frees the bounce buffers and
+ * sends straight from the draw buffers again.
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_NO_MEM: Out of internal DMA memory, bouncing is off
+ */
+esp_err_t disp_flush_set_bounce(disp_flush_handle_t engine, size_t bounce_bytes);
+
+/**
+ * @brief Get the statistics of the last completed frame and the totals since the last reset
+ *
+ * @param[in]  engine Engine handle
+ * @param[out] last   Last frame (may be NULL)
+ * @param[out] total  Sum over all frames (may be NULL)
+ */
+void disp_flush_get_stats(disp_flush_handle_t engine, disp_flush_stats_t *last, disp_flush_stats_t *total);
+
+/**
+ * @brief Clear the accumulated totals
+ */
+void disp_flush_reset_stats(disp_flush_handle_t engine);
+
+/**
+ * @brief Block until every queued sub-transfer is on the glass
+ */
+esp_err_t disp_flush_wait_idle(disp_flush_handle_t engine, TickType_t ticks_to_wait);
+
+#ifdef __cplusplus
+}
+#endif
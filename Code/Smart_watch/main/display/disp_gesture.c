@@ -0,0 +1,322 @@
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_log.h"
+
+#include "disp_gesture.h"
+
+static const char *TAG = "disp_gesture";
+
+// Samples kept for the velocity, about 100 ms of FT5x06 reports
+#define DISP_GESTURE_HISTORY 8
+
+typedef enum
+{
+    DISP_GESTURE_IDLE,              // nothing touches the screen
+    DISP_GESTURE_TRACKING,          // touched, direction not locked yet
+    DISP_GESTURE_DRAGGING,          // a transition follows the finger
+    DISP_GESTURE_DONE,              // gesture sent or none possible, the rest of the touch is LVGL's
+} disp_gesture_state_t;
+
+typedef struct
+{
+    lv_coord_t x;
+    lv_coord_t y;
+    int64_t t_us;
+} disp_gesture_point_t;
+
+struct disp_gesture_t
+{
+    disp_gesture_config_t cfg;
+    lv_indev_t *indev;
+    disp_gesture_state_t state;
+    disp_gesture_point_t down;      // where the touch started
+    disp_gesture_point_t history[DISP_GESTURE_HISTORY];
+    size_t head;                    // next slot of `history`
+    size_t count;
+    lv_dir_t dir;                   // locked direction
+    bool in_event;                  // sending LV_EVENT_GESTURE, loads start a drag
+    lv_coord_t span;                // travel from no progress to the whole transition
+    int time;                       // duration of the whole transition, as asked by the UI
+    disp_gesture_stats_t stats;
+};
+
+static void disp_gesture_push(disp_gesture_handle_t gesture, lv_coord_t x, lv_coord_t y, int64_t t_us)
+{
+    gesture->history[gesture->head] = (disp_gesture_point_t) {x, y, t_us};
+    gesture->head = (gesture->head + 1) % DISP_GESTURE_HISTORY;
+    if (gesture->count < DISP_GESTURE_HISTORY)
+    {
+        gesture->count++;
+    }
+}
+
+// Least squares velocity over the samples of the last `window_ms`, in pixels per second
+static void disp_gesture_velocity(disp_gesture_handle_t gesture, int32_t *vx, int32_t *vy)
+{
+    *vx = 0;
+    *vy = 0;
+    if (gesture->count < 2)
+    {
+        return;
+    }
+    const disp_gesture_point_t *last = &gesture->history[(gesture->head + DISP_GESTURE_HISTORY - 1) % DISP_GESTURE_HISTORY];
+    int64_t n = 0, st = 0, stt = 0, sx = 0, sy = 0, stx = 0, sty = 0;
+    for (size_t i = 0; i < gesture->count; i++)
+    {
+        const disp_gesture_point_t *p = &gesture->history[(gesture->head + DISP_GESTURE_HISTORY - 1 - i) % DISP_GESTURE_HISTORY];
+        // Relative to the newest sample, so the sums stay small
+        const int64_t t = p->t_us - last->t_us;
+        if (-t > (int64_t)gesture->cfg.window_ms * 1000)
+        {
+            break;
+        }
+        n++;
+        st += t;
+        stt += t * t;
+        sx += p->x;
+        sy += p->y;
+        stx += t * p->x;
+        sty += t * p->y;
+    }
+    const int64_t den = n * stt - st * st;
+    if (n < 2 || den <= 0)
+    {
+        return;
+    }
+    *vx = (int32_t)((n * stx - st * sx) * 1000000 / den);
+    *vy = (int32_t)((n * sty - st * sy) * 1000000 / den);
+}
+
+// Travel and velocity along the locked direction
+static lv_coord_t disp_gesture_along(disp_gesture_handle_t gesture, lv_coord_t dx, lv_coord_t dy, int32_t vx,
+                                     int32_t vy, int32_t *v)
+{
+    switch (gesture->dir)
+    {
+    case LV_DIR_LEFT:
+        *v = -vx;
+        return -dx;
+    case LV_DIR_RIGHT:
+        *v = vx;
+        return dx;
+    case LV_DIR_TOP:
+        *v = -vy;
+        return -dy;
+    default:
+        *v = vy;
+        return dy;
+    }
+}
+
+// Finish the drag, on to the new screen or back
+static void disp_gesture_release(disp_gesture_handle_t gesture, bool commit)
+{
+    const int32_t progress = disp_trans_get_progress(gesture->cfg.trans);
+    const int32_t rest = commit ? DISP_TRANS_PROGRESS_MAX - progress : progress;
+    // What is left of the animation the UI asked for, at its speed
+    disp_trans_release(gesture->cfg.trans, commit, gesture->time * rest / DISP_TRANS_PROGRESS_MAX);
+    if (commit)
+    {
+        gesture->stats.commits++;
+    }
+    else
+    {
+        gesture->stats.cancels++;
+    }
+    gesture->state = DISP_GESTURE_DONE;
+}
+
+// Send the gesture to the object LVGL would have sent it to; a screen change it asks for may start a drag
+static void disp_gesture_send(disp_gesture_handle_t gesture)
+{
+    _lv_indev_proc_t *proc = &gesture->indev->proc;
+    // LVGL does not send gestures while scrolling either
+    if (proc->types.pointer.scroll_obj || proc->types.pointer.gesture_sent)
+    {
+        gesture->state = DISP_GESTURE_DONE;
+        return;
+    }
+    lv_obj_t *obj = proc->types.pointer.act_obj;
+    while (obj && lv_obj_has_flag(obj, LV_OBJ_FLAG_GESTURE_BUBBLE))
+    {
+        obj = lv_obj_get_parent(obj);
+    }
+    if (obj == NULL)
+    {
+        gesture->state = DISP_GESTURE_DONE;
+        return;
+    }
+    proc->types.pointer.gesture_sent = 1;
+    proc->types.pointer.gesture_dir = gesture->dir;
+    gesture->stats.gestures++;
+    gesture->in_event = true;
+    lv_event_send(obj, LV_EVENT_GESTURE, gesture->indev);
+    gesture->in_event = false;
+    if (gesture->state != DISP_GESTURE_DRAGGING)
+    {
+        gesture->state = DISP_GESTURE_DONE;
+    }
+}
+
+// Follow the finger, or let the transition finish on its own once the finger is fast enough
+static void disp_gesture_drag(disp_gesture_handle_t gesture, lv_coord_t travel, int32_t v)
+{
+    if (!disp_trans_is_running(gesture->cfg.trans))
+    {
+        // Another load took over
+        gesture->state = DISP_GESTURE_DONE;
+        return;
+    }
+    disp_trans_set_progress(gesture->cfg.trans, (int32_t)travel * DISP_TRANS_PROGRESS_MAX / gesture->span);
+    if (v >= gesture->cfg.early_flick_px_s)
+    {
+        gesture->stats.flicks++;
+        disp_gesture_release(gesture, true);
+    }
+}
+
+static void disp_gesture_move(disp_gesture_handle_t gesture, lv_coord_t x, lv_coord_t y, int64_t t_us)
+{
+    disp_gesture_push(gesture, x, y, t_us);
+    int32_t vx, vy, v;
+    disp_gesture_velocity(gesture, &vx, &vy);
+    const lv_coord_t dx = x - gesture->down.x;
+    const lv_coord_t dy = y - gesture->down.y;
+    if (gesture->state == DISP_GESTURE_DRAGGING)
+    {
+        const lv_coord_t travel = disp_gesture_along(gesture, dx, dy, vx, vy, &v);
+        disp_gesture_drag(gesture, travel, v);
+        return;
+    }
+
+    // Lock on the axis moved most, earlier when the finger is fast
+    const bool horizontal = LV_ABS(dx) > LV_ABS(dy);
+    gesture->dir = horizontal ? (dx < 0 ? LV_DIR_LEFT : LV_DIR_RIGHT) : (dy < 0 ? LV_DIR_TOP : LV_DIR_BOTTOM);
+    const lv_coord_t travel = disp_gesture_along(gesture, dx, dy, vx, vy, &v);
+    if (travel < gesture->cfg.lock_px && (travel * 2 < gesture->cfg.lock_px || v < gesture->cfg.early_flick_px_s))
+    {
+        return;
+    }
+    const uint32_t lock_us = (uint32_t)(t_us - gesture->down.t_us);
+    gesture->stats.locks++;
+    gesture->stats.lock_us += lock_us;
+    gesture->stats.max_lock_us = lock_us > gesture->stats.max_lock_us ? lock_us : gesture->stats.max_lock_us;
+    lv_disp_t *disp = gesture->indev->driver->disp ? gesture->indev->driver->disp : lv_disp_get_default();
+    gesture->span = horizontal ? lv_disp_get_hor_res(disp) : lv_disp_get_ver_res(disp);
+    disp_gesture_send(gesture);
+    if (gesture->state == DISP_GESTURE_DRAGGING)
+    {
+        ESP_LOGD(TAG, "drag %d after %" PRIu32 " us, %" PRId32 " px/s", gesture->dir, lock_us, v);
+        disp_gesture_drag(gesture, travel, v);
+    }
+}
+
+esp_err_t disp_gesture_new(const disp_gesture_config_t *config, disp_gesture_handle_t *ret_gesture)
+{
+    ESP_RETURN_ON_FALSE(config && config->trans && ret_gesture, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    disp_gesture_handle_t gesture = calloc(1, sizeof(struct disp_gesture_t));
+    ESP_RETURN_ON_FALSE(gesture, ESP_ERR_NO_MEM, TAG, "no mem for gestures");
+    gesture->cfg = *config;
+    if (gesture->cfg.lock_px == 0)
+    {
+        gesture->cfg.lock_px = DISP_GESTURE_DEFAULT_LOCK_PX;
+    }
+    if (gesture->cfg.flick_px_s == 0)
+    {
+        gesture->cfg.flick_px_s = DISP_GESTURE_DEFAULT_FLICK_PX_S;
+    }
+    if (gesture->cfg.early_flick_px_s == 0)
+    {
+        gesture->cfg.early_flick_px_s = DISP_GESTURE_DEFAULT_EARLY_FLICK_PX_S;
+    }
+    if (gesture->cfg.window_ms == 0)
+    {
+        gesture->cfg.window_ms = DISP_GESTURE_DEFAULT_WINDOW_MS;
+    }
+    *ret_gesture = gesture;
+    return ESP_OK;
+}
+
+esp_err_t disp_gesture_attach(disp_gesture_handle_t gesture, lv_indev_t *indev)
+{
+    ESP_RETURN_ON_FALSE(gesture && indev && indev->driver->type == LV_INDEV_TYPE_POINTER, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid argument");
+    gesture->indev = indev;
+    // LVGL needs both a sum over the limit and every step over the minimum, no step is 255 px
+    indev->driver->gesture_limit = UINT8_MAX;
+    indev->driver->gesture_min_velocity = UINT8_MAX;
+    return ESP_OK;
+}
+
+void disp_gesture_feed(disp_gesture_handle_t gesture, lv_coord_t x, lv_coord_t y, bool pressed, int64_t t_us)
+{
+    if (gesture->indev == NULL)
+    {
+        return;
+    }
+    if (!pressed)
+    {
+        if (gesture->state == DISP_GESTURE_DRAGGING && disp_trans_is_running(gesture->cfg.trans))
+        {
+            // The samples before the release, a lift report adds no movement
+            int32_t vx, vy, v;
+            disp_gesture_velocity(gesture, &vx, &vy);
+            disp_gesture_along(gesture, 0, 0, vx, vy, &v);
+            const int32_t progress = disp_trans_get_progress(gesture->cfg.trans);
+            disp_gesture_release(gesture, v >= gesture->cfg.flick_px_s ||
+                                 (progress * 2 >= DISP_TRANS_PROGRESS_MAX && v > -(int32_t)gesture->cfg.flick_px_s));
+        }
+        gesture->state = DISP_GESTURE_IDLE;
+        return;
+    }
+    if (gesture->state == DISP_GESTURE_IDLE)
+    {
+        gesture->state = DISP_GESTURE_TRACKING;
+        gesture->down = (disp_gesture_point_t) {x, y, t_us};
+        gesture->head = 0;
+        gesture->count = 0;
+        gesture->stats.touches++;
+        disp_gesture_push(gesture, x, y, t_us);
+        return;
+    }
+    if (gesture->state != DISP_GESTURE_DONE)
+    {
+        disp_gesture_move(gesture, x, y, t_us);
+    }
+}
+
+void disp_gesture_load(lv_obj_t *scr, lv_scr_load_anim_t anim, int time, int delay, void *user_ctx)
+{
+    disp_gesture_handle_t gesture = (disp_gesture_handle_t)user_ctx;
+    if (gesture->in_event && gesture->state == DISP_GESTURE_TRACKING && time > 0 && anim != LV_SCR_LOAD_ANIM_NONE &&
+        disp_trans_begin(gesture->cfg.trans, scr, anim) == ESP_OK)
+    {
+        gesture->state = DISP_GESTURE_DRAGGING;
+        gesture->time = time;
+        if (anim == LV_SCR_LOAD_ANIM_FADE_IN || anim == LV_SCR_LOAD_ANIM_FADE_OUT)
+        {
+            // Nothing slides under the finger, half the screen is a full fade
+            gesture->span /= 2;
+        }
+        gesture->stats.drags++;
+        return;
+    }
+    disp_trans_load(scr, anim, time, delay, gesture->cfg.trans);
+}
+
+bool disp_gesture_is_dragging(disp_gesture_handle_t gesture)
+{
+    return gesture->state == DISP_GESTURE_DRAGGING;
+}
+
+void disp_gesture_get_stats(disp_gesture_handle_t gesture, disp_gesture_stats_t *stats, bool reset)
+{
+    *stats = gesture->stats;
+    if (reset)
+    {
+        memset(&gesture->stats, 0, sizeof(gesture->stats));
+    }
+}
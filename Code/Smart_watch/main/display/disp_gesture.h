@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#include "disp_trans.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default travel that locks the direction of a swipe, about a quarter of LVGL's default gesture limit
+#define DISP_GESTURE_DEFAULT_LOCK_PX 12
+// Default speed at release that finishes a drag short of half the screen, in pixels per second
+#define DISP_GESTURE_DEFAULT_FLICK_PX_S 300
+// Default speed while the finger is still down that finishes the transition at once, in pixels per second
+#define DISP_GESTURE_DEFAULT_EARLY_FLICK_PX_S 1000
+// Default span of the latest samples the velocity is fitted to
+#define DISP_GESTURE_DEFAULT_WINDOW_MS 50
+
+typedef struct disp_gesture_t *disp_gesture_handle_t;
+
+/**
+ * @brief Gesture recognizer configuration
+ */
+typedef struct {
+    disp_trans_handle_t trans;      /*!< Transitions the screen changes run on, drags included */
+    uint16_t lock_px;               /*!< Travel that locks the direction, 0 selects DISP_GESTURE_DEFAULT_LOCK_PX */
+    uint16_t flick_px_s;            /*!< Release speed that finishes a drag whatever its progress, 0 selects
+                                         DISP_GESTURE_DEFAULT_FLICK_PX_S */
+    uint16_t early_flick_px_s;      /*!< Speed that locks at half the travel and finishes the transition without
+                                         waiting for the release, 0 selects DISP_GESTURE_DEFAULT_EARLY_FLICK_PX_S */
+    uint16_t window_ms;             /*!< Samples the velocity is fitted to, 0 selects DISP_GESTURE_DEFAULT_WINDOW_MS */
+} disp_gesture_config_t;
+
+/**
+ * @brief Gesture counters since the last reset
+ */
+typedef struct {
+    uint32_t touches;               /*!< Touches seen */
+    uint32_t locks;                 /*!< Touches whose direction locked */
+    uint32_t gestures;              /*!< LV_EVENT_GESTURE sent */
+    uint32_t drags;                 /*!< Gestures whose screen change followed the finger */
+    uint32_t flicks;                /*!< Drags finished by their speed before the release */
+    uint32_t commits;               /*!< Drags released on to the new screen, flicks included */
+    uint32_t cancels;               /*!< Drags released back to the screen they started from */
+    uint64_t lock_us;               /*!< Sum over the locks of touch down to lock, in sample time */
+    uint32_t max_lock_us;           /*!< Longest of those */
+} disp_gesture_stats_t;
+
+/**
+ * @brief Create the gesture recognizer
+ *
+ * @param[in]  config    Configuration
+ * @param[out] ret_gesture Handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t disp_gesture_new(const disp_gesture_config_t *config, disp_gesture_handle_t *ret_gesture);
+
+/**
+ * @brief Take the gestures of a pointer input device over from LVGL, with the LVGL lock held
+ *
+ * Turns LVGL's own gesture detection off; the recognizer sends LV_EVENT_GESTURE, to the object LVGL would have
+ * sent it to and with the direction in `lv_indev_get_gesture_dir`, as soon as the direction locks. Feed it every
+ * sample the device reads with disp_gesture_feed.
+ */
+esp_err_t disp_gesture_attach(disp_gesture_handle_t gesture, lv_indev_t *indev);
+
+/**
+ * @brief Feed a touch sample, from the `read_cb` of the attached input device before LVGL sees it
+ *
+ * Fits the velocity to the samples of the last `window_ms`, locks the direction after `lock_px` of travel (half
+ * of it at `early_flick_px_s`) and sends the gesture. While a screen change started by the gesture follows the
+ * finger, moves it with the travel; at the release, or at `early_flick_px_s` before it, lets it finish or go
+ * back depending on the progress and the velocity.
+ *
+ * @param x         Point, ignored when released
+ * @param y         Point, ignored when released
+ * @param pressed   Whether the screen is touched
+ * @param t_us      Time the sample was taken, esp_timer_get_time() clock
+ */
+void disp_gesture_feed(disp_gesture_handle_t gesture, lv_coord_t x, lv_coord_t y, bool pressed, int64_t t_us);
+
+/**
+ * @brief Load a screen: during a gesture start a transition that follows the finger, else disp_trans_load
+ *
+ * Has the signature of the SquareLine load hook, pass it to _ui_screen_set_load_cb with the handle as user data.
+ */
+void disp_gesture_load(lv_obj_t *scr, lv_scr_load_anim_t anim, int time, int delay, void *user_ctx);
+
+/**
+ * @brief Whether a screen change follows the finger
+ */
+bool disp_gesture_is_dragging(disp_gesture_handle_t gesture);
+
+/**
+ * @brief Get the counters and optionally clear them, with the LVGL lock held
+ */
+void disp_gesture_get_stats(disp_gesture_handle_t gesture, disp_gesture_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,335 @@
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+#include "draw/sw/lv_draw_sw.h"
+#include "disp_glyph.h"
+
+static const char *TAG = "disp_glyph";
+
+// Hash chains of the cache, a power of two
+#define DISP_GLYPH_BUCKETS 64
+#define DISP_GLYPH_NONE UINT16_MAX
+
+// Opacity of every pixel value, defined by lv_draw_sw_letter.c
+extern const uint8_t _lv_bpp1_opa_table[2];
+extern const uint8_t _lv_bpp2_opa_table[4];
+extern const uint8_t _lv_bpp4_opa_table[16];
+extern const uint8_t _lv_bpp8_opa_table[256];
+
+typedef struct
+{
+    const lv_font_t *font;          // font drawn with, NULL when the slot is free
+    uint32_t letter;
+    lv_opa_t *mask;                 // box_w x box_h opacities, NULL for an empty glyph
+    uint32_t last_used;             // LRU stamp
+    uint16_t next;                  // next entry of the hash chain
+    uint8_t box_w;
+    uint8_t box_h;
+    int8_t ofs_x;
+    int8_t ofs_y;
+} disp_glyph_entry_t;
+
+struct disp_glyph_t
+{
+    disp_glyph_config_t cfg;
+    lv_disp_t *disp;
+    void (*draw_letter)(lv_draw_ctx_t *draw_ctx, const lv_draw_label_dsc_t *dsc, const lv_point_t *pos_p,
+                        uint32_t letter);
+    bool enabled;
+    disp_glyph_stats_t stats;
+    uint32_t clock;                 // LRU clock, bumped on every letter
+    size_t cached_bytes;
+    uint16_t buckets[DISP_GLYPH_BUCKETS];
+    disp_glyph_entry_t entries[DISP_GLYPH_CACHE_MAX];
+};
+
+// The draw context's user data is disp_par's
+static disp_glyph_handle_t s_glyph;
+
+static inline uint32_t disp_glyph_bucket(const lv_font_t *font, uint32_t letter)
+{
+    return ((uint32_t)(uintptr_t)font * 31 + letter * 0x9E3779B1u) >> 26;
+}
+
+static disp_glyph_entry_t *disp_glyph_find(disp_glyph_handle_t glyph, const lv_font_t *font, uint32_t letter)
+{
+    for (uint16_t i = glyph->buckets[disp_glyph_bucket(font, letter)]; i != DISP_GLYPH_NONE;
+         i = glyph->entries[i].next)
+    {
+        disp_glyph_entry_t *entry = &glyph->entries[i];
+        if (entry->font == font && entry->letter == letter)
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void disp_glyph_drop(disp_glyph_handle_t glyph, disp_glyph_entry_t *entry)
+{
+    const uint16_t index = entry - glyph->entries;
+    uint16_t *link = &glyph->buckets[disp_glyph_bucket(entry->font, entry->letter)];
+    while (*link != index)
+    {
+        link = &glyph->entries[*link].next;
+    }
+    *link = entry->next;
+    glyph->cached_bytes -= entry->box_w * entry->box_h;
+    heap_caps_free(entry->mask);
+    memset(entry, 0, sizeof(*entry));
+    glyph->stats.cached--;
+}
+
+// A free slot with `size` bytes of budget left, evicting the least recently drawn glyphs
+static disp_glyph_entry_t *disp_glyph_make_room(disp_glyph_handle_t glyph, size_t size)
+{
+    while (true)
+    {
+        disp_glyph_entry_t *free_entry = NULL;
+        disp_glyph_entry_t *lru = NULL;
+        for (size_t i = 0; i < DISP_GLYPH_CACHE_MAX; i++)
+        {
+            disp_glyph_entry_t *entry = &glyph->entries[i];
+            if (entry->font == NULL)
+            {
+                free_entry = free_entry ? free_entry : entry;
+            }
+            else if (lru == NULL || entry->last_used < lru->last_used)
+            {
+                lru = entry;
+            }
+        }
+        if (free_entry && glyph->cached_bytes + size <= glyph->cfg.cache_bytes)
+        {
+            return free_entry;
+        }
+        if (lru == NULL)
+        {
+            return NULL;
+        }
+        glyph->stats.evictions++;
+        disp_glyph_drop(glyph, lru);
+    }
+}
+
+// Unpack the glyph of `letter` into the cache as lv_draw_sw_letter does; returns NULL when LVGL must draw it
+static disp_glyph_entry_t *disp_glyph_add(disp_glyph_handle_t glyph, const lv_font_t *font, uint32_t letter)
+{
+    lv_font_glyph_dsc_t g;
+    if (!lv_font_get_glyph_dsc(font, &g, letter, '\0') || g.resolved_font->subpx)
+    {
+        return NULL;
+    }
+    const uint8_t *table;
+    switch (g.bpp)
+    {
+    case 1:
+        table = _lv_bpp1_opa_table;
+        break;
+    case 2:
+        table = _lv_bpp2_opa_table;
+        break;
+    case 4:
+        table = _lv_bpp4_opa_table;
+        break;
+    case 8:
+        table = _lv_bpp8_opa_table;
+        break;
+    default:
+        // bpp 3 and image fonts
+        return NULL;
+    }
+    if (g.box_w > UINT8_MAX || g.box_h > UINT8_MAX || g.ofs_x < INT8_MIN || g.ofs_x > INT8_MAX ||
+        g.ofs_y < INT8_MIN || g.ofs_y > INT8_MAX)
+    {
+        return NULL;
+    }
+    const size_t size = g.box_w * g.box_h;
+    const uint8_t *map = NULL;
+    if (size)
+    {
+        map = lv_font_get_glyph_bitmap(g.resolved_font, letter);
+        if (map == NULL || size > glyph->cfg.cache_bytes)
+        {
+            return NULL;
+        }
+    }
+    disp_glyph_entry_t *entry = disp_glyph_make_room(glyph, size);
+    if (entry == NULL)
+    {
+        return NULL;
+    }
+    if (size)
+    {
+        entry->mask = heap_caps_malloc(size, glyph->cfg.cache_caps);
+        if (entry->mask == NULL)
+        {
+            return NULL;
+        }
+        // Rows are not byte aligned, the bits run on from one row to the next
+        const uint32_t shades = (1u << g.bpp) - 1;
+        uint32_t bit = 0;
+        for (size_t i = 0; i < size; i++, bit += g.bpp)
+        {
+            const uint32_t px = (map[bit >> 3] >> (8 - g.bpp - (bit & 7))) & shades;
+            entry->mask[i] = table[px];
+        }
+    }
+    entry->font = font;
+    entry->letter = letter;
+    entry->box_w = g.box_w;
+    entry->box_h = g.box_h;
+    entry->ofs_x = g.ofs_x;
+    entry->ofs_y = g.ofs_y;
+    const uint32_t bucket = disp_glyph_bucket(font, letter);
+    entry->next = glyph->buckets[bucket];
+    glyph->buckets[bucket] = entry - glyph->entries;
+    glyph->cached_bytes += size;
+    glyph->stats.cached++;
+    glyph->stats.misses++;
+    return entry;
+}
+
+static void disp_glyph_draw_letter(lv_draw_ctx_t *draw_ctx, const lv_draw_label_dsc_t *dsc, const lv_point_t *pos_p,
+                                   uint32_t letter)
+{
+    disp_glyph_handle_t glyph = s_glyph;
+    if (!glyph->enabled)
+    {
+        glyph->draw_letter(draw_ctx, dsc, pos_p, letter);
+        return;
+    }
+    glyph->stats.letters++;
+    // Below LV_OPA_MAX LVGL scales the mask by the opacity too, and without anti-aliasing the blend rounds the
+    // mask in place
+    if (dsc->opa < LV_OPA_MAX || !_lv_refr_get_disp_refreshing()->driver->antialiasing)
+    {
+        glyph->stats.fallbacks++;
+        glyph->draw_letter(draw_ctx, dsc, pos_p, letter);
+        return;
+    }
+    disp_glyph_entry_t *entry = disp_glyph_find(glyph, dsc->font, letter);
+    if (entry)
+    {
+        glyph->stats.hits++;
+    }
+    else if ((entry = disp_glyph_add(glyph, dsc->font, letter)) == NULL)
+    {
+        glyph->stats.fallbacks++;
+        glyph->draw_letter(draw_ctx, dsc, pos_p, letter);
+        return;
+    }
+    entry->last_used = ++glyph->clock;
+    if (entry->mask == NULL)
+    {
+        return;
+    }
+
+    // Placed as lv_draw_sw_letter places it
+    lv_area_t area;
+    area.x1 = pos_p->x + entry->ofs_x;
+    area.y1 = pos_p->y + (dsc->font->line_height - dsc->font->base_line) - entry->box_h - entry->ofs_y;
+    area.x2 = area.x1 + entry->box_w - 1;
+    area.y2 = area.y1 + entry->box_h - 1;
+    if (!_lv_area_is_on(&area, draw_ctx->clip_area))
+    {
+        return;
+    }
+    if (lv_draw_mask_is_any(&area))
+    {
+        glyph->stats.fallbacks++;
+        glyph->draw_letter(draw_ctx, dsc, pos_p, letter);
+        return;
+    }
+
+    // The blend clips to the clip area and finds the first visible opacity through the mask area
+    lv_draw_sw_blend_dsc_t blend_dsc;
+    lv_memset_00(&blend_dsc, sizeof(blend_dsc));
+    blend_dsc.color = dsc->color;
+    blend_dsc.opa = dsc->opa;
+    blend_dsc.blend_mode = dsc->blend_mode;
+    blend_dsc.blend_area = &area;
+    blend_dsc.mask_area = &area;
+    blend_dsc.mask_buf = entry->mask;
+    blend_dsc.mask_res = LV_DRAW_MASK_RES_CHANGED;
+    lv_draw_sw_blend(draw_ctx, &blend_dsc);
+}
+
+esp_err_t disp_glyph_new(const disp_glyph_config_t *config, disp_glyph_handle_t *ret_glyph)
+{
+    ESP_RETURN_ON_FALSE(config && ret_glyph, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    disp_glyph_handle_t glyph = calloc(1, sizeof(struct disp_glyph_t));
+    ESP_RETURN_ON_FALSE(glyph, ESP_ERR_NO_MEM, TAG, "no mem for glyph cache");
+    glyph->cfg = *config;
+    if (glyph->cfg.cache_bytes == 0)
+    {
+        glyph->cfg.cache_bytes = DISP_GLYPH_DEFAULT_CACHE_BYTES;
+    }
+    if (glyph->cfg.cache_caps == 0)
+    {
+        glyph->cfg.cache_caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    }
+    for (size_t i = 0; i < DISP_GLYPH_BUCKETS; i++)
+    {
+        glyph->buckets[i] = DISP_GLYPH_NONE;
+    }
+    *ret_glyph = glyph;
+    return ESP_OK;
+}
+
+esp_err_t disp_glyph_attach(disp_glyph_handle_t glyph, lv_disp_t *disp)
+{
+    ESP_RETURN_ON_FALSE(glyph && disp && disp->driver->draw_ctx, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(s_glyph == NULL || s_glyph == glyph, ESP_ERR_INVALID_STATE, TAG, "a cache is attached");
+    lv_draw_ctx_t *draw_ctx = disp->driver->draw_ctx;
+    if (draw_ctx->draw_letter != disp_glyph_draw_letter)
+    {
+        glyph->draw_letter = draw_ctx->draw_letter;
+        draw_ctx->draw_letter = disp_glyph_draw_letter;
+    }
+    glyph->disp = disp;
+    s_glyph = glyph;
+    glyph->enabled = true;
+    ESP_LOGI(TAG, "glyphs cached in %u bytes", (unsigned)glyph->cfg.cache_bytes);
+    return ESP_OK;
+}
+
+void disp_glyph_set_enabled(disp_glyph_handle_t glyph, bool enabled)
+{
+    glyph->enabled = enabled;
+}
+
+void disp_glyph_get_stats(disp_glyph_handle_t glyph, disp_glyph_stats_t *stats, bool reset)
+{
+    *stats = glyph->stats;
+    stats->cached_bytes = glyph->cached_bytes;
+    if (reset)
+    {
+        const uint32_t cached = glyph->stats.cached;
+        memset(&glyph->stats, 0, sizeof(glyph->stats));
+        glyph->stats.cached = cached;
+    }
+}
+
+void disp_glyph_del(disp_glyph_handle_t glyph)
+{
+    if (!glyph)
+    {
+        return;
+    }
+    if (s_glyph == glyph)
+    {
+        glyph->disp->driver->draw_ctx->draw_letter = glyph->draw_letter;
+        s_glyph = NULL;
+    }
+    for (size_t i = 0; i < DISP_GLYPH_CACHE_MAX; i++)
+    {
+        heap_caps_free(glyph->entries[i].mask);
+    }
+    free(glyph);
+}
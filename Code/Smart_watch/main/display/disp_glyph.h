@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default budget of the glyph cache, the characters of the UI in the three Montserrat sizes take about 7 KB
+#define DISP_GLYPH_DEFAULT_CACHE_BYTES (16 * 1024)
+// Most glyphs held at once
+#define DISP_GLYPH_CACHE_MAX 256
+
+typedef struct disp_glyph_t *disp_glyph_handle_t;
+
+/**
+ * @brief Glyph cache configuration
+ */
+typedef struct {
+    size_t cache_bytes;             /*!< Bytes of the unpacked glyph bitmaps, 0 selects
+                                         DISP_GLYPH_DEFAULT_CACHE_BYTES */
+    uint32_t cache_caps;            /*!< Heap of the bitmaps, 0 selects MALLOC_CAP_INTERNAL: they are read for every
+                                         letter drawn */
+} disp_glyph_config_t;
+
+/**
+ * @brief Glyph cache counters since the last reset
+ */
+typedef struct {
+    uint32_t letters;               /*!< Letters LVGL asked to draw */
+    uint32_t hits;                  /*!< Letters drawn from the cache */
+    uint32_t misses;                /*!< Letters whose glyph was unpacked into the cache, then drawn from it */
+    uint32_t fallbacks;             /*!< Letters drawn by LVGL: under a mask, translucent, missing from the font
+                                         or not fitting in the cache */
+    uint32_t evictions;             /*!< Glyphs dropped from the cache to make room */
+    size_t cached_bytes;            /*!< Held by the cache now, not reset */
+    uint32_t cached;                /*!< Glyphs in the cache now */
+} disp_glyph_stats_t;
+
+/**
+ * @brief Create the cache of unpacked glyph bitmaps
+ *
+ * @param[in]  config    Configuration
+ * @param[out] ret_glyph Handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t disp_glyph_new(const disp_glyph_config_t *config, disp_glyph_handle_t *ret_glyph);
+
+/**
+ * @brief Draw the letters of `disp` from the cache, with the LVGL lock held
+ *
+ * LVGL looks up the glyph of every letter it draws, unpacks its 1-8 bpp bitmap pixel by pixel into an opacity
+ * mask and blends the mask, every frame. The cache keeps, by font and character, the glyph metrics and its
+ * bitmap unpacked to one opacity byte per pixel, exactly as LVGL unpacks it, so a letter found there is a single
+ * blend of the cached mask; the least recently drawn glyphs make room when the budget is full. A letter under a
+ * mask (rounded corners, fades), drawn with opacity below LV_OPA_MAX, of a sub-pixel font or on a display without
+ * anti-aliasing is drawn by LVGL as before, and so looks the same either way.
+ *
+ * Fonts are cached by address and must not change while attached, as the built-in and generated ones do not.
+ * One display at a time: the draw context's user data belongs to disp_par.
+ */
+esp_err_t disp_glyph_attach(disp_glyph_handle_t glyph, lv_disp_t *disp);
+
+/**
+ * @brief Turn the cache on or off, e.g. to compare against LVGL's letter drawing; on after `disp_glyph_attach`
+ *
+ * Call with the LVGL lock held.
+ */
+void disp_glyph_set_enabled(disp_glyph_handle_t glyph, bool enabled);
+
+/**
+ * @brief Get the counters and optionally clear them, with the LVGL lock held
+ */
+void disp_glyph_get_stats(disp_glyph_handle_t glyph, disp_glyph_stats_t *stats, bool reset);
+
+/**
+ * @brief Give the letters back to LVGL and free the cache, with the LVGL lock held
+ */
+void disp_glyph_del(disp_glyph_handle_t glyph);
+
+#ifdef __cplusplus
+}
+#endif
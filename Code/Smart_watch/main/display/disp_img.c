@@ -0,0 +1,462 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "disp_img.h"
+
+static const char *TAG = "disp_img";
+
+// magic, width, height, mode, flags, palette entries
+#define DISP_IMG_HEADER_SIZE 12
+// Packet byte: repeat the next unit, else copy the units that follow
+#define DISP_IMG_RUN 0x80
+
+typedef struct
+{
+    const lv_img_dsc_t *src;        // image decoded, NULL when the slot is free
+    const uint8_t *data;            // its data then, a new asset pack maps other data under the same descriptor
+    uint8_t *buf;                   // the decoded pixels
+    size_t size;
+    uint32_t last_used;             // LRU stamp
+    uint16_t refs;                  // opened by LVGL and not closed yet, never evicted meanwhile
+    bool pinned;
+} disp_img_entry_t;
+
+struct disp_img_t
+{
+    disp_img_config_t cfg;
+    lv_img_decoder_t *decoder;
+    disp_img_stats_t stats;
+    uint32_t clock;                 // LRU clock, bumped on every open
+    size_t cached_bytes;
+    size_t pinned_bytes;
+    disp_img_entry_t entries[DISP_IMG_CACHE_MAX];
+};
+
+// The blobs are byte arrays, read the fields a byte at a time
+static inline uint16_t disp_img_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t disp_img_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool disp_img_is_compressed(const lv_img_dsc_t *dsc)
+{
+    if (!dsc || dsc->header.cf != LV_IMG_CF_USER_ENCODED_0 || !dsc->data || dsc->data_size < DISP_IMG_HEADER_SIZE)
+    {
+        return false;
+    }
+    const uint8_t *p = dsc->data;
+    return disp_img_u32(p) == DISP_IMG_MAGIC && disp_img_u16(p + 4) == dsc->header.w &&
+           disp_img_u16(p + 6) == dsc->header.h &&
+           dsc->data_size >= DISP_IMG_HEADER_SIZE + 4 * (uint32_t)dsc->header.h;
+}
+
+// Skip `skip` pixels of a packet stream, then write `len` units of `unit` bytes `stride` bytes apart
+static void disp_img_unpack(const uint8_t *p, size_t unit, lv_coord_t skip, lv_coord_t len, uint8_t *out, size_t stride)
+{
+    while (len > 0)
+    {
+        const uint8_t c = *p++;
+        const bool run = c & DISP_IMG_RUN;
+        lv_coord_t n = (c & ~DISP_IMG_RUN) + 1;
+        const uint8_t *src = p;
+        p += run ? unit : n * unit;
+        if (skip >= n)
+        {
+            skip -= n;
+            continue;
+        }
+        if (!run)
+        {
+            src += skip * unit;
+        }
+        n -= skip;
+        skip = 0;
+        if (n > len)
+        {
+            n = len;
+        }
+        len -= n;
+        if (run && unit == 2)
+        {
+            for (; n > 0; n--, out += stride)
+            {
+                out[0] = src[0];
+                out[1] = src[1];
+            }
+        }
+        else if (run)
+        {
+            for (; n > 0; n--, out += stride)
+            {
+                out[0] = src[0];
+            }
+        }
+        else if (unit == 2)
+        {
+            for (; n > 0; n--, out += stride, src += 2)
+            {
+                out[0] = src[0];
+                out[1] = src[1];
+            }
+        }
+        else
+        {
+            for (; n > 0; n--, out += stride, src++)
+            {
+                out[0] = src[0];
+            }
+        }
+    }
+}
+
+// Same walk over 1-byte palette indices, writing the palette entries
+static void disp_img_unpack_indexed(const uint8_t *p, const uint8_t *palette, size_t px_size, lv_coord_t skip,
+                                    lv_coord_t len, uint8_t *out)
+{
+    while (len > 0)
+    {
+        const uint8_t c = *p++;
+        const bool run = c & DISP_IMG_RUN;
+        lv_coord_t n = (c & ~DISP_IMG_RUN) + 1;
+        const uint8_t *src = p;
+        p += run ? 1 : n;
+        if (skip >= n)
+        {
+            skip -= n;
+            continue;
+        }
+        if (!run)
+        {
+            src += skip;
+        }
+        n -= skip;
+        skip = 0;
+        if (n > len)
+        {
+            n = len;
+        }
+        len -= n;
+        for (; n > 0; n--, out += px_size)
+        {
+            const uint8_t *entry = palette + 3 * *src;
+            memcpy(out, entry, px_size);
+            if (!run)
+            {
+                src++;
+            }
+        }
+    }
+}
+
+esp_err_t disp_img_read_line(const lv_img_dsc_t *dsc, lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t *buf)
+{
+    if (!disp_img_is_compressed(dsc) || x < 0 || y < 0 || len < 0 || x + len > dsc->header.w || y >= dsc->header.h)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const uint8_t *blob = dsc->data;
+    const bool alpha = blob[9] & DISP_IMG_FLAG_ALPHA;
+    const uint8_t *row = blob + disp_img_u32(blob + DISP_IMG_HEADER_SIZE + 4 * y);
+    const size_t px_size = alpha ? LV_IMG_PX_SIZE_ALPHA_BYTE : sizeof(lv_color_t);
+    if (blob[8] == DISP_IMG_MODE_INDEXED)
+    {
+        const uint8_t *palette = blob + DISP_IMG_HEADER_SIZE + 4 * dsc->header.h;
+        disp_img_unpack_indexed(row, palette, px_size, x, len, buf);
+    }
+    else if (alpha)
+    {
+        disp_img_unpack(row + 2, 2, x, len, buf, px_size);
+        disp_img_unpack(row + disp_img_u16(row), 1, x, len, buf + 2, px_size);
+    }
+    else
+    {
+        disp_img_unpack(row, 2, x, len, buf, px_size);
+    }
+    return ESP_OK;
+}
+
+static size_t disp_img_decoded_size(const lv_img_dsc_t *dsc)
+{
+    const size_t px_size = dsc->data[9] & DISP_IMG_FLAG_ALPHA ? LV_IMG_PX_SIZE_ALPHA_BYTE : sizeof(lv_color_t);
+    return (size_t)dsc->header.w * dsc->header.h * px_size;
+}
+
+static void disp_img_cache_drop(disp_img_handle_t img, disp_img_entry_t *entry)
+{
+    img->cached_bytes -= entry->size;
+    if (entry->pinned)
+    {
+        img->pinned_bytes -= entry->size;
+    }
+    heap_caps_free(entry->buf);
+    memset(entry, 0, sizeof(*entry));
+}
+
+// Entry holding `src` decoded, NULL when not cached
+static disp_img_entry_t *disp_img_cache_find(disp_img_handle_t img, const lv_img_dsc_t *src)
+{
+    for (size_t i = 0; i < DISP_IMG_CACHE_MAX; i++)
+    {
+        disp_img_entry_t *entry = &img->entries[i];
+        if (entry->src != src)
+        {
+            continue;
+        }
+        if (entry->data == src->data)
+        {
+            return entry;
+        }
+        // Decoded from data the descriptor no longer points at
+        if (entry->refs == 0)
+        {
+            disp_img_cache_drop(img, entry);
+        }
+    }
+    return NULL;
+}
+
+// Evict the least recently drawn images until `size` more bytes and one more image fit; returns a free slot
+static disp_img_entry_t *disp_img_cache_make_room(disp_img_handle_t img, size_t size)
+{
+    while (true)
+    {
+        disp_img_entry_t *free_entry = NULL;
+        disp_img_entry_t *lru = NULL;
+        for (size_t i = 0; i < DISP_IMG_CACHE_MAX; i++)
+        {
+            disp_img_entry_t *entry = &img->entries[i];
+            if (entry->src == NULL)
+            {
+                free_entry = free_entry ? free_entry : entry;
+            }
+            else if (!entry->pinned && entry->refs == 0 && (lru == NULL || entry->last_used < lru->last_used))
+            {
+                lru = entry;
+            }
+        }
+        if (free_entry && img->cached_bytes + size <= img->cfg.cache_bytes)
+        {
+            return free_entry;
+        }
+        if (lru == NULL)
+        {
+            return NULL;
+        }
+        ESP_LOGD(TAG, "evicting %dx%d image, %u bytes", lru->src->header.w, lru->src->header.h,
+                 (unsigned)lru->size);
+        img->stats.evictions++;
+        disp_img_cache_drop(img, lru);
+    }
+}
+
+// Decode `src` whole into the cache; returns NULL when it does not fit
+static disp_img_entry_t *disp_img_cache_add(disp_img_handle_t img, const lv_img_dsc_t *src)
+{
+    const size_t size = disp_img_decoded_size(src);
+    if (size == 0 || size > img->cfg.cache_bytes - img->pinned_bytes)
+    {
+        return NULL;
+    }
+    disp_img_entry_t *entry = disp_img_cache_make_room(img, size);
+    if (entry == NULL)
+    {
+        return NULL;
+    }
+    uint8_t *buf = heap_caps_malloc(size, img->cfg.cache_caps);
+    if (buf == NULL)
+    {
+        return NULL;
+    }
+    const int64_t t = esp_timer_get_time();
+    const size_t stride = size / src->header.h;
+    for (lv_coord_t y = 0; y < src->header.h; y++)
+    {
+        disp_img_read_line(src, 0, y, src->header.w, buf + y * stride);
+    }
+    img->stats.decode_us += esp_timer_get_time() - t;
+    img->stats.decoded_bytes += size;
+    entry->src = src;
+    entry->data = src->data;
+    entry->buf = buf;
+    entry->size = size;
+    img->cached_bytes += size;
+    return entry;
+}
+
+static lv_res_t disp_img_info_cb(lv_img_decoder_t *decoder, const void *src, lv_img_header_t *header)
+{
+    LV_UNUSED(decoder);
+    if (lv_img_src_get_type(src) != LV_IMG_SRC_VARIABLE || !disp_img_is_compressed(src))
+    {
+        return LV_RES_INV;
+    }
+    const lv_img_dsc_t *dsc = src;
+    header->always_zero = 0;
+    header->w = dsc->header.w;
+    header->h = dsc->header.h;
+    header->cf = (dsc->data[9] & DISP_IMG_FLAG_ALPHA) ? LV_IMG_CF_TRUE_COLOR_ALPHA : LV_IMG_CF_TRUE_COLOR;
+    return LV_RES_OK;
+}
+
+static lv_res_t disp_img_open_cb(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc)
+{
+    if (dsc->src_type != LV_IMG_SRC_VARIABLE || !disp_img_is_compressed(dsc->src))
+    {
+        return LV_RES_INV;
+    }
+    disp_img_handle_t img = decoder->user_data;
+    img->stats.opens++;
+    disp_img_entry_t *entry = NULL;
+    if (img->cfg.cache_bytes)
+    {
+        entry = disp_img_cache_find(img, dsc->src);
+        if (entry)
+        {
+            img->stats.hits++;
+        }
+        else if ((entry = disp_img_cache_add(img, dsc->src)) != NULL)
+        {
+            img->stats.misses++;
+        }
+    }
+    if (entry == NULL)
+    {
+        // No whole image: LVGL reads the visible part of every row with read_line_cb
+        img->stats.uncached++;
+        dsc->img_data = NULL;
+        dsc->user_data = NULL;
+        return LV_RES_OK;
+    }
+    entry->refs++;
+    entry->last_used = ++img->clock;
+    dsc->img_data = entry->buf;
+    dsc->user_data = entry;
+    return LV_RES_OK;
+}
+
+static lv_res_t disp_img_read_line_cb(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc, lv_coord_t x,
+                                      lv_coord_t y, lv_coord_t len, uint8_t *buf)
+{
+    disp_img_handle_t img = decoder->user_data;
+    if (disp_img_read_line(dsc->src, x, y, len, buf) != ESP_OK)
+    {
+        img->stats.errors++;
+        return LV_RES_INV;
+    }
+    img->stats.lines++;
+    img->stats.px += len;
+    return LV_RES_OK;
+}
+
+static void disp_img_close_cb(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc)
+{
+    // The decoded image stays in the cache, LVGL may close twice after a failed read
+    LV_UNUSED(decoder);
+    disp_img_entry_t *entry = dsc->user_data;
+    if (entry)
+    {
+        entry->refs--;
+        dsc->user_data = NULL;
+    }
+}
+
+esp_err_t disp_img_new(const disp_img_config_t *config, disp_img_handle_t *ret_img)
+{
+    ESP_RETURN_ON_FALSE(config && ret_img, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    disp_img_handle_t img = calloc(1, sizeof(struct disp_img_t));
+    ESP_RETURN_ON_FALSE(img, ESP_ERR_NO_MEM, TAG, "no mem for image decoder");
+    img->cfg = *config;
+    if (img->cfg.cache_caps == 0)
+    {
+        img->cfg.cache_caps = MALLOC_CAP_SPIRAM;
+    }
+    img->decoder = lv_img_decoder_create();
+    if (!img->decoder)
+    {
+        free(img);
+        ESP_LOGE(TAG, "no mem for LVGL decoder");
+        return ESP_ERR_NO_MEM;
+    }
+    lv_img_decoder_set_info_cb(img->decoder, disp_img_info_cb);
+    lv_img_decoder_set_open_cb(img->decoder, disp_img_open_cb);
+    lv_img_decoder_set_read_line_cb(img->decoder, disp_img_read_line_cb);
+    lv_img_decoder_set_close_cb(img->decoder, disp_img_close_cb);
+    img->decoder->user_data = img;
+    *ret_img = img;
+    return ESP_OK;
+}
+
+esp_err_t disp_img_pin(disp_img_handle_t img, const lv_img_dsc_t *src)
+{
+    ESP_RETURN_ON_FALSE(disp_img_is_compressed(src), ESP_ERR_INVALID_ARG, TAG, "not a compressed image");
+    ESP_RETURN_ON_FALSE(img->cfg.cache_bytes, ESP_ERR_INVALID_STATE, TAG, "no image cache");
+    disp_img_entry_t *entry = disp_img_cache_find(img, src);
+    if (entry == NULL)
+    {
+        entry = disp_img_cache_add(img, src);
+    }
+    ESP_RETURN_ON_FALSE(entry, ESP_ERR_NO_MEM, TAG, "%dx%d image does not fit, %u of %u bytes pinned",
+                        src->header.w, src->header.h, (unsigned)img->pinned_bytes, (unsigned)img->cfg.cache_bytes);
+    if (!entry->pinned)
+    {
+        entry->pinned = true;
+        img->pinned_bytes += entry->size;
+    }
+    return ESP_OK;
+}
+
+void disp_img_unpin(disp_img_handle_t img, const lv_img_dsc_t *src)
+{
+    for (size_t i = 0; i < DISP_IMG_CACHE_MAX; i++)
+    {
+        disp_img_entry_t *entry = &img->entries[i];
+        if (entry->src == src && entry->pinned)
+        {
+            entry->pinned = false;
+            img->pinned_bytes -= entry->size;
+        }
+    }
+}
+
+void disp_img_get_stats(disp_img_handle_t img, disp_img_stats_t *stats, bool reset)
+{
+    img->stats.cached_bytes = img->cached_bytes;
+    img->stats.pinned_bytes = img->pinned_bytes;
+    img->stats.cached = 0;
+    for (size_t i = 0; i < DISP_IMG_CACHE_MAX; i++)
+    {
+        img->stats.cached += img->entries[i].src != NULL;
+    }
+    *stats = img->stats;
+    if (reset)
+    {
+        memset(&img->stats, 0, sizeof(img->stats));
+    }
+}
+
+void disp_img_del(disp_img_handle_t img)
+{
+    if (!img)
+    {
+        return;
+    }
+    for (size_t i = 0; i < DISP_IMG_CACHE_MAX; i++)
+    {
+        if (img->entries[i].src)
+        {
+            disp_img_cache_drop(img, &img->entries[i]);
+        }
+    }
+    lv_img_decoder_delete(img->decoder);
+    free(img);
+}
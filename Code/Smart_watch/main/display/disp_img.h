@@ -0,0 +1,130 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// First word of a compressed image, "DIMG"
+#define DISP_IMG_MAGIC 0x474D4944
+
+/**
+ * @brief Layout of the rows of a compressed image
+ */
+typedef enum {
+    DISP_IMG_MODE_PLANES = 0,       /*!< Run-length RGB565 plane then, with alpha, run-length A8 plane per row */
+    DISP_IMG_MODE_INDEXED = 1,      /*!< Run-length 8-bit indices into a palette of RGB565 + A8 entries */
+} disp_img_mode_t;
+
+// Header flag: some pixels are not opaque, rows decode to LV_IMG_CF_TRUE_COLOR_ALPHA
+#define DISP_IMG_FLAG_ALPHA 0x01
+// Most images held decoded at once
+#define DISP_IMG_CACHE_MAX 48
+
+typedef struct disp_img_t *disp_img_handle_t;
+
+/**
+ * @brief Image decoder configuration
+ */
+typedef struct {
+    size_t cache_bytes;             /*!< Decoded images kept for the next draws, pinned ones included; 0 decodes the
+                                         rows of every draw */
+    uint32_t cache_caps;            /*!< Heap of the decoded images, 0 selects MALLOC_CAP_SPIRAM */
+} disp_img_config_t;
+
+/**
+ * @brief Image decoder counters since the last reset
+ */
+typedef struct {
+    uint32_t opens;                 /*!< Compressed images opened by LVGL to draw them */
+    uint32_t lines;                 /*!< Lines decoded for draws not served by the cache */
+    uint64_t px;                    /*!< Pixels decoded in those lines */
+    uint32_t errors;                /*!< Lines that could not be decoded, e.g. out of the image */
+    uint32_t hits;                  /*!< Opens served decoded by the cache */
+    uint32_t misses;                /*!< Opens that decoded the whole image into the cache */
+    uint32_t uncached;              /*!< Opens drawn line by line: no cache, or the image did not fit in it */
+    uint32_t evictions;             /*!< Images dropped from the cache to make room */
+    uint64_t decoded_bytes;         /*!< Bytes decoded into the cache, pins included */
+    uint64_t decode_us;             /*!< Time spent decoding them */
+    size_t cached_bytes;            /*!< Held by the cache now, not reset */
+    size_t pinned_bytes;            /*!< Of them, held by pinned images */
+    uint32_t cached;                /*!< Images in the cache now */
+} disp_img_stats_t;
+
+/**
+ * @brief Register the decoder of compressed images with LVGL, with the LVGL lock held
+ *
+ * Images converted by tools/img_conv.py are `lv_img_dsc_t` variables with LV_IMG_CF_USER_ENCODED_0 data, used as
+ * any other image source. LVGL sees them as LV_IMG_CF_TRUE_COLOR_ALPHA (LV_IMG_CF_TRUE_COLOR when opaque).
+ *
+ * With a `cache_bytes` budget, an image opened for a draw is decoded whole into `cache_caps` memory and handed
+ * to LVGL, which blends from it as from a raw array; later draws find it there. When the budget is full, the
+ * least recently drawn images that are not pinned make room. An image that does not fit, or any image without a
+ * cache, is drawn as LVGL does with no whole image: the visible part of every row is decoded into a line buffer
+ * and blended, a row being found through the row offset table and its runs.
+ *
+ * LVGL's own image cache (CONFIG_LV_IMG_CACHE_DEF_SIZE) should stay 0: it counts images, not bytes, and would
+ * keep images of the decoder open.
+ *
+ * @param[in]  config  Configuration
+ * @param[out] ret_img Handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t disp_img_new(const disp_img_config_t *config, disp_img_handle_t *ret_img);
+
+/**
+ * @brief Whether `dsc` holds a compressed image
+ */
+bool disp_img_is_compressed(const lv_img_dsc_t *dsc);
+
+/**
+ * @brief Decode row `y` of a compressed image, pixels `x` to `x + len - 1`, as the LVGL decoder does
+ *
+ * @param buf   2 bytes per pixel, 3 with DISP_IMG_FLAG_ALPHA
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Not a compressed image or out of it
+ */
+esp_err_t disp_img_read_line(const lv_img_dsc_t *dsc, lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t *buf);
+
+/**
+ * @brief Decode `src` into the cache now and keep it there, e.g. the images of the watch face, with the LVGL
+ *        lock held
+ *
+ * A pinned image is never evicted; the pinned images together must fit in the budget.
+ *
+ * @return
+ *      - ESP_OK: Success, or pinned already
+ *      - ESP_ERR_INVALID_ARG: Not a compressed image
+ *      - ESP_ERR_INVALID_STATE: No cache
+ *      - ESP_ERR_NO_MEM: The pinned images would overflow the budget, or out of memory
+ */
+esp_err_t disp_img_pin(disp_img_handle_t img, const lv_img_dsc_t *src);
+
+/**
+ * @brief Let `src` be evicted again, with the LVGL lock held
+ */
+void disp_img_unpin(disp_img_handle_t img, const lv_img_dsc_t *src);
+
+/**
+ * @brief Get the counters and optionally clear them, with the LVGL lock held
+ */
+void disp_img_get_stats(disp_img_handle_t img, disp_img_stats_t *stats, bool reset);
+
+/**
+ * @brief Unregister the decoder and free the cache, with the LVGL lock held and no image being drawn
+ */
+void disp_img_del(disp_img_handle_t img);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,278 @@
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "disp_lock.h"
+
+static const char *TAG = "disp_lock";
+
+typedef struct
+{
+    TaskHandle_t task;              // NULL for the "other" entry
+    disp_lock_holder_t h;
+} disp_lock_slot_t;
+
+struct disp_lock_t
+{
+    disp_lock_config_t cfg;
+    SemaphoreHandle_t mux;
+    TickType_t slice_ticks;         // wait slice, the budget in ticks
+    // Written by the holder only, between take and give
+    TaskHandle_t owner;
+    int64_t hold_start_us;
+    portMUX_TYPE lock;              // protects everything below
+    int64_t last_warn_us;
+    uint32_t warn_suppressed;
+    disp_lock_stats_t stats;        // holders are kept in `slots`
+    disp_lock_slot_t slots[DISP_LOCK_MAX_HOLDERS];
+};
+
+// A plain copy, no formatting: disp_lock_slot calls it with interrupts off
+static void disp_lock_task_name(TaskHandle_t task, char *name)
+{
+    strncpy(name, task ? pcTaskGetName(task) : "-", DISP_LOCK_NAME_LEN - 1);
+    name[DISP_LOCK_NAME_LEN - 1] = '\0';
+}
+
+// Entry of `task`, the last one collects the tasks that found the table full; call with `lock` held
+static disp_lock_holder_t *disp_lock_slot(disp_lock_handle_t lock, TaskHandle_t task)
+{
+    for (int i = 0; i < DISP_LOCK_MAX_HOLDERS - 1; i++)
+    {
+        disp_lock_slot_t *slot = &lock->slots[i];
+        if (slot->task == task)
+        {
+            return &slot->h;
+        }
+        if (slot->task == NULL)
+        {
+            slot->task = task;
+            disp_lock_task_name(task, slot->h.name);
+            return &slot->h;
+        }
+    }
+    disp_lock_slot_t *other = &lock->slots[DISP_LOCK_MAX_HOLDERS - 1];
+    if (other->h.name[0] == '\0')
+    {
+        strcpy(other->h.name, "other");
+    }
+    return &other->h;
+}
+
+// Rate-limited warning; true when the caller may log now, `suppressed` gets the warnings skipped since the last one
+static bool disp_lock_may_warn(disp_lock_handle_t lock, int64_t now_us, uint32_t *suppressed)
+{
+    bool warn = false;
+    portENTER_CRITICAL(&lock->lock);
+    if (now_us - lock->last_warn_us >= (int64_t)lock->cfg.warn_interval_ms * 1000)
+    {
+        warn = true;
+        *suppressed = lock->warn_suppressed;
+        lock->warn_suppressed = 0;
+        lock->last_warn_us = now_us;
+    }
+    else
+    {
+        lock->warn_suppressed++;
+    }
+    portEXIT_CRITICAL(&lock->lock);
+    return warn;
+}
+
+esp_err_t disp_lock_new(const disp_lock_config_t *config, disp_lock_handle_t *ret_lock)
+{
+    ESP_RETURN_ON_FALSE(config && ret_lock, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    disp_lock_handle_t lock = calloc(1, sizeof(struct disp_lock_t));
+    ESP_RETURN_ON_FALSE(lock, ESP_ERR_NO_MEM, TAG, "no mem for lock");
+    lock->cfg = *config;
+    if (lock->cfg.budget_us == 0)
+    {
+        lock->cfg.budget_us = DISP_LOCK_DEFAULT_BUDGET_US;
+    }
+    if (lock->cfg.warn_interval_ms == 0)
+    {
+        lock->cfg.warn_interval_ms = 1000;
+    }
+    lock->slice_ticks = pdMS_TO_TICKS((lock->cfg.budget_us + 999) / 1000);
+    if (lock->slice_ticks == 0)
+    {
+        lock->slice_ticks = 1;
+    }
+    lock->last_warn_us = -(int64_t)lock->cfg.warn_interval_ms * 1000;
+    portMUX_INITIALIZE(&lock->lock);
+
+    // A mutex, not a binary semaphore: only a mutex has priority inheritance
+    lock->mux = xSemaphoreCreateMutex();
+    if (lock->mux == NULL)
+    {
+        free(lock);
+        ESP_LOGE(TAG, "no mem for mutex");
+        return ESP_ERR_NO_MEM;
+    }
+    *ret_lock = lock;
+    return ESP_OK;
+}
+
+bool disp_lock_take(disp_lock_handle_t lock, int timeout_ms)
+{
+    const int64_t t0 = esp_timer_get_time();
+    const TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    bool contended = false;
+    bool taken = xSemaphoreTake(lock->mux, 0) == pdTRUE;
+    if (!taken)
+    {
+        contended = true;
+        const TickType_t timeout_ticks = timeout_ms < 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+        TickType_t waited = 0;
+        while (!taken && (timeout_ms < 0 || waited < timeout_ticks))
+        {
+            TickType_t ticks = lock->slice_ticks;
+            if (timeout_ms >= 0 && timeout_ticks - waited < ticks)
+            {
+                ticks = timeout_ticks - waited;
+            }
+            taken = xSemaphoreTake(lock->mux, ticks) == pdTRUE;
+            waited += ticks;
+            if (!taken && timeout_ms < 0)
+            {
+                // Still waiting a frame budget later: name the holder
+                const int64_t now = esp_timer_get_time();
+                uint32_t suppressed = 0;
+                if (disp_lock_may_warn(lock, now, &suppressed))
+                {
+                    char holder[DISP_LOCK_NAME_LEN];
+                    disp_lock_task_name(xSemaphoreGetMutexHolder(lock->mux), holder);
+                    ESP_LOGW(TAG, "%s waiting %" PRId64 " ms for the lock held by %s (%" PRIu32 " warnings skipped)",
+                             pcTaskGetName(self), (now - t0) / 1000, holder, suppressed);
+                }
+            }
+        }
+    }
+    const int64_t now = esp_timer_get_time();
+    const uint32_t wait_us = (uint32_t)(now - t0);
+    char holder[DISP_LOCK_NAME_LEN] = "";
+    if (!taken)
+    {
+        disp_lock_task_name(xSemaphoreGetMutexHolder(lock->mux), holder);
+    }
+    else
+    {
+        lock->owner = self;
+        lock->hold_start_us = now;
+    }
+
+    portENTER_CRITICAL(&lock->lock);
+    disp_lock_holder_t *h = disp_lock_slot(lock, self);
+    h->wait_us += wait_us;
+    h->max_wait_us = wait_us > h->max_wait_us ? wait_us : h->max_wait_us;
+    lock->stats.wait_us += wait_us;
+    if (taken)
+    {
+        lock->stats.takes++;
+        lock->stats.contended += contended;
+    }
+    else
+    {
+        lock->stats.timeouts++;
+        memcpy(lock->stats.last_timeout_holder, holder, DISP_LOCK_NAME_LEN);
+    }
+    portEXIT_CRITICAL(&lock->lock);
+    return taken;
+}
+
+void disp_lock_give(disp_lock_handle_t lock)
+{
+    const TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (lock->owner != self)
+    {
+        // FreeRTOS would refuse it too; giving on behalf of another task breaks the priority inheritance
+        ESP_LOGE(TAG, "%s gives a lock it does not hold", pcTaskGetName(self));
+        return;
+    }
+    const int64_t now = esp_timer_get_time();
+    const uint32_t hold_us = (uint32_t)(now - lock->hold_start_us);
+    lock->owner = NULL;
+    xSemaphoreGive(lock->mux);
+
+    int bucket = 0;
+    while (bucket < DISP_LOCK_HIST_BUCKETS - 1 && hold_us >= (1000U << bucket))
+    {
+        bucket++;
+    }
+    const bool over = hold_us > lock->cfg.budget_us;
+    portENTER_CRITICAL(&lock->lock);
+    disp_lock_holder_t *h = disp_lock_slot(lock, self);
+    h->holds++;
+    h->hold_us += hold_us;
+    h->max_hold_us = hold_us > h->max_hold_us ? hold_us : h->max_hold_us;
+    h->hist[bucket]++;
+    h->over_budget += over;
+    lock->stats.hold_us += hold_us;
+    lock->stats.over_budget += over;
+    if (hold_us > lock->stats.max_hold_us)
+    {
+        lock->stats.max_hold_us = hold_us;
+        memcpy(lock->stats.max_hold_name, h->name, DISP_LOCK_NAME_LEN);
+    }
+    portEXIT_CRITICAL(&lock->lock);
+
+    uint32_t suppressed = 0;
+    if (over && disp_lock_may_warn(lock, now, &suppressed))
+    {
+        ESP_LOGW(TAG, "%s held the lock for %" PRIu32 " us, budget %" PRIu32 " us (%" PRIu32 " warnings skipped)",
+                 pcTaskGetName(self), hold_us, lock->cfg.budget_us, suppressed);
+    }
+}
+
+TaskHandle_t disp_lock_get_holder(disp_lock_handle_t lock)
+{
+    return xSemaphoreGetMutexHolder(lock->mux);
+}
+
+void disp_lock_get_stats(disp_lock_handle_t lock, disp_lock_stats_t *stats, bool reset)
+{
+    portENTER_CRITICAL(&lock->lock);
+    *stats = lock->stats;
+    stats->holder_count = 0;
+    for (int i = 0; i < DISP_LOCK_MAX_HOLDERS; i++)
+    {
+        if (lock->slots[i].h.holds || lock->slots[i].h.wait_us)
+        {
+            stats->holders[stats->holder_count++] = lock->slots[i].h;
+        }
+    }
+    if (reset)
+    {
+        memset(&lock->stats, 0, sizeof(lock->stats));
+        // Keep the task of every entry, a task keeps its place across resets
+        for (int i = 0; i < DISP_LOCK_MAX_HOLDERS; i++)
+        {
+            char name[DISP_LOCK_NAME_LEN];
+            memcpy(name, lock->slots[i].h.name, DISP_LOCK_NAME_LEN);
+            memset(&lock->slots[i].h, 0, sizeof(lock->slots[i].h));
+            memcpy(lock->slots[i].h.name, name, DISP_LOCK_NAME_LEN);
+        }
+    }
+    portEXIT_CRITICAL(&lock->lock);
+
+    // Longest holders first
+    for (size_t i = 1; i < stats->holder_count; i++)
+    {
+        disp_lock_holder_t h = stats->holders[i];
+        size_t j = i;
+        while (j > 0 && stats->holders[j - 1].max_hold_us < h.max_hold_us)
+        {
+            stats->holders[j] = stats->holders[j - 1];
+            j--;
+        }
+        stats->holders[j] = h;
+    }
+}
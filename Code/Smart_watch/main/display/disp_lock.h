@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default hold time that makes a frame late, one panel refresh at 60 Hz
+#define DISP_LOCK_DEFAULT_BUDGET_US 16667
+// Tasks whose holds are kept apart, later ones are counted as "other"
+#define DISP_LOCK_MAX_HOLDERS 8
+// Hold time histogram: bucket i counts holds shorter than (1 << i) ms, the last one everything longer
+#define DISP_LOCK_HIST_BUCKETS 8
+// Longest task name kept, NUL included
+#define DISP_LOCK_NAME_LEN 16
+
+typedef struct disp_lock_t *disp_lock_handle_t;
+
+/**
+ * @brief Instrumented lock configuration
+ */
+typedef struct {
+    uint32_t budget_us;             /*!< Holds longer than this are counted and warned about, 0 selects
+                                         DISP_LOCK_DEFAULT_BUDGET_US */
+    uint32_t warn_interval_ms;      /*!< Least time between two over-budget warnings, 0 selects 1 s */
+} disp_lock_config_t;
+
+/**
+ * @brief Holds of one task since the last reset
+ */
+typedef struct {
+    char name[DISP_LOCK_NAME_LEN];  /*!< Task name, "other" past DISP_LOCK_MAX_HOLDERS tasks */
+    uint32_t holds;                 /*!< Times the task took the lock */
+    uint32_t over_budget;           /*!< Holds longer than the budget */
+    uint64_t hold_us;               /*!< Total hold time */
+    uint32_t max_hold_us;           /*!< Longest hold */
+    uint64_t wait_us;               /*!< Total time waited for the lock */
+    uint32_t max_wait_us;           /*!< Longest wait, timeouts included */
+    uint32_t hist[DISP_LOCK_HIST_BUCKETS]; /*!< Hold time histogram */
+} disp_lock_holder_t;
+
+/**
+ * @brief Lock counters since the last reset
+ */
+typedef struct {
+    uint32_t takes;                 /*!< Successful takes */
+    uint32_t contended;             /*!< Of them, takes that found the lock held */
+    uint32_t timeouts;              /*!< Takes that gave up */
+    uint32_t over_budget;           /*!< Holds longer than the budget */
+    uint64_t wait_us;               /*!< Total time waited, timeouts included */
+    uint64_t hold_us;               /*!< Total hold time */
+    uint32_t max_hold_us;           /*!< Longest hold */
+    char max_hold_name[DISP_LOCK_NAME_LEN]; /*!< Task that held it the longest */
+    char last_timeout_holder[DISP_LOCK_NAME_LEN]; /*!< Task that held the lock when the last take gave up */
+    size_t holder_count;            /*!< Entries in `holders` */
+    disp_lock_holder_t holders[DISP_LOCK_MAX_HOLDERS]; /*!< Per task, longest hold first */
+} disp_lock_stats_t;
+
+/**
+ * @brief Create the lock, a FreeRTOS mutex so a low-priority holder inherits the priority of its waiters
+ *
+ * @param[in]  config   Configuration
+ * @param[out] ret_lock Handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Bad configuration
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t disp_lock_new(const disp_lock_config_t *config, disp_lock_handle_t *ret_lock);
+
+/**
+ * @brief Take the lock, from a task
+ *
+ * The wait is cut into slices of the budget. Every slice re-arms the priority inheritance, and a timed-out
+ * slice lets FreeRTOS drop the holder back to its own priority; each slice that expires logs who holds the
+ * lock. Not recursive.
+ *
+ * @param timeout_ms Longest wait, -1 to wait until the lock is free
+ * @return true once taken, false on timeout
+ */
+bool disp_lock_take(disp_lock_handle_t lock, int timeout_ms);
+
+/**
+ * @brief Give the lock back, from the task that took it, and account the hold
+ */
+void disp_lock_give(disp_lock_handle_t lock);
+
+/**
+ * @brief Task holding the lock, NULL when free
+ */
+TaskHandle_t disp_lock_get_holder(disp_lock_handle_t lock);
+
+/**
+ * @brief Get the lock counters and optionally clear them
+ */
+void disp_lock_get_stats(disp_lock_handle_t lock, disp_lock_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,297 @@
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "disp_model.h"
+
+static const char *TAG = "disp_model";
+
+typedef enum
+{
+    DISP_MODEL_BIND_NONE,           // free slot
+    DISP_MODEL_BIND_LABEL,
+    DISP_MODEL_BIND_ARC,
+    DISP_MODEL_BIND_BAR,
+} disp_model_bind_type_t;
+
+typedef struct
+{
+    const char *name;
+    _Atomic int32_t value;          // last value set, any task
+    int32_t shown;                  // value on the widgets, LVGL task only
+} disp_model_value_t;
+
+typedef struct
+{
+    disp_model_bind_type_t type;
+    disp_model_id_t id;
+    lv_obj_t *obj;
+    const char *fmt;                // printf format, or NULL for format_cb
+    disp_model_format_cb_t format_cb;
+    void *user_ctx;
+    char text[DISP_MODEL_TEXT_LEN]; // the label shows this buffer (lv_label_set_text_static)
+} disp_model_binding_t;
+
+struct disp_model_t
+{
+    disp_model_config_t cfg;
+    size_t count;
+    disp_model_value_t values[DISP_MODEL_MAX_VALUES];
+    _Atomic uint32_t changed;       // one bit per value set since the last apply
+    _Atomic uint32_t sets;
+    _Atomic uint32_t coalesced;
+    disp_model_binding_t bindings[DISP_MODEL_MAX_BINDINGS];
+    disp_model_stats_t stats;       // LVGL task counters
+};
+
+// Show `value` on the widget of `b`, leaving it alone when it would look the same
+static void disp_model_show(disp_model_handle_t model, disp_model_binding_t *b, int32_t value)
+{
+    switch (b->type)
+    {
+    case DISP_MODEL_BIND_LABEL:
+    {
+        char text[DISP_MODEL_TEXT_LEN];
+        if (b->fmt)
+        {
+            snprintf(text, sizeof(text), b->fmt, value);
+        }
+        else
+        {
+            text[0] = '\0';
+            b->format_cb(value, text, sizeof(text), b->user_ctx);
+            text[sizeof(text) - 1] = '\0';
+        }
+        if (strcmp(text, b->text) == 0 && lv_label_get_text(b->obj) == b->text)
+        {
+            model->stats.text_unchanged++;
+            return;
+        }
+        memcpy(b->text, text, sizeof(text));
+        // Same buffer every time, LVGL only measures the text again and invalidates the label
+        lv_label_set_text_static(b->obj, b->text);
+        model->stats.label_updates++;
+        break;
+    }
+    case DISP_MODEL_BIND_ARC:
+    {
+        // Arc values are 16 bit: clamp first, so a count past the range stays full instead of wrapping
+        const int16_t shown = (int16_t)LV_CLAMP(lv_arc_get_min_value(b->obj), value, lv_arc_get_max_value(b->obj));
+        if (lv_arc_get_value(b->obj) != shown)
+        {
+            lv_arc_set_value(b->obj, shown);
+            model->stats.value_updates++;
+        }
+        break;
+    }
+    case DISP_MODEL_BIND_BAR:
+        if (lv_bar_get_value(b->obj) != value)
+        {
+            lv_bar_set_value(b->obj, value, LV_ANIM_OFF);
+            model->stats.value_updates++;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// A bound widget is being deleted, e.g. with its screen: drop its bindings
+static void disp_model_delete_cb(lv_event_t *e)
+{
+    disp_model_handle_t model = (disp_model_handle_t)lv_event_get_user_data(e);
+    lv_obj_t *obj = lv_event_get_target(e);
+    for (size_t i = 0; i < DISP_MODEL_MAX_BINDINGS; i++)
+    {
+        if (model->bindings[i].obj == obj)
+        {
+            memset(&model->bindings[i], 0, sizeof(model->bindings[i]));
+            model->stats.bindings--;
+        }
+    }
+}
+
+static esp_err_t disp_model_bind(disp_model_handle_t model, const disp_model_binding_t *binding)
+{
+    disp_model_binding_t *slot = NULL;
+    for (size_t i = 0; i < DISP_MODEL_MAX_BINDINGS; i++)
+    {
+        disp_model_binding_t *b = &model->bindings[i];
+        if (b->obj == binding->obj)
+        {
+            // Bound again, to this value or another one
+            slot = b;
+            break;
+        }
+        if (slot == NULL && b->type == DISP_MODEL_BIND_NONE)
+        {
+            slot = b;
+        }
+    }
+    ESP_RETURN_ON_FALSE(slot, ESP_ERR_NO_MEM, TAG, "too many bindings");
+    if (slot->obj == NULL)
+    {
+        lv_obj_add_event_cb(binding->obj, disp_model_delete_cb, LV_EVENT_DELETE, model);
+        model->stats.bindings++;
+    }
+    *slot = *binding;
+    disp_model_show(model, slot, model->values[binding->id].shown);
+    return ESP_OK;
+}
+
+esp_err_t disp_model_new(const disp_model_config_t *config, disp_model_handle_t *ret_model)
+{
+    ESP_RETURN_ON_FALSE(config && ret_model, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    // Set from any task, so internal RAM
+    disp_model_handle_t model = calloc(1, sizeof(struct disp_model_t));
+    ESP_RETURN_ON_FALSE(model, ESP_ERR_NO_MEM, TAG, "no mem for data model");
+    model->cfg = *config;
+    *ret_model = model;
+    return ESP_OK;
+}
+
+esp_err_t disp_model_add(disp_model_handle_t model, const char *name, int32_t initial, disp_model_id_t *ret_id)
+{
+    ESP_RETURN_ON_FALSE(model && name && ret_id, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(model->count < DISP_MODEL_MAX_VALUES, ESP_ERR_NO_MEM, TAG, "too many values");
+    disp_model_value_t *v = &model->values[model->count];
+    v->name = name;
+    atomic_init(&v->value, initial);
+    v->shown = initial;
+    *ret_id = (disp_model_id_t)model->count++;
+    return ESP_OK;
+}
+
+esp_err_t disp_model_set(disp_model_handle_t model, disp_model_id_t id, int32_t value)
+{
+    ESP_RETURN_ON_FALSE(model && id < model->count, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    atomic_store_explicit(&model->values[id].value, value, memory_order_relaxed);
+    // Release: the LVGL task that sees the bit sees the value
+    const uint32_t bit = 1u << id;
+    const uint32_t changed = atomic_fetch_or_explicit(&model->changed, bit, memory_order_release);
+    atomic_fetch_add_explicit(&model->sets, 1, memory_order_relaxed);
+    if (changed & bit)
+    {
+        atomic_fetch_add_explicit(&model->coalesced, 1, memory_order_relaxed);
+    }
+    else if (model->cfg.on_change)
+    {
+        model->cfg.on_change(model->cfg.user_ctx);
+    }
+    return ESP_OK;
+}
+
+int32_t disp_model_get(disp_model_handle_t model, disp_model_id_t id)
+{
+    return atomic_load_explicit(&model->values[id].value, memory_order_relaxed);
+}
+
+esp_err_t disp_model_bind_label(disp_model_handle_t model, disp_model_id_t id, lv_obj_t *label, const char *fmt)
+{
+    ESP_RETURN_ON_FALSE(model && id < model->count && label && fmt, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(lv_obj_check_type(label, &lv_label_class), ESP_ERR_INVALID_ARG, TAG, "not a label");
+    const disp_model_binding_t b = {
+        .type = DISP_MODEL_BIND_LABEL,
+        .id = id,
+        .obj = label,
+        .fmt = fmt,
+    };
+    return disp_model_bind(model, &b);
+}
+
+esp_err_t disp_model_bind_label_cb(disp_model_handle_t model, disp_model_id_t id, lv_obj_t *label,
+                                   disp_model_format_cb_t format_cb, void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(model && id < model->count && label && format_cb, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid argument");
+    ESP_RETURN_ON_FALSE(lv_obj_check_type(label, &lv_label_class), ESP_ERR_INVALID_ARG, TAG, "not a label");
+    const disp_model_binding_t b = {
+        .type = DISP_MODEL_BIND_LABEL,
+        .id = id,
+        .obj = label,
+        .format_cb = format_cb,
+        .user_ctx = user_ctx,
+    };
+    return disp_model_bind(model, &b);
+}
+
+esp_err_t disp_model_bind_value(disp_model_handle_t model, disp_model_id_t id, lv_obj_t *obj)
+{
+    ESP_RETURN_ON_FALSE(model && id < model->count && obj, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    disp_model_binding_t b = {
+        .id = id,
+        .obj = obj,
+    };
+    if (lv_obj_check_type(obj, &lv_arc_class))
+    {
+        b.type = DISP_MODEL_BIND_ARC;
+    }
+    else if (lv_obj_check_type(obj, &lv_bar_class))
+    {
+        b.type = DISP_MODEL_BIND_BAR;
+    }
+    ESP_RETURN_ON_FALSE(b.type != DISP_MODEL_BIND_NONE, ESP_ERR_INVALID_ARG, TAG, "not an arc or a bar");
+    return disp_model_bind(model, &b);
+}
+
+size_t disp_model_apply(disp_model_handle_t model)
+{
+    uint32_t changed = atomic_exchange_explicit(&model->changed, 0, memory_order_acquire);
+    if (changed == 0)
+    {
+        return 0;
+    }
+    const int64_t t0 = esp_timer_get_time();
+    size_t applied = 0;
+    while (changed)
+    {
+        const int id = __builtin_ctz(changed);
+        changed &= changed - 1;
+        disp_model_value_t *v = &model->values[id];
+        const int32_t value = atomic_load_explicit(&v->value, memory_order_relaxed);
+        if (value == v->shown)
+        {
+            // Changed and changed back within the frame
+            model->stats.unchanged++;
+            continue;
+        }
+        v->shown = value;
+        ESP_LOGV(TAG, "%s: %" PRId32, v->name, value);
+        for (size_t i = 0; i < DISP_MODEL_MAX_BINDINGS; i++)
+        {
+            if (model->bindings[i].type != DISP_MODEL_BIND_NONE && model->bindings[i].id == id)
+            {
+                disp_model_show(model, &model->bindings[i], value);
+            }
+        }
+        applied++;
+    }
+    model->stats.applied += applied;
+    model->stats.passes++;
+    model->stats.apply_us += esp_timer_get_time() - t0;
+    return applied;
+}
+
+void disp_model_get_stats(disp_model_handle_t model, disp_model_stats_t *stats, bool reset)
+{
+    *stats = model->stats;
+    if (reset)
+    {
+        const uint32_t bindings = model->stats.bindings;
+        memset(&model->stats, 0, sizeof(model->stats));
+        model->stats.bindings = bindings;
+        stats->sets = atomic_exchange_explicit(&model->sets, 0, memory_order_relaxed);
+        stats->coalesced = atomic_exchange_explicit(&model->coalesced, 0, memory_order_relaxed);
+    }
+    else
+    {
+        stats->sets = atomic_load_explicit(&model->sets, memory_order_relaxed);
+        stats->coalesced = atomic_load_explicit(&model->coalesced, memory_order_relaxed);
+    }
+}
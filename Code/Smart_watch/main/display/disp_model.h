@@ -0,0 +1,148 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Most values in a model, one bit each in the change mask
+#define DISP_MODEL_MAX_VALUES 32
+// Most widgets bound at once
+#define DISP_MODEL_MAX_BINDINGS 32
+// Text buffer of a bound label, NUL included; longer texts are cut
+#define DISP_MODEL_TEXT_LEN 16
+
+typedef struct disp_model_t *disp_model_handle_t;
+
+/**
+ * @brief Value of a model, returned by disp_model_add
+ */
+typedef uint8_t disp_model_id_t;
+
+/**
+ * @brief Called in the setting task when a value changes for the first time since the last apply, e.g. to wake
+ *        the LVGL task up
+ */
+typedef void (*disp_model_change_cb_t)(void *user_ctx);
+
+/**
+ * @brief Writes the text of a value into `buf`, e.g. minutes of the day as "17:23"
+ */
+typedef void (*disp_model_format_cb_t)(int32_t value, char *buf, size_t size, void *user_ctx);
+
+/**
+ * @brief Data model configuration
+ */
+typedef struct {
+    disp_model_change_cb_t on_change; /*!< Called on the first change of a frame (may be NULL) */
+    void *user_ctx;                 /*!< Passed to `on_change` */
+} disp_model_config_t;
+
+/**
+ * @brief Data model counters since the last reset
+ */
+typedef struct {
+    uint32_t sets;                  /*!< disp_model_set calls */
+    uint32_t coalesced;             /*!< Sets replaced by a later one before the LVGL task applied them */
+    uint32_t unchanged;             /*!< Changed values the LVGL task found back at the value shown */
+    uint32_t applied;               /*!< Values pushed to their widgets */
+    uint32_t passes;                /*!< `disp_model_apply` calls that found changes */
+    uint32_t label_updates;         /*!< Label texts changed */
+    uint32_t text_unchanged;        /*!< Labels left alone because the new text was the one shown */
+    uint32_t value_updates;         /*!< Arc and bar values changed */
+    uint32_t bindings;              /*!< Widgets bound now */
+    uint64_t apply_us;              /*!< Time spent in `disp_model_apply` */
+} disp_model_stats_t;
+
+/**
+ * @brief Create a data model
+ *
+ * @param[in]  config    Configuration
+ * @param[out] ret_model Handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t disp_model_new(const disp_model_config_t *config, disp_model_handle_t *ret_model);
+
+/**
+ * @brief Add a value to the model, at init before any task sets it
+ *
+ * @param name    Name for the logs, must stay valid
+ * @param initial Value until the first set
+ * @param ret_id  Id to set and bind the value with
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NO_MEM: DISP_MODEL_MAX_VALUES values added already
+ */
+esp_err_t disp_model_add(disp_model_handle_t model, const char *name, int32_t initial, disp_model_id_t *ret_id);
+
+/**
+ * @brief Set a value, from any task
+ *
+ * Never blocks and never takes the LVGL lock: the value is stored and marked changed with atomics. Sets of the
+ * same value between two passes of the LVGL task coalesce, only the last one reaches the widgets.
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t disp_model_set(disp_model_handle_t model, disp_model_id_t id, int32_t value);
+
+/**
+ * @brief Last value set, from any task
+ */
+int32_t disp_model_get(disp_model_handle_t model, disp_model_id_t id);
+
+/**
+ * @brief Bind a label to a value, with the LVGL lock held
+ *
+ * The label shows the value formatted with `fmt`, a printf format taking one int32_t (e.g. "%" PRId32 "%%"), in a
+ * buffer of the binding set with lv_label_set_text_static, so updates never allocate. The label gets the current
+ * value right away. The binding goes when the label is deleted, e.g. with its screen; bind the new label once
+ * the screen is built again.
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument or not a label
+ *      - ESP_ERR_NO_MEM: DISP_MODEL_MAX_BINDINGS widgets bound already
+ */
+esp_err_t disp_model_bind_label(disp_model_handle_t model, disp_model_id_t id, lv_obj_t *label, const char *fmt);
+
+/**
+ * @brief Bind a label to a value formatted by `format_cb`, as disp_model_bind_label
+ */
+esp_err_t disp_model_bind_label_cb(disp_model_handle_t model, disp_model_id_t id, lv_obj_t *label,
+                                   disp_model_format_cb_t format_cb, void *user_ctx);
+
+/**
+ * @brief Bind the value of an arc or a bar to a value, clamped to its range; as disp_model_bind_label
+ */
+esp_err_t disp_model_bind_value(disp_model_handle_t model, disp_model_id_t id, lv_obj_t *obj);
+
+/**
+ * @brief Push the values changed since the last call to their widgets, at the start of an LVGL task pass
+ *
+ * Values back at the one shown are skipped, and so are labels whose new text is the one shown, so only widgets
+ * that look different are invalidated. Call in the LVGL task with the LVGL lock held.
+ *
+ * @return Number of values pushed to their widgets
+ */
+size_t disp_model_apply(disp_model_handle_t model);
+
+/**
+ * @brief Get the counters and optionally clear them, with the LVGL lock held
+ */
+void disp_model_get_stats(disp_model_handle_t model, disp_model_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
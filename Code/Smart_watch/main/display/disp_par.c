@@ -0,0 +1,170 @@
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "draw/sw/lv_draw_sw.h"
+#include "disp_par.h"
+
+static const char *TAG = "disp_par";
+
+struct disp_par_t
+{
+    disp_par_config_t cfg;
+    lv_disp_t *disp;
+    void (*blend)(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc);
+    bool enabled;
+    TaskHandle_t task;
+    SemaphoreHandle_t done;         // given by the worker when its half is blended
+    // The job handed to the worker, written by the LVGL task before the notification and read back after `done`
+    lv_draw_sw_ctx_t job_ctx;
+    lv_area_t job_clip;
+    const lv_draw_sw_blend_dsc_t *job_dsc;
+    int64_t job_us;
+    portMUX_TYPE lock;              // protects the counters
+    disp_par_stats_t stats;
+};
+
+static void disp_par_task(void *arg)
+{
+    disp_par_handle_t par = (disp_par_handle_t)arg;
+    ESP_LOGI(TAG, "Starting blend worker");
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        const int64_t t0 = esp_timer_get_time();
+        par->blend(&par->job_ctx.base_draw, par->job_dsc);
+        par->job_us = esp_timer_get_time() - t0;
+        xSemaphoreGive(par->done);
+    }
+}
+
+// Blend callback of the software draw context, in the LVGL task
+static void disp_par_blend(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc)
+{
+    disp_par_handle_t par = (disp_par_handle_t)draw_ctx->user_data;
+    lv_area_t area;
+    if (!_lv_area_intersect(&area, dsc->blend_area, draw_ctx->clip_area))
+    {
+        return;
+    }
+    const uint32_t px = lv_area_get_size(&area);
+    const lv_coord_t h = lv_area_get_height(&area);
+    const lv_disp_drv_t *drv = par->disp->driver;
+    // set_px_cb is user code, and without anti-aliasing the blend rounds the whole mask in place
+    const bool split = par->enabled && px >= par->cfg.min_px && h >= 2 && drv->set_px_cb == NULL &&
+                       (drv->antialiasing || dsc->mask_buf == NULL);
+    if (!split)
+    {
+        par->blend(draw_ctx, dsc);
+        portENTER_CRITICAL(&par->lock);
+        par->stats.blends++;
+        par->stats.px += px;
+        portEXIT_CRITICAL(&par->lock);
+        return;
+    }
+
+    lv_area_t top = area;
+    top.y2 = area.y1 + h / 2 - 1;
+    // The worker gets a copy of the context clipped to the bottom rows
+    par->job_ctx = *(lv_draw_sw_ctx_t *)draw_ctx;
+    par->job_clip = area;
+    par->job_clip.y1 = top.y2 + 1;
+    par->job_ctx.base_draw.clip_area = &par->job_clip;
+    par->job_dsc = dsc;
+    xTaskNotifyGive(par->task);
+
+    const lv_area_t *clip_area = draw_ctx->clip_area;
+    draw_ctx->clip_area = &top;
+    par->blend(draw_ctx, dsc);
+    draw_ctx->clip_area = clip_area;
+
+    const int64_t t0 = esp_timer_get_time();
+    xSemaphoreTake(par->done, portMAX_DELAY);
+    const int64_t wait_us = esp_timer_get_time() - t0;
+
+    portENTER_CRITICAL(&par->lock);
+    par->stats.blends++;
+    par->stats.split++;
+    par->stats.px += px;
+    par->stats.split_px += px;
+    par->stats.worker_px += lv_area_get_size(&par->job_clip);
+    par->stats.worker_us += par->job_us;
+    par->stats.join_wait_us += wait_us;
+    portEXIT_CRITICAL(&par->lock);
+}
+
+esp_err_t disp_par_new(const disp_par_config_t *config, disp_par_handle_t *ret_par)
+{
+    esp_err_t ret = ESP_OK;
+    disp_par_handle_t par = NULL;
+    ESP_RETURN_ON_FALSE(config && ret_par, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    par = calloc(1, sizeof(struct disp_par_t));
+    ESP_RETURN_ON_FALSE(par, ESP_ERR_NO_MEM, TAG, "no mem for parallel blend");
+    par->cfg = *config;
+    if (par->cfg.min_px == 0)
+    {
+        par->cfg.min_px = DISP_PAR_DEFAULT_MIN_PX;
+    }
+    if (par->cfg.task_stack == 0)
+    {
+        par->cfg.task_stack = 3 * 1024;
+    }
+    portMUX_INITIALIZE(&par->lock);
+
+    par->done = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(par->done, ESP_ERR_NO_MEM, err, TAG, "no mem for join semaphore");
+    BaseType_t res = xTaskCreatePinnedToCore(disp_par_task, "disp_par", par->cfg.task_stack, par,
+                                             par->cfg.task_priority, &par->task, par->cfg.task_core);
+    ESP_GOTO_ON_FALSE(res == pdPASS, ESP_ERR_NO_MEM, err, TAG, "create blend worker failed");
+
+    *ret_par = par;
+    return ESP_OK;
+
+err:
+    if (par->done)
+    {
+        vSemaphoreDelete(par->done);
+    }
+    free(par);
+    return ret;
+}
+
+esp_err_t disp_par_attach(disp_par_handle_t par, lv_disp_t *disp)
+{
+    ESP_RETURN_ON_FALSE(par && disp && disp->driver->draw_ctx, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    lv_draw_sw_ctx_t *sw_ctx = (lv_draw_sw_ctx_t *)disp->driver->draw_ctx;
+    par->disp = disp;
+    if (sw_ctx->blend != disp_par_blend)
+    {
+        par->blend = sw_ctx->blend;
+        sw_ctx->blend = disp_par_blend;
+    }
+    sw_ctx->base_draw.user_data = par;
+    par->enabled = true;
+    ESP_LOGI(TAG, "blends from %" PRIu32 " px split with core %d", par->cfg.min_px, (int)par->cfg.task_core);
+    return ESP_OK;
+}
+
+void disp_par_set_enabled(disp_par_handle_t par, bool enabled)
+{
+    par->enabled = enabled;
+}
+
+void disp_par_get_stats(disp_par_handle_t par, disp_par_stats_t *stats, bool reset)
+{
+    portENTER_CRITICAL(&par->lock);
+    *stats = par->stats;
+    if (reset)
+    {
+        memset(&par->stats, 0, sizeof(par->stats));
+    }
+    portEXIT_CRITICAL(&par->lock);
+}
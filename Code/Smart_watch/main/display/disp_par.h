@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default smallest blend worth handing half of to the other core, about 22 rows of the 368 px panel; below it
+// the two task switches of the hand-over cost more than the half blend saves
+#define DISP_PAR_DEFAULT_MIN_PX 8192
+
+typedef struct disp_par_t *disp_par_handle_t;
+
+/**
+ * @brief Parallel blend configuration
+ */
+typedef struct {
+    uint32_t min_px;                /*!< Blends covering fewer pixels stay on the LVGL task, 0 selects
+                                         DISP_PAR_DEFAULT_MIN_PX */
+    uint32_t task_stack;            /*!< Worker task stack size in bytes, 0 selects 3 KB */
+    UBaseType_t task_priority;      /*!< Worker task priority, at least the LVGL task's so the join is short */
+    BaseType_t task_core;           /*!< Worker task core, the one the LVGL task is not pinned to */
+} disp_par_config_t;
+
+/**
+ * @brief Parallel blend counters since the last reset
+ */
+typedef struct {
+    uint32_t blends;                /*!< Blends that reached the draw buffer */
+    uint32_t split;                 /*!< Of them, blends split between the two cores */
+    uint64_t px;                    /*!< Pixels blended */
+    uint64_t split_px;              /*!< Pixels of the split blends */
+    uint64_t worker_px;             /*!< Pixels blended by the worker */
+    uint64_t worker_us;             /*!< Time the worker spent blending */
+    uint64_t join_wait_us;          /*!< Time the LVGL task waited for the worker after blending its own half */
+} disp_par_stats_t;
+
+/**
+ * @brief Create the worker task that blends half of the large fills and images on the other core
+ *
+ * @param[in]  config  Configuration
+ * @param[out] ret_par Handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Bad configuration
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t disp_par_new(const disp_par_config_t *config, disp_par_handle_t *ret_par);
+
+/**
+ * @brief Split the software blends of `disp` between the LVGL task and the worker
+ *
+ * Every blend of at least `min_px` pixels is cut into a top and a bottom half. The LVGL task blends the top
+ * rows while the worker blends the bottom rows, each through its own copy of the draw context clipped to its
+ * half, so they write disjoint rows of the draw buffer; the blend returns once both are done, so everything
+ * drawn later and the flush see the whole area. Call after `lv_disp_drv_register`, with the LVGL lock held.
+ */
+esp_err_t disp_par_attach(disp_par_handle_t par, lv_disp_t *disp);
+
+/**
+ * @brief Turn the splitting on or off, e.g. to compare against single-core rendering; on after `disp_par_attach`
+ *
+ * Call with the LVGL lock held.
+ */
+void disp_par_set_enabled(disp_par_handle_t par, bool enabled);
+
+/**
+ * @brief Get the parallel blend counters and optionally clear them
+ */
+void disp_par_get_stats(disp_par_handle_t par, disp_par_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,66 @@
+#include <stdint.h>
+
+#include "esp_lcd_panel_ops.h"
+#include "pixel_conv.h"
+
+#include "disp_port.h"
+
+// Callback function to notify LVGL that the flush is ready
+bool example_notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    // Get the LVGL display driver pointer
+    lv_disp_drv_t *disp_driver = (lv_disp_drv_t *)user_ctx;
+    // Notify the LVGL display driver that the flush is ready
+    lv_disp_flush_ready(disp_driver);
+    return false;
+}
+
+// Convert a rendered area to the pixel format sent to the LCD, in place
+void example_lvgl_color_pack(const lv_area_t *area, lv_color_t *color_map)
+{
+#if LCD_BIT_PER_PIXEL == 24
+    // lv_color32_t is B, G, R, A in memory, the panel expects R, G, B
+    pixel_conv_xrgb8888_to_rgb888((uint8_t *)color_map, (const uint32_t *)color_map, lv_area_get_size(area));
+#elif LCD_BIT_PER_PIXEL == 16 && !LV_COLOR_16_SWAP
+    // The panel takes RGB565 high byte first, swap here when the renderer does not
+    pixel_conv_rgb565_swap((uint16_t *)color_map, (const uint16_t *)color_map, lv_area_get_size(area));
+#else
+    (void)area;
+    (void)color_map;
+#endif
+}
+
+// LVGL flush callback function to draw the buffer content to the LCD
+void example_lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    // Get the LCD panel handle
+    esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t)drv->user_data;
+    // Get the coordinates of the area to be drawn
+    const int offsetx1 = area->x1;
+    const int offsetx2 = area->x2;
+    const int offsety1 = area->y1;
+    const int offsety2 = area->y2;
+
+    example_lvgl_color_pack(area, color_map);
+
+    // Draw the buffer content to the specified area
+    esp_lcd_panel_draw_bitmap(panel_handle, offsetx1, offsety1, offsetx2 + 1, offsety2 + 1, color_map);
+}
+
+// LVGL area rounding callback function to adjust the drawing area
+void example_lvgl_rounder_cb(struct _lv_disp_drv_t *disp_drv, lv_area_t *area)
+{
+    // Get the start and end coordinates of the area
+    uint16_t x1 = area->x1;
+    uint16_t x2 = area->x2;
+
+    uint16_t y1 = area->y1;
+    uint16_t y2 = area->y2;
+
+    // Round down the start coordinates to the nearest even number
+    area->x1 = (x1 >> 1) << 1;
+    area->y1 = (y1 >> 1) << 1;
+    // Round up the end coordinates to the nearest odd number
+    area->x2 = ((x2 >> 1) << 1) + 1;
+    area->y2 = ((y2 >> 1) << 1) + 1;
+}
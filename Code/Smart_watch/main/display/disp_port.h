@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "esp_lcd_panel_io.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Define the horizontal and vertical pixel counts of the LCD
+#define EXAMPLE_LCD_H_RES 368
+#define EXAMPLE_LCD_V_RES 448
+
+// Configure the number of bits per pixel of the LCD according to the LVGL color depth
+#if CONFIG_LV_COLOR_DEPTH == 32
+#define LCD_BIT_PER_PIXEL (24)
+#elif CONFIG_LV_COLOR_DEPTH == 16
+#define LCD_BIT_PER_PIXEL (16)
+#endif
+
+// Define the height of the LVGL drawing buffer
+#define EXAMPLE_LVGL_BUF_HEIGHT (EXAMPLE_LCD_V_RES / 4)
+
+/**
+ * @brief Panel IO callback that hands the draw buffer back to LVGL
+ *
+ * @note  Register it as `on_color_trans_done` with the LVGL display driver as `user_ctx`.
+ */
+bool example_notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx);
+
+/**
+ * @brief Convert a rendered area in place to the pixel format sent to the LCD (RGB888 when LCD_BIT_PER_PIXEL is 24)
+ */
+void example_lvgl_color_pack(const lv_area_t *area, lv_color_t *color_map);
+
+/**
+ * @brief LVGL flush callback, sends a rendered area to the panel stored in `drv->user_data`
+ */
+void example_lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map);
+
+/**
+ * @brief LVGL rounder callback, the SH8601 needs even window start and odd window end coordinates
+ */
+void example_lvgl_rounder_cb(struct _lv_disp_drv_t *disp_drv, lv_area_t *area);
+
+#ifdef __cplusplus
+}
+#endif
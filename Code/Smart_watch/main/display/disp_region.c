@@ -0,0 +1,263 @@
+#include <inttypes.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_log.h"
+
+#include "disp_region.h"
+
+static const char *TAG = "disp_region";
+
+// Displays that can have a planner at the same time
+#define DISP_REGION_MAX_DISPLAYS 2
+
+typedef struct
+{
+    lv_disp_t *disp;
+    lv_timer_cb_t refr_timer_cb;
+    disp_region_config_t cfg;
+    disp_region_stats_t stats;
+} disp_region_t;
+
+static disp_region_t s_regions[DISP_REGION_MAX_DISPLAYS];
+
+static disp_region_t *disp_region_find(lv_disp_t *disp)
+{
+    for (int i = 0; i < DISP_REGION_MAX_DISPLAYS; i++)
+    {
+        if (s_regions[i].disp == disp)
+        {
+            return &s_regions[i];
+        }
+    }
+    return NULL;
+}
+
+static inline uint64_t disp_region_cost(const disp_region_t *region, const lv_area_t *area)
+{
+    return region->cfg.area_cost_ns + (uint64_t)lv_area_get_size(area) * region->cfg.pixel_cost_ns;
+}
+
+static void disp_region_remove(lv_area_t *areas, uint16_t *count, uint16_t idx)
+{
+    memmove(&areas[idx], &areas[idx + 1], (*count - idx - 1) * sizeof(lv_area_t));
+    (*count)--;
+}
+
+// Greedy merge: join the pair whose bounding box is cheapest compared to sending both, until no pair pays off
+static void disp_region_merge(disp_region_t *region, lv_area_t *areas, uint16_t *count)
+{
+    while (*count > 1)
+    {
+        int64_t best_gain = 0;
+        int best_i = -1;
+        int best_j = -1;
+        lv_area_t best_union;
+        for (int i = 0; i < *count; i++)
+        {
+            const uint64_t cost_i = disp_region_cost(region, &areas[i]);
+            for (int j = i + 1; j < *count; j++)
+            {
+                lv_area_t joined;
+                _lv_area_join(&joined, &areas[i], &areas[j]);
+                const int64_t gain = (int64_t)(cost_i + disp_region_cost(region, &areas[j])) -
+                                     (int64_t)disp_region_cost(region, &joined);
+                if (gain > best_gain)
+                {
+                    best_gain = gain;
+                    best_i = i;
+                    best_j = j;
+                    best_union = joined;
+                }
+            }
+        }
+        if (best_i < 0)
+        {
+            break;
+        }
+        areas[best_i] = best_union;
+        disp_region_remove(areas, count, best_j);
+        region->stats.merges++;
+    }
+}
+
+// Cut `b` into the up to four rectangles of `b` outside `a`
+static int disp_region_subtract(const lv_area_t *b, const lv_area_t *a, lv_area_t *pieces)
+{
+    lv_area_t common;
+    if (!_lv_area_intersect(&common, a, b))
+    {
+        return -1;
+    }
+    int n = 0;
+    if (b->y1 < common.y1)
+    {
+        lv_area_set(&pieces[n++], b->x1, b->y1, b->x2, common.y1 - 1);
+    }
+    if (b->y2 > common.y2)
+    {
+        lv_area_set(&pieces[n++], b->x1, common.y2 + 1, b->x2, b->y2);
+    }
+    if (b->x1 < common.x1)
+    {
+        lv_area_set(&pieces[n++], b->x1, common.y1, common.x1 - 1, common.y2);
+    }
+    if (b->x2 > common.x2)
+    {
+        lv_area_set(&pieces[n++], common.x2 + 1, common.y1, b->x2, common.y2);
+    }
+    return n;
+}
+
+// Areas that overlap but were not worth merging send the common pixels twice; cut them out when that is cheaper
+static void disp_region_split(disp_region_t *region, lv_area_t *areas, uint16_t *count)
+{
+    for (int i = 0; i < *count; i++)
+    {
+        for (int j = 0; j < *count; j++)
+        {
+            if (i == j)
+            {
+                continue;
+            }
+            lv_area_t pieces[4];
+            const int n = disp_region_subtract(&areas[j], &areas[i], pieces);
+            if (n < 0 || *count + n - 1 > LV_INV_BUF_SIZE)
+            {
+                continue;
+            }
+            uint64_t cost = 0;
+            for (int k = 0; k < n; k++)
+            {
+                cost += disp_region_cost(region, &pieces[k]);
+            }
+            if (cost >= disp_region_cost(region, &areas[j]))
+            {
+                continue;
+            }
+            // Replace area j by its pieces, j is visited again so the pieces are checked against area i too
+            disp_region_remove(areas, count, j);
+            memcpy(&areas[*count], pieces, n * sizeof(lv_area_t));
+            *count += n;
+            region->stats.splits++;
+            if (j < i)
+            {
+                i--;
+            }
+            j = -1;
+        }
+    }
+}
+
+void disp_region_plan(lv_disp_t *disp)
+{
+    disp_region_t *region = disp_region_find(disp);
+    if (!region || disp->inv_p == 0)
+    {
+        return;
+    }
+
+    // Layout changes invalidate areas too, let them in before planning (LVGL repeats this cheaply)
+    if (disp->act_scr)
+    {
+        lv_obj_update_layout(disp->act_scr);
+    }
+    if (disp->prev_scr)
+    {
+        lv_obj_update_layout(disp->prev_scr);
+    }
+    lv_obj_update_layout(disp->top_layer);
+    lv_obj_update_layout(disp->sys_layer);
+
+    lv_area_t areas[LV_INV_BUF_SIZE];
+    uint16_t count = 0;
+    for (uint16_t i = 0; i < disp->inv_p; i++)
+    {
+        if (!disp->inv_area_joined[i])
+        {
+            areas[count++] = disp->inv_areas[i];
+            region->stats.px_in += lv_area_get_size(&disp->inv_areas[i]);
+        }
+    }
+    const uint16_t count_in = count;
+
+    disp_region_merge(region, areas, &count);
+    disp_region_split(region, areas, &count);
+
+    memcpy(disp->inv_areas, areas, count * sizeof(lv_area_t));
+    memset(disp->inv_area_joined, 0, sizeof(disp->inv_area_joined));
+    disp->inv_p = count;
+
+    region->stats.frames++;
+    region->stats.areas_in += count_in;
+    region->stats.areas_out += count;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        region->stats.px_out += lv_area_get_size(&areas[i]);
+    }
+    if (count < count_in)
+    {
+        region->stats.trans_saved += (count_in - count) * DISP_REGION_TRANS_PER_AREA;
+    }
+}
+
+// Refresh timer wrapper: plan, then let LVGL refresh as usual
+static void disp_region_refr_timer_cb(lv_timer_t *timer)
+{
+    lv_disp_t *disp = (lv_disp_t *)timer->user_data;
+    disp_region_t *region = disp_region_find(disp);
+    disp_region_plan(disp);
+    region->refr_timer_cb(timer);
+}
+
+esp_err_t disp_region_attach(lv_disp_t *disp, const disp_region_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(disp && disp->refr_timer, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    disp_region_t *region = disp_region_find(disp);
+    if (!region)
+    {
+        region = disp_region_find(NULL);
+    }
+    ESP_RETURN_ON_FALSE(region, ESP_ERR_NO_MEM, TAG, "too many displays");
+
+    // Attached again: the refresh timer already calls the wrapper, which still needs LVGL's callback
+    void (*refr_timer_cb)(lv_timer_t *) = region->refr_timer_cb;
+    memset(region, 0, sizeof(*region));
+    region->disp = disp;
+    region->refr_timer_cb = refr_timer_cb;
+    if (config)
+    {
+        region->cfg = *config;
+    }
+    if (region->cfg.area_cost_ns == 0)
+    {
+        region->cfg.area_cost_ns = DISP_REGION_DEFAULT_AREA_COST_NS;
+    }
+    if (region->cfg.pixel_cost_ns == 0)
+    {
+        region->cfg.pixel_cost_ns = DISP_REGION_DEFAULT_PIXEL_COST_NS;
+    }
+    if (disp->refr_timer->timer_cb != disp_region_refr_timer_cb)
+    {
+        region->refr_timer_cb = disp->refr_timer->timer_cb;
+        disp->refr_timer->timer_cb = disp_region_refr_timer_cb;
+    }
+    ESP_LOGI(TAG, "planner on, %" PRIu32 " ns per area, %" PRIu32 " ns per pixel", region->cfg.area_cost_ns,
+             region->cfg.pixel_cost_ns);
+    return ESP_OK;
+}
+
+void disp_region_get_stats(lv_disp_t *disp, disp_region_stats_t *stats, bool reset)
+{
+    disp_region_t *region = disp_region_find(disp);
+    if (!region)
+    {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    *stats = region->stats;
+    if (reset)
+    {
+        memset(&region->stats, 0, sizeof(region->stats));
+    }
+}
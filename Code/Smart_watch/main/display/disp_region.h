@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Cost of one flushed area on top of its pixels: CASET + RASET + RAMWR preamble (~30 us) and LVGL redrawing
+// every object that intersects the area, which dominates for nested widgets such as the arcs of ui_Screen1
+#define DISP_REGION_DEFAULT_AREA_COST_NS 300000
+// Cost of one pixel: 16 bits over four QSPI lines at 40 MHz (100 ns) plus rendering it
+#define DISP_REGION_DEFAULT_PIXEL_COST_NS 150
+// SPI transactions every area costs before its pixels: CASET, RASET and the RAMWR that carries the first pixels
+#define DISP_REGION_TRANS_PER_AREA 3
+
+/**
+ * @brief Region planner cost model, in nanoseconds
+ */
+typedef struct {
+    uint32_t area_cost_ns;      /*!< Fixed cost of flushing one area, 0 selects DISP_REGION_DEFAULT_AREA_COST_NS */
+    uint32_t pixel_cost_ns;     /*!< Cost of rendering and sending one pixel, 0 selects DISP_REGION_DEFAULT_PIXEL_COST_NS */
+} disp_region_config_t;
+
+/**
+ * @brief Region planner counters since the last reset
+ */
+typedef struct {
+    uint32_t frames;            /*!< Frames with at least one invalid area */
+    uint32_t areas_in;          /*!< Invalid areas reported by LVGL */
+    uint32_t areas_out;         /*!< Areas left after planning */
+    uint32_t merges;            /*!< Pairs merged into their bounding box */
+    uint32_t splits;            /*!< Areas cut to remove pixels another area already covers */
+    uint64_t px_in;             /*!< Pixels of the invalid areas, overlaps counted twice */
+    uint64_t px_out;            /*!< Pixels of the planned areas */
+    uint32_t trans_saved;       /*!< SPI preamble transactions saved, DISP_REGION_TRANS_PER_AREA per area removed */
+} disp_region_stats_t;
+
+/**
+ * @brief Plan the invalid areas of every refresh of `disp`
+ *
+ * Wraps the refresh timer of the display, so the planner runs right before LVGL renders. Call after
+ * `lv_disp_drv_register`. Attaching a display again replaces its cost model and clears its counters.
+ *
+ * @param[in] disp   Display
+ * @param[in] config Cost model, NULL for the defaults
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Bad argument
+ *      - ESP_ERR_NO_MEM: Too many displays
+ */
+esp_err_t disp_region_attach(lv_disp_t *disp, const disp_region_config_t *config);
+
+/**
+ * @brief Merge and split the invalid areas of `disp` now, e.g. before `lv_refr_now`, which bypasses the refresh timer
+ */
+void disp_region_plan(lv_disp_t *disp);
+
+/**
+ * @brief Get the planner counters of `disp` and optionally clear them
+ */
+void disp_region_get_stats(lv_disp_t *disp, disp_region_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
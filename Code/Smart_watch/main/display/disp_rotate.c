@@ -0,0 +1,248 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "pixel_conv.h"
+
+#include "disp_port.h"
+#include "disp_rotate.h"
+
+static const char *TAG = "disp_rotate";
+
+// Displays that can be rotated at the same time
+#define DISP_ROTATE_MAX_DISPLAYS 2
+// Bands are whole row pairs, so the SH8601 window start stays even and its end odd
+#define DISP_ROTATE_ROWS_ALIGN 2
+
+struct disp_rotate_t
+{
+    disp_rotate_config_t cfg;
+    lv_disp_drv_t *drv;
+    void (*flush_cb)(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map);
+    uint16_t *bounce[2];
+    uint8_t bounce_idx;
+    disp_rotate_stats_t stats;
+};
+
+// `drv->user_data` keeps the panel handle for the other display callbacks, so the stage is looked up by driver
+static struct
+{
+    lv_disp_drv_t *drv;
+    disp_rotate_handle_t rotate;
+} s_attached[DISP_ROTATE_MAX_DISPLAYS];
+
+static disp_rotate_handle_t disp_rotate_from_drv(lv_disp_drv_t *drv)
+{
+    for (int i = 0; i < DISP_ROTATE_MAX_DISPLAYS; i++)
+    {
+        if (s_attached[i].drv == drv)
+        {
+            return s_attached[i].rotate;
+        }
+    }
+    return NULL;
+}
+
+void disp_rotate_point(const lv_disp_drv_t *drv, lv_coord_t x, lv_coord_t y, lv_coord_t *px, lv_coord_t *py)
+{
+    // Inverse of indev_pointer_proc: 180 mirrors both axes, 90 and 270 also swap them
+    switch (drv->rotated)
+    {
+    case LV_DISP_ROT_90:
+        *px = y;
+        *py = drv->ver_res - 1 - x;
+        break;
+    case LV_DISP_ROT_180:
+        *px = drv->hor_res - 1 - x;
+        *py = drv->ver_res - 1 - y;
+        break;
+    case LV_DISP_ROT_270:
+        *px = drv->hor_res - 1 - y;
+        *py = x;
+        break;
+    default:
+        *px = x;
+        *py = y;
+        break;
+    }
+}
+
+void disp_rotate_touch_point(const lv_disp_drv_t *drv, lv_coord_t px, lv_coord_t py, lv_coord_t *x, lv_coord_t *y)
+{
+    // As indev_pointer_proc: 180 and 270 mirror both axes, 90 and 270 then swap them
+    switch (drv->rotated)
+    {
+    case LV_DISP_ROT_90:
+        *x = drv->ver_res - 1 - py;
+        *y = px;
+        break;
+    case LV_DISP_ROT_180:
+        *x = drv->hor_res - 1 - px;
+        *y = drv->ver_res - 1 - py;
+        break;
+    case LV_DISP_ROT_270:
+        *x = py;
+        *y = drv->hor_res - 1 - px;
+        break;
+    default:
+        *x = px;
+        *y = py;
+        break;
+    }
+}
+
+static void disp_rotate_lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    disp_rotate_handle_t rotate = disp_rotate_from_drv(drv);
+    if (drv->rotated == LV_DISP_ROT_NONE)
+    {
+        rotate->flush_cb(drv, area, color_map);
+        return;
+    }
+    if (rotate->cfg.engine)
+    {
+        // Right after a rotation change the engine may still be sending the last unrotated frame
+        disp_flush_wait_idle(rotate->cfg.engine, portMAX_DELAY);
+    }
+    example_lvgl_color_pack(area, color_map);
+
+    // Opposite corners of the area on the panel; the rounder made the logical ones even/odd, and with an even
+    // resolution they stay so after mirroring
+    lv_coord_t ax, ay, bx, by;
+    disp_rotate_point(drv, area->x1, area->y1, &ax, &ay);
+    disp_rotate_point(drv, area->x2, area->y2, &bx, &by);
+    const int px1 = LV_MIN(ax, bx);
+    const int px2 = LV_MAX(ax, bx);
+    const int py1 = LV_MIN(ay, by);
+    const int py2 = LV_MAX(ay, by);
+
+    const int lw = lv_area_get_width(area);
+    const int lh = lv_area_get_height(area);
+    const int pw = px2 - px1 + 1;
+    const int ph = py2 - py1 + 1;
+    int band_rows = (int)(rotate->cfg.bounce_bytes / sizeof(uint16_t)) / pw;
+    band_rows -= band_rows % DISP_ROTATE_ROWS_ALIGN;
+    const pixel_conv_rotation_t rot = (pixel_conv_rotation_t)drv->rotated;
+    const uint16_t *src = (const uint16_t *)color_map;
+
+    for (int r = 0; r < ph; r += band_rows)
+    {
+        const int n = LV_MIN(band_rows, ph - r);
+        // Panel rows r .. r + n - 1 come from logical columns (90/270) or rows (180) of the area
+        const uint16_t *block;
+        int bw, bh;
+        switch (drv->rotated)
+        {
+        case LV_DISP_ROT_90:
+            block = src + (lw - r - n);
+            bw = n;
+            bh = lh;
+            break;
+        case LV_DISP_ROT_270:
+            block = src + r;
+            bw = n;
+            bh = lh;
+            break;
+        default:
+            block = src + (size_t)(lh - r - n) * lw;
+            bw = lw;
+            bh = n;
+            break;
+        }
+
+        // Two bounce buffers: draw_bitmap returns once the band before the previous one left the bus (the
+        // CASET of a new window waits for the color transfer in flight), so this one is free to overwrite
+        uint16_t *dst = rotate->bounce[rotate->bounce_idx];
+        rotate->bounce_idx ^= 1;
+        const int64_t t0 = esp_timer_get_time();
+        pixel_conv_rotate_rgb565(dst, block, lw, bw, bh, rot);
+        const int64_t t1 = esp_timer_get_time();
+        esp_err_t ret = esp_lcd_panel_draw_bitmap(rotate->cfg.panel, px1, py1 + r, px2 + 1, py1 + r + n, dst);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "draw bitmap failed: %s", esp_err_to_name(ret));
+        }
+        rotate->stats.rotate_us += t1 - t0;
+        rotate->stats.send_us += esp_timer_get_time() - t1;
+        rotate->stats.bands++;
+    }
+    rotate->stats.areas++;
+    rotate->stats.pixels += (uint32_t)(lw * lh);
+
+    // Everything is in the bounce buffers, LVGL can draw into this buffer again
+    lv_disp_flush_ready(drv);
+}
+
+esp_err_t disp_rotate_new(const disp_rotate_config_t *config, disp_rotate_handle_t *ret_rotate)
+{
+    esp_err_t ret = ESP_OK;
+    disp_rotate_handle_t rotate = NULL;
+    ESP_RETURN_ON_FALSE(config && ret_rotate && config->panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    rotate = calloc(1, sizeof(struct disp_rotate_t));
+    ESP_RETURN_ON_FALSE(rotate, ESP_ERR_NO_MEM, TAG, "no mem for rotation stage");
+    rotate->cfg = *config;
+    if (rotate->cfg.bounce_bytes == 0)
+    {
+        rotate->cfg.bounce_bytes = DISP_ROTATE_DEFAULT_BOUNCE_BYTES;
+    }
+
+    // The panel DMA reads internal RAM
+    for (int i = 0; i < 2; i++)
+    {
+        rotate->bounce[i] = heap_caps_malloc(rotate->cfg.bounce_bytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        ESP_GOTO_ON_FALSE(rotate->bounce[i], ESP_ERR_NO_MEM, err, TAG, "no mem for bounce buffer");
+    }
+
+    *ret_rotate = rotate;
+    return ESP_OK;
+
+err:
+    heap_caps_free(rotate->bounce[0]);
+    heap_caps_free(rotate->bounce[1]);
+    free(rotate);
+    return ret;
+}
+
+esp_err_t disp_rotate_attach(disp_rotate_handle_t rotate, lv_disp_drv_t *drv)
+{
+    ESP_RETURN_ON_FALSE(rotate && drv && drv->flush_cb, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(LCD_BIT_PER_PIXEL == 16, ESP_ERR_NOT_SUPPORTED, TAG, "only 16-bit colors are rotated");
+    ESP_RETURN_ON_FALSE(!drv->direct_mode && !drv->sw_rotate, ESP_ERR_INVALID_ARG, TAG,
+                        "not for direct mode or LVGL software rotation");
+    const size_t row_bytes = (size_t)LV_MAX(drv->hor_res, drv->ver_res) * sizeof(uint16_t);
+    ESP_RETURN_ON_FALSE(rotate->cfg.bounce_bytes >= DISP_ROTATE_ROWS_ALIGN * row_bytes, ESP_ERR_INVALID_ARG, TAG,
+                        "bounce buffer smaller than a row pair");
+    int slot = -1;
+    for (int i = DISP_ROTATE_MAX_DISPLAYS - 1; i >= 0; i--)
+    {
+        if (s_attached[i].drv == drv || (slot < 0 && s_attached[i].drv == NULL))
+        {
+            slot = i;
+        }
+    }
+    ESP_RETURN_ON_FALSE(slot >= 0, ESP_ERR_NO_MEM, TAG, "too many displays");
+
+    s_attached[slot].drv = drv;
+    s_attached[slot].rotate = rotate;
+    rotate->drv = drv;
+    if (drv->flush_cb != disp_rotate_lvgl_flush_cb)
+    {
+        rotate->flush_cb = drv->flush_cb;
+        drv->flush_cb = disp_rotate_lvgl_flush_cb;
+    }
+    return ESP_OK;
+}
+
+void disp_rotate_get_stats(disp_rotate_handle_t rotate, disp_rotate_stats_t *stats, bool reset)
+{
+    *stats = rotate->stats;
+    if (reset)
+    {
+        memset(&rotate->stats, 0, sizeof(rotate->stats));
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_lcd_panel_ops.h"
+#include "lvgl.h"
+
+#include "disp_flush.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default size of each of the two internal DMA bounce buffers the rotated bands are sent from
+#define DISP_ROTATE_DEFAULT_BOUNCE_BYTES (16 * 1024)
+
+typedef struct disp_rotate_t *disp_rotate_handle_t;
+
+/**
+ * @brief Rotation stage configuration
+ */
+typedef struct {
+    esp_lcd_panel_handle_t panel;   /*!< Panel the rotated areas are drawn to */
+    size_t bounce_bytes;            /*!< Size of each bounce buffer, 0 selects DISP_ROTATE_DEFAULT_BOUNCE_BYTES */
+    disp_flush_handle_t engine;     /*!< Flush engine of the unrotated frames, drained before a rotated area (may be NULL) */
+} disp_rotate_config_t;
+
+/**
+ * @brief Rotation stage counters since the last reset
+ */
+typedef struct {
+    uint32_t areas;             /*!< Rotated areas */
+    uint32_t bands;             /*!< Bands sent from the bounce buffers */
+    uint64_t pixels;            /*!< Rotated pixels */
+    uint64_t rotate_us;         /*!< Time spent in the rotation kernel */
+    uint64_t send_us;           /*!< Time spent in `esp_lcd_panel_draw_bitmap`, i.e. waiting for the previous band */
+} disp_rotate_stats_t;
+
+/**
+ * @brief Create a rotation stage and its bounce buffers
+ *
+ * @param[in]  config     Configuration
+ * @param[out] ret_rotate Handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Bad configuration
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t disp_rotate_new(const disp_rotate_config_t *config, disp_rotate_handle_t *ret_rotate);
+
+/**
+ * @brief Rotate the areas of an LVGL driver in software when `drv->rotated` is set
+ *
+ * The SH8601 can neither swap its axes nor mirror Y, so `lv_disp_set_rotation` is carried out here: every
+ * area is turned band by band into one bounce buffer while the other one is on the bus, and drawn at the
+ * panel coordinates LVGL's touch transform expects, so touch points need no extra remapping. Unrotated areas
+ * go to the `flush_cb` installed before. Call after `disp_flush_attach`, if used, and before
+ * `lv_disp_drv_register`. 16-bit colors only; not for direct mode drivers.
+ */
+esp_err_t disp_rotate_attach(disp_rotate_handle_t rotate, lv_disp_drv_t *drv);
+
+/**
+ * @brief Map a point of the rotated LVGL screen to panel coordinates, the inverse of LVGL's touch transform
+ *
+ * @param[in]  drv Driver, its `hor_res`, `ver_res` and `rotated`
+ * @param[in]  x   Logical X
+ * @param[in]  y   Logical Y
+ * @param[out] px  Panel X
+ * @param[out] py  Panel Y
+ */
+void disp_rotate_point(const lv_disp_drv_t *drv, lv_coord_t x, lv_coord_t y, lv_coord_t *px, lv_coord_t *py);
+
+/**
+ * @brief Map a touch point in panel coordinates to the rotated LVGL screen, LVGL's touch transform
+ *
+ * For consumers of the raw touch samples, e.g. disp_gesture, which LVGL's input device processing does not reach.
+ *
+ * @param[in]  drv Driver, its `hor_res`, `ver_res` and `rotated`
+ * @param[in]  px  Panel X
+ * @param[in]  py  Panel Y
+ * @param[out] x   Logical X
+ * @param[out] y   Logical Y
+ */
+void disp_rotate_touch_point(const lv_disp_drv_t *drv, lv_coord_t px, lv_coord_t py, lv_coord_t *x, lv_coord_t *y);
+
+/**
+ * @brief Get the rotation counters and optionally clear them
+ */
+void disp_rotate_get_stats(disp_rotate_handle_t rotate, disp_rotate_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,240 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "disp_screens.h"
+
+static const char *TAG = "disp_screens";
+
+typedef struct
+{
+    lv_obj_t **var;                 // SquareLine screen variable
+    lv_obj_t *scr;                  // screen accounted, NULL when not built
+    uint32_t last_shown;            // LRU stamp, 0 when never shown
+    disp_screens_screen_t s;
+} disp_screens_entry_t;
+
+struct disp_screens_t
+{
+    disp_screens_config_t cfg;
+    lv_timer_t *evict_timer;        // runs the eviction once the load that triggered it is over
+    uint32_t clock;                 // LRU clock, bumped on every load
+    size_t resident_bytes;
+    size_t max_resident_bytes;
+    size_t count;
+    disp_screens_entry_t entries[DISP_SCREENS_MAX];
+};
+
+// Heap malloc draws from, LVGL allocates with it (CONFIG_LV_MEM_CUSTOM)
+static size_t disp_screens_heap_free(void)
+{
+    return heap_caps_get_free_size(MALLOC_CAP_INTERNAL) + heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+}
+
+static disp_screens_entry_t *disp_screens_find(disp_screens_handle_t screens, lv_obj_t *scr)
+{
+    for (size_t i = 0; i < screens->count; i++)
+    {
+        if (screens->entries[i].scr == scr)
+        {
+            return &screens->entries[i];
+        }
+    }
+    return NULL;
+}
+
+// Stop accounting the screen of `entry`, it is being deleted
+static void disp_screens_forget(disp_screens_handle_t screens, disp_screens_entry_t *entry)
+{
+    screens->resident_bytes -= entry->s.heap_bytes;
+    if (*entry->var == entry->scr)
+    {
+        *entry->var = NULL;
+    }
+    entry->scr = NULL;
+    entry->s.built = false;
+}
+
+// Delete the least recently shown screens until the built ones fit in the budget
+static void disp_screens_evict(disp_screens_handle_t screens, lv_disp_t *disp)
+{
+    while (screens->resident_bytes > screens->cfg.budget_bytes)
+    {
+        disp_screens_entry_t *lru = NULL;
+        for (size_t i = 0; i < screens->count; i++)
+        {
+            disp_screens_entry_t *entry = &screens->entries[i];
+            // Neither the screen shown, nor one that takes part in a load animation, nor the last one to start
+            // loading (a transition may show it later)
+            if (entry->scr == NULL || entry->scr == disp->act_scr || entry->scr == disp->prev_scr ||
+                entry->scr == disp->scr_to_load || entry->last_shown == screens->clock)
+            {
+                continue;
+            }
+            if (lru == NULL || entry->last_shown < lru->last_shown)
+            {
+                lru = entry;
+            }
+        }
+        if (lru == NULL)
+        {
+            return;
+        }
+        ESP_LOGD(TAG, "deleting %s, %u bytes", lru->s.name, (unsigned)lru->s.heap_bytes);
+        lv_obj_t *scr = lru->scr;
+        lru->s.evictions++;
+        disp_screens_forget(screens, lru);
+        lv_obj_del(scr);
+    }
+}
+
+static void disp_screens_evict_timer_cb(lv_timer_t *timer)
+{
+    disp_screens_handle_t screens = (disp_screens_handle_t)timer->user_data;
+    lv_timer_pause(timer);
+    disp_screens_evict(screens, lv_disp_get_default());
+}
+
+static void disp_screens_event_cb(lv_event_t *e)
+{
+    disp_screens_handle_t screens = (disp_screens_handle_t)lv_event_get_user_data(e);
+    lv_obj_t *scr = lv_event_get_target(e);
+    disp_screens_entry_t *entry = disp_screens_find(screens, scr);
+    if (entry == NULL)
+    {
+        // A screen the manager deleted already
+        return;
+    }
+    if (lv_event_get_code(e) == LV_EVENT_DELETE)
+    {
+        // Deleted by someone else, e.g. _ui_screen_delete
+        disp_screens_forget(screens, entry);
+        return;
+    }
+    entry->last_shown = ++screens->clock;
+    if (lv_event_get_code(e) == LV_EVENT_SCREEN_LOAD_START)
+    {
+        return;
+    }
+    entry->s.loads++;
+    // LVGL still sends LV_EVENT_SCREEN_UNLOADED to the old screen and ends the animation after this event, the
+    // old screen can only go once that is done
+    lv_timer_resume(screens->evict_timer);
+}
+
+// Account the screen of `entry` built now, `heap_bytes` is what it took
+static void disp_screens_track(disp_screens_handle_t screens, disp_screens_entry_t *entry, size_t heap_bytes)
+{
+    entry->scr = *entry->var;
+    entry->s.built = true;
+    entry->s.heap_bytes = heap_bytes;
+    screens->resident_bytes += heap_bytes;
+    if (screens->resident_bytes > screens->max_resident_bytes)
+    {
+        screens->max_resident_bytes = screens->resident_bytes;
+    }
+    lv_obj_add_event_cb(entry->scr, disp_screens_event_cb, LV_EVENT_SCREEN_LOAD_START, screens);
+    lv_obj_add_event_cb(entry->scr, disp_screens_event_cb, LV_EVENT_SCREEN_LOADED, screens);
+    lv_obj_add_event_cb(entry->scr, disp_screens_event_cb, LV_EVENT_DELETE, screens);
+}
+
+esp_err_t disp_screens_new(const disp_screens_config_t *config, disp_screens_handle_t *ret_screens)
+{
+    ESP_RETURN_ON_FALSE(config && ret_screens, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    disp_screens_handle_t screens = calloc(1, sizeof(struct disp_screens_t));
+    ESP_RETURN_ON_FALSE(screens, ESP_ERR_NO_MEM, TAG, "no mem for screen manager");
+    screens->cfg = *config;
+    if (screens->cfg.budget_bytes == 0)
+    {
+        screens->cfg.budget_bytes = DISP_SCREENS_DEFAULT_BUDGET;
+    }
+    screens->evict_timer = lv_timer_create(disp_screens_evict_timer_cb, 0, screens);
+    if (screens->evict_timer == NULL)
+    {
+        free(screens);
+        ESP_LOGE(TAG, "no mem for eviction timer");
+        return ESP_ERR_NO_MEM;
+    }
+    lv_timer_pause(screens->evict_timer);
+    *ret_screens = screens;
+    return ESP_OK;
+}
+
+esp_err_t disp_screens_add(disp_screens_handle_t screens, const char *name, lv_obj_t **scr)
+{
+    ESP_RETURN_ON_FALSE(screens && name && scr, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    for (size_t i = 0; i < screens->count; i++)
+    {
+        ESP_RETURN_ON_FALSE(screens->entries[i].var != scr, ESP_ERR_INVALID_ARG, TAG, "%s added twice", name);
+    }
+    ESP_RETURN_ON_FALSE(screens->count < DISP_SCREENS_MAX, ESP_ERR_NO_MEM, TAG, "too many screens");
+    disp_screens_entry_t *entry = &screens->entries[screens->count++];
+    entry->var = scr;
+    entry->s.name = name;
+    if (*scr)
+    {
+        disp_screens_track(screens, entry, 0);
+    }
+    return ESP_OK;
+}
+
+void disp_screens_build(lv_obj_t **scr, void (*init)(void), void *user_ctx)
+{
+    disp_screens_handle_t screens = (disp_screens_handle_t)user_ctx;
+    disp_screens_entry_t *entry = NULL;
+    for (size_t i = 0; i < screens->count && entry == NULL; i++)
+    {
+        entry = screens->entries[i].var == scr ? &screens->entries[i] : NULL;
+    }
+    if (entry == NULL)
+    {
+        init();
+        return;
+    }
+
+    // Other tasks allocate meanwhile too, the size is close but not exact
+    const size_t free_before = disp_screens_heap_free();
+    const int64_t t0 = esp_timer_get_time();
+    init();
+    const uint32_t build_us = (uint32_t)(esp_timer_get_time() - t0);
+    const size_t free_after = disp_screens_heap_free();
+
+    entry->s.builds++;
+    entry->s.build_us = build_us;
+    entry->s.max_build_us = build_us > entry->s.max_build_us ? build_us : entry->s.max_build_us;
+    disp_screens_track(screens, entry, free_before > free_after ? free_before - free_after : 0);
+    ESP_LOGD(TAG, "built %s in %u us, %u bytes", entry->s.name, (unsigned)build_us, (unsigned)entry->s.heap_bytes);
+    if (screens->cfg.on_build)
+    {
+        screens->cfg.on_build(entry->scr, entry->s.name, screens->cfg.user_ctx);
+    }
+}
+
+void disp_screens_get_stats(disp_screens_handle_t screens, disp_screens_stats_t *stats, bool reset)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->budget_bytes = screens->cfg.budget_bytes;
+    stats->resident_bytes = screens->resident_bytes;
+    stats->max_resident_bytes = screens->max_resident_bytes;
+    stats->count = screens->count;
+    for (size_t i = 0; i < screens->count; i++)
+    {
+        disp_screens_screen_t *s = &screens->entries[i].s;
+        stats->screens[i] = *s;
+        if (reset)
+        {
+            s->builds = 0;
+            s->evictions = 0;
+            s->loads = 0;
+            s->max_build_us = 0;
+        }
+    }
+    if (reset)
+    {
+        screens->max_resident_bytes = screens->resident_bytes;
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default heap the built screens may keep, the watch face and two or three of the other SquareLine screens
+#define DISP_SCREENS_DEFAULT_BUDGET (16 * 1024)
+// Most screens managed
+#define DISP_SCREENS_MAX 8
+
+typedef struct disp_screens_t *disp_screens_handle_t;
+
+/**
+ * @brief Called once a screen is built, e.g. to name it in the frame trace or give it a buffer strategy
+ */
+typedef void (*disp_screens_build_cb_t)(lv_obj_t *scr, const char *name, void *user_ctx);
+
+/**
+ * @brief Screen manager configuration
+ */
+typedef struct {
+    size_t budget_bytes;            /*!< Heap the built screens may keep, beyond it the least recently shown ones are
+                                         deleted once a screen load is over; the screen on display is always kept. 0 selects
+                                         DISP_SCREENS_DEFAULT_BUDGET, SIZE_MAX never deletes */
+    disp_screens_build_cb_t on_build; /*!< Called after every build, NULL if unused */
+    void *user_ctx;                 /*!< Passed to on_build */
+} disp_screens_config_t;
+
+/**
+ * @brief One screen since the last reset; `built`, `heap_bytes` and `build_us` are kept across resets
+ */
+typedef struct {
+    const char *name;               /*!< Name given to disp_screens_add */
+    bool built;                     /*!< The screen exists */
+    uint32_t builds;                /*!< Times it was built, the first one included */
+    uint32_t evictions;             /*!< Times it was deleted to stay within the budget */
+    uint32_t loads;                 /*!< Times it was shown */
+    uint32_t build_us;              /*!< Duration of the last build */
+    uint32_t max_build_us;          /*!< Longest build */
+    size_t heap_bytes;              /*!< Heap taken by the last build */
+} disp_screens_screen_t;
+
+/**
+ * @brief Screen manager counters since the last reset
+ */
+typedef struct {
+    size_t budget_bytes;            /*!< Configured budget */
+    size_t resident_bytes;          /*!< Heap of the screens built now */
+    size_t max_resident_bytes;      /*!< Highest resident_bytes */
+    size_t count;                   /*!< Entries in `screens` */
+    disp_screens_screen_t screens[DISP_SCREENS_MAX]; /*!< In the order they were added */
+} disp_screens_stats_t;
+
+/**
+ * @brief Create the screen manager
+ *
+ * @param[in]  config      Configuration
+ * @param[out] ret_screens Handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Bad configuration
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t disp_screens_new(const disp_screens_config_t *config, disp_screens_handle_t *ret_screens);
+
+/**
+ * @brief Manage the screen kept in `*scr`, a SquareLine screen variable
+ *
+ * A screen built already is accounted from now on, with an unknown heap size.
+ *
+ * @param name Name for the stats, must stay valid
+ * @param scr  Screen variable, set by the init function of the screen and cleared when the manager deletes it
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NO_MEM: DISP_SCREENS_MAX screens managed already
+ */
+esp_err_t disp_screens_add(disp_screens_handle_t screens, const char *name, lv_obj_t **scr);
+
+/**
+ * @brief Build a screen, timing it and measuring the heap it takes; with the LVGL lock held
+ *
+ * Has the signature of the SquareLine build hook, pass it to _ui_screen_set_build_cb with the handle as
+ * user data. Screens not managed are built without accounting.
+ *
+ * @param scr       Screen variable
+ * @param init      Init function of the screen
+ * @param user_ctx  The disp_screens_handle_t
+ */
+void disp_screens_build(lv_obj_t **scr, void (*init)(void), void *user_ctx);
+
+/**
+ * @brief Get the counters and optionally clear them, with the LVGL lock held
+ */
+void disp_screens_get_stats(disp_screens_handle_t screens, disp_screens_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
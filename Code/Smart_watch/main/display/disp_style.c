@@ -0,0 +1,409 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "disp_style.h"
+
+static const char *TAG = "disp_style";
+
+// Most properties of its own a local style may keep and still share the rest
+#define DISP_STYLE_OWN_MAX 4
+
+struct disp_style_t
+{
+    disp_style_config_t cfg;
+    size_t count;                   // shared styles in the table
+    lv_style_t **styles;            // shared styles, local styles taken over or copies of their properties
+    uint32_t *hashes;               // property set hash of each shared style
+    size_t screen_count;
+    disp_style_screen_t screens[DISP_STYLE_MAX_SCREENS];
+};
+
+// Counters of one share
+typedef struct
+{
+    uint32_t objects;
+    uint32_t local_styles;
+    uint32_t reused;
+    uint32_t added;
+    uint32_t kept;
+} disp_style_walk_t;
+
+// Properties lv_obj, lv_label, lv_img and lv_arc read while drawing the SquareLine widgets
+static const lv_style_prop_t disp_style_probe_props[] = {
+    LV_STYLE_BG_COLOR, LV_STYLE_BG_OPA, LV_STYLE_BG_IMG_SRC, LV_STYLE_RADIUS, LV_STYLE_BORDER_WIDTH,
+    LV_STYLE_OUTLINE_WIDTH, LV_STYLE_SHADOW_WIDTH, LV_STYLE_PAD_TOP, LV_STYLE_OPA, LV_STYLE_TEXT_COLOR,
+    LV_STYLE_TEXT_OPA, LV_STYLE_TEXT_FONT, LV_STYLE_IMG_OPA, LV_STYLE_IMG_RECOLOR_OPA, LV_STYLE_ARC_COLOR,
+    LV_STYLE_ARC_WIDTH,
+};
+static const lv_part_t disp_style_probe_parts[] = {LV_PART_MAIN, LV_PART_INDICATOR, LV_PART_KNOB};
+
+// Heap malloc draws from, LVGL allocates with it (CONFIG_LV_MEM_CUSTOM)
+static size_t disp_style_heap_free(void)
+{
+    return heap_caps_get_free_size(MALLOC_CAP_INTERNAL) + heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+}
+
+// Property `i` of a style with its inherit and initial flags, and its value
+static void disp_style_prop_at(const lv_style_t *style, uint32_t i, lv_style_prop_t *prop, lv_style_value_t *value)
+{
+    if (style->prop_cnt == 1)
+    {
+        *prop = style->prop1;
+        *value = style->v_p.value1;
+        return;
+    }
+    const lv_style_value_t *values = (const lv_style_value_t *)style->v_p.values_and_props;
+    const uint16_t *props = (const uint16_t *)(style->v_p.values_and_props + style->prop_cnt * sizeof(lv_style_value_t));
+    *prop = props[i];
+    *value = values[i];
+}
+
+// Properties left in the local style: the position of each object is its own, shared it would give every object
+// a style of its own. Values with inherit or initial flags stay too, SquareLine sets none
+static bool disp_style_is_own(lv_style_prop_t prop)
+{
+    return (prop & LV_STYLE_PROP_META_MASK) || prop == LV_STYLE_X || prop == LV_STYLE_Y;
+}
+
+// Values are compared as raw bytes: a color leaves the rest of the union as the setter initialized it, which at
+// worst keeps two equal values apart, never merges two different ones
+static uint32_t disp_style_hash(const lv_style_t *style)
+{
+    uint32_t hash = 0;
+    for (uint32_t i = 0; i < style->prop_cnt; i++)
+    {
+        lv_style_prop_t prop;
+        lv_style_value_t value;
+        disp_style_prop_at(style, i, &prop, &value);
+        if (disp_style_is_own(prop))
+        {
+            continue;
+        }
+        // FNV-1a of each property, summed so the order they were set in does not matter
+        uint32_t h = 2166136261u;
+        h = (h ^ prop) * 16777619u;
+        const uint8_t *bytes = (const uint8_t *)&value;
+        for (size_t b = 0; b < sizeof(value); b++)
+        {
+            h = (h ^ bytes[b]) * 16777619u;
+        }
+        hash += h;
+    }
+    return hash;
+}
+
+// Whether `shared` holds exactly the properties of `local` that are not its own
+static bool disp_style_equal(const lv_style_t *shared, const lv_style_t *local, uint32_t shareable)
+{
+    if (shared->prop_cnt != shareable)
+    {
+        return false;
+    }
+    // A style holds a property once
+    for (uint32_t i = 0; i < local->prop_cnt; i++)
+    {
+        lv_style_prop_t prop_l;
+        lv_style_value_t value_l;
+        disp_style_prop_at(local, i, &prop_l, &value_l);
+        if (disp_style_is_own(prop_l))
+        {
+            continue;
+        }
+        bool found = false;
+        for (uint32_t j = 0; j < shared->prop_cnt && !found; j++)
+        {
+            lv_style_prop_t prop_s;
+            lv_style_value_t value_s;
+            disp_style_prop_at(shared, j, &prop_s, &value_s);
+            found = prop_l == prop_s && memcmp(&value_l, &value_s, sizeof(value_l)) == 0;
+        }
+        if (!found)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Shared style with the properties of `local`, NULL if there is none yet
+static lv_style_t *disp_style_find(disp_style_handle_t styles, const lv_style_t *local, uint32_t shareable,
+                                   uint32_t hash)
+{
+    for (size_t i = 0; i < styles->count; i++)
+    {
+        if (styles->hashes[i] == hash && disp_style_equal(styles->styles[i], local, shareable))
+        {
+            return styles->styles[i];
+        }
+    }
+    return NULL;
+}
+
+// New shared style with the properties of `local` that are not its own, NULL when out of memory
+static lv_style_t *disp_style_copy(const lv_style_t *local)
+{
+    lv_style_t *style = lv_mem_alloc(sizeof(lv_style_t));
+    if (style == NULL)
+    {
+        return NULL;
+    }
+    lv_style_init(style);
+    for (uint32_t i = 0; i < local->prop_cnt; i++)
+    {
+        lv_style_prop_t prop;
+        lv_style_value_t value;
+        disp_style_prop_at(local, i, &prop, &value);
+        if (!disp_style_is_own(prop))
+        {
+            lv_style_set_prop(style, prop, value);
+        }
+    }
+    return style;
+}
+
+// Leave in `local` only the properties of its own
+static void disp_style_keep_own(lv_style_t *local)
+{
+    lv_style_prop_t props[DISP_STYLE_OWN_MAX];
+    lv_style_value_t values[DISP_STYLE_OWN_MAX];
+    uint32_t own = 0;
+    for (uint32_t i = 0; i < local->prop_cnt && own < DISP_STYLE_OWN_MAX; i++)
+    {
+        lv_style_prop_t prop;
+        lv_style_value_t value;
+        disp_style_prop_at(local, i, &prop, &value);
+        if (disp_style_is_own(prop))
+        {
+            props[own] = prop;
+            values[own] = value;
+            own++;
+        }
+    }
+    lv_style_reset(local);
+    for (uint32_t i = 0; i < own; i++)
+    {
+        lv_style_set_prop(local, props[i], values[i]);
+    }
+}
+
+static void disp_style_share_obj(disp_style_handle_t styles, lv_obj_t *obj, disp_style_walk_t *walk)
+{
+    walk->objects++;
+    // Transition styles come first, then the local ones, then the normal ones. The shared style is inserted
+    // after the local ones, so `i` moves on to the next local style or past them
+    uint32_t i = 0;
+    while (i < obj->style_cnt)
+    {
+        const _lv_obj_style_t *entry = &obj->styles[i];
+        if (entry->is_trans)
+        {
+            i++;
+            continue;
+        }
+        if (!entry->is_local)
+        {
+            break;
+        }
+        lv_style_t *local = entry->style;
+        const lv_style_selector_t selector = entry->selector;
+        walk->local_styles++;
+        uint32_t own = 0;
+        for (uint32_t p = 0; p < local->prop_cnt; p++)
+        {
+            lv_style_prop_t prop;
+            lv_style_value_t value;
+            disp_style_prop_at(local, p, &prop, &value);
+            own += disp_style_is_own(prop) ? 1 : 0;
+        }
+        // More than fit in disp_style_keep_own stay local as a whole
+        const uint32_t shareable = own <= DISP_STYLE_OWN_MAX ? local->prop_cnt - own : 0;
+        const uint32_t hash = disp_style_hash(local);
+        lv_style_t *shared = shareable ? disp_style_find(styles, local, shareable, hash) : NULL;
+        if (shared == NULL && shareable && styles->count < styles->cfg.max_styles)
+        {
+            if (own == 0)
+            {
+                // Not local any more, so removing it from the object keeps it for the table
+                obj->styles[i].is_local = 0;
+                shared = local;
+            }
+            else
+            {
+                shared = disp_style_copy(local);
+            }
+            if (shared)
+            {
+                styles->styles[styles->count] = shared;
+                styles->hashes[styles->count] = hash;
+                styles->count++;
+                walk->added++;
+            }
+        }
+        else if (shared)
+        {
+            walk->reused++;
+        }
+        if (shared == NULL)
+        {
+            walk->kept++;
+            i++;
+            continue;
+        }
+        if (own)
+        {
+            disp_style_keep_own(local);
+            i++;
+        }
+        else
+        {
+            // Freed unless it just went into the table
+            lv_obj_remove_style(obj, local, selector);
+        }
+        lv_obj_add_style(obj, shared, selector);
+    }
+
+    const uint32_t child_cnt = lv_obj_get_child_cnt(obj);
+    for (uint32_t c = 0; c < child_cnt; c++)
+    {
+        disp_style_share_obj(styles, lv_obj_get_child(obj, c), walk);
+    }
+}
+
+static uint32_t disp_style_lookup_pass(lv_obj_t *obj)
+{
+    static volatile int32_t sink;
+    uint32_t lookups = 0;
+    for (size_t p = 0; p < sizeof(disp_style_probe_parts) / sizeof(disp_style_probe_parts[0]); p++)
+    {
+        for (size_t i = 0; i < sizeof(disp_style_probe_props) / sizeof(disp_style_probe_props[0]); i++)
+        {
+            sink += lv_obj_get_style_prop(obj, disp_style_probe_parts[p], disp_style_probe_props[i]).num;
+            lookups++;
+        }
+    }
+    const uint32_t child_cnt = lv_obj_get_child_cnt(obj);
+    for (uint32_t c = 0; c < child_cnt; c++)
+    {
+        lookups += disp_style_lookup_pass(lv_obj_get_child(obj, c));
+    }
+    return lookups;
+}
+
+static disp_style_screen_t *disp_style_screen(disp_style_handle_t styles, const char *name)
+{
+    for (size_t i = 0; i < styles->screen_count; i++)
+    {
+        if (strcmp(styles->screens[i].name, name) == 0)
+        {
+            return &styles->screens[i];
+        }
+    }
+    if (styles->screen_count == DISP_STYLE_MAX_SCREENS)
+    {
+        return NULL;
+    }
+    disp_style_screen_t *s = &styles->screens[styles->screen_count++];
+    s->name = name;
+    return s;
+}
+
+esp_err_t disp_style_new(const disp_style_config_t *config, disp_style_handle_t *ret_styles)
+{
+    ESP_RETURN_ON_FALSE(config && ret_styles, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    disp_style_handle_t styles = calloc(1, sizeof(struct disp_style_t));
+    ESP_RETURN_ON_FALSE(styles, ESP_ERR_NO_MEM, TAG, "no mem for style table");
+    styles->cfg = *config;
+    if (styles->cfg.max_styles == 0)
+    {
+        styles->cfg.max_styles = DISP_STYLE_DEFAULT_MAX_STYLES;
+    }
+    styles->styles = calloc(styles->cfg.max_styles, sizeof(lv_style_t *));
+    styles->hashes = calloc(styles->cfg.max_styles, sizeof(uint32_t));
+    if (styles->styles == NULL || styles->hashes == NULL)
+    {
+        ESP_LOGE(TAG, "no mem for %u styles", (unsigned)styles->cfg.max_styles);
+        free(styles->styles);
+        free(styles->hashes);
+        free(styles);
+        return ESP_ERR_NO_MEM;
+    }
+    *ret_styles = styles;
+    return ESP_OK;
+}
+
+esp_err_t disp_style_share(disp_style_handle_t styles, lv_obj_t *root, const char *name)
+{
+    ESP_RETURN_ON_FALSE(styles && root, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    disp_style_screen_t *s = name ? disp_style_screen(styles, name) : NULL;
+    uint32_t lookups = 0;
+    uint32_t lookup_us_before = 0;
+    if (styles->cfg.lookup_rounds)
+    {
+        lookup_us_before = disp_style_time_lookups(root, styles->cfg.lookup_rounds, &lookups);
+    }
+
+    // Every property resolves as before, the objects need neither a refresh nor a redraw
+    disp_style_walk_t walk = {0};
+    const size_t free_before = disp_style_heap_free();
+    lv_obj_enable_style_refresh(false);
+    disp_style_share_obj(styles, root, &walk);
+    lv_obj_enable_style_refresh(true);
+    const size_t free_after = disp_style_heap_free();
+    ESP_LOGD(TAG, "%s: %u of %u local styles shared, %d bytes, %u shared styles", name ? name : "-",
+             (unsigned)(walk.reused + walk.added), (unsigned)walk.local_styles, (int)(free_after - free_before),
+             (unsigned)styles->count);
+
+    if (s)
+    {
+        s->shares++;
+        s->objects = walk.objects;
+        s->local_styles = walk.local_styles;
+        s->reused = walk.reused;
+        s->added = walk.added;
+        s->kept = walk.kept;
+        // Other tasks allocate meanwhile too, the size is close but not exact
+        s->saved_bytes = (int32_t)(free_after - free_before);
+        s->lookups = lookups;
+        s->lookup_us_before = lookup_us_before;
+        s->lookup_us_after = styles->cfg.lookup_rounds ?
+                             disp_style_time_lookups(root, styles->cfg.lookup_rounds, NULL) : 0;
+    }
+    return ESP_OK;
+}
+
+uint32_t disp_style_time_lookups(lv_obj_t *root, uint32_t rounds, uint32_t *lookups)
+{
+    uint32_t count = 0;
+    const int64_t t0 = esp_timer_get_time();
+    for (uint32_t r = 0; r < rounds; r++)
+    {
+        count = disp_style_lookup_pass(root);
+    }
+    const uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    if (lookups)
+    {
+        *lookups = count;
+    }
+    return us;
+}
+
+void disp_style_get_stats(disp_style_handle_t styles, disp_style_stats_t *stats, bool reset)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->styles = styles->count;
+    stats->max_styles = styles->cfg.max_styles;
+    stats->count = styles->screen_count;
+    for (size_t i = 0; i < styles->screen_count; i++)
+    {
+        stats->screens[i] = styles->screens[i];
+        if (reset)
+        {
+            styles->screens[i].shares = 0;
+        }
+    }
+}
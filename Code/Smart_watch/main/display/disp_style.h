@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default number of shared styles, the six SquareLine screens need 54
+#define DISP_STYLE_DEFAULT_MAX_STYLES 96
+// Most screens with their own statistics
+#define DISP_STYLE_MAX_SCREENS 8
+
+typedef struct disp_style_t *disp_style_handle_t;
+
+/**
+ * @brief Shared style table configuration
+ */
+typedef struct {
+    size_t max_styles;              /*!< Shared styles the table may hold, local styles found once it is full stay
+                                         local. 0 selects DISP_STYLE_DEFAULT_MAX_STYLES */
+    uint32_t lookup_rounds;         /*!< Passes of lv_obj_get_style_prop over a screen timed before and after its
+                                         styles are shared, 0 times nothing */
+} disp_style_config_t;
+
+/**
+ * @brief One screen; `shares` is since the last reset, the rest describe its last share
+ */
+typedef struct {
+    const char *name;               /*!< Name given to disp_style_share */
+    uint32_t shares;                /*!< Times its styles were shared, once per build */
+    uint32_t objects;               /*!< Objects of the screen */
+    uint32_t local_styles;          /*!< Local styles found */
+    uint32_t reused;                /*!< Of them whose properties were already in the table */
+    uint32_t added;                 /*!< Of them whose properties went into the table, for the next ones to reuse */
+    uint32_t kept;                  /*!< Of them left as they were: nothing but x and y, or the table was full */
+    int32_t saved_bytes;            /*!< Heap given back, net of the styles copied into the table */
+    uint32_t lookups;               /*!< lv_obj_get_style_prop calls of one lookup pass, 0 when not timed */
+    uint32_t lookup_us_before;      /*!< lookup_rounds passes with the local styles */
+    uint32_t lookup_us_after;       /*!< lookup_rounds passes with the shared styles */
+} disp_style_screen_t;
+
+/**
+ * @brief Shared style table counters
+ */
+typedef struct {
+    size_t styles;                  /*!< Shared styles in the table */
+    size_t max_styles;              /*!< Configured size of the table */
+    size_t count;                   /*!< Entries in `screens` */
+    disp_style_screen_t screens[DISP_STYLE_MAX_SCREENS]; /*!< In the order they were first shared */
+} disp_style_stats_t;
+
+/**
+ * @brief Create the table of shared styles
+ *
+ * @param[in]  config     Configuration
+ * @param[out] ret_styles Handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t disp_style_new(const disp_style_config_t *config, disp_style_handle_t *ret_styles);
+
+/**
+ * @brief Swap the local styles of a screen built by SquareLine for shared ones, with the LVGL lock held
+ *
+ * SquareLine sets every property with lv_obj_set_style_*(obj, value, part | state), and the position and size with
+ * lv_obj_set_*, which gives each object one heap-allocated local style per part and state, most of them holding
+ * the same few sizes, alignments, colors, opacities and fonts next to the object's own x and y. The properties of
+ * a local style other than x and y are looked up in the table, and the first local style with a given set of them
+ * puts that set in the table: the style itself when it holds nothing else, a copy otherwise. Every local style
+ * whose set is in the table is then left with its x and y only, or freed when it had none, and the shared style is
+ * added to its object for the same part and state. Styles added that way come before the theme's, so every
+ * property resolves to the same value and nothing needs to be redrawn; an object with its own x and y walks one
+ * more style per lookup. Values set on the objects afterwards go to their local styles, which take precedence, as
+ * they would have.
+ *
+ * Shared styles are never freed, objects of later builds keep using them: a screen built again after the screen
+ * manager deleted it finds all of its sets in the table.
+ *
+ * @param root Screen, or any object, shared with its children
+ * @param name Name for the stats, must stay valid; NULL leaves the screen out of them
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t disp_style_share(disp_style_handle_t styles, lv_obj_t *root, const char *name);
+
+/**
+ * @brief Time `rounds` passes of lv_obj_get_style_prop over `root` and its children, with the LVGL lock held
+ *
+ * Every pass looks up the properties the widgets of the SquareLine screens read while drawing, in their main,
+ * indicator and knob parts.
+ *
+ * @param[out] lookups lv_obj_get_style_prop calls of one pass, may be NULL
+ * @return Duration of all the passes in microseconds
+ */
+uint32_t disp_style_time_lookups(lv_obj_t *root, uint32_t rounds, uint32_t *lookups);
+
+/**
+ * @brief Get the counters and optionally clear them, with the LVGL lock held
+ */
+void disp_style_get_stats(disp_style_handle_t styles, disp_style_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,275 @@
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "disp_te.h"
+
+static const char *TAG = "disp_te";
+
+struct disp_te_t
+{
+    disp_te_config_t cfg;
+    lv_disp_t *disp;
+    lv_timer_cb_t refr_timer_cb;
+    SemaphoreHandle_t edge;         // given on every TE edge
+    esp_timer_handle_t timer;       // DISP_TE_SOURCE_TIMER only
+    portMUX_TYPE lock;              // protects everything below, shared with the edge ISR
+    int64_t edge_us;
+    bool frame_active;              // a refresh was started on the last edge and not yet checked
+    bool frame_rendered;            // that refresh returned to the LVGL task
+    disp_te_stats_t stats;
+};
+
+// Count the edge, and a missed deadline when the previous frame is not on the glass yet
+static void IRAM_ATTR disp_te_edge_locked(disp_te_handle_t te)
+{
+    te->stats.edges++;
+    te->edge_us = esp_timer_get_time();
+    if (te->frame_active)
+    {
+        if (!te->frame_rendered || te->disp->driver->draw_buf->flushing)
+        {
+            te->stats.missed++;
+        }
+        te->frame_active = false;
+    }
+}
+
+static void IRAM_ATTR disp_te_edge_isr(void *arg)
+{
+    disp_te_handle_t te = (disp_te_handle_t)arg;
+    BaseType_t need_yield = pdFALSE;
+    portENTER_CRITICAL_ISR(&te->lock);
+    disp_te_edge_locked(te);
+    portEXIT_CRITICAL_ISR(&te->lock);
+    if (xSemaphoreGiveFromISR(te->edge, &need_yield) != pdTRUE)
+    {
+        // The LVGL task has not taken the previous edge yet
+        portENTER_CRITICAL_ISR(&te->lock);
+        te->stats.dropped_edges++;
+        portEXIT_CRITICAL_ISR(&te->lock);
+    }
+    portYIELD_FROM_ISR(need_yield);
+}
+
+static void disp_te_timer_cb(void *arg)
+{
+    disp_te_handle_t te = (disp_te_handle_t)arg;
+    portENTER_CRITICAL(&te->lock);
+    disp_te_edge_locked(te);
+    portEXIT_CRITICAL(&te->lock);
+    if (xSemaphoreGive(te->edge) != pdTRUE)
+    {
+        portENTER_CRITICAL(&te->lock);
+        te->stats.dropped_edges++;
+        portEXIT_CRITICAL(&te->lock);
+    }
+}
+
+// Refresh timer wrapper: between edges the invalid areas wait for the next one
+static void disp_te_refr_timer_cb(lv_timer_t *timer)
+{
+    lv_timer_pause(timer);
+}
+
+esp_err_t disp_te_new(const disp_te_config_t *config, disp_te_handle_t *ret_te)
+{
+    esp_err_t ret = ESP_OK;
+    disp_te_handle_t te = NULL;
+    ESP_RETURN_ON_FALSE(config && ret_te, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(config->source != DISP_TE_SOURCE_GPIO || config->te_gpio >= 0, ESP_ERR_INVALID_ARG, TAG,
+                        "no TE GPIO");
+
+    te = calloc(1, sizeof(struct disp_te_t));
+    ESP_RETURN_ON_FALSE(te, ESP_ERR_NO_MEM, TAG, "no mem for TE scheduler");
+    te->cfg = *config;
+    if (te->cfg.period_us == 0)
+    {
+        te->cfg.period_us = DISP_TE_DEFAULT_PERIOD_US;
+    }
+    portMUX_INITIALIZE(&te->lock);
+    te->edge = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(te->edge, ESP_ERR_NO_MEM, err, TAG, "no mem for TE semaphore");
+
+    switch (te->cfg.source)
+    {
+    case DISP_TE_SOURCE_GPIO:
+    {
+        const gpio_config_t te_gpio_config = {
+            .pin_bit_mask = 1ULL << te->cfg.te_gpio,
+            .mode = GPIO_MODE_INPUT,
+            .intr_type = GPIO_INTR_POSEDGE,
+        };
+        ESP_GOTO_ON_ERROR(gpio_config(&te_gpio_config), err, TAG, "configure TE GPIO failed");
+        // The service may already be installed by another driver
+        ret = gpio_install_isr_service(0);
+        ESP_GOTO_ON_FALSE(ret == ESP_OK || ret == ESP_ERR_INVALID_STATE, ret, err, TAG, "install GPIO ISR service failed");
+        ESP_GOTO_ON_ERROR(gpio_isr_handler_add(te->cfg.te_gpio, disp_te_edge_isr, te), err, TAG, "add TE ISR failed");
+        break;
+    }
+    case DISP_TE_SOURCE_TIMER:
+    {
+        const esp_timer_create_args_t timer_args = {
+            .callback = disp_te_timer_cb,
+            .arg = te,
+            .name = "disp_te",
+            .skip_unhandled_events = true,
+        };
+        ESP_GOTO_ON_ERROR(esp_timer_create(&timer_args, &te->timer), err, TAG, "create TE timer failed");
+        ESP_GOTO_ON_ERROR(esp_timer_start_periodic(te->timer, te->cfg.period_us), err, TAG, "start TE timer failed");
+        break;
+    }
+    case DISP_TE_SOURCE_EXTERNAL:
+        break;
+    }
+
+    ESP_LOGI(TAG, "TE source %d, period %" PRIu32 " us", te->cfg.source, te->cfg.period_us);
+    *ret_te = te;
+    return ESP_OK;
+
+err:
+    if (te->timer)
+    {
+        esp_timer_delete(te->timer);
+    }
+    if (te->edge)
+    {
+        vSemaphoreDelete(te->edge);
+    }
+    free(te);
+    return ret;
+}
+
+esp_err_t disp_te_attach(disp_te_handle_t te, lv_disp_t *disp)
+{
+    ESP_RETURN_ON_FALSE(te && disp && disp->refr_timer, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    portENTER_CRITICAL(&te->lock);
+    te->disp = disp;
+    portEXIT_CRITICAL(&te->lock);
+    if (disp->refr_timer->timer_cb != disp_te_refr_timer_cb)
+    {
+        te->refr_timer_cb = disp->refr_timer->timer_cb;
+        disp->refr_timer->timer_cb = disp_te_refr_timer_cb;
+    }
+    // The timer only pauses itself now; its period still sets the FPS limit of the performance monitor
+    lv_timer_set_period(disp->refr_timer, te->cfg.period_us / 1000);
+    return ESP_OK;
+}
+
+bool disp_te_wait(disp_te_handle_t te, uint32_t timeout_ms)
+{
+    const TickType_t timeout = timeout_ms == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    return xSemaphoreTake(te->edge, timeout) == pdTRUE;
+}
+
+void disp_te_refresh(disp_te_handle_t te)
+{
+    lv_disp_t *disp = te->disp;
+
+    // Layout changes invalidate areas too, let them in before deciding (LVGL repeats this cheaply)
+    if (disp->act_scr)
+    {
+        lv_obj_update_layout(disp->act_scr);
+    }
+    if (disp->prev_scr)
+    {
+        lv_obj_update_layout(disp->prev_scr);
+    }
+    lv_obj_update_layout(disp->top_layer);
+    lv_obj_update_layout(disp->sys_layer);
+
+    const int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&te->lock);
+    if (disp->inv_p == 0)
+    {
+        te->stats.idle_edges++;
+        portEXIT_CRITICAL(&te->lock);
+        return;
+    }
+    const uint32_t delay_us = (uint32_t)(now - te->edge_us);
+    te->stats.frames++;
+    te->stats.start_delay_us += delay_us;
+    if (delay_us > te->stats.max_start_delay_us)
+    {
+        te->stats.max_start_delay_us = delay_us;
+    }
+    te->frame_active = true;
+    te->frame_rendered = false;
+    portEXIT_CRITICAL(&te->lock);
+
+    te->refr_timer_cb(disp->refr_timer);
+
+    portENTER_CRITICAL(&te->lock);
+    te->frame_rendered = true;
+    portEXIT_CRITICAL(&te->lock);
+}
+
+bool disp_te_frame_pending(disp_te_handle_t te)
+{
+    // Invalidating and marking the layout dirty both resume the refresh timer, which pauses itself once it ran
+    const lv_disp_t *disp = te->disp;
+    return disp->inv_p > 0 || !disp->refr_timer->paused;
+}
+
+void disp_te_notify_edge(disp_te_handle_t te)
+{
+    disp_te_edge_isr(te);
+}
+
+esp_err_t disp_te_set_enabled(disp_te_handle_t te, bool enabled)
+{
+    ESP_RETURN_ON_FALSE(te, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    esp_err_t ret = ESP_OK;
+    switch (te->cfg.source)
+    {
+    case DISP_TE_SOURCE_GPIO:
+        ret = enabled ? gpio_intr_enable(te->cfg.te_gpio) : gpio_intr_disable(te->cfg.te_gpio);
+        break;
+    case DISP_TE_SOURCE_TIMER:
+        if (enabled)
+        {
+            ret = esp_timer_start_periodic(te->timer, te->cfg.period_us);
+        }
+        else
+        {
+            ret = esp_timer_stop(te->timer);
+        }
+        // Starting a running or stopping a stopped timer is not an error here
+        if (ret == ESP_ERR_INVALID_STATE)
+        {
+            ret = ESP_OK;
+        }
+        break;
+    case DISP_TE_SOURCE_EXTERNAL:
+        break;
+    }
+    ESP_RETURN_ON_ERROR(ret, TAG, "switch TE source failed");
+    if (enabled)
+    {
+        // The last edge before the stop is long gone, the next refresh waits for a fresh one
+        xSemaphoreTake(te->edge, 0);
+        portENTER_CRITICAL(&te->lock);
+        te->frame_active = false;
+        portEXIT_CRITICAL(&te->lock);
+    }
+    return ESP_OK;
+}
+
+void disp_te_get_stats(disp_te_handle_t te, disp_te_stats_t *stats, bool reset)
+{
+    portENTER_CRITICAL(&te->lock);
+    *stats = te->stats;
+    if (reset)
+    {
+        memset(&te->stats, 0, sizeof(te->stats));
+    }
+    portEXIT_CRITICAL(&te->lock);
+}
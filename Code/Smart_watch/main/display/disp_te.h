@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SH8601 refresh period at its default 60 Hz frame rate, used by the timer source
+#define DISP_TE_DEFAULT_PERIOD_US 16667
+
+typedef struct disp_te_t *disp_te_handle_t;
+
+/**
+ * @brief Source of the tearing-effect edges
+ */
+typedef enum {
+    DISP_TE_SOURCE_GPIO,        /*!< Rising edge of the panel TE output on `te_gpio` */
+    DISP_TE_SOURCE_TIMER,       /*!< esp_timer every `period_us`: a frame pacer, not TE sync. Not in phase with
+                                     the panel scan, so frames may still tear, every update waits up to one period,
+                                     and `missed` only counts frames longer than a period; for tests without a panel */
+    DISP_TE_SOURCE_EXTERNAL,    /*!< Edges are fed with `disp_te_notify_edge`, e.g. by a simulated panel */
+} disp_te_source_t;
+
+/**
+ * @brief TE scheduler configuration
+ */
+typedef struct {
+    disp_te_source_t source;    /*!< Where the edges come from */
+    int te_gpio;                /*!< GPIO wired to the panel TE pad, for DISP_TE_SOURCE_GPIO */
+    uint32_t period_us;         /*!< Refresh period for DISP_TE_SOURCE_TIMER, 0 selects DISP_TE_DEFAULT_PERIOD_US */
+} disp_te_config_t;
+
+/**
+ * @brief TE scheduler counters since the last reset
+ */
+typedef struct {
+    uint32_t edges;             /*!< TE edges */
+    uint32_t frames;            /*!< Refreshes started on an edge */
+    uint32_t idle_edges;        /*!< Edges picked up with nothing to redraw */
+    uint32_t dropped_edges;     /*!< Edges that came before the LVGL task picked up the previous one */
+    uint32_t missed;            /*!< Frames still rendering or transferring at the next edge, i.e. that may tear */
+    uint64_t start_delay_us;    /*!< Sum over the frames of the delay from the edge to the refresh start */
+    uint32_t max_start_delay_us;    /*!< Longest delay from an edge to the refresh start */
+} disp_te_stats_t;
+
+/**
+ * @brief Create a TE scheduler and start its edge source
+ *
+ * @param[in]  config Configuration
+ * @param[out] ret_te Handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Bad configuration
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t disp_te_new(const disp_te_config_t *config, disp_te_handle_t *ret_te);
+
+/**
+ * @brief Refresh `disp` only on TE edges
+ *
+ * Wraps the refresh timer of the display so `lv_timer_handler` no longer refreshes on its own; refreshes are
+ * started by `disp_te_refresh`. Call after `lv_disp_drv_register` and after `disp_region_attach`, if used.
+ */
+esp_err_t disp_te_attach(disp_te_handle_t te, lv_disp_t *disp);
+
+/**
+ * @brief Block until the next TE edge or `timeout_ms` (UINT32_MAX: no timeout), call without the LVGL lock
+ *
+ * @return true on an edge, then call `disp_te_refresh` with the LVGL lock held
+ */
+bool disp_te_wait(disp_te_handle_t te, uint32_t timeout_ms);
+
+/**
+ * @brief Refresh the display right after an edge, so the RAMWR stream follows the scan line instead of crossing it
+ *
+ * Does nothing when there is nothing to redraw. Call with the LVGL lock held.
+ */
+void disp_te_refresh(disp_te_handle_t te);
+
+/**
+ * @brief Whether the next edge has something to refresh: invalidated areas, or a layout change that may add some
+ *
+ * When not, the edge source can be stopped until LVGL invalidates again. Call with the LVGL lock held.
+ */
+bool disp_te_frame_pending(disp_te_handle_t te);
+
+/**
+ * @brief Report a TE edge, for DISP_TE_SOURCE_EXTERNAL; safe from an ISR
+ */
+void disp_te_notify_edge(disp_te_handle_t te);
+
+/**
+ * @brief Stop or restart the edge source, e.g. while the panel is in partial mode and nothing is refreshed at 60 Hz
+ *
+ * Stopped, neither the TE interrupt nor the timer wakes the CPU; an edge left pending is dropped on restart.
+ */
+esp_err_t disp_te_set_enabled(disp_te_handle_t te, bool enabled);
+
+/**
+ * @brief Get the scheduler counters and optionally clear them
+ */
+void disp_te_get_stats(disp_te_handle_t te, disp_te_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,273 @@
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "disp_touch.h"
+
+static const char *TAG = "disp_touch";
+
+// One touch report as LVGL will see it
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+    bool pressed;
+    int64_t t_us;       // INT edge that announced it, or the read when no edge did
+} disp_touch_sample_t;
+
+struct disp_touch_t
+{
+    disp_touch_config_t cfg;
+    TaskHandle_t task;
+    QueueHandle_t samples;
+    lv_indev_t *indev;
+    disp_touch_sample_t shown;      // what LVGL was given last, LVGL task only
+    portMUX_TYPE lock;              // protects everything below, shared with the INT ISR
+    bool down;                      // the last read had a point
+    uint16_t last_x;
+    uint16_t last_y;
+    int64_t edge_us;                // first edge since the last read, 0 when none
+    bool discarding;                // drop reads until the finger is lifted
+    disp_touch_stats_t stats;
+};
+
+static void IRAM_ATTR disp_touch_isr(esp_lcd_touch_handle_t tp)
+{
+    disp_touch_handle_t touch = (disp_touch_handle_t)tp->config.user_data;
+    BaseType_t need_yield = pdFALSE;
+    // Masked until the reader task has read the report: on a low-level interrupt, e.g. armed as the light sleep
+    // wakeup source, it would fire again for as long as the controller holds INT low
+    gpio_intr_disable(tp->config.int_gpio_num);
+    portENTER_CRITICAL_ISR(&touch->lock);
+    touch->stats.edges++;
+    if (touch->edge_us == 0)
+    {
+        touch->edge_us = esp_timer_get_time();
+    }
+    portEXIT_CRITICAL_ISR(&touch->lock);
+    vTaskNotifyGiveFromISR(touch->task, &need_yield);
+    if (touch->cfg.on_edge)
+    {
+        touch->cfg.on_edge(touch->cfg.user_ctx);
+    }
+    portYIELD_FROM_ISR(need_yield);
+}
+
+// Queue a sample for LVGL; when LVGL is behind, the oldest sample goes so the newest position is never lost
+static void disp_touch_post(disp_touch_handle_t touch, const disp_touch_sample_t *sample)
+{
+    if (xQueueSend(touch->samples, sample, 0) != pdTRUE)
+    {
+        disp_touch_sample_t oldest;
+        xQueueReceive(touch->samples, &oldest, 0);
+        xQueueSend(touch->samples, sample, 0);
+        portENTER_CRITICAL(&touch->lock);
+        touch->stats.dropped++;
+        portEXIT_CRITICAL(&touch->lock);
+    }
+    portENTER_CRITICAL(&touch->lock);
+    touch->stats.samples++;
+    portEXIT_CRITICAL(&touch->lock);
+    if (touch->cfg.on_sample)
+    {
+        touch->cfg.on_sample(touch->cfg.user_ctx);
+    }
+}
+
+// Reader task: the controller is read once per INT edge, and only while touched also after the lift timeout
+static void disp_touch_task(void *arg)
+{
+    disp_touch_handle_t touch = (disp_touch_handle_t)arg;
+    esp_lcd_touch_handle_t tp = touch->cfg.tp;
+    ESP_LOGI(TAG, "Starting touch task");
+    while (1)
+    {
+        const TickType_t wait = touch->down ? pdMS_TO_TICKS(touch->cfg.lift_timeout_ms) : portMAX_DELAY;
+        const bool edge = ulTaskNotifyTake(pdTRUE, wait) > 0;
+
+        uint16_t x = 0;
+        uint16_t y = 0;
+        uint8_t cnt = 0;
+        const int64_t t0 = esp_timer_get_time();
+        esp_lcd_touch_read_data(tp);
+        const bool pressed = esp_lcd_touch_get_coordinates(tp, &x, &y, NULL, &cnt, 1) && cnt > 0;
+        const int64_t t1 = esp_timer_get_time();
+        // The read released INT
+        gpio_intr_enable(tp->config.int_gpio_num);
+
+        portENTER_CRITICAL(&touch->lock);
+        touch->stats.reads++;
+        touch->stats.lift_timeouts += !edge;
+        touch->stats.read_us += t1 - t0;
+        const int64_t edge_us = touch->edge_us ? touch->edge_us : t0;
+        touch->edge_us = 0;
+        // Edges without news: a release while nothing is down, or the finger resting on the same point
+        const bool news = pressed ? (!touch->down || x != touch->last_x || y != touch->last_y) : touch->down;
+        const bool discard = touch->discarding;
+        if (!pressed)
+        {
+            touch->discarding = false;
+        }
+        touch->down = pressed;
+        if (pressed)
+        {
+            touch->last_x = x;
+            touch->last_y = y;
+        }
+        portEXIT_CRITICAL(&touch->lock);
+
+        if (!news || discard)
+        {
+            continue;
+        }
+        const disp_touch_sample_t sample = {
+            .x = touch->last_x,
+            .y = touch->last_y,
+            .pressed = pressed,
+            .t_us = edge_us,
+        };
+        disp_touch_post(touch, &sample);
+    }
+}
+
+// LVGL read callback: hand over the queued samples, all of them in this read pass
+static void disp_touch_lvgl_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    disp_touch_handle_t touch = (disp_touch_handle_t)drv->user_data;
+    disp_touch_sample_t sample;
+    const bool got = xQueueReceive(touch->samples, &sample, 0) == pdTRUE;
+    const int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&touch->lock);
+    touch->stats.lvgl_polls++;
+    if (got)
+    {
+        const uint32_t latency_us = (uint32_t)(now - sample.t_us);
+        touch->stats.delivered++;
+        touch->stats.latency_us += latency_us;
+        if (latency_us > touch->stats.max_latency_us)
+        {
+            touch->stats.max_latency_us = latency_us;
+        }
+    }
+    portEXIT_CRITICAL(&touch->lock);
+
+    if (got)
+    {
+        touch->shown = sample;
+        if (touch->cfg.on_read)
+        {
+            touch->cfg.on_read(sample.x, sample.y, sample.pressed, sample.t_us, touch->cfg.user_ctx);
+        }
+    }
+    data->point.x = touch->shown.x;
+    data->point.y = touch->shown.y;
+    data->state = touch->shown.pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+    data->continue_reading = uxQueueMessagesWaiting(touch->samples) > 0;
+
+    // Nothing left to read: stop polling once the finger is up and a scroll throw (which needs reads) has ended
+    if (!touch->shown.pressed && !data->continue_reading && touch->indev->proc.types.pointer.scroll_obj == NULL)
+    {
+        lv_timer_pause(drv->read_timer);
+    }
+}
+
+esp_err_t disp_touch_new(const disp_touch_config_t *config, disp_touch_handle_t *ret_touch)
+{
+    esp_err_t ret = ESP_OK;
+    disp_touch_handle_t touch = NULL;
+    ESP_RETURN_ON_FALSE(config && ret_touch && config->tp, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(config->tp->config.int_gpio_num != GPIO_NUM_NC, ESP_ERR_INVALID_ARG, TAG, "no touch INT GPIO");
+
+    touch = calloc(1, sizeof(struct disp_touch_t));
+    ESP_RETURN_ON_FALSE(touch, ESP_ERR_NO_MEM, TAG, "no mem for touch path");
+    touch->cfg = *config;
+    if (touch->cfg.queue_depth == 0)
+    {
+        touch->cfg.queue_depth = DISP_TOUCH_DEFAULT_QUEUE_DEPTH;
+    }
+    if (touch->cfg.lift_timeout_ms == 0)
+    {
+        touch->cfg.lift_timeout_ms = DISP_TOUCH_DEFAULT_LIFT_TIMEOUT_MS;
+    }
+    if (touch->cfg.task_stack == 0)
+    {
+        touch->cfg.task_stack = 3 * 1024;
+    }
+    portMUX_INITIALIZE(&touch->lock);
+
+    touch->samples = xQueueCreate(touch->cfg.queue_depth, sizeof(disp_touch_sample_t));
+    ESP_GOTO_ON_FALSE(touch->samples, ESP_ERR_NO_MEM, err, TAG, "no mem for touch queue");
+    BaseType_t res = xTaskCreatePinnedToCore(disp_touch_task, "disp_touch", touch->cfg.task_stack, touch,
+                                             touch->cfg.task_priority, &touch->task, touch->cfg.task_core);
+    ESP_GOTO_ON_FALSE(res == pdPASS, ESP_ERR_NO_MEM, err, TAG, "create touch task failed");
+    ESP_GOTO_ON_ERROR(esp_lcd_touch_register_interrupt_callback_with_data(touch->cfg.tp, disp_touch_isr, touch), err,
+                      TAG, "register touch ISR failed");
+
+    ESP_LOGI(TAG, "Touch INT on GPIO %d, queue %u", touch->cfg.tp->config.int_gpio_num, (unsigned)touch->cfg.queue_depth);
+    *ret_touch = touch;
+    return ESP_OK;
+
+err:
+    if (touch->task)
+    {
+        vTaskDelete(touch->task);
+    }
+    if (touch->samples)
+    {
+        vQueueDelete(touch->samples);
+    }
+    free(touch);
+    return ret;
+}
+
+esp_err_t disp_touch_attach(disp_touch_handle_t touch, lv_indev_t *indev)
+{
+    ESP_RETURN_ON_FALSE(touch && indev && indev->driver->type == LV_INDEV_TYPE_POINTER, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid argument");
+    touch->indev = indev;
+    indev->driver->read_cb = disp_touch_lvgl_read_cb;
+    indev->driver->user_data = touch;
+    // Idle until the first sample arrives
+    lv_timer_pause(indev->driver->read_timer);
+    return ESP_OK;
+}
+
+void disp_touch_process(disp_touch_handle_t touch)
+{
+    if (touch->indev && uxQueueMessagesWaiting(touch->samples) > 0)
+    {
+        lv_timer_t *read_timer = touch->indev->driver->read_timer;
+        lv_timer_resume(read_timer);
+        lv_timer_ready(read_timer);
+    }
+}
+
+void disp_touch_discard(disp_touch_handle_t touch)
+{
+    portENTER_CRITICAL(&touch->lock);
+    touch->discarding = touch->down;
+    portEXIT_CRITICAL(&touch->lock);
+    xQueueReset(touch->samples);
+    touch->shown.pressed = false;
+}
+
+void disp_touch_get_stats(disp_touch_handle_t touch, disp_touch_stats_t *stats, bool reset)
+{
+    portENTER_CRITICAL(&touch->lock);
+    *stats = touch->stats;
+    if (reset)
+    {
+        memset(&touch->stats, 0, sizeof(touch->stats));
+    }
+    portEXIT_CRITICAL(&touch->lock);
+}
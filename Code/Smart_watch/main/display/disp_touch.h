@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "esp_lcd_touch.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default number of samples waiting for LVGL, about 200 ms of reports
+#define DISP_TOUCH_DEFAULT_QUEUE_DEPTH 16
+// Default time without INT while touched before the controller is read anyway, four FT5x06 active scan periods
+// (ID_G_PERIODACTIVE, 12 ms as set by its driver)
+#define DISP_TOUCH_DEFAULT_LIFT_TIMEOUT_MS 48
+
+typedef struct disp_touch_t *disp_touch_handle_t;
+
+/**
+ * @brief Notification from the touch path
+ */
+typedef void (*disp_touch_cb_t)(void *user_ctx);
+
+/**
+ * @brief A sample handed to LVGL, with the time of the INT edge (or read) that announced it
+ */
+typedef void (*disp_touch_read_cb_t)(uint16_t x, uint16_t y, bool pressed, int64_t t_us, void *user_ctx);
+
+/**
+ * @brief Event-mode touch configuration
+ */
+typedef struct {
+    esp_lcd_touch_handle_t tp;      /*!< Touch controller, with `int_gpio_num` wired */
+    size_t queue_depth;             /*!< Sample queue length, 0 selects DISP_TOUCH_DEFAULT_QUEUE_DEPTH */
+    uint32_t lift_timeout_ms;       /*!< Read again after this long without INT while touched, so a missed lift
+                                         report does not leave the finger down; 0 selects
+                                         DISP_TOUCH_DEFAULT_LIFT_TIMEOUT_MS */
+    uint32_t task_stack;            /*!< Reader task stack size in bytes, 0 selects 3 KB */
+    UBaseType_t task_priority;      /*!< Reader task priority, above the LVGL task keeps the latency low */
+    BaseType_t task_core;           /*!< Reader task core, or tskNO_AFFINITY */
+    disp_touch_cb_t on_edge;        /*!< Called from the INT interrupt, e.g. to wake the watch up (may be NULL) */
+    disp_touch_cb_t on_sample;      /*!< Called from the reader task after a sample is queued, e.g. to wake the
+                                         LVGL task (may be NULL) */
+    disp_touch_read_cb_t on_read;   /*!< Called from the LVGL read callback with every sample LVGL gets, e.g. to
+                                         feed a gesture recognizer the real sample times (may be NULL) */
+    void *user_ctx;                 /*!< Passed to `on_edge`, `on_sample` and `on_read` */
+} disp_touch_config_t;
+
+/**
+ * @brief Touch path counters since the last reset
+ */
+typedef struct {
+    uint32_t edges;             /*!< INT edges */
+    uint32_t reads;             /*!< Controller reads (`esp_lcd_touch_read_data`) */
+    uint32_t lift_timeouts;     /*!< Reads forced by `lift_timeout_ms` */
+    uint64_t read_us;           /*!< Time spent in the reads, mostly I2C */
+    uint32_t samples;           /*!< Samples queued */
+    uint32_t dropped;           /*!< Oldest samples dropped because LVGL did not keep up */
+    uint32_t delivered;         /*!< Samples read by LVGL */
+    uint64_t latency_us;        /*!< Sum over the delivered samples of INT edge (or read) to LVGL read */
+    uint32_t max_latency_us;    /*!< Longest of those */
+    uint32_t lvgl_polls;        /*!< LVGL indev reads, the read timer is paused while nothing is touched */
+} disp_touch_stats_t;
+
+/**
+ * @brief Create the event-mode touch path: INT interrupt, reader task and sample queue
+ *
+ * Takes over the interrupt callback of `tp`. Nothing is read from the controller until an INT edge. The interrupt
+ * is masked from the edge until the reader task has read the report, so INT may also interrupt on its low level.
+ *
+ * @param[in]  config    Configuration
+ * @param[out] ret_touch Handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Bad configuration, or INT not wired
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t disp_touch_new(const disp_touch_config_t *config, disp_touch_handle_t *ret_touch);
+
+/**
+ * @brief Feed an LVGL pointer input device from the sample queue
+ *
+ * Sets the `read_cb` and `user_data` of the driver. Call after `lv_indev_drv_register`, with the LVGL lock held.
+ */
+esp_err_t disp_touch_attach(disp_touch_handle_t touch, lv_indev_t *indev);
+
+/**
+ * @brief Resume the LVGL read timer when samples are waiting, call from the LVGL task before `lv_timer_handler`
+ *
+ * The read timer pauses itself once the finger is up and scrolling has stopped, so an idle watch neither
+ * polls the controller nor wakes up for LVGL input reads.
+ */
+void disp_touch_process(disp_touch_handle_t touch);
+
+/**
+ * @brief Drop the queued samples and the rest of the current touch, e.g. the touch that woke the watch up
+ */
+void disp_touch_discard(disp_touch_handle_t touch);
+
+/**
+ * @brief Get the touch path counters and optionally clear them
+ */
+void disp_touch_get_stats(disp_touch_handle_t touch, disp_touch_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,372 @@
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "disp_trace.h"
+
+static const char *TAG = "disp_trace";
+
+// Displays that can be traced at the same time
+#define DISP_TRACE_MAX_DISPLAYS 2
+// Longest dump line: 11 numbers and a screen name
+#define DISP_TRACE_LINE_BYTES 160
+
+// One ring entry; `seq` is the record index + 1 once the record is complete, 0 while it is written
+typedef struct
+{
+    _Atomic uint32_t seq;
+    disp_trace_record_t rec;
+} disp_trace_slot_t;
+
+struct disp_trace_t
+{
+    disp_trace_config_t cfg;
+    disp_trace_slot_t *slots;
+    uint32_t mask;
+    _Atomic uint32_t head;      // next record index, only the LVGL task writes records
+    uint32_t tail;              // next record to dump, owned by the dumping task
+    _Atomic uint32_t dumped;
+    _Atomic uint32_t lost;
+    lv_disp_drv_t *drv;
+    void (*flush_cb)(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map);
+    void (*wait_cb)(lv_disp_drv_t *drv);
+    void (*render_start_cb)(lv_disp_drv_t *drv);
+    void (*monitor_cb)(lv_disp_drv_t *drv, uint32_t time, uint32_t px);
+    // Below: the frame being drawn, LVGL task only
+    int64_t frame_start_us;
+    int64_t pass_start_us;
+    bool in_pass;
+    bool pending;               // a frame ended in the current pass and waits for the pass time
+    disp_trace_record_t frame;
+    disp_trace_record_t pending_frame;
+    disp_img_handle_t img;
+    disp_img_stats_t img_start;     // image counters when the frame started
+    struct
+    {
+        lv_obj_t *scr;
+        const char *name;
+    } screens[DISP_TRACE_MAX_SCREENS];
+};
+
+// `drv->user_data` keeps the panel handle for the other display callbacks, so the trace is looked up by driver
+static struct
+{
+    lv_disp_drv_t *drv;
+    disp_trace_handle_t trace;
+} s_attached[DISP_TRACE_MAX_DISPLAYS];
+
+static disp_trace_handle_t disp_trace_from_drv(lv_disp_drv_t *drv)
+{
+    for (int i = 0; i < DISP_TRACE_MAX_DISPLAYS; i++)
+    {
+        if (s_attached[i].drv == drv)
+        {
+            return s_attached[i].trace;
+        }
+    }
+    return NULL;
+}
+
+// Single writer: the slot is marked busy, filled, then published with its index so a reader racing with
+// the write sees a mismatch instead of a torn record
+static void disp_trace_push(disp_trace_handle_t trace, disp_trace_record_t *rec)
+{
+    const uint32_t idx = atomic_load_explicit(&trace->head, memory_order_relaxed);
+    disp_trace_slot_t *slot = &trace->slots[idx & trace->mask];
+    rec->seq = idx;
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->rec = *rec;
+    atomic_store_explicit(&slot->seq, idx + 1, memory_order_release);
+    atomic_store_explicit(&trace->head, idx + 1, memory_order_release);
+}
+
+static uint8_t disp_trace_screen_index(disp_trace_handle_t trace)
+{
+    lv_disp_t *disp = _lv_refr_get_disp_refreshing();
+    if (disp == NULL || disp->act_scr == NULL)
+    {
+        return DISP_TRACE_SCREEN_NONE;
+    }
+    for (int i = 0; i < DISP_TRACE_MAX_SCREENS; i++)
+    {
+        if (trace->screens[i].scr == disp->act_scr)
+        {
+            return i + 1;
+        }
+    }
+    return DISP_TRACE_SCREEN_NONE;
+}
+
+static void disp_trace_lvgl_render_start_cb(lv_disp_drv_t *drv)
+{
+    disp_trace_handle_t trace = disp_trace_from_drv(drv);
+    trace->frame_start_us = esp_timer_get_time();
+    memset(&trace->frame, 0, sizeof(trace->frame));
+    trace->frame.t_ms = (uint32_t)(trace->frame_start_us / 1000);
+    trace->frame.screen = disp_trace_screen_index(trace);
+    if (trace->img)
+    {
+        disp_img_get_stats(trace->img, &trace->img_start, false);
+    }
+    if (trace->render_start_cb)
+    {
+        trace->render_start_cb(drv);
+    }
+}
+
+static void disp_trace_lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    disp_trace_handle_t trace = disp_trace_from_drv(drv);
+    const int64_t t0 = esp_timer_get_time();
+    trace->frame.areas++;
+    trace->frame.bytes += lv_area_get_size(area) * sizeof(lv_color_t);
+    trace->flush_cb(drv, area, color_map);
+    trace->frame.flush_us += (uint32_t)(esp_timer_get_time() - t0);
+}
+
+static void disp_trace_lvgl_wait_cb(lv_disp_drv_t *drv)
+{
+    disp_trace_handle_t trace = disp_trace_from_drv(drv);
+    const int64_t t0 = esp_timer_get_time();
+    if (trace->wait_cb)
+    {
+        trace->wait_cb(drv);
+    }
+    else
+    {
+        // LVGL would spin on `flushing` without a wait_cb too, spinning here keeps the whole wait measured
+        while (drv->draw_buf->flushing)
+        {
+        }
+    }
+    trace->frame.flush_us += (uint32_t)(esp_timer_get_time() - t0);
+}
+
+static void disp_trace_lvgl_monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    disp_trace_handle_t trace = disp_trace_from_drv(drv);
+    if (trace->monitor_cb)
+    {
+        trace->monitor_cb(drv, time, px);
+    }
+    const int64_t refresh_us = esp_timer_get_time() - trace->frame_start_us;
+    trace->frame.render_us = refresh_us > trace->frame.flush_us ? (uint32_t)(refresh_us - trace->frame.flush_us) : 0;
+    if (trace->img)
+    {
+        disp_img_stats_t st;
+        disp_img_get_stats(trace->img, &st, false);
+        // Counters only grow within a frame, the decoder's stats are reset between frames
+        trace->frame.img_hits = (uint16_t)(st.hits - trace->img_start.hits);
+        trace->frame.img_misses = (uint16_t)(st.misses - trace->img_start.misses);
+        trace->frame.img_bytes = (uint32_t)(st.decoded_bytes - trace->img_start.decoded_bytes);
+    }
+    if (trace->pending)
+    {
+        // A second refresh in the same pass, e.g. lv_refr_now from a timer: the first one keeps no pass time
+        disp_trace_push(trace, &trace->pending_frame);
+    }
+    if (trace->in_pass)
+    {
+        trace->pending_frame = trace->frame;
+        trace->pending = true;
+    }
+    else
+    {
+        disp_trace_push(trace, &trace->frame);
+    }
+}
+
+esp_err_t disp_trace_new(const disp_trace_config_t *config, disp_trace_handle_t *ret_trace)
+{
+    disp_trace_handle_t trace = NULL;
+    ESP_RETURN_ON_FALSE(config && ret_trace, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    trace = calloc(1, sizeof(struct disp_trace_t));
+    ESP_RETURN_ON_FALSE(trace, ESP_ERR_NO_MEM, TAG, "no mem for frame trace");
+    trace->cfg = *config;
+    if (trace->cfg.records == 0)
+    {
+        trace->cfg.records = DISP_TRACE_DEFAULT_RECORDS;
+    }
+    size_t records = 1;
+    while (records < trace->cfg.records)
+    {
+        records <<= 1;
+    }
+    trace->cfg.records = records;
+    trace->mask = records - 1;
+
+    // Only the LVGL task and the dump touch the ring, a few cycles more per frame in PSRAM do not matter
+    trace->slots = heap_caps_calloc(records, sizeof(disp_trace_slot_t), MALLOC_CAP_SPIRAM);
+    if (trace->slots == NULL)
+    {
+        trace->slots = heap_caps_calloc(records, sizeof(disp_trace_slot_t), MALLOC_CAP_DEFAULT);
+    }
+    if (trace->slots == NULL)
+    {
+        free(trace);
+        ESP_LOGE(TAG, "no mem for %u trace records", (unsigned)records);
+        return ESP_ERR_NO_MEM;
+    }
+
+    *ret_trace = trace;
+    return ESP_OK;
+}
+
+esp_err_t disp_trace_attach(disp_trace_handle_t trace, lv_disp_drv_t *drv)
+{
+    ESP_RETURN_ON_FALSE(trace && drv && drv->flush_cb, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    int slot = -1;
+    for (int i = DISP_TRACE_MAX_DISPLAYS - 1; i >= 0; i--)
+    {
+        if (s_attached[i].drv == drv || (slot < 0 && s_attached[i].drv == NULL))
+        {
+            slot = i;
+        }
+    }
+    ESP_RETURN_ON_FALSE(slot >= 0, ESP_ERR_NO_MEM, TAG, "too many displays");
+
+    s_attached[slot].drv = drv;
+    s_attached[slot].trace = trace;
+    trace->drv = drv;
+    if (drv->flush_cb != disp_trace_lvgl_flush_cb)
+    {
+        trace->flush_cb = drv->flush_cb;
+        trace->wait_cb = drv->wait_cb;
+        trace->render_start_cb = drv->render_start_cb;
+        trace->monitor_cb = drv->monitor_cb;
+        drv->flush_cb = disp_trace_lvgl_flush_cb;
+        drv->wait_cb = disp_trace_lvgl_wait_cb;
+        drv->render_start_cb = disp_trace_lvgl_render_start_cb;
+        drv->monitor_cb = disp_trace_lvgl_monitor_cb;
+    }
+    return ESP_OK;
+}
+
+// A deleted screen keeps its name and index, the next screen given that name takes them over
+static void disp_trace_screen_delete_cb(lv_event_t *e)
+{
+    disp_trace_handle_t trace = (disp_trace_handle_t)lv_event_get_user_data(e);
+    lv_obj_t *scr = lv_event_get_target(e);
+    for (int i = 0; i < DISP_TRACE_MAX_SCREENS; i++)
+    {
+        if (trace->screens[i].scr == scr)
+        {
+            trace->screens[i].scr = NULL;
+        }
+    }
+}
+
+esp_err_t disp_trace_set_screen_name(disp_trace_handle_t trace, lv_obj_t *scr, const char *name)
+{
+    ESP_RETURN_ON_FALSE(trace && scr && name, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    int slot = -1;
+    for (int i = DISP_TRACE_MAX_SCREENS - 1; i >= 0; i--)
+    {
+        if (trace->screens[i].scr == scr)
+        {
+            trace->screens[i].name = name;
+            return ESP_OK;
+        }
+        // A screen rebuilt under the same name keeps its index, so the dump still tells one screen
+        if ((trace->screens[i].scr == NULL && trace->screens[i].name && strcmp(trace->screens[i].name, name) == 0) ||
+            (trace->screens[i].name == NULL && (slot < 0 || trace->screens[slot].name == NULL)))
+        {
+            slot = i;
+        }
+    }
+    ESP_RETURN_ON_FALSE(slot >= 0, ESP_ERR_NO_MEM, TAG, "too many screens");
+    trace->screens[slot].scr = scr;
+    trace->screens[slot].name = name;
+    lv_obj_add_event_cb(scr, disp_trace_screen_delete_cb, LV_EVENT_DELETE, trace);
+    return ESP_OK;
+}
+
+esp_err_t disp_trace_set_images(disp_trace_handle_t trace, disp_img_handle_t img)
+{
+    ESP_RETURN_ON_FALSE(trace, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    trace->img = img;
+    if (img)
+    {
+        // A frame being drawn now counts from here
+        disp_img_get_stats(img, &trace->img_start, false);
+    }
+    return ESP_OK;
+}
+
+void disp_trace_begin(disp_trace_handle_t trace)
+{
+    trace->pass_start_us = esp_timer_get_time();
+    trace->in_pass = true;
+}
+
+void disp_trace_end(disp_trace_handle_t trace)
+{
+    if (trace->pending)
+    {
+        trace->pending_frame.timer_us = (uint32_t)(esp_timer_get_time() - trace->pass_start_us);
+        disp_trace_push(trace, &trace->pending_frame);
+        trace->pending = false;
+    }
+    trace->in_pass = false;
+}
+
+esp_err_t disp_trace_dump(disp_trace_handle_t trace, disp_trace_write_t write, void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(trace && write, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    char line[DISP_TRACE_LINE_BYTES];
+    int len = snprintf(line, sizeof(line), "trace,seq,t_ms,screen,timer_us,render_us,flush_us,bytes,areas,img_hits,img_misses,img_bytes\n");
+    ESP_RETURN_ON_ERROR(write(line, len, user_ctx), TAG, "write failed");
+
+    const uint32_t head = atomic_load_explicit(&trace->head, memory_order_acquire);
+    if (head - trace->tail > trace->mask + 1)
+    {
+        // Lapped since the last dump
+        atomic_fetch_add_explicit(&trace->lost, head - trace->tail - (trace->mask + 1), memory_order_relaxed);
+        trace->tail = head - (trace->mask + 1);
+    }
+    while (trace->tail != head)
+    {
+        const disp_trace_slot_t *slot = &trace->slots[trace->tail & trace->mask];
+        const uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        const disp_trace_record_t rec = slot->rec;
+        atomic_thread_fence(memory_order_acquire);
+        if (seq != trace->tail + 1 || atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq)
+        {
+            // Overwritten by the LVGL task while this dump was writing out older records
+            atomic_fetch_add_explicit(&trace->lost, 1, memory_order_relaxed);
+            trace->tail++;
+            continue;
+        }
+        const char *name = rec.screen != DISP_TRACE_SCREEN_NONE && rec.screen <= DISP_TRACE_MAX_SCREENS ?
+                           trace->screens[rec.screen - 1].name : NULL;
+        len = snprintf(line, sizeof(line), "trace,%" PRIu32 ",%" PRIu32 ",%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%u,%u,%u,%" PRIu32 "\n",
+                       rec.seq, rec.t_ms, name ? name : "-", rec.timer_us, rec.render_us, rec.flush_us, rec.bytes,
+                       (unsigned)rec.areas, (unsigned)rec.img_hits, (unsigned)rec.img_misses, rec.img_bytes);
+        ESP_RETURN_ON_ERROR(write(line, len < (int)sizeof(line) ? len : (int)sizeof(line) - 1, user_ctx), TAG,
+                            "write failed");
+        atomic_fetch_add_explicit(&trace->dumped, 1, memory_order_relaxed);
+        trace->tail++;
+    }
+    return ESP_OK;
+}
+
+esp_err_t disp_trace_write_file(const char *line, size_t len, void *user_ctx)
+{
+    return fwrite(line, 1, len, (FILE *)user_ctx) == len ? ESP_OK : ESP_FAIL;
+}
+
+void disp_trace_get_stats(disp_trace_handle_t trace, disp_trace_stats_t *stats)
+{
+    stats->recorded = atomic_load_explicit(&trace->head, memory_order_relaxed);
+    stats->dumped = atomic_load_explicit(&trace->dumped, memory_order_relaxed);
+    stats->lost = atomic_load_explicit(&trace->lost, memory_order_relaxed);
+}
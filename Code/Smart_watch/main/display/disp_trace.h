@@ -0,0 +1,144 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#include "disp_img.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default ring length, about 17 s of frames at 60 fps
+#define DISP_TRACE_DEFAULT_RECORDS 1024
+// Most screens that can be given a name for the dump
+#define DISP_TRACE_MAX_SCREENS 16
+// Screen index of frames drawn on a screen without a name
+#define DISP_TRACE_SCREEN_NONE 0
+
+typedef struct disp_trace_t *disp_trace_handle_t;
+
+/**
+ * @brief Timing of one LVGL refresh
+ *
+ * `render_us + flush_us` is the refresh time; with the flush engine `flush_us` is mostly the time LVGL waited
+ * for a free draw buffer, the bus time itself is in the engine statistics. The image counters are those of the
+ * decoder given to `disp_trace_set_images` while the frame was drawn, 0 without one.
+ */
+typedef struct {
+    uint32_t seq;               /*!< Frame number since creation, gaps in a dump are overwritten records */
+    uint32_t t_ms;              /*!< Render start, milliseconds since boot */
+    uint32_t timer_us;          /*!< LVGL task pass that rendered the frame, between `disp_trace_begin` and `disp_trace_end` (0 outside one) */
+    uint32_t render_us;         /*!< Drawing: refresh time minus `flush_us` */
+    uint32_t flush_us;          /*!< Time spent in `flush_cb` and waiting for a free draw buffer */
+    uint32_t bytes;             /*!< Pixel bytes handed to `flush_cb` */
+    uint32_t img_bytes;         /*!< Bytes the image cache decoded for the frame */
+    uint16_t areas;             /*!< Areas handed to `flush_cb` */
+    uint16_t img_hits;          /*!< Compressed images the cache served decoded */
+    uint16_t img_misses;        /*!< Compressed images decoded whole into the cache */
+    uint8_t screen;             /*!< Active screen, 1 + its index in the name table or DISP_TRACE_SCREEN_NONE */
+    uint8_t reserved;
+} disp_trace_record_t;
+
+/**
+ * @brief Frame trace configuration
+ */
+typedef struct {
+    size_t records;             /*!< Ring length, rounded up to a power of two, 0 selects DISP_TRACE_DEFAULT_RECORDS */
+} disp_trace_config_t;
+
+/**
+ * @brief Ring counters since creation
+ */
+typedef struct {
+    uint32_t recorded;          /*!< Frames written to the ring */
+    uint32_t dumped;            /*!< Records written out by `disp_trace_dump` */
+    uint32_t lost;              /*!< Records overwritten before they were dumped */
+} disp_trace_stats_t;
+
+/**
+ * @brief Write one dump line (text, ends with a newline, not NUL terminated)
+ *
+ * @return ESP_OK to go on, anything else stops the dump
+ */
+typedef esp_err_t (*disp_trace_write_t)(const char *line, size_t len, void *user_ctx);
+
+/**
+ * @brief Create a frame trace and its ring, in PSRAM when there is some
+ *
+ * @param[in]  config    Configuration
+ * @param[out] ret_trace Handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Bad configuration
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t disp_trace_new(const disp_trace_config_t *config, disp_trace_handle_t *ret_trace);
+
+/**
+ * @brief Time the refreshes of an LVGL driver
+ *
+ * Wraps `flush_cb`, `wait_cb`, `render_start_cb` and `monitor_cb`, keeping the ones installed before. Call
+ * after every other stage that installs driver callbacks and before `lv_disp_drv_register`.
+ */
+esp_err_t disp_trace_attach(disp_trace_handle_t trace, lv_disp_drv_t *drv);
+
+/**
+ * @brief Name a screen in the dump, frames are recorded with the screen active when they start
+ *
+ * A screen deleted and built again under the same name keeps its place in the dump.
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_NO_MEM: DISP_TRACE_MAX_SCREENS screens already have a name
+ */
+esp_err_t disp_trace_set_screen_name(disp_trace_handle_t trace, lv_obj_t *scr, const char *name);
+
+/**
+ * @brief Count the image cache hits, misses and decoded bytes of every frame, NULL stops; with the LVGL lock held
+ *
+ * The counters are read when a frame starts and ends, so the decoder's own stats can still be reset between
+ * frames. Call with NULL before deleting the decoder.
+ */
+esp_err_t disp_trace_set_images(disp_trace_handle_t trace, disp_img_handle_t img);
+
+/**
+ * @brief Mark the start of an LVGL task pass (`lv_timer_handler` or a TE refresh), from the LVGL task
+ */
+void disp_trace_begin(disp_trace_handle_t trace);
+
+/**
+ * @brief Mark the end of the pass, the frame it rendered is written to the ring with the pass time
+ */
+void disp_trace_end(disp_trace_handle_t trace);
+
+/**
+ * @brief Write the records added since the last dump as CSV lines starting with "trace,"
+ *
+ * The first line is the column header. Records are never locked: the LVGL task keeps writing during the dump
+ * and records it overwrites are counted as lost. Call from one task at a time, e.g. a low priority dump task;
+ * the lines carry their own prefix so they can be picked out of a console log.
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - Otherwise: The error returned by `write`, the records not written are dumped next time
+ */
+esp_err_t disp_trace_dump(disp_trace_handle_t trace, disp_trace_write_t write, void *user_ctx);
+
+/**
+ * @brief `disp_trace_write_t` appending to the `FILE *` in `user_ctx`, e.g. a file on the SD card
+ */
+esp_err_t disp_trace_write_file(const char *line, size_t len, void *user_ctx);
+
+/**
+ * @brief Get the ring counters
+ */
+void disp_trace_get_stats(disp_trace_handle_t trace, disp_trace_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,361 @@
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "disp_trans.h"
+
+static const char *TAG = "disp_trans";
+
+// Positions are interpolated in 1/DISP_TRANS_RES steps
+#define DISP_TRANS_RES DISP_TRANS_PROGRESS_MAX
+
+typedef enum
+{
+    DISP_TRANS_PROP_NONE,
+    DISP_TRANS_PROP_X,              // in screen widths
+    DISP_TRANS_PROP_Y,              // in screen heights
+    DISP_TRANS_PROP_OPA,            // 1 is LV_OPA_COVER
+} disp_trans_prop_t;
+
+typedef struct
+{
+    disp_trans_prop_t prop;
+    int8_t from;
+    int8_t to;
+} disp_trans_move_t;
+
+// What lv_scr_load_anim does to the outgoing [0] and incoming [1] screen, and which one is drawn on top
+static const struct
+{
+    disp_trans_move_t move[2];
+    bool old_on_top;
+} disp_trans_anims[] = {
+    [LV_SCR_LOAD_ANIM_OVER_LEFT] = {{{0}, {DISP_TRANS_PROP_X, 1, 0}}, false},
+    [LV_SCR_LOAD_ANIM_OVER_RIGHT] = {{{0}, {DISP_TRANS_PROP_X, -1, 0}}, false},
+    [LV_SCR_LOAD_ANIM_OVER_TOP] = {{{0}, {DISP_TRANS_PROP_Y, 1, 0}}, false},
+    [LV_SCR_LOAD_ANIM_OVER_BOTTOM] = {{{0}, {DISP_TRANS_PROP_Y, -1, 0}}, false},
+    [LV_SCR_LOAD_ANIM_MOVE_LEFT] = {{{DISP_TRANS_PROP_X, 0, -1}, {DISP_TRANS_PROP_X, 1, 0}}, false},
+    [LV_SCR_LOAD_ANIM_MOVE_RIGHT] = {{{DISP_TRANS_PROP_X, 0, 1}, {DISP_TRANS_PROP_X, -1, 0}}, false},
+    [LV_SCR_LOAD_ANIM_MOVE_TOP] = {{{DISP_TRANS_PROP_Y, 0, -1}, {DISP_TRANS_PROP_Y, 1, 0}}, false},
+    [LV_SCR_LOAD_ANIM_MOVE_BOTTOM] = {{{DISP_TRANS_PROP_Y, 0, 1}, {DISP_TRANS_PROP_Y, -1, 0}}, false},
+    [LV_SCR_LOAD_ANIM_FADE_IN] = {{{0}, {DISP_TRANS_PROP_OPA, 0, 1}}, false},
+    [LV_SCR_LOAD_ANIM_FADE_OUT] = {{{DISP_TRANS_PROP_OPA, 1, 0}, {0}}, true},
+    [LV_SCR_LOAD_ANIM_OUT_LEFT] = {{{DISP_TRANS_PROP_X, 0, -1}, {0}}, true},
+    [LV_SCR_LOAD_ANIM_OUT_RIGHT] = {{{DISP_TRANS_PROP_X, 0, 1}, {0}}, true},
+    [LV_SCR_LOAD_ANIM_OUT_TOP] = {{{DISP_TRANS_PROP_Y, 0, -1}, {0}}, true},
+    [LV_SCR_LOAD_ANIM_OUT_BOTTOM] = {{{DISP_TRANS_PROP_Y, 0, 1}, {0}}, true},
+};
+
+struct disp_trans_t
+{
+    disp_trans_config_t cfg;
+    lv_disp_t *disp;
+    lv_coord_t hor_res;
+    lv_coord_t ver_res;
+    uint32_t buf_size;
+    uint8_t *buf[2];                // snapshots of the outgoing [0] and incoming [1] screen
+    lv_img_dsc_t dsc[2];
+    lv_obj_t *scr;                  // screen the two images are animated on
+    lv_obj_t *img[2];
+    lv_obj_t *from;                 // screen shown before, loaded again when a drag is cancelled
+    lv_obj_t *target;               // loaded when the transition is over
+    lv_scr_load_anim_t anim;
+    bool running;
+    bool commit;                    // ends on the target, not back on `from`
+    int32_t progress;               // shown now, 0 to DISP_TRANS_RES
+    int64_t start_us;               // first animation step
+    disp_trans_stats_t stats;
+};
+
+// Put both images where they are `v` / DISP_TRANS_RES of the way through the animation
+static void disp_trans_apply(disp_trans_handle_t trans, int32_t v)
+{
+    for (int i = 0; i < 2; i++)
+    {
+        const disp_trans_move_t *m = &disp_trans_anims[trans->anim].move[i];
+        const int32_t pos = (m->from * (DISP_TRANS_RES - v) + m->to * v);
+        switch (m->prop)
+        {
+        case DISP_TRANS_PROP_X:
+            lv_obj_set_pos(trans->img[i], (lv_coord_t)(pos * trans->hor_res / DISP_TRANS_RES), 0);
+            break;
+        case DISP_TRANS_PROP_Y:
+            lv_obj_set_pos(trans->img[i], 0, (lv_coord_t)(pos * trans->ver_res / DISP_TRANS_RES));
+            break;
+        case DISP_TRANS_PROP_OPA:
+            lv_obj_set_style_img_opa(trans->img[i], (lv_opa_t)(pos * LV_OPA_COVER / DISP_TRANS_RES), 0);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static void disp_trans_exec_cb(void *var, int32_t v)
+{
+    disp_trans_handle_t trans = (disp_trans_handle_t)var;
+    disp_trans_apply(trans, v);
+    trans->progress = v;
+    trans->stats.frames++;
+}
+
+static void disp_trans_start_cb(lv_anim_t *a)
+{
+    disp_trans_handle_t trans = (disp_trans_handle_t)a->var;
+    trans->start_us = esp_timer_get_time();
+}
+
+// End the transition and show the target screen live (or the one it started from, when a drag was cancelled),
+// unless another screen (e.g. the AOD face) took over
+static void disp_trans_finish(disp_trans_handle_t trans)
+{
+    trans->running = false;
+    if (trans->start_us)
+    {
+        trans->stats.anim_us += esp_timer_get_time() - trans->start_us;
+    }
+    lv_obj_t *scr = trans->commit ? trans->target : trans->from;
+    if (!trans->commit)
+    {
+        // Back where it started, not on the way to the target
+        trans->target = trans->from;
+    }
+    if (lv_disp_get_scr_act(trans->disp) == trans->scr && lv_obj_is_valid(scr))
+    {
+        lv_disp_load_scr(scr);
+    }
+}
+
+static void disp_trans_ready_cb(lv_anim_t *a)
+{
+    disp_trans_finish((disp_trans_handle_t)a->var);
+}
+
+static void disp_trans_forward_cb(void *user_ctx)
+{
+    disp_trans_handle_t trans = (disp_trans_handle_t)user_ctx;
+    if (!trans->running && lv_disp_get_scr_act(trans->disp) == trans->scr && lv_obj_is_valid(trans->target))
+    {
+        lv_disp_load_scr(trans->target);
+    }
+}
+
+// The transition screen came back without a transition, e.g. restored by the AOD: move on to the target
+static void disp_trans_screen_event_cb(lv_event_t *e)
+{
+    disp_trans_handle_t trans = (disp_trans_handle_t)lv_event_get_user_data(e);
+    if (!trans->running && trans->target)
+    {
+        // Not from within the load that is sending this event
+        lv_async_call(disp_trans_forward_cb, trans);
+    }
+}
+
+esp_err_t disp_trans_new(const disp_trans_config_t *config, lv_disp_t *disp, disp_trans_handle_t *ret_trans)
+{
+    esp_err_t ret = ESP_OK;
+    disp_trans_handle_t trans = NULL;
+    ESP_RETURN_ON_FALSE(config && disp && ret_trans, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    trans = calloc(1, sizeof(struct disp_trans_t));
+    ESP_RETURN_ON_FALSE(trans, ESP_ERR_NO_MEM, TAG, "no mem for transitions");
+    trans->cfg = *config;
+    if (trans->cfg.caps == 0)
+    {
+        trans->cfg.caps = MALLOC_CAP_SPIRAM;
+    }
+    trans->disp = disp;
+    trans->hor_res = lv_disp_get_hor_res(disp);
+    trans->ver_res = lv_disp_get_ver_res(disp);
+
+    trans->scr = lv_obj_create(NULL);
+    ESP_GOTO_ON_FALSE(trans->scr, ESP_ERR_NO_MEM, err, TAG, "no mem for transition screen");
+    lv_obj_clear_flag(trans->scr, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_set_style_bg_color(trans->scr, lv_color_black(), 0);
+    lv_obj_set_style_bg_opa(trans->scr, LV_OPA_COVER, 0);
+    lv_obj_add_event_cb(trans->scr, disp_trans_screen_event_cb, LV_EVENT_SCREEN_LOADED, trans);
+    trans->buf_size = lv_snapshot_buf_size_needed(trans->scr, LV_IMG_CF_TRUE_COLOR);
+    for (int i = 0; i < 2; i++)
+    {
+        trans->img[i] = lv_img_create(trans->scr);
+        ESP_GOTO_ON_FALSE(trans->img[i], ESP_ERR_NO_MEM, err, TAG, "no mem for transition image");
+        trans->buf[i] = heap_caps_malloc(trans->buf_size, trans->cfg.caps | MALLOC_CAP_8BIT);
+        ESP_GOTO_ON_FALSE(trans->buf[i], ESP_ERR_NO_MEM, err, TAG, "no mem for snapshot");
+    }
+    ESP_LOGI(TAG, "two %" PRIu32 " byte snapshots", trans->buf_size);
+    *ret_trans = trans;
+    return ESP_OK;
+
+err:
+    if (trans->scr)
+    {
+        lv_obj_del(trans->scr);
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        heap_caps_free(trans->buf[i]);
+    }
+    free(trans);
+    return ret;
+}
+
+// Put both screens on the transition screen at the start of `anim`, drawn once; false if they cannot be drawn
+static bool disp_trans_prepare(disp_trans_handle_t trans, lv_obj_t *scr, lv_scr_load_anim_t anim, int time)
+{
+    if (trans->running)
+    {
+        // Straight to the end of the one on display, the next one starts from its target
+        lv_anim_del(trans, disp_trans_exec_cb);
+        trans->stats.interrupted++;
+        disp_trans_finish(trans);
+    }
+
+    lv_obj_t *act = lv_disp_get_scr_act(trans->disp);
+    bool animate = act && act != scr && act != trans->scr && time > 0 && anim != LV_SCR_LOAD_ANIM_NONE &&
+                   (size_t)anim < sizeof(disp_trans_anims) / sizeof(disp_trans_anims[0]);
+    const int64_t t0 = esp_timer_get_time();
+    // Both screens drawn once, the animation only moves the images
+    lv_obj_t *from_to[2] = {act, scr};
+    for (int i = 0; i < 2 && animate; i++)
+    {
+        animate = lv_snapshot_take_to_buf(from_to[i], LV_IMG_CF_TRUE_COLOR, &trans->dsc[i], trans->buf[i],
+                                          trans->buf_size) == LV_RES_OK;
+    }
+    if (!animate)
+    {
+        trans->stats.fallbacks++;
+        return false;
+    }
+    const uint32_t snapshot_us = (uint32_t)(esp_timer_get_time() - t0);
+    trans->stats.snapshot_us += snapshot_us;
+    trans->stats.max_snapshot_us = snapshot_us > trans->stats.max_snapshot_us ? snapshot_us : trans->stats.max_snapshot_us;
+    trans->stats.transitions++;
+
+    for (int i = 0; i < 2; i++)
+    {
+        // Same descriptor, new pixels
+        lv_img_cache_invalidate_src(&trans->dsc[i]);
+        lv_img_set_src(trans->img[i], &trans->dsc[i]);
+        lv_obj_set_pos(trans->img[i], 0, 0);
+        lv_obj_set_style_img_opa(trans->img[i], LV_OPA_COVER, 0);
+    }
+    if (disp_trans_anims[anim].old_on_top)
+    {
+        lv_obj_move_foreground(trans->img[0]);
+    }
+    else
+    {
+        lv_obj_move_foreground(trans->img[1]);
+    }
+    trans->anim = anim;
+    trans->from = act;
+    trans->target = scr;
+    trans->running = true;
+    trans->commit = true;
+    trans->progress = 0;
+    trans->start_us = 0;
+    disp_trans_apply(trans, 0);
+    // Looks like the outgoing screen until the animation starts
+    lv_disp_load_scr(trans->scr);
+    // The target is loading from now on, as with lv_scr_load_anim; it gets LV_EVENT_SCREEN_LOADED at the end
+    lv_event_send(scr, LV_EVENT_SCREEN_LOAD_START, NULL);
+    return true;
+}
+
+// Animate from the progress shown to `end`
+static void disp_trans_animate(disp_trans_handle_t trans, int32_t end, int time, int delay)
+{
+    lv_anim_t a;
+    lv_anim_init(&a);
+    lv_anim_set_var(&a, trans);
+    lv_anim_set_exec_cb(&a, disp_trans_exec_cb);
+    lv_anim_set_values(&a, trans->progress, end);
+    lv_anim_set_time(&a, time);
+    lv_anim_set_delay(&a, delay);
+    lv_anim_set_start_cb(&a, disp_trans_start_cb);
+    lv_anim_set_ready_cb(&a, disp_trans_ready_cb);
+    lv_anim_start(&a);
+}
+
+void disp_trans_load(lv_obj_t *scr, lv_scr_load_anim_t anim, int time, int delay, void *user_ctx)
+{
+    disp_trans_handle_t trans = (disp_trans_handle_t)user_ctx;
+    if (!disp_trans_prepare(trans, scr, anim, time))
+    {
+        lv_scr_load_anim(scr, anim, time, delay, false);
+        return;
+    }
+    disp_trans_animate(trans, DISP_TRANS_RES, time, delay);
+}
+
+esp_err_t disp_trans_begin(disp_trans_handle_t trans, lv_obj_t *scr, lv_scr_load_anim_t anim)
+{
+    ESP_RETURN_ON_FALSE(trans && scr, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    // Any duration, the drag sets the progress
+    ESP_RETURN_ON_FALSE(disp_trans_prepare(trans, scr, anim, 1), ESP_FAIL, TAG, "cannot draw the screens");
+    trans->stats.drags++;
+    return ESP_OK;
+}
+
+void disp_trans_set_progress(disp_trans_handle_t trans, int32_t progress)
+{
+    if (!trans->running || lv_anim_get(trans, disp_trans_exec_cb))
+    {
+        return;
+    }
+    progress = progress < 0 ? 0 : progress > DISP_TRANS_RES ? DISP_TRANS_RES : progress;
+    if (progress != trans->progress)
+    {
+        disp_trans_apply(trans, progress);
+        trans->progress = progress;
+    }
+}
+
+void disp_trans_release(disp_trans_handle_t trans, bool commit, int time)
+{
+    if (!trans->running || lv_anim_get(trans, disp_trans_exec_cb))
+    {
+        return;
+    }
+    trans->commit = commit;
+    if (!commit)
+    {
+        trans->stats.cancelled++;
+    }
+    const int32_t end = commit ? DISP_TRANS_RES : 0;
+    if (time <= 0 || trans->progress == end)
+    {
+        disp_trans_finish(trans);
+        return;
+    }
+    disp_trans_animate(trans, end, time, 0);
+}
+
+int32_t disp_trans_get_progress(disp_trans_handle_t trans)
+{
+    return trans->running ? trans->progress : 0;
+}
+
+lv_obj_t *disp_trans_get_screen(disp_trans_handle_t trans)
+{
+    return trans->scr;
+}
+
+bool disp_trans_is_running(disp_trans_handle_t trans)
+{
+    return trans->running;
+}
+
+void disp_trans_get_stats(disp_trans_handle_t trans, disp_trans_stats_t *stats, bool reset)
+{
+    *stats = trans->stats;
+    if (reset)
+    {
+        memset(&trans->stats, 0, sizeof(trans->stats));
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Progress of a transition at its end, see disp_trans_set_progress
+#define DISP_TRANS_PROGRESS_MAX 1024
+
+typedef struct disp_trans_t *disp_trans_handle_t;
+
+/**
+ * @brief Snapshot transition configuration
+ */
+typedef struct {
+    uint32_t caps;                  /*!< Heap capabilities of the two snapshots, 0 selects MALLOC_CAP_SPIRAM */
+} disp_trans_config_t;
+
+/**
+ * @brief Transition counters since the last reset
+ */
+typedef struct {
+    uint32_t transitions;           /*!< Screen loads animated from snapshots */
+    uint32_t fallbacks;             /*!< Loads left to lv_scr_load_anim: no animation or a snapshot failed */
+    uint32_t interrupted;           /*!< Transitions cut short by the next load */
+    uint32_t drags;                 /*!< Transitions started by disp_trans_begin */
+    uint32_t cancelled;             /*!< Drags released back to the screen they started from */
+    uint64_t snapshot_us;           /*!< Time spent rendering the two snapshots of every transition */
+    uint32_t max_snapshot_us;       /*!< Longest pair of snapshots */
+    uint32_t frames;                /*!< Animation steps, one per rendered frame */
+    uint64_t anim_us;               /*!< Time from the first to the last step of every transition */
+} disp_trans_stats_t;
+
+/**
+ * @brief Create the transition engine and allocate its two full-screen snapshots
+ *
+ * @param[in]  config    Configuration
+ * @param[in]  disp      Display the screens are on
+ * @param[out] ret_trans Handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t disp_trans_new(const disp_trans_config_t *config, lv_disp_t *disp, disp_trans_handle_t *ret_trans);
+
+/**
+ * @brief Load a screen like lv_scr_load_anim, with the LVGL lock held
+ *
+ * Renders the screen shown and `scr` once into the snapshots, then animates two images on a screen of its own
+ * instead of both widget trees; `scr` is loaded, and drawn live again, when the animation is over. A load during
+ * a transition ends it first. Loads without animation go straight to lv_scr_load_anim.
+ *
+ * Has the signature of the SquareLine load hook, pass it to _ui_screen_set_load_cb with the handle as user data.
+ *
+ * @param scr       Screen to load
+ * @param anim      Animation, as for lv_scr_load_anim
+ * @param time      Duration of the animation in milliseconds
+ * @param delay     Delay before the animation in milliseconds
+ * @param user_ctx  The disp_trans_handle_t
+ */
+void disp_trans_load(lv_obj_t *scr, lv_scr_load_anim_t anim, int time, int delay, void *user_ctx);
+
+/**
+ * @brief Start a transition to `scr` that follows a finger, with the LVGL lock held
+ *
+ * Draws the snapshots as disp_trans_load does and shows the start of `anim`, but leaves the progress to
+ * disp_trans_set_progress until disp_trans_release animates the rest of the way, to `scr` or back.
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_FAIL: No animation or a snapshot failed, nothing was loaded
+ */
+esp_err_t disp_trans_begin(disp_trans_handle_t trans, lv_obj_t *scr, lv_scr_load_anim_t anim);
+
+/**
+ * @brief Move a transition started by disp_trans_begin to `progress`, 0 to DISP_TRANS_PROGRESS_MAX
+ *
+ * Only moves the two images, the frame is drawn by the next refresh. Ignored once released.
+ */
+void disp_trans_set_progress(disp_trans_handle_t trans, int32_t progress);
+
+/**
+ * @brief Let go of a transition started by disp_trans_begin
+ *
+ * @param commit    Animate on to the new screen, or back to the one the drag started from
+ * @param time      Duration of the rest of the animation in milliseconds, 0 to end it now
+ */
+void disp_trans_release(disp_trans_handle_t trans, bool commit, int time);
+
+/**
+ * @brief Progress of the transition on display, 0 to DISP_TRANS_PROGRESS_MAX; 0 when none is
+ */
+int32_t disp_trans_get_progress(disp_trans_handle_t trans);
+
+/**
+ * @brief Screen the transitions are drawn on, e.g. to name it in the frame trace
+ */
+lv_obj_t *disp_trans_get_screen(disp_trans_handle_t trans);
+
+/**
+ * @brief Whether a transition is on display
+ */
+bool disp_trans_is_running(disp_trans_handle_t trans);
+
+/**
+ * @brief Get the counters and optionally clear them, with the LVGL lock held
+ */
+void disp_trans_get_stats(disp_trans_handle_t trans, disp_trans_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,366 @@
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "disp_update.h"
+
+static const char *TAG = "disp_update";
+
+typedef enum
+{
+    DISP_UPDATE_LABEL_TEXT,
+    DISP_UPDATE_ARC_VALUE,
+    DISP_UPDATE_CHART_POINT,
+    DISP_UPDATE_IMG_SRC,
+} disp_update_type_t;
+
+typedef struct
+{
+    disp_update_type_t type;
+    lv_obj_t *obj;
+    union
+    {
+        char text[DISP_UPDATE_TEXT_LEN];
+        int16_t value;
+        struct
+        {
+            lv_chart_series_t *ser;
+            lv_coord_t value;
+        } point;
+        const void *src;
+    };
+} disp_update_msg_t;
+
+// One ring entry; `seq` is the position the slot can be claimed at, and that position + 1 once the message in it
+// is published. The consumer frees it for the next lap by moving it one ring length ahead.
+typedef struct
+{
+    _Atomic uint32_t seq;
+    disp_update_msg_t msg;
+} disp_update_slot_t;
+
+struct disp_update_t
+{
+    disp_update_config_t cfg;
+    disp_update_slot_t *slots;
+    uint32_t mask;
+    _Atomic uint32_t head;          // next position to claim, shared by the producers
+    _Atomic uint32_t tail;          // next position to apply, only the LVGL task moves it
+    _Atomic uint32_t posted;
+    _Atomic uint32_t dropped;
+    _Atomic uint32_t max_depth;
+    disp_update_msg_t *batch;       // messages taken by the current `disp_update_apply`, LVGL task only
+    portMUX_TYPE lock;              // protects the consumer counters
+    disp_update_stats_t stats;
+};
+
+// Claim a slot, NULL when the queue is full; the message must be published with `disp_update_publish`
+static disp_update_slot_t *disp_update_claim(disp_update_handle_t update, uint32_t *ret_pos)
+{
+    uint32_t pos = atomic_load_explicit(&update->head, memory_order_relaxed);
+    while (1)
+    {
+        disp_update_slot_t *slot = &update->slots[pos & update->mask];
+        const uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        const int32_t dif = (int32_t)(seq - pos);
+        if (dif == 0)
+        {
+            // The slot is free for this lap, take it unless another producer did
+            if (atomic_compare_exchange_weak_explicit(&update->head, &pos, pos + 1, memory_order_relaxed,
+                                                      memory_order_relaxed))
+            {
+                *ret_pos = pos;
+                return slot;
+            }
+        }
+        else if (dif < 0)
+        {
+            // Still holds the message of the previous lap: full
+            atomic_fetch_add_explicit(&update->dropped, 1, memory_order_relaxed);
+            return NULL;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&update->head, memory_order_relaxed);
+        }
+    }
+}
+
+static void disp_update_publish(disp_update_handle_t update, disp_update_slot_t *slot, uint32_t pos)
+{
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    atomic_fetch_add_explicit(&update->posted, 1, memory_order_relaxed);
+
+    const uint32_t depth = pos + 1 - atomic_load_explicit(&update->tail, memory_order_relaxed);
+    uint32_t max_depth = atomic_load_explicit(&update->max_depth, memory_order_relaxed);
+    while (depth > max_depth &&
+           !atomic_compare_exchange_weak_explicit(&update->max_depth, &max_depth, depth, memory_order_relaxed,
+                                                  memory_order_relaxed))
+    {
+    }
+    if (update->cfg.on_post)
+    {
+        update->cfg.on_post(update->cfg.user_ctx);
+    }
+}
+
+esp_err_t disp_update_new(const disp_update_config_t *config, disp_update_handle_t *ret_update)
+{
+    esp_err_t ret = ESP_OK;
+    disp_update_handle_t update = NULL;
+    ESP_RETURN_ON_FALSE(config && ret_update, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    update = calloc(1, sizeof(struct disp_update_t));
+    ESP_RETURN_ON_FALSE(update, ESP_ERR_NO_MEM, TAG, "no mem for update queue");
+    update->cfg = *config;
+    if (update->cfg.depth == 0)
+    {
+        update->cfg.depth = DISP_UPDATE_DEFAULT_DEPTH;
+    }
+    size_t depth = 1;
+    while (depth < update->cfg.depth)
+    {
+        depth <<= 1;
+    }
+    update->cfg.depth = depth;
+    update->mask = depth - 1;
+    portMUX_INITIALIZE(&update->lock);
+
+    // Posted from any task, so internal RAM
+    update->slots = calloc(depth, sizeof(disp_update_slot_t));
+    ESP_GOTO_ON_FALSE(update->slots, ESP_ERR_NO_MEM, err, TAG, "no mem for %u messages", (unsigned)depth);
+    update->batch = calloc(depth, sizeof(disp_update_msg_t));
+    ESP_GOTO_ON_FALSE(update->batch, ESP_ERR_NO_MEM, err, TAG, "no mem for the batch");
+    for (uint32_t i = 0; i < depth; i++)
+    {
+        atomic_init(&update->slots[i].seq, i);
+    }
+
+    *ret_update = update;
+    return ESP_OK;
+
+err:
+    free(update->slots);
+    free(update->batch);
+    free(update);
+    return ret;
+}
+
+esp_err_t disp_update_label_text(disp_update_handle_t update, lv_obj_t *label, const char *text)
+{
+    ESP_RETURN_ON_FALSE(update && label && text, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    uint32_t pos;
+    disp_update_slot_t *slot = disp_update_claim(update, &pos);
+    if (slot == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    slot->msg.type = DISP_UPDATE_LABEL_TEXT;
+    slot->msg.obj = label;
+    snprintf(slot->msg.text, sizeof(slot->msg.text), "%s", text);
+    disp_update_publish(update, slot, pos);
+    return ESP_OK;
+}
+
+esp_err_t disp_update_label_text_fmt(disp_update_handle_t update, lv_obj_t *label, const char *fmt, ...)
+{
+    ESP_RETURN_ON_FALSE(update && label && fmt, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    uint32_t pos;
+    disp_update_slot_t *slot = disp_update_claim(update, &pos);
+    if (slot == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    slot->msg.type = DISP_UPDATE_LABEL_TEXT;
+    slot->msg.obj = label;
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(slot->msg.text, sizeof(slot->msg.text), fmt, args);
+    va_end(args);
+    disp_update_publish(update, slot, pos);
+    return ESP_OK;
+}
+
+esp_err_t disp_update_arc_value(disp_update_handle_t update, lv_obj_t *arc, int16_t value)
+{
+    ESP_RETURN_ON_FALSE(update && arc, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    uint32_t pos;
+    disp_update_slot_t *slot = disp_update_claim(update, &pos);
+    if (slot == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    slot->msg.type = DISP_UPDATE_ARC_VALUE;
+    slot->msg.obj = arc;
+    slot->msg.value = value;
+    disp_update_publish(update, slot, pos);
+    return ESP_OK;
+}
+
+esp_err_t disp_update_chart_point(disp_update_handle_t update, lv_obj_t *chart, lv_chart_series_t *ser,
+                                  lv_coord_t value)
+{
+    ESP_RETURN_ON_FALSE(update && chart && ser, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    uint32_t pos;
+    disp_update_slot_t *slot = disp_update_claim(update, &pos);
+    if (slot == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    slot->msg.type = DISP_UPDATE_CHART_POINT;
+    slot->msg.obj = chart;
+    slot->msg.point.ser = ser;
+    slot->msg.point.value = value;
+    disp_update_publish(update, slot, pos);
+    return ESP_OK;
+}
+
+esp_err_t disp_update_img_src(disp_update_handle_t update, lv_obj_t *img, const void *src)
+{
+    ESP_RETURN_ON_FALSE(update && img && src, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    uint32_t pos;
+    disp_update_slot_t *slot = disp_update_claim(update, &pos);
+    if (slot == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    slot->msg.type = DISP_UPDATE_IMG_SRC;
+    slot->msg.obj = img;
+    slot->msg.src = src;
+    disp_update_publish(update, slot, pos);
+    return ESP_OK;
+}
+
+// The widget may have been deleted since the message was posted, or its memory reused by another object
+static bool disp_update_target_valid(const disp_update_msg_t *msg)
+{
+    static const lv_obj_class_t *const classes[] = {
+        [DISP_UPDATE_LABEL_TEXT] = &lv_label_class,
+        [DISP_UPDATE_ARC_VALUE] = &lv_arc_class,
+        [DISP_UPDATE_CHART_POINT] = &lv_chart_class,
+        [DISP_UPDATE_IMG_SRC] = &lv_img_class,
+    };
+    return lv_obj_is_valid(msg->obj) && lv_obj_check_type(msg->obj, classes[msg->type]);
+}
+
+static void disp_update_apply_msg(const disp_update_msg_t *msg)
+{
+    switch (msg->type)
+    {
+    case DISP_UPDATE_LABEL_TEXT:
+        lv_label_set_text(msg->obj, msg->text);
+        break;
+    case DISP_UPDATE_ARC_VALUE:
+        lv_arc_set_value(msg->obj, msg->value);
+        break;
+    case DISP_UPDATE_CHART_POINT:
+        lv_chart_set_next_value(msg->obj, msg->point.ser, msg->point.value);
+        break;
+    case DISP_UPDATE_IMG_SRC:
+        lv_img_set_src(msg->obj, msg->src);
+        break;
+    }
+}
+
+size_t disp_update_apply(disp_update_handle_t update)
+{
+    const int64_t t0 = esp_timer_get_time();
+    // Take the published messages out of the ring first, so the producers get their slots back at once
+    uint32_t tail = atomic_load_explicit(&update->tail, memory_order_relaxed);
+    size_t count = 0;
+    while (count <= update->mask)
+    {
+        disp_update_slot_t *slot = &update->slots[tail & update->mask];
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != tail + 1)
+        {
+            // Empty, or claimed and not published yet: the rest waits for the next batch
+            break;
+        }
+        update->batch[count++] = slot->msg;
+        atomic_store_explicit(&slot->seq, tail + update->mask + 1, memory_order_release);
+        tail++;
+    }
+    atomic_store_explicit(&update->tail, tail, memory_order_relaxed);
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    uint32_t applied = 0;
+    uint32_t coalesced = 0;
+    uint32_t stale = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        const disp_update_msg_t *msg = &update->batch[i];
+        bool replaced = false;
+        for (size_t j = i + 1; j < count && msg->type != DISP_UPDATE_CHART_POINT; j++)
+        {
+            if (update->batch[j].obj == msg->obj && update->batch[j].type == msg->type)
+            {
+                replaced = true;
+                break;
+            }
+        }
+        if (replaced)
+        {
+            coalesced++;
+        }
+        else if (!disp_update_target_valid(msg))
+        {
+            stale++;
+        }
+        else
+        {
+            disp_update_apply_msg(msg);
+            applied++;
+        }
+    }
+
+    const int64_t us = esp_timer_get_time() - t0;
+    portENTER_CRITICAL(&update->lock);
+    update->stats.batches++;
+    update->stats.max_batch = count > update->stats.max_batch ? count : update->stats.max_batch;
+    update->stats.applied += applied;
+    update->stats.coalesced += coalesced;
+    update->stats.stale += stale;
+    update->stats.apply_us += us;
+    portEXIT_CRITICAL(&update->lock);
+    if (stale)
+    {
+        ESP_LOGD(TAG, "%" PRIu32 " updates for deleted widgets skipped", stale);
+    }
+    return count;
+}
+
+void disp_update_get_stats(disp_update_handle_t update, disp_update_stats_t *stats, bool reset)
+{
+    portENTER_CRITICAL(&update->lock);
+    *stats = update->stats;
+    if (reset)
+    {
+        memset(&update->stats, 0, sizeof(update->stats));
+    }
+    portEXIT_CRITICAL(&update->lock);
+    if (reset)
+    {
+        stats->posted = atomic_exchange_explicit(&update->posted, 0, memory_order_relaxed);
+        stats->dropped = atomic_exchange_explicit(&update->dropped, 0, memory_order_relaxed);
+        stats->max_depth = atomic_exchange_explicit(&update->max_depth, 0, memory_order_relaxed);
+    }
+    else
+    {
+        stats->posted = atomic_load_explicit(&update->posted, memory_order_relaxed);
+        stats->dropped = atomic_load_explicit(&update->dropped, memory_order_relaxed);
+        stats->max_depth = atomic_load_explicit(&update->max_depth, memory_order_relaxed);
+    }
+    stats->depth = atomic_load_explicit(&update->head, memory_order_relaxed) -
+                   atomic_load_explicit(&update->tail, memory_order_relaxed);
+}
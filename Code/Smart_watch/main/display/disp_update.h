@@ -0,0 +1,117 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default queue length, a few frames of updates from several sensor tasks
+#define DISP_UPDATE_DEFAULT_DEPTH 32
+// Longest label text a message carries, NUL included; longer texts are cut
+#define DISP_UPDATE_TEXT_LEN 32
+
+typedef struct disp_update_t *disp_update_handle_t;
+
+/**
+ * @brief Called after a message was queued, in the posting task, e.g. to wake the LVGL task up
+ */
+typedef void (*disp_update_post_cb_t)(void *user_ctx);
+
+/**
+ * @brief UI update queue configuration
+ */
+typedef struct {
+    size_t depth;                   /*!< Messages that can wait for the LVGL task, rounded up to a power of two,
+                                         0 selects DISP_UPDATE_DEFAULT_DEPTH */
+    disp_update_post_cb_t on_post;  /*!< Called after every queued message (may be NULL) */
+    void *user_ctx;                 /*!< Passed to `on_post` */
+} disp_update_config_t;
+
+/**
+ * @brief UI update queue counters since the last reset
+ */
+typedef struct {
+    uint32_t posted;                /*!< Messages queued */
+    uint32_t dropped;               /*!< Messages dropped because the queue was full */
+    uint32_t depth;                 /*!< Messages waiting right now */
+    uint32_t max_depth;             /*!< Most messages waiting at once, seen when posting */
+    uint32_t batches;               /*!< `disp_update_apply` calls that found messages */
+    uint32_t max_batch;             /*!< Most messages taken in one batch */
+    uint32_t applied;               /*!< Messages applied to a widget */
+    uint32_t coalesced;             /*!< Messages skipped because a later one in the same batch replaced them */
+    uint32_t stale;                 /*!< Messages skipped because their widget was deleted or of another type */
+    uint64_t apply_us;              /*!< Time spent in `disp_update_apply` */
+} disp_update_stats_t;
+
+/**
+ * @brief Create a UI update queue
+ *
+ * @param[in]  config     Configuration
+ * @param[out] ret_update Handle
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Bad configuration
+ *      - ESP_ERR_NO_MEM: Out of memory
+ */
+esp_err_t disp_update_new(const disp_update_config_t *config, disp_update_handle_t *ret_update);
+
+/**
+ * @brief Queue a new label text, copied into the message
+ *
+ * The post functions never block and never take the LVGL lock: any number of tasks may post at the same time,
+ * a slot is claimed with a compare-and-swap. Only the LVGL task touches the widget, in `disp_update_apply`.
+ *
+ * @return
+ *      - ESP_OK: Queued
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NO_MEM: Queue full, the update was dropped
+ */
+esp_err_t disp_update_label_text(disp_update_handle_t update, lv_obj_t *label, const char *text);
+
+/**
+ * @brief Queue a new label text, formatted in the posting task
+ */
+esp_err_t disp_update_label_text_fmt(disp_update_handle_t update, lv_obj_t *label, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/**
+ * @brief Queue a new arc value
+ */
+esp_err_t disp_update_arc_value(disp_update_handle_t update, lv_obj_t *arc, int16_t value);
+
+/**
+ * @brief Queue a point to append to a chart series, the series must live as long as the chart
+ */
+esp_err_t disp_update_chart_point(disp_update_handle_t update, lv_obj_t *chart, lv_chart_series_t *ser,
+                                  lv_coord_t value);
+
+/**
+ * @brief Queue a new image source, a static image descriptor or symbol that outlives the message
+ */
+esp_err_t disp_update_img_src(disp_update_handle_t update, lv_obj_t *img, const void *src);
+
+/**
+ * @brief Apply the queued messages in one batch, at the start of an LVGL task pass
+ *
+ * Takes every message published so far. Of several label, arc or image updates of the same widget only the
+ * last one is applied; chart points are all appended, in order. Messages whose widget no longer exists are
+ * skipped. Call in the LVGL task with the LVGL lock held.
+ *
+ * @return Number of messages taken from the queue
+ */
+size_t disp_update_apply(disp_update_handle_t update);
+
+/**
+ * @brief Get the queue counters and optionally clear them
+ */
+void disp_update_get_stats(disp_update_handle_t update, disp_update_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,4 +1,6 @@
 #include <stdio.h>
+#include <inttypes.h>
+#include <time.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -6,11 +8,14 @@
 #include "driver/i2c.h"
 #include "driver/spi_master.h"
 #include "esp_timer.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_panel_vendor.h"
 #include "esp_lcd_panel_ops.h"
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_system.h"
 
 #include "lvgl.h"
 
@@ -20,11 +25,35 @@
 #include "esp_io_expander_tca9554.h"
 
 #include "ui.h"
+#include "disp_port.h"
+#include "disp_flush.h"
+#include "disp_region.h"
+#include "disp_fb.h"
+#include "disp_te.h"
+#include "disp_rotate.h"
+#include "disp_buf.h"
+#include "disp_trace.h"
+#include "disp_aod.h"
+#include "disp_touch.h"
+#include "disp_par.h"
+#include "disp_bench.h"
+#include "disp_update.h"
+#include "disp_model.h"
+#include "disp_lock.h"
+#include "disp_screens.h"
+#include "disp_trans.h"
+#include "disp_gesture.h"
+#include "disp_img.h"
+#include "disp_assets.h"
+#include "disp_glyph.h"
+#include "disp_style.h"
+#include "bsp/UART_dev.h"
+#ifdef UI_ASSET_PARTITION
+#include "ui_assets.h"
+#endif
 
 // Log tag
 static const char *TAG = "SmartWatch";
-// LVGL mutex semaphore
-static SemaphoreHandle_t lvgl_mux = NULL;
 
 /*---------------------------------LCD Touch Parameter Configuration--------------------------*/
 
@@ -39,17 +68,6 @@ static SemaphoreHandle_t lvgl_mux = NULL;
 // Define the I2C host interface used by the touch controller
 #define TOUCH_HOST I2C_NUM_0    //I2C0
 
-// Define the horizontal and vertical pixel counts of the LCD
-#define EXAMPLE_LCD_H_RES 368
-#define EXAMPLE_LCD_V_RES 448
-
-// Configure the number of bits per pixel of the LCD according to the LVGL color depth
-#if CONFIG_LV_COLOR_DEPTH == 32
-#define LCD_BIT_PER_PIXEL (24)
-#elif CONFIG_LV_COLOR_DEPTH == 16
-#define LCD_BIT_PER_PIXEL (16)
-#endif
-
 /*----------------------------------LCD SPI IO Configuration----------------------------------------------------------*/
 #if EXAMPLE_USE_LCD
 
@@ -70,6 +88,8 @@ static SemaphoreHandle_t lvgl_mux = NULL;
 #define EXAMPLE_PIN_NUM_LCD_RST (-1)
 // Define the backlight pin of the LCD
 #define EXAMPLE_PIN_NUM_BK_LIGHT (-1)
+// Define the tearing-effect output pin of the LCD (-1: not wired, refreshes are not synchronized to the panel)
+#define EXAMPLE_PIN_NUM_LCD_TE (-1)
 
 // Define the LCD initialization command array
 static const sh8601_lcd_init_cmd_t lcd_init_cmds[] = {
@@ -97,118 +117,353 @@ static const sh8601_lcd_init_cmd_t lcd_init_cmds[] = {
 
 // Touch controller handle
 esp_lcd_touch_handle_t tp = NULL;
+// LVGL input device of the touch controller
+static lv_indev_t *lcd_indev = NULL;
 #endif
 
 /*----------------------------------LVGL Task Configuration----------------------------------------------------------*/
-// Define the height of the LVGL drawing buffer
-#define EXAMPLE_LVGL_BUF_HEIGHT (EXAMPLE_LCD_V_RES / 4)
-// Define the tick period of LVGL (in milliseconds)
-#define EXAMPLE_LVGL_TICK_PERIOD_MS 2
-// Define the maximum delay time of the LVGL task (in milliseconds)
-#define EXAMPLE_LVGL_TASK_MAX_DELAY_MS 500
-// Define the minimum delay time of the LVGL task (in milliseconds)
-#define EXAMPLE_LVGL_TASK_MIN_DELAY_MS 1
+// LVGL reads its time from esp_timer (CONFIG_LV_TICK_CUSTOM), no tick interrupt; the task sleeps until the next
+// LVGL timer is due or until it is notified
 // Define the stack size of the LVGL task
 #define EXAMPLE_LVGL_TASK_STACK_SIZE (4 * 1024)
 // Define the priority of the LVGL task
 #define EXAMPLE_LVGL_TASK_PRIORITY 2
 
-/*----------------------------------LVGL Function Configuration----------------------------------------------------------*/
-// Callback function to notify LVGL that the flush is ready
-static bool example_notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
-{
-    // Get the LVGL display driver pointer
-    lv_disp_drv_t *disp_driver = (lv_disp_drv_t *)user_ctx;
-    // Notify the LVGL display driver that the flush is ready
-    lv_disp_flush_ready(disp_driver);
-    return false;
-}
+// LVGL task handle, the touch reader and other tasks releasing the LVGL lock wake it up
+static TaskHandle_t lvgl_task = NULL;
 
-// LVGL flush callback function to draw the buffer content to the LCD
-static void example_lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
-{
-    // Get the LCD panel handle
-    esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t)drv->user_data;
-    // Get the coordinates of the area to be drawn
-    const int offsetx1 = area->x1;
-    const int offsetx2 = area->x2;
-    const int offsety1 = area->y1;
-    const int offsety2 = area->y2;
+/*----------------------------------LVGL Lock Configuration----------------------------------------------------------*/
+// Define whether the LVGL lock records wait and hold times per task (0: plain mutex)
+#define EXAMPLE_USE_LOCK_TRACE 1
+// Define the hold time that makes a frame late and is warned about (in microseconds)
+#define EXAMPLE_LOCK_BUDGET_US DISP_LOCK_DEFAULT_BUDGET_US
+// Define the period of the LVGL lock statistics log (in milliseconds)
+#define EXAMPLE_LOCK_STATS_PERIOD_MS 10000
+
+#if EXAMPLE_USE_LOCK_TRACE
+// Instrumented LVGL lock
+static disp_lock_handle_t lvgl_lock = NULL;
+#else
+// LVGL mutex semaphore
+static SemaphoreHandle_t lvgl_mux = NULL;
+#endif
 
-#if LCD_BIT_PER_PIXEL == 24
-    // Convert the color map to a byte pointer
-    uint8_t *to = (uint8_t *)color_map;
-    uint8_t temp = 0;
-    // Calculate the number of pixels to be drawn
-    uint16_t pixel_num = (offsetx2 - offsetx1 + 1) * (offsety2 - offsety1 + 1);
+/*----------------------------------Power Management Configuration----------------------------------------------------------*/
+// Define whether the CPU clock scales down and the chip light-sleeps while every task is blocked
+// (needs CONFIG_PM_ENABLE and CONFIG_FREERTOS_USE_TICKLESS_IDLE)
+#define EXAMPLE_USE_LIGHT_SLEEP 1
+// Define the CPU clock while the LVGL task works and while it is idle (in MHz)
+#define EXAMPLE_PM_MAX_CPU_FREQ_MHZ 240
+#define EXAMPLE_PM_MIN_CPU_FREQ_MHZ 80
 
-    // Special handling for the first pixel
-    temp = color_map[0].ch.blue;
-    *to++ = color_map[0].ch.red;
-    *to++ = color_map[0].ch.green;
-    *to++ = temp;
-    // Handle other pixels
-    for (int i = 1; i < pixel_num; i++)
-    {
-        *to++ = color_map[i].ch.red;
-        *to++ = color_map[i].ch.green;
-        *to++ = color_map[i].ch.blue;
-    }
+#if EXAMPLE_USE_LIGHT_SLEEP
+// Held while the LVGL task runs, so rendering never happens at the low clock
+static esp_pm_lock_handle_t lvgl_pm_lock = NULL;
+// Held while the TE edges are on, a frame is due within one panel period and light sleep would miss its edge
+static esp_pm_lock_handle_t te_pm_lock = NULL;
 #endif
 
-    // Draw the buffer content to the specified area
-    esp_lcd_panel_draw_bitmap(panel_handle, offsetx1, offsety1, offsetx2 + 1, offsety2 + 1, color_map);
-}
+/*----------------------------------Flush Engine Configuration----------------------------------------------------------*/
+// Define whether areas are sent through the pipelined flush engine (0: flush directly from the LVGL task)
+#define EXAMPLE_USE_FLUSH_ENGINE 1
+// Define whether the engine waits for every transfer before LVGL continues (reference for overlap measurements)
+#define EXAMPLE_FLUSH_ENGINE_SERIALIZED 0
+// Define the size of one QSPI sub-transfer
+#define EXAMPLE_FLUSH_CHUNK_BYTES (32 * 1024)
+// Define the stack size of the flush task
+#define EXAMPLE_FLUSH_TASK_STACK_SIZE (3 * 1024)
+// Define the priority of the flush task, above the LVGL task so the bus never waits for rendering
+#define EXAMPLE_FLUSH_TASK_PRIORITY (EXAMPLE_LVGL_TASK_PRIORITY + 1)
+// Define every how many frames the flush statistics are logged
+#define EXAMPLE_FLUSH_STATS_PERIOD 100
 
-/* When the screen is rotated in LVGL, rotate the display and touch. Called when the driver parameters are updated. */
-static void example_lvgl_update_cb(lv_disp_drv_t *drv)
-{
-    // Get the LCD panel handle
-    esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t)drv->user_data;
+/*----------------------------------Region Planner Configuration----------------------------------------------------------*/
+// Define whether invalid areas are merged/split with the QSPI cost model before every refresh
+#define EXAMPLE_USE_REGION_PLANNER 1
+// Define the interval of the region planner log (in milliseconds)
+#define EXAMPLE_REGION_STATS_PERIOD_MS 10000
 
-    switch (drv->rotated)
-    {
-    case LV_DISP_ROT_NONE:
-        // Do not rotate the LCD display
-        esp_lcd_panel_swap_xy(panel_handle, false);
-        esp_lcd_panel_mirror(panel_handle, true, false);
-        break;
-    case LV_DISP_ROT_90:
-        // Rotate the LCD display by 90 degrees
-        esp_lcd_panel_swap_xy(panel_handle, true);
-        esp_lcd_panel_mirror(panel_handle, true, true);
-        break;
-    case LV_DISP_ROT_180:
-        // Rotate the LCD display by 180 degrees
-        esp_lcd_panel_swap_xy(panel_handle, false);
-        esp_lcd_panel_mirror(panel_handle, false, true);
-        break;
-    case LV_DISP_ROT_270:
-        // Rotate the LCD display by 270 degrees
-        esp_lcd_panel_swap_xy(panel_handle, true);
-        esp_lcd_panel_mirror(panel_handle, false, false);
-        break;
-    }
-}
+/*----------------------------------PSRAM Framebuffer Configuration----------------------------------------------------------*/
+// Define whether LVGL draws into a full-screen framebuffer in PSRAM (direct mode) and only changed segments are sent
+// (replaces the two internal DMA draw buffers and the flush engine)
+#define EXAMPLE_USE_PSRAM_FRAMEBUFFER 0
+// Define the size of each of the two internal DMA bounce buffers the changed segments are sent from
+#define EXAMPLE_FB_BOUNCE_BYTES (16 * 1024)
+// Define the interval of the framebuffer log (in milliseconds)
+#define EXAMPLE_FB_STATS_PERIOD_MS 10000
+
+/*----------------------------------TE Scheduler Configuration----------------------------------------------------------*/
+// Define whether refreshes start on the tearing-effect edge of the panel (0: whenever the LVGL refresh timer is due);
+// needs the TE pin wired, a timer standing in for it would only delay every update without keeping frames from
+// tearing
+#define EXAMPLE_USE_TE_SYNC (EXAMPLE_PIN_NUM_LCD_TE >= 0)
+// Define the interval of the TE scheduler log (in milliseconds)
+#define EXAMPLE_TE_STATS_PERIOD_MS 10000
+
+/*----------------------------------Rotation Configuration----------------------------------------------------------*/
+// Define whether lv_disp_set_rotation is carried out in software (the SH8601 can neither swap axes nor mirror Y)
+// (not available with the PSRAM framebuffer)
+#define EXAMPLE_USE_SW_ROTATION 1
+// Define the size of each of the two internal DMA bounce buffers the rotated bands are sent from
+#define EXAMPLE_ROTATE_BOUNCE_BYTES (16 * 1024)
+// Define the rotation the display starts in (LV_DISP_ROT_NONE, LV_DISP_ROT_90, LV_DISP_ROT_180 or LV_DISP_ROT_270)
+#define EXAMPLE_LCD_ROTATION LV_DISP_ROT_NONE
+
+/*----------------------------------Draw Buffer Manager Configuration----------------------------------------------------------*/
+// Define whether the draw buffers are sized and placed (internal SRAM or PSRAM) from the free memory at runtime
+// (not available with the PSRAM framebuffer)
+#define EXAMPLE_USE_BUF_MANAGER 1
+// Define the strategy applied at start and on every screen load; DISP_BUF_AUTO re-plans from the free memory
+#define EXAMPLE_BUF_STRATEGY DISP_BUF_AUTO
+// Define the internal RAM left to the rest of the firmware
+#define EXAMPLE_BUF_INTERNAL_RESERVE DISP_BUF_DEFAULT_INTERNAL_RESERVE
+// Define the tallest stripe; taller stripes save draw passes but not bus time
+#define EXAMPLE_BUF_MAX_ROWS EXAMPLE_LVGL_BUF_HEIGHT
+// Define the size of the internal DMA bounce buffer PSRAM stripes are sent from
+#define EXAMPLE_BUF_BOUNCE_BYTES DISP_BUF_DEFAULT_BOUNCE_BYTES
+
+#if EXAMPLE_USE_BUF_MANAGER && !EXAMPLE_USE_PSRAM_FRAMEBUFFER
+// Draw buffer manager handle, screens pick their strategy when they are built
+static disp_buf_handle_t lcd_buf = NULL;
+#endif
+
+/*----------------------------------Frame Trace Configuration----------------------------------------------------------*/
+// Define whether the timer handler, render and flush time, bytes and areas of every frame are recorded
+// (replaces CONFIG_LV_USE_PERF_MONITOR, whose overlay costs redraws itself); a profiling aid, its dump fills the
+// console UART every EXAMPLE_TRACE_DUMP_PERIOD_MS, so set it to 1 only while measuring
+#define EXAMPLE_USE_FRAME_TRACE 0
+// Define the number of frames the ring keeps between two dumps
+#define EXAMPLE_TRACE_RECORDS DISP_TRACE_DEFAULT_RECORDS
+// Define how often the new records are written out, host_sim/trace_report.py turns them into percentiles
+#define EXAMPLE_TRACE_DUMP_PERIOD_MS 10000
+// Define the UART the records are dumped to (the console UART, lines start with "trace,")
+#define EXAMPLE_TRACE_UART_PORT UART_NUM_0
+#define EXAMPLE_TRACE_UART_BAUD_RATE 115200
+// Define the UART TX buffer, so the dump task rarely waits for the wire
+#define EXAMPLE_TRACE_UART_TX_BUFFER (8 * 1024)
+// Define the dump task, below the LVGL task so dumping never delays a frame
+#define EXAMPLE_TRACE_TASK_STACK_SIZE (3 * 1024)
+#define EXAMPLE_TRACE_TASK_PRIORITY 1
+
+#if EXAMPLE_USE_FRAME_TRACE
+// Frame trace handle, the LVGL task brackets its passes with it
+static disp_trace_handle_t lcd_trace = NULL;
+#endif
+
+#if EXAMPLE_USE_TE_SYNC
+// TE scheduler handle, the LVGL task waits on it
+static disp_te_handle_t lcd_te = NULL;
+// Whether the TE edges are on; they are stopped while nothing is invalidated and in AOD
+static bool lcd_te_enabled = true;
+#endif
+
+/*----------------------------------Always-On Display Configuration----------------------------------------------------------*/
+// Define whether the watch drops to a minimal clock face in the SH8601 partial and idle modes when nobody touches it
+#define EXAMPLE_USE_AOD 1
+// Define the time without touch before the always-on face is shown (in milliseconds)
+#define EXAMPLE_AOD_TIMEOUT_MS 30000
+// Define the rows kept lit around the middle of the panel
+#define EXAMPLE_AOD_ROWS DISP_AOD_DEFAULT_ROWS
+// Define the panel brightness (0x51 register) of the always-on face
+#define EXAMPLE_AOD_BRIGHTNESS DISP_AOD_DEFAULT_BRIGHTNESS
+// Define the panel brightness restored when the watch wakes up, as set by lcd_init_cmds
+#define EXAMPLE_AOD_NORMAL_BRIGHTNESS 0xFF
+// Define whether the panel also goes to idle mode (8 colors) in AOD
+#define EXAMPLE_AOD_IDLE_MODE 1
+
+#if EXAMPLE_USE_AOD
+// AOD handle, the LVGL task sleeps on it while the face is shown; the touch interrupt wakes it
+static disp_aod_handle_t lcd_aod = NULL;
+#endif
+
+/*----------------------------------Touch Input Configuration----------------------------------------------------------*/
+// Define whether the touch controller is read when it raises INT, by a task that queues the points for LVGL (0: LVGL polls it every read period)
+#define EXAMPLE_USE_TOUCH_IRQ 1
+// Define the number of touch points that can wait for LVGL
+#define EXAMPLE_TOUCH_QUEUE_DEPTH DISP_TOUCH_DEFAULT_QUEUE_DEPTH
+// Define the stack size of the touch reader task
+#define EXAMPLE_TOUCH_TASK_STACK_SIZE (3 * 1024)
+// Define the priority of the touch reader task, above LVGL so a point is queued as soon as INT fires
+#define EXAMPLE_TOUCH_TASK_PRIORITY (EXAMPLE_LVGL_TASK_PRIORITY + 1)
+// Define the period of the touch statistics log (in milliseconds)
+#define EXAMPLE_TOUCH_STATS_PERIOD_MS 10000
+
+#if EXAMPLE_USE_TOUCH && EXAMPLE_USE_TOUCH_IRQ
+// Touch path handle, LVGL reads its queue
+static disp_touch_handle_t lcd_touch = NULL;
+#endif
+
+/*----------------------------------Parallel Render Configuration----------------------------------------------------------*/
+// Define whether the large blends of a frame are split between the two cores (0: LVGL renders on its own core)
+#define EXAMPLE_USE_PAR_RENDER 1
+// Define the smallest blend split between the cores (in pixels)
+#define EXAMPLE_PAR_MIN_PX DISP_PAR_DEFAULT_MIN_PX
+// Define the stack size of the blend worker task
+#define EXAMPLE_PAR_TASK_STACK_SIZE (3 * 1024)
+// Define the priority of the blend worker task, above LVGL so its half starts as soon as it is handed over
+#define EXAMPLE_PAR_TASK_PRIORITY (EXAMPLE_LVGL_TASK_PRIORITY + 1)
+// Define the cores of the LVGL task and the blend worker
+#define EXAMPLE_PAR_LVGL_CORE 0
+#define EXAMPLE_PAR_WORKER_CORE 1
+// Define the period of the parallel render statistics log (in milliseconds)
+#define EXAMPLE_PAR_STATS_PERIOD_MS 10000
+// Define whether the lv_demo_benchmark scenes run on one core and on two instead of the watch UI (needs CONFIG_LV_USE_DEMO_BENCHMARK,
+// and UI_FONT_SUBSET OFF in main/CMakeLists.txt for the glyphs of its texts)
+#define EXAMPLE_RUN_RENDER_BENCHMARK 0
+
+#if EXAMPLE_USE_PAR_RENDER
+// Blend worker handle
+static disp_par_handle_t lcd_par = NULL;
+#endif
+
+/*----------------------------------UI Update Queue Configuration----------------------------------------------------------*/
+// Define whether other tasks hand widget updates to the LVGL task through a lock-free queue (0: they take the LVGL lock)
+#define EXAMPLE_USE_UI_QUEUE 1
+// Define the number of updates that can wait for the LVGL task
+#define EXAMPLE_UI_QUEUE_DEPTH DISP_UPDATE_DEFAULT_DEPTH
+// Define the period of the UI update queue statistics log (in milliseconds)
+#define EXAMPLE_UI_QUEUE_STATS_PERIOD_MS 10000
+
+#if EXAMPLE_USE_UI_QUEUE
+// UI update queue; sensor tasks post label texts, arc values, chart points and image sources to it without
+// waiting for a render, the LVGL task applies them at the start of its next pass
+static disp_update_handle_t ui_updates = NULL;
+#endif
+
+/*----------------------------------UI Data Model Configuration----------------------------------------------------------*/
+// Define whether the watch face shows the values of a data model the sensor tasks set, through widgets bound to
+// them (0: the texts and arcs stay as SquareLine designed them)
+#define EXAMPLE_USE_UI_MODEL 1
+// Define the period of the clock update (in milliseconds)
+#define EXAMPLE_UI_CLOCK_PERIOD_MS 1000
+// Define the period of the data model statistics log (in milliseconds)
+#define EXAMPLE_UI_MODEL_STATS_PERIOD_MS 10000
+
+#if EXAMPLE_USE_UI_MODEL
+// Data model of the watch face; sensor tasks set its values with disp_model_set without the LVGL lock, the LVGL
+// task pushes the changed ones to the bound widgets at the start of its next pass
+static disp_model_handle_t ui_model = NULL;
+static disp_model_id_t ui_model_time;       // minutes since midnight
+static disp_model_id_t ui_model_date;       // month * 100 + day of the month
+static disp_model_id_t ui_model_steps;
+static disp_model_id_t ui_model_kcal;
+static disp_model_id_t ui_model_heart_rate; // beats per minute
+static disp_model_id_t ui_model_battery;    // percent
+#endif
+
+/*----------------------------------Screen Manager Configuration----------------------------------------------------------*/
+// Define whether screens are built on their first load and the least recently shown ones deleted past a heap budget
+// (0: every screen is built at boot and kept)
+#define EXAMPLE_USE_SCREEN_MANAGER 1
+// Define the heap the built screens may keep, the screen on display is never deleted
+#define EXAMPLE_SCREEN_BUDGET_BYTES DISP_SCREENS_DEFAULT_BUDGET
+// Define the period of the screen statistics log (in milliseconds)
+#define EXAMPLE_SCREEN_STATS_PERIOD_MS 10000
 
-// LVGL area rounding callback function to adjust the drawing area
-void example_lvgl_rounder_cb(struct _lv_disp_drv_t *disp_drv, lv_area_t *area)
+// The SquareLine screens
+static const struct
 {
-    // Get the start and end coordinates of the area
-    uint16_t x1 = area->x1;
-    uint16_t x2 = area->x2;
+    const char *name;
+    lv_obj_t **scr;
+    void (*init)(void);
+} example_screens[] = {
+    {"Screen1", &ui_Screen1, ui_Screen1_screen_init},
+    {"Screen2", &ui_Screen2, ui_Screen2_screen_init},
+    {"Screen3", &ui_Screen3, ui_Screen3_screen_init},
+    {"Screen4", &ui_Screen4, ui_Screen4_screen_init},
+    {"Screen5", &ui_Screen5, ui_Screen5_screen_init},
+    {"Screen6", &ui_Screen6, ui_Screen6_screen_init},
+};
 
-    uint16_t y1 = area->y1;
-    uint16_t y2 = area->y2;
+#if EXAMPLE_USE_SCREEN_MANAGER
+// Screen manager handle, SquareLine builds screens through it
+static disp_screens_handle_t ui_screens = NULL;
+#endif
 
-    // Round down the start coordinates to the nearest even number
-    area->x1 = (x1 >> 1) << 1;
-    area->y1 = (y1 >> 1) << 1;
-    // Round up the end coordinates to the nearest odd number
-    area->x2 = ((x2 >> 1) << 1) + 1;
-    area->y2 = ((y2 >> 1) << 1) + 1;
-}
+/*----------------------------------Screen Transition Configuration----------------------------------------------------------*/
+// Define whether screen changes animate two PSRAM snapshots of the screens instead of redrawing both widget trees
+// every frame (0: lv_scr_load_anim)
+#define EXAMPLE_USE_SNAPSHOT_TRANSITIONS 1
+// Define the period of the transition statistics log (in milliseconds)
+#define EXAMPLE_TRANS_STATS_PERIOD_MS 10000
+
+#if EXAMPLE_USE_SNAPSHOT_TRANSITIONS
+// Snapshot transition handle, SquareLine loads screens through it
+static disp_trans_handle_t ui_trans = NULL;
+#endif
+
+/*----------------------------------Gesture Configuration----------------------------------------------------------*/
+// Define whether swipes are recognized from the touch samples with their velocity, and the screen changes they
+// start follow the finger (0: LVGL's gesture detection after 50 px of travel, then a fixed animation); needs the
+// snapshot transitions
+#define EXAMPLE_USE_GESTURES 1
+// Define the travel that locks the direction of a swipe (in pixels)
+#define EXAMPLE_GESTURE_LOCK_PX DISP_GESTURE_DEFAULT_LOCK_PX
+// Define the finger speed that finishes a screen change without waiting for the release (in pixels per second)
+#define EXAMPLE_GESTURE_EARLY_FLICK_PX_S DISP_GESTURE_DEFAULT_EARLY_FLICK_PX_S
+// Define the period of the gesture statistics log (in milliseconds)
+#define EXAMPLE_GESTURE_STATS_PERIOD_MS 10000
+
+#if EXAMPLE_USE_GESTURES && EXAMPLE_USE_SNAPSHOT_TRANSITIONS && EXAMPLE_USE_TOUCH
+// Gesture recognizer handle, fed by the touch input device; SquareLine loads screens through it
+static disp_gesture_handle_t ui_gesture = NULL;
+#endif
+
+/*----------------------------------Image Configuration----------------------------------------------------------*/
+// Whether the SquareLine images are run-length compressed at build time and decoded row by row while drawing
+// (0: raw RGB565 + A8 arrays); set by UI_COMPRESSED_IMAGES in main/CMakeLists.txt
+#ifdef UI_COMPRESSED_IMAGES
+#define EXAMPLE_USE_COMPRESSED_IMAGES 1
+#else
+#define EXAMPLE_USE_COMPRESSED_IMAGES 0
+#endif
+// Define the PSRAM budget of the decoded image cache (in bytes, 0: decode the rows of every draw)
+#define EXAMPLE_IMG_CACHE_BYTES (320 * 1024)
+// Whether the images of the watch face are decoded at boot and never evicted
+#define EXAMPLE_IMG_PIN_WATCH_FACE 1
+// Define the period of the image decoder statistics log (in milliseconds)
+#define EXAMPLE_IMG_STATS_PERIOD_MS 10000
+// Whether the SquareLine images are read from the asset pack in the "assets" partition, mapped at boot, instead of
+// linked into the app (0: linked); set by UI_ASSET_PARTITION in main/CMakeLists.txt
+#ifdef UI_ASSET_PARTITION
+#define EXAMPLE_USE_ASSET_PARTITION 1
+#else
+#define EXAMPLE_USE_ASSET_PARTITION 0
+#endif
+// Define the label of the partition holding the asset pack
+#define EXAMPLE_ASSET_PARTITION_LABEL DISP_ASSETS_DEFAULT_LABEL
+// Define whether the CRC of the pack is checked at boot, so a pack cut short by an update is not drawn
+#define EXAMPLE_ASSET_VERIFY 1
+
+/*----------------------------------Font Configuration----------------------------------------------------------*/
+// The Montserrat fonts are cut down at build time to the characters the UI shows, see UI_FONT_SUBSET in
+// main/CMakeLists.txt; characters of texts set otherwise go in its ui_font_chars
+// Define whether the glyphs drawn are kept unpacked, one opacity byte per pixel, and blended from there
+// (0: LVGL unpacks every letter it draws)
+#define EXAMPLE_USE_GLYPH_CACHE 1
+// Define the internal RAM budget of the glyph cache (in bytes)
+#define EXAMPLE_GLYPH_CACHE_BYTES DISP_GLYPH_DEFAULT_CACHE_BYTES
+// Define the period of the glyph cache statistics log (in milliseconds)
+#define EXAMPLE_GLYPH_STATS_PERIOD_MS 10000
 
+/*----------------------------------Style Configuration----------------------------------------------------------*/
+// Define whether the properties SquareLine sets on every object, but its x and y, are moved out of the object's
+// local style into shared styles once the screen is built (0: every object keeps all of them)
+#define EXAMPLE_USE_SHARED_STYLES 1
+// Define the most shared styles
+#define EXAMPLE_SHARED_STYLES_MAX DISP_STYLE_DEFAULT_MAX_STYLES
+// Define the passes of style lookups timed over every screen before and after sharing (0: not timed); a
+// profiling aid, the passes walk each screen inside the LVGL lock as it is built, so set it only while measuring
+#define EXAMPLE_STYLE_LOOKUP_ROUNDS 0
+// Define the period of the shared style statistics log (in milliseconds)
+#define EXAMPLE_STYLE_STATS_PERIOD_MS 10000
+
+#if EXAMPLE_USE_SHARED_STYLES
+// Shared style table, filled by the screens as they are built
+static disp_style_handle_t ui_styles = NULL;
+#endif
+
+/*----------------------------------LVGL Function Configuration----------------------------------------------------------*/
 // LVGL touch callback function to read the touch coordinates
 #if EXAMPLE_USE_TOUCH
 static void example_lvgl_touch_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
@@ -237,19 +492,526 @@ static void example_lvgl_touch_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
         // Touch released, update the touch state
         data->state = LV_INDEV_STATE_RELEASED;
     }
+#if EXAMPLE_USE_GESTURES && EXAMPLE_USE_SNAPSHOT_TRANSITIONS
+    // Rotated with the screen, as LVGL will rotate the sample
+    if (ui_gesture)
+    {
+        lv_coord_t lx, ly;
+        disp_rotate_touch_point(drv->disp->driver, data->point.x, data->point.y, &lx, &ly);
+        disp_gesture_feed(ui_gesture, lx, ly, data->state == LV_INDEV_STATE_PRESSED, esp_timer_get_time());
+    }
+#endif
+}
+#endif
+
+#if EXAMPLE_USE_FLUSH_ENGINE && !EXAMPLE_USE_PSRAM_FRAMEBUFFER
+// Flush engine frame callback, logs the render/transfer overlap
+static void example_flush_stats_cb(disp_flush_handle_t engine, const disp_flush_stats_t *frame, void *user_ctx)
+{
+    disp_flush_stats_t total;
+    disp_flush_get_stats(engine, NULL, &total);
+    if (total.frames < EXAMPLE_FLUSH_STATS_PERIOD)
+    {
+        return;
+    }
+    ESP_LOGI(TAG, "flush: %" PRIu32 " frames, avg render %" PRIu64 " us, transfer %" PRIu64 " us, wall %" PRIu64 " us, overlap %" PRIu64 " us",
+             total.frames, total.render_us / total.frames, total.transfer_us / total.frames, total.wall_us / total.frames,
+             total.overlap_us / total.frames);
+    disp_flush_reset_stats(engine);
+}
+#endif
+
+#if EXAMPLE_USE_REGION_PLANNER
+// LVGL timer callback, logs how many areas and SPI transactions the region planner saved
+static void example_region_stats_cb(lv_timer_t *timer)
+{
+    disp_region_stats_t st;
+    disp_region_get_stats((lv_disp_t *)timer->user_data, &st, true);
+    if (st.frames == 0)
+    {
+        return;
+    }
+    ESP_LOGI(TAG, "regions: %" PRIu32 " frames, %" PRIu32 " -> %" PRIu32 " areas (%" PRIu32 " merged, %" PRIu32 " split), %" PRIu64 " -> %" PRIu64 " px, %" PRIu32 " transactions saved",
+             st.frames, st.areas_in, st.areas_out, st.merges, st.splits, st.px_in, st.px_out, st.trans_saved);
 }
 #endif
 
-// Callback function to increase the LVGL tick count
-static void example_increase_lvgl_tick(void *arg)
+#if EXAMPLE_USE_PSRAM_FRAMEBUFFER
+// LVGL timer callback, logs how much of what LVGL redrew actually changed and was sent
+static void example_fb_stats_cb(lv_timer_t *timer)
 {
-    // Tell LVGL that the specified number of milliseconds has passed
-    lv_tick_inc(EXAMPLE_LVGL_TICK_PERIOD_MS);
+    disp_fb_stats_t st;
+    disp_fb_get_stats((disp_fb_handle_t)timer->user_data, &st, true);
+    if (st.frames == 0)
+    {
+        return;
+    }
+    ESP_LOGI(TAG, "fb: %" PRIu32 " frames, %" PRIu64 " px redrawn, %" PRIu64 " px changed, %" PRIu64 " px sent in %" PRIu32 " windows, avg hash %" PRIu64 " us, send %" PRIu64 " us",
+             st.frames, st.px_rendered, st.px_changed, st.px_sent, st.rects, st.hash_us / st.frames, st.send_us / st.frames);
 }
+#endif
+
+#if EXAMPLE_USE_TE_SYNC
+// LVGL timer callback, logs the TE deadlines
+static void example_te_stats_cb(lv_timer_t *timer)
+{
+    disp_te_stats_t st;
+    disp_te_get_stats((disp_te_handle_t)timer->user_data, &st, true);
+    if (st.edges == 0)
+    {
+        return;
+    }
+    ESP_LOGI(TAG, "te: %" PRIu32 " edges, %" PRIu32 " frames, %" PRIu32 " idle, %" PRIu32 " dropped, %" PRIu32 " missed, avg start delay %" PRIu64 " us, max %" PRIu32 " us",
+             st.edges, st.frames, st.idle_edges, st.dropped_edges, st.missed, st.frames ? st.start_delay_us / st.frames : 0,
+             st.max_start_delay_us);
+}
+#endif
+
+#if EXAMPLE_USE_TOUCH && EXAMPLE_USE_TOUCH_IRQ
+// Touch reader callback, a point is waiting: wake the LVGL task up instead of waiting for its next timer
+static void example_touch_sample_cb(void *user_ctx)
+{
+    if (lvgl_task)
+    {
+        xTaskNotifyGive(lvgl_task);
+    }
+}
+
+#if EXAMPLE_USE_GESTURES && EXAMPLE_USE_SNAPSHOT_TRANSITIONS
+// Touch read callback, LVGL is about to see this sample: the gesture recognizer sees it first, with its INT time,
+// rotated with the screen as LVGL will rotate it
+static void example_touch_read_cb(uint16_t x, uint16_t y, bool pressed, int64_t t_us, void *user_ctx)
+{
+    if (ui_gesture)
+    {
+        lv_coord_t lx, ly;
+        disp_rotate_touch_point(lcd_indev->driver->disp->driver, x, y, &lx, &ly);
+        disp_gesture_feed(ui_gesture, lx, ly, pressed, t_us);
+    }
+}
+#endif
+
+// LVGL timer callback, logs the touch path counters
+static void example_touch_stats_cb(lv_timer_t *timer)
+{
+    disp_touch_stats_t st;
+    disp_touch_get_stats((disp_touch_handle_t)timer->user_data, &st, true);
+    if (st.edges == 0 && st.reads == 0)
+    {
+        return;
+    }
+    ESP_LOGI(TAG, "touch: %" PRIu32 " edges, %" PRIu32 " reads (%" PRIu32 " lift timeouts, avg %" PRIu64 " us), %" PRIu32 " samples, %" PRIu32 " dropped, avg latency %" PRIu64 " us, max %" PRIu32 " us, %" PRIu32 " LVGL polls",
+             st.edges, st.reads, st.lift_timeouts, st.reads ? st.read_us / st.reads : 0, st.samples, st.dropped,
+             st.delivered ? st.latency_us / st.delivered : 0, st.max_latency_us, st.lvgl_polls);
+}
+#endif
+
+#if EXAMPLE_USE_PAR_RENDER
+// LVGL timer callback, logs how much of the blending ran on the second core
+static void example_par_stats_cb(lv_timer_t *timer)
+{
+    disp_par_stats_t st;
+    disp_par_get_stats((disp_par_handle_t)timer->user_data, &st, true);
+    if (st.blends == 0)
+    {
+        return;
+    }
+    ESP_LOGI(TAG, "par: %" PRIu32 " blends, %" PRIu32 " split, %" PRIu64 "%% px split, %" PRIu64 " px on core %d in %" PRIu64 " us, join wait %" PRIu64 " us",
+             st.blends, st.split, st.px ? st.split_px * 100 / st.px : 0, st.worker_px, EXAMPLE_PAR_WORKER_CORE,
+             st.worker_us, st.join_wait_us);
+}
+#endif
+
+#if EXAMPLE_USE_GLYPH_CACHE
+// LVGL timer callback, logs how many letters the glyph cache drew
+static void example_glyph_stats_cb(lv_timer_t *timer)
+{
+    disp_glyph_stats_t st;
+    disp_glyph_get_stats((disp_glyph_handle_t)timer->user_data, &st, true);
+    if (st.letters == 0)
+    {
+        return;
+    }
+    ESP_LOGI(TAG, "glyphs: %" PRIu32 " letters, %" PRIu32 " hits, %" PRIu32 " misses, %" PRIu32 " drawn by LVGL, %" PRIu32 " evicted, %u bytes in %" PRIu32 " glyphs",
+             st.letters, st.hits, st.misses, st.fallbacks, st.evictions, (unsigned)st.cached_bytes, st.cached);
+}
+#endif
+
+#if EXAMPLE_USE_UI_QUEUE
+// UI update queue callback, an update is waiting: wake the LVGL task up instead of waiting for its next timer
+static void example_ui_update_post_cb(void *user_ctx)
+{
+    if (lvgl_task)
+    {
+        xTaskNotifyGive(lvgl_task);
+    }
+}
+
+// LVGL timer callback, logs the UI update queue counters
+static void example_ui_update_stats_cb(lv_timer_t *timer)
+{
+    disp_update_stats_t st;
+    disp_update_get_stats((disp_update_handle_t)timer->user_data, &st, true);
+    if (st.posted == 0 && st.dropped == 0)
+    {
+        return;
+    }
+    ESP_LOGI(TAG, "ui queue: %" PRIu32 " posted, %" PRIu32 " dropped, depth %" PRIu32 " (max %" PRIu32 "), %" PRIu32 " batches (max %" PRIu32 "), %" PRIu32 " applied, %" PRIu32 " coalesced, %" PRIu32 " stale, avg apply %" PRIu64 " us",
+             st.posted, st.dropped, st.depth, st.max_depth, st.batches, st.max_batch, st.applied, st.coalesced,
+             st.stale, st.batches ? st.apply_us / st.batches : 0);
+}
+#endif
+
+#if EXAMPLE_USE_UI_MODEL
+// Data model callback, a value changed: wake the LVGL task up instead of waiting for its next timer
+static void example_ui_model_change_cb(void *user_ctx)
+{
+    if (lvgl_task)
+    {
+        xTaskNotifyGive(lvgl_task);
+    }
+}
+
+// Data model formatter, minutes since midnight as "17:23"
+static void example_ui_format_time(int32_t value, char *buf, size_t size, void *user_ctx)
+{
+    snprintf(buf, size, "%" PRId32 ":%02" PRId32, value / 60, value % 60);
+}
+
+// Data model formatter, month * 100 + day as "4/23"
+static void example_ui_format_date(int32_t value, char *buf, size_t size, void *user_ctx)
+{
+    snprintf(buf, size, "%" PRId32 "/%" PRId32, value / 100, value % 100);
+}
+
+// Clock timer callback, in the esp_timer task: the time of day into the data model
+static void example_ui_clock_cb(void *arg)
+{
+    const time_t now = time(NULL);
+    struct tm tm;
+    localtime_r(&now, &tm);
+    disp_model_set(ui_model, ui_model_time, tm.tm_hour * 60 + tm.tm_min);
+    disp_model_set(ui_model, ui_model_date, (tm.tm_mon + 1) * 100 + tm.tm_mday);
+}
+
+// Bind the widgets of a screen just built to the data model
+static void example_ui_model_bind(lv_obj_t *scr)
+{
+    if (scr == ui_Screen1)
+    {
+        ESP_ERROR_CHECK(disp_model_bind_label_cb(ui_model, ui_model_time, ui_Label10, example_ui_format_time, NULL));
+        ESP_ERROR_CHECK(disp_model_bind_label_cb(ui_model, ui_model_date, ui_Label14, example_ui_format_date, NULL));
+        ESP_ERROR_CHECK(disp_model_bind_label(ui_model, ui_model_steps, ui_Label6, "%" PRId32));
+        ESP_ERROR_CHECK(disp_model_bind_value(ui_model, ui_model_steps, ui_Arc7));
+        ESP_ERROR_CHECK(disp_model_bind_label(ui_model, ui_model_kcal, ui_Label13, "%" PRId32));
+        ESP_ERROR_CHECK(disp_model_bind_value(ui_model, ui_model_kcal, ui_Arc3));
+        ESP_ERROR_CHECK(disp_model_bind_label(ui_model, ui_model_heart_rate, ui_Label12, "%" PRId32));
+        ESP_ERROR_CHECK(disp_model_bind_label(ui_model, ui_model_battery, ui_Label11, "%" PRId32 "%%"));
+        ESP_ERROR_CHECK(disp_model_bind_value(ui_model, ui_model_battery, ui_Arc1));
+    }
+    else if (scr == ui_Screen3)
+    {
+        // Battery of the status bar
+        ESP_ERROR_CHECK(disp_model_bind_label(ui_model, ui_model_battery, ui_Label1, "%" PRId32 "%%"));
+        ESP_ERROR_CHECK(disp_model_bind_value(ui_model, ui_model_battery, ui_Bar3));
+    }
+}
+
+// LVGL timer callback, logs the data model counters
+static void example_ui_model_stats_cb(lv_timer_t *timer)
+{
+    disp_model_stats_t st;
+    disp_model_get_stats((disp_model_handle_t)timer->user_data, &st, true);
+    if (st.sets == 0)
+    {
+        return;
+    }
+    ESP_LOGI(TAG, "ui model: %" PRIu32 " sets, %" PRIu32 " coalesced, %" PRIu32 " unchanged, %" PRIu32 " applied in %" PRIu32 " passes (avg %" PRIu64 " us), %" PRIu32 " label updates, %" PRIu32 " texts unchanged, %" PRIu32 " value updates, %" PRIu32 " bindings",
+             st.sets, st.coalesced, st.unchanged, st.applied, st.passes, st.passes ? st.apply_us / st.passes : 0,
+             st.label_updates, st.text_unchanged, st.value_updates, st.bindings);
+}
+#endif
+
+#if EXAMPLE_USE_LOCK_TRACE
+// LVGL timer callback, logs who held the LVGL lock and for how long; runs with the lock held, so its own hold
+// is accounted to the next period
+static void example_lock_stats_cb(lv_timer_t *timer)
+{
+    static disp_lock_stats_t st;
+    disp_lock_get_stats((disp_lock_handle_t)timer->user_data, &st, true);
+    if (st.takes == 0 && st.timeouts == 0)
+    {
+        return;
+    }
+    ESP_LOGI(TAG, "lock: %" PRIu32 " takes, %" PRIu32 " contended, %" PRIu32 " timeouts (last held by %s), %" PRIu32 " over budget, wait %" PRIu64 " us, hold %" PRIu64 " us, longest %" PRIu32 " us by %s",
+             st.takes, st.contended, st.timeouts, st.timeouts ? st.last_timeout_holder : "-", st.over_budget,
+             st.wait_us, st.hold_us, st.max_hold_us, st.max_hold_name);
+    for (size_t i = 0; i < st.holder_count; i++)
+    {
+        const disp_lock_holder_t *h = &st.holders[i];
+        ESP_LOGI(TAG, "lock: %-12s %5" PRIu32 " holds, max %6" PRIu32 " us, avg %5" PRIu64 " us, max wait %6" PRIu32 " us, <1/2/4/8/16/32/64/+ ms %" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32,
+                 h->name, h->holds, h->max_hold_us, h->holds ? h->hold_us / h->holds : 0, h->max_wait_us, h->hist[0],
+                 h->hist[1], h->hist[2], h->hist[3], h->hist[4], h->hist[5], h->hist[6], h->hist[7]);
+    }
+}
+#endif
+
+// A screen was built: share its styles, name it in the frame trace and give it its draw buffer strategy
+static void example_screen_built_cb(lv_obj_t *scr, const char *name, void *user_ctx)
+{
+#if EXAMPLE_USE_SHARED_STYLES
+    ESP_ERROR_CHECK(disp_style_share(ui_styles, scr, name));
+#endif
+#if EXAMPLE_USE_FRAME_TRACE
+    ESP_ERROR_CHECK(disp_trace_set_screen_name(lcd_trace, scr, name));
+#endif
+#if EXAMPLE_USE_BUF_MANAGER && !EXAMPLE_USE_PSRAM_FRAMEBUFFER
+    // Re-plan on every screen load, so RAM freed or taken since then changes the stripes
+    ESP_ERROR_CHECK(disp_buf_set_screen_strategy(lcd_buf, scr, EXAMPLE_BUF_STRATEGY));
+#endif
+#if EXAMPLE_USE_UI_MODEL
+    example_ui_model_bind(scr);
+#endif
+}
+
+#if EXAMPLE_USE_SCREEN_MANAGER
+// LVGL timer callback, logs the heap of the built screens and the cost of building each one
+static void example_screen_stats_cb(lv_timer_t *timer)
+{
+    static disp_screens_stats_t st;
+    disp_screens_get_stats((disp_screens_handle_t)timer->user_data, &st, true);
+    uint32_t loads = 0;
+    for (size_t i = 0; i < st.count; i++)
+    {
+        loads += st.screens[i].loads;
+    }
+    if (loads == 0)
+    {
+        return;
+    }
+    ESP_LOGI(TAG, "screens: %u bytes resident (max %u, budget %u)", (unsigned)st.resident_bytes,
+             (unsigned)st.max_resident_bytes, (unsigned)st.budget_bytes);
+    for (size_t i = 0; i < st.count; i++)
+    {
+        const disp_screens_screen_t *s = &st.screens[i];
+        ESP_LOGI(TAG, "screens: %-8s %-5s %4" PRIu32 " loads, %3" PRIu32 " builds, %3" PRIu32 " evictions, last build %6" PRIu32 " us (max %6" PRIu32 " us), %6u bytes",
+                 s->name, s->built ? "built" : "-", s->loads, s->builds, s->evictions, s->build_us, s->max_build_us,
+                 (unsigned)s->heap_bytes);
+    }
+}
+#endif
+
+#if EXAMPLE_USE_SHARED_STYLES
+// LVGL timer callback, logs the heap the shared styles gave back and, when timed, the style lookups of every
+// screen built
+static void example_style_stats_cb(lv_timer_t *timer)
+{
+    static disp_style_stats_t st;
+    disp_style_get_stats((disp_style_handle_t)timer->user_data, &st, true);
+    uint32_t shares = 0;
+    for (size_t i = 0; i < st.count; i++)
+    {
+        shares += st.screens[i].shares;
+    }
+    if (shares == 0)
+    {
+        return;
+    }
+    ESP_LOGI(TAG, "styles: %u shared (max %u)", (unsigned)st.styles, (unsigned)st.max_styles);
+    for (size_t i = 0; i < st.count; i++)
+    {
+        const disp_style_screen_t *s = &st.screens[i];
+        ESP_LOGI(TAG, "styles: %-8s %3" PRIu32 " shares, %3" PRIu32 " objects, %3" PRIu32 " local styles (%" PRIu32 " reused, %" PRIu32 " added, %" PRIu32 " kept), %5" PRId32 " bytes saved",
+                 s->name, s->shares, s->objects, s->local_styles, s->reused, s->added, s->kept, s->saved_bytes);
+        if (s->lookups)
+        {
+            ESP_LOGI(TAG, "styles: %-8s %5" PRIu32 " lookups %6" PRIu32 " -> %6" PRIu32 " us", s->name, s->lookups,
+                     s->lookup_us_before, s->lookup_us_after);
+        }
+    }
+}
+#endif
+
+#if EXAMPLE_USE_SNAPSHOT_TRANSITIONS
+// LVGL timer callback, logs what the screen transitions cost
+static void example_trans_stats_cb(lv_timer_t *timer)
+{
+    disp_trans_stats_t st;
+    disp_trans_get_stats((disp_trans_handle_t)timer->user_data, &st, true);
+    if (st.transitions == 0 && st.fallbacks == 0)
+    {
+        return;
+    }
+    ESP_LOGI(TAG, "transitions: %" PRIu32 " (%" PRIu32 " cut short, %" PRIu32 " dragged, %" PRIu32 " dragged back), %" PRIu32 " fallbacks, snapshots avg %" PRIu64 " us (max %" PRIu32 " us), %" PRIu32 " frames, %" PRIu64 " fps",
+             st.transitions, st.interrupted, st.drags, st.cancelled, st.fallbacks, st.transitions ? st.snapshot_us / st.transitions : 0,
+             st.max_snapshot_us, st.frames, st.anim_us ? (uint64_t)st.frames * 1000000 / st.anim_us : 0);
+}
+#endif
+
+#if EXAMPLE_USE_GESTURES && EXAMPLE_USE_SNAPSHOT_TRANSITIONS && EXAMPLE_USE_TOUCH
+// LVGL timer callback, logs how swipes were recognized and how the drags ended
+static void example_gesture_stats_cb(lv_timer_t *timer)
+{
+    disp_gesture_stats_t st;
+    disp_gesture_get_stats((disp_gesture_handle_t)timer->user_data, &st, true);
+    if (st.touches == 0)
+    {
+        return;
+    }
+    ESP_LOGI(TAG, "gestures: %" PRIu32 " touches, %" PRIu32 " locks (avg %" PRIu64 " us, max %" PRIu32 " us), %" PRIu32 " sent, %" PRIu32 " drags, %" PRIu32 " flicks, %" PRIu32 " committed, %" PRIu32 " cancelled",
+             st.touches, st.locks, st.locks ? st.lock_us / st.locks : 0, st.max_lock_us, st.gestures, st.drags,
+             st.flicks, st.commits, st.cancels);
+}
+#endif
+
+#if EXAMPLE_USE_COMPRESSED_IMAGES
+#if EXAMPLE_IMG_PIN_WATCH_FACE && EXAMPLE_IMG_CACHE_BYTES
+// Images of Screen1, the watch face, shown most of the time
+static const lv_img_dsc_t *const example_watch_face_images[] = {
+    &ui_img_duoyun_png,
+    &ui_img_heartsmall_png,
+    &ui_img_kaluli_png,
+    &ui_img_shandian_png,
+    &ui_img_zuji_png,
+};
+#endif
+
+// LVGL timer callback, logs how much the compressed images decoded and how the cache served them
+static void example_img_stats_cb(lv_timer_t *timer)
+{
+    disp_img_stats_t st;
+    disp_img_get_stats((disp_img_handle_t)timer->user_data, &st, true);
+    if (st.opens == 0)
+    {
+        return;
+    }
+    ESP_LOGI(TAG, "images: %" PRIu32 " opened, %" PRIu32 " lines, %" PRIu64 " px decoded, %" PRIu32 " errors",
+             st.opens, st.lines, st.px, st.errors);
+    if (EXAMPLE_IMG_CACHE_BYTES)
+    {
+        ESP_LOGI(TAG, "image cache: %" PRIu32 " hits, %" PRIu32 " misses, %" PRIu32 " uncached (%" PRIu32 "%% hit), %" PRIu32 " evicted, %" PRIu64 " B/s decoded at %" PRIu64 " B/ms, %u of %u bytes in %" PRIu32 " images, %u pinned",
+                 st.hits, st.misses, st.uncached, st.hits * 100 / st.opens, st.evictions,
+                 st.decoded_bytes * 1000 / EXAMPLE_IMG_STATS_PERIOD_MS,
+                 st.decode_us ? st.decoded_bytes * 1000 / st.decode_us : 0, (unsigned)st.cached_bytes,
+                 (unsigned)EXAMPLE_IMG_CACHE_BYTES, st.cached, (unsigned)st.pinned_bytes);
+    }
+}
+#endif
+
+#if EXAMPLE_USE_FRAME_TRACE
+// Frame trace writer, one CSV line to the trace UART
+static esp_err_t example_trace_write_uart(const char *line, size_t len, void *user_ctx)
+{
+    return UART_dev_write(EXAMPLE_TRACE_UART_PORT, line, len);
+}
+
+// Frame trace dump task, the ring is lock-free so the LVGL task is never held up
+static void example_trace_dump_task(void *arg)
+{
+    disp_trace_handle_t trace = (disp_trace_handle_t)arg;
+    ESP_ERROR_CHECK(UART_dev_init(EXAMPLE_TRACE_UART_PORT, EXAMPLE_TRACE_UART_BAUD_RATE, EXAMPLE_TRACE_UART_TX_BUFFER));
+    while (1)
+    {
+        vTaskDelay(pdMS_TO_TICKS(EXAMPLE_TRACE_DUMP_PERIOD_MS));
+        disp_trace_dump(trace, example_trace_write_uart, NULL);
+        disp_trace_stats_t st;
+        disp_trace_get_stats(trace, &st);
+        if (st.lost)
+        {
+            ESP_LOGW(TAG, "trace: %" PRIu32 " of %" PRIu32 " frames lost, dump more often", st.lost, st.recorded);
+        }
+    }
+}
+#endif
+
+#if EXAMPLE_USE_TE_SYNC
+// Start or stop the TE edges, from the LVGL task; light sleep is allowed only while they are stopped
+static void example_te_set_enabled(bool enabled)
+{
+    if (enabled == lcd_te_enabled)
+    {
+        return;
+    }
+#if EXAMPLE_USE_LIGHT_SLEEP
+    if (enabled)
+    {
+        esp_pm_lock_acquire(te_pm_lock);
+    }
+#endif
+    ESP_ERROR_CHECK(disp_te_set_enabled(lcd_te, enabled));
+#if EXAMPLE_USE_LIGHT_SLEEP
+    if (!enabled)
+    {
+        esp_pm_lock_release(te_pm_lock);
+    }
+#endif
+    lcd_te_enabled = enabled;
+}
+#endif
+
+#if EXAMPLE_USE_AOD
+// Always-on face text, the wall clock in hours and minutes
+static void example_aod_text_cb(char *buf, size_t len, void *user_ctx)
+{
+    time_t now = time(NULL);
+    struct tm tm;
+    localtime_r(&now, &tm);
+    strftime(buf, len, "%H:%M", &tm);
+}
+
+// Touch interrupt, called from the GPIO ISR: a touch on the always-on face wakes the watch up
+#if EXAMPLE_USE_TOUCH && EXAMPLE_USE_TOUCH_IRQ
+static void example_touch_edge_cb(void *user_ctx)
+{
+    if (lcd_aod)
+    {
+        disp_aod_wake(lcd_aod);
+    }
+}
+#elif EXAMPLE_USE_TOUCH
+static void example_touch_isr_cb(esp_lcd_touch_handle_t tp)
+{
+    if (lcd_aod)
+    {
+        disp_aod_wake(lcd_aod);
+    }
+}
+#endif
+
+// Switch to the always-on face and stop everything that runs at a fixed rate, call with the LVGL lock held
+static void example_aod_enter(void)
+{
+    if (disp_aod_enter(lcd_aod, lv_disp_get_default()) != ESP_OK)
+    {
+        return;
+    }
+    // No LVGL timer runs in AOD, the task waits for the minute update or a touch instead
+#if EXAMPLE_USE_TE_SYNC
+    example_te_set_enabled(false);
+#endif
+}
+
+// Back to the watch face, call with the LVGL lock held
+static void example_aod_exit(void)
+{
+    ESP_ERROR_CHECK(disp_aod_exit(lcd_aod));
+#if EXAMPLE_USE_TOUCH && EXAMPLE_USE_TOUCH_IRQ
+    // The touch that woke the watch up must not also press what is under it on the watch face
+    disp_touch_discard(lcd_touch);
+#endif
+    // The TE edges come back with the first invalidation, in the LVGL task loop
+    lv_disp_trig_activity(NULL);
+}
+#endif
 
 // LVGL lock function
 static bool example_lvgl_lock(int timeout_ms)
 {
+#if EXAMPLE_USE_LOCK_TRACE
+    assert(lvgl_lock && "bsp_display_start must be called first");
+    // Waits in budget-long slices, naming the holder when one expires
+    return disp_lock_take(lvgl_lock, timeout_ms);
+#else
     // Ensure that the LVGL mutex semaphore has been initialized
     assert(lvgl_mux && "bsp_display_start must be called first");
 
@@ -257,47 +1019,190 @@ static bool example_lvgl_lock(int timeout_ms)
     const TickType_t timeout_ticks = (timeout_ms == -1) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
     // Take the mutex semaphore
     return xSemaphoreTake(lvgl_mux, timeout_ticks) == pdTRUE;
+#endif
 }
 
 // LVGL unlock function
 static void example_lvgl_unlock(void)
 {
+#if EXAMPLE_USE_LOCK_TRACE
+    assert(lvgl_lock && "bsp_display_start must be called first");
+    // Accounts the hold to this task, warns when it took longer than the budget
+    disp_lock_give(lvgl_lock);
+#else
     // Ensure that the LVGL mutex semaphore has been initialized
     assert(lvgl_mux && "bsp_display_start must be called first");
     // Give back the mutex semaphore
     xSemaphoreGive(lvgl_mux);
+#endif
+    // Whatever another task changed may make an LVGL timer due before the LVGL task planned to wake up
+    if (lvgl_task && xTaskGetCurrentTaskHandle() != lvgl_task)
+    {
+        xTaskNotifyGive(lvgl_task);
+    }
+}
+
+// Turn what lv_timer_handler returned into a sleep, rounded up so the task does not wake before the timer is due
+static TickType_t example_lvgl_delay_ticks(uint32_t task_delay_ms)
+{
+    if (task_delay_ms == LV_NO_TIMER_READY)
+    {
+        return portMAX_DELAY;
+    }
+    return (TickType_t)(((uint64_t)task_delay_ms * configTICK_RATE_HZ + 999) / 1000);
+}
+
+#if EXAMPLE_USE_LIGHT_SLEEP
+// The LVGL task keeps the CPU at full clock from the moment it wakes up until it blocks again
+static void example_lvgl_pm_idle(bool idle)
+{
+    if (idle)
+    {
+        esp_pm_lock_release(lvgl_pm_lock);
+    }
+    else
+    {
+        esp_pm_lock_acquire(lvgl_pm_lock);
+    }
+}
+#else
+static void example_lvgl_pm_idle(bool idle)
+{
 }
+#endif
 
 // LVGL task function
 static void example_lvgl_port_task(void *arg)
 {
     ESP_LOGI(TAG, "Starting LVGL task");
-    // Initialize the task delay time
-    uint32_t task_delay_ms = EXAMPLE_LVGL_TASK_MAX_DELAY_MS;
+    example_lvgl_pm_idle(false);
     while (1)
     {
+#if EXAMPLE_USE_AOD
+        if (disp_aod_is_active(lcd_aod))
+        {
+            // Only the minute update and a touch wake the task up, no LVGL timer runs in AOD
+            example_lvgl_pm_idle(true);
+            const disp_aod_event_t event = disp_aod_wait(lcd_aod, UINT32_MAX);
+            example_lvgl_pm_idle(false);
+            if (event != DISP_AOD_EVENT_TIMEOUT && example_lvgl_lock(-1))
+            {
+                if (event == DISP_AOD_EVENT_WAKE)
+                {
+                    example_aod_exit();
+                }
+                else
+                {
+                    disp_aod_tick(lcd_aod);
+                }
+                example_lvgl_unlock();
+            }
+            continue;
+        }
+#endif
+        // Time until the next LVGL timer is due, LV_NO_TIMER_READY when none runs
+        uint32_t task_delay_ms = LV_NO_TIMER_READY;
         // Lock the mutex because the LVGL APIs are not thread-safe
         if (example_lvgl_lock(-1))
         {
+#if EXAMPLE_USE_UI_QUEUE
+            // Widget updates of the other tasks first, in one batch, so this pass renders them
+            disp_update_apply(ui_updates);
+#endif
+#if EXAMPLE_USE_UI_MODEL
+            // Values the sensor tasks changed since the last pass, only the widgets that look different are redrawn
+            disp_model_apply(ui_model);
+#endif
+#if EXAMPLE_USE_TOUCH && EXAMPLE_USE_TOUCH_IRQ
+            // Let LVGL read the queued touch points right away
+            disp_touch_process(lcd_touch);
+#endif
+#if EXAMPLE_USE_FRAME_TRACE
+            disp_trace_begin(lcd_trace);
+#endif
             // Handle LVGL timers
             task_delay_ms = lv_timer_handler();
+#if EXAMPLE_USE_FRAME_TRACE
+            disp_trace_end(lcd_trace);
+#endif
+#if EXAMPLE_USE_TE_SYNC
+            // Keep the TE edges only while they have a frame to start
+            example_te_set_enabled(disp_te_frame_pending(lcd_te));
+#endif
+#if EXAMPLE_USE_AOD
+            const uint32_t inactive_ms = lv_disp_get_inactive_time(NULL);
+            if (disp_bench_is_running())
+            {
+                // The benchmark keeps the display busy on its own
+            }
+            else if (inactive_ms > EXAMPLE_AOD_TIMEOUT_MS)
+            {
+                example_aod_enter();
+            }
+            else if (task_delay_ms > EXAMPLE_AOD_TIMEOUT_MS + 1 - inactive_ms)
+            {
+                // No LVGL timer may be due by then, wake up for the timeout anyway
+                task_delay_ms = EXAMPLE_AOD_TIMEOUT_MS + 1 - inactive_ms;
+            }
+#endif
             // Unlock the mutex
             example_lvgl_unlock();
         }
-        // Limit the task delay time between the maximum and minimum values
-        if (task_delay_ms > EXAMPLE_LVGL_TASK_MAX_DELAY_MS)
+#if EXAMPLE_USE_TE_SYNC
+        if (lcd_te_enabled)
         {
-            task_delay_ms = EXAMPLE_LVGL_TASK_MAX_DELAY_MS;
-        }
-        else if (task_delay_ms < EXAMPLE_LVGL_TASK_MIN_DELAY_MS)
-        {
-            task_delay_ms = EXAMPLE_LVGL_TASK_MIN_DELAY_MS;
+            // Sleep until the next TE edge or until another LVGL timer is due, refresh right after the edge
+            example_lvgl_pm_idle(true);
+            const bool edge = disp_te_wait(lcd_te, task_delay_ms);
+            example_lvgl_pm_idle(false);
+            if (edge && example_lvgl_lock(-1))
+            {
+#if EXAMPLE_USE_FRAME_TRACE
+                disp_trace_begin(lcd_trace);
+#endif
+                disp_te_refresh(lcd_te);
+#if EXAMPLE_USE_FRAME_TRACE
+                disp_trace_end(lcd_trace);
+#endif
+                example_lvgl_unlock();
+            }
+            continue;
         }
-        // Task delay
-        vTaskDelay(pdMS_TO_TICKS(task_delay_ms));
+#endif
+        // Sleep until the next LVGL timer is due, a touch point is queued or another task released the LVGL lock
+        example_lvgl_pm_idle(true);
+        ulTaskNotifyTake(pdTRUE, example_lvgl_delay_ticks(task_delay_ms));
+        example_lvgl_pm_idle(false);
     }
 }
 
+#if EXAMPLE_USE_LIGHT_SLEEP
+// Scale the CPU clock with the PM locks and let the idle task light-sleep until the next FreeRTOS or esp_timer event
+static void example_pm_init(void)
+{
+    ESP_LOGI(TAG, "Enable automatic light sleep");
+    const esp_pm_config_t pm_config = {
+        .max_freq_mhz = EXAMPLE_PM_MAX_CPU_FREQ_MHZ,
+        .min_freq_mhz = EXAMPLE_PM_MIN_CPU_FREQ_MHZ,
+        .light_sleep_enable = true,
+    };
+    ESP_ERROR_CHECK(esp_pm_configure(&pm_config));
+    ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "lvgl", &lvgl_pm_lock));
+    ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "te", &te_pm_lock));
+#if EXAMPLE_USE_TE_SYNC
+    // The TE edges start enabled
+    ESP_ERROR_CHECK(esp_pm_lock_acquire(te_pm_lock));
+#endif
+#if EXAMPLE_USE_TOUCH
+    // A touch has to wake the chip up; digital GPIOs wake it on a level only, so INT (active low, pulsed once per
+    // report) interrupts on the low level from now on. disp_touch masks the interrupt from the first one until its
+    // reader task has read the report and the controller released INT, so a held level does not refire
+    ESP_ERROR_CHECK(gpio_wakeup_enable(EXAMPLE_PIN_NUM_TOUCH_INT, GPIO_INTR_LOW_LEVEL));
+    ESP_ERROR_CHECK(esp_sleep_enable_gpio_wakeup());
+#endif
+}
+#endif
+
 static void lv_lcdtouch_init(void)
 {
     esp_log_level_set("lcd_panel.io.i2c", ESP_LOG_NONE);
@@ -402,6 +1307,9 @@ static void lv_lcdtouch_init(void)
             .mirror_x = 0,
             .mirror_y = 0,
         },
+#if EXAMPLE_USE_AOD && !EXAMPLE_USE_TOUCH_IRQ
+        .interrupt_callback = example_touch_isr_cb,
+#endif
     };
 
     ESP_LOGI(TAG, "Initialize touch controller");
@@ -416,6 +1324,12 @@ static void lv_lcdtouch_init(void)
     //LVGL init
     ESP_LOGI(TAG, "Initialize LVGL library");
     lv_init();
+#if EXAMPLE_USE_PSRAM_FRAMEBUFFER
+    // alloc one full-screen framebuffer in PSRAM, LVGL draws straight into it
+    lv_color_t *buf1 = heap_caps_malloc(EXAMPLE_LCD_H_RES * EXAMPLE_LCD_V_RES * sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
+    assert(buf1);
+    lv_disp_draw_buf_init(&disp_buf, buf1, NULL, EXAMPLE_LCD_H_RES * EXAMPLE_LCD_V_RES);
+#elif !EXAMPLE_USE_BUF_MANAGER
     // alloc draw buffers used by LVGL
     // it's recommended to choose the size of the draw buffer(s) to be at least 1/10 screen sized
     lv_color_t *buf1 = heap_caps_malloc(EXAMPLE_LCD_H_RES * EXAMPLE_LVGL_BUF_HEIGHT * sizeof(lv_color_t), MALLOC_CAP_DMA);
@@ -424,6 +1338,7 @@ static void lv_lcdtouch_init(void)
     assert(buf2);
     // initialize LVGL draw buffers
     lv_disp_draw_buf_init(&disp_buf, buf1, buf2, EXAMPLE_LCD_H_RES * EXAMPLE_LVGL_BUF_HEIGHT);
+#endif
 
     //LVGL LCD drive init
 #if EXAMPLE_USE_LCD
@@ -433,21 +1348,139 @@ static void lv_lcdtouch_init(void)
     disp_drv.ver_res = EXAMPLE_LCD_V_RES;
     disp_drv.flush_cb = example_lvgl_flush_cb;
     disp_drv.rounder_cb = example_lvgl_rounder_cb;
-    disp_drv.drv_update_cb = example_lvgl_update_cb;
     disp_drv.draw_buf = &disp_buf;
     disp_drv.user_data = panel_handle;
+#if EXAMPLE_USE_PSRAM_FRAMEBUFFER
+    // Draw in place at screen coordinates, then send only the segments whose hash changed since the last frame
+    ESP_LOGI(TAG, "Install PSRAM framebuffer");
+    disp_fb_handle_t fb = NULL;
+    const disp_fb_config_t fb_config = {
+        .panel = panel_handle,
+        .io = io_handle,
+        .bounce_bytes = EXAMPLE_FB_BOUNCE_BYTES,
+    };
+    disp_drv.direct_mode = 1;
+    ESP_ERROR_CHECK(disp_fb_new(&fb_config, &fb));
+    ESP_ERROR_CHECK(disp_fb_attach(fb, &disp_drv));
+#elif EXAMPLE_USE_FLUSH_ENGINE
+    // Split areas into DMA-sized sub-transfers so LVGL renders the next area while the bus sends this one
+    ESP_LOGI(TAG, "Install flush engine");
+    disp_flush_handle_t flush_engine = NULL;
+    const disp_flush_config_t flush_config = {
+        .panel = panel_handle,
+        .io = io_handle,
+        .chunk_bytes = EXAMPLE_FLUSH_CHUNK_BYTES,
+        .serialized = EXAMPLE_FLUSH_ENGINE_SERIALIZED,
+        .task_stack = EXAMPLE_FLUSH_TASK_STACK_SIZE,
+        .task_priority = EXAMPLE_FLUSH_TASK_PRIORITY,
+        .task_core = tskNO_AFFINITY,
+        .on_frame = example_flush_stats_cb,
+    };
+    ESP_ERROR_CHECK(disp_flush_new(&flush_config, &flush_engine));
+    ESP_ERROR_CHECK(disp_flush_attach(flush_engine, &disp_drv));
+#endif
+#if EXAMPLE_USE_BUF_MANAGER && !EXAMPLE_USE_PSRAM_FRAMEBUFFER
+    // Double internal stripes when they fit, else PSRAM stripes sent through a bounce buffer, else one stripe
+    ESP_LOGI(TAG, "Install draw buffer manager");
+    const disp_buf_config_t buf_config = {
+        .panel = panel_handle,
+#if EXAMPLE_USE_FLUSH_ENGINE
+        .engine = flush_engine,
+#endif
+        .internal_reserve = EXAMPLE_BUF_INTERNAL_RESERVE,
+        .max_rows = EXAMPLE_BUF_MAX_ROWS,
+        .bounce_bytes = EXAMPLE_BUF_BOUNCE_BYTES,
+    };
+    ESP_ERROR_CHECK(disp_buf_new(&buf_config, &lcd_buf));
+    ESP_ERROR_CHECK(disp_buf_attach(lcd_buf, &disp_drv, EXAMPLE_BUF_STRATEGY));
+#endif
+#if EXAMPLE_USE_SW_ROTATION && !EXAMPLE_USE_PSRAM_FRAMEBUFFER
+    // Turn rotated areas band by band into bounce buffers; LVGL maps the touch points with the same transform
+    ESP_LOGI(TAG, "Install rotation stage");
+    disp_rotate_handle_t rotate = NULL;
+    const disp_rotate_config_t rotate_config = {
+        .panel = panel_handle,
+        .bounce_bytes = EXAMPLE_ROTATE_BOUNCE_BYTES,
+#if EXAMPLE_USE_FLUSH_ENGINE
+        .engine = flush_engine,
+#endif
+    };
+    ESP_ERROR_CHECK(disp_rotate_new(&rotate_config, &rotate));
+    ESP_ERROR_CHECK(disp_rotate_attach(rotate, &disp_drv));
+#endif
+#if EXAMPLE_USE_FRAME_TRACE
+    // Outermost stage, so the flush time covers everything the stages above do in the LVGL task
+    ESP_LOGI(TAG, "Install frame trace");
+    const disp_trace_config_t trace_config = {
+        .records = EXAMPLE_TRACE_RECORDS,
+    };
+    ESP_ERROR_CHECK(disp_trace_new(&trace_config, &lcd_trace));
+    ESP_ERROR_CHECK(disp_trace_attach(lcd_trace, &disp_drv));
+#endif
     lv_disp_t *disp = lv_disp_drv_register(&disp_drv);
+#if EXAMPLE_USE_SW_ROTATION && !EXAMPLE_USE_PSRAM_FRAMEBUFFER
+    lv_disp_set_rotation(disp, EXAMPLE_LCD_ROTATION);
+#endif
+#if EXAMPLE_USE_REGION_PLANNER
+    // Merge or split LVGL's invalid areas by comparing the per-area QSPI preamble with the extra pixels
+    ESP_ERROR_CHECK(disp_region_attach(disp, NULL));
+    lv_timer_create(example_region_stats_cb, EXAMPLE_REGION_STATS_PERIOD_MS, disp);
+#endif
+#if EXAMPLE_USE_PSRAM_FRAMEBUFFER
+    lv_timer_create(example_fb_stats_cb, EXAMPLE_FB_STATS_PERIOD_MS, fb);
+#endif
+#if EXAMPLE_USE_TE_SYNC
+    // Start refreshes on the TE edge so the RAMWR stream follows the scan line, after the planner wrapped the timer
+    ESP_LOGI(TAG, "Install TE scheduler");
+    const disp_te_config_t te_config = {
+        .source = DISP_TE_SOURCE_GPIO,
+        .te_gpio = EXAMPLE_PIN_NUM_LCD_TE,
+    };
+    ESP_ERROR_CHECK(disp_te_new(&te_config, &lcd_te));
+    ESP_ERROR_CHECK(disp_te_attach(lcd_te, disp));
+    lv_timer_create(example_te_stats_cb, EXAMPLE_TE_STATS_PERIOD_MS, lcd_te);
+#endif
+#if EXAMPLE_USE_PAR_RENDER
+    // Blend the bottom half of every large fill and image on the other core while LVGL blends the top half
+    ESP_LOGI(TAG, "Install parallel blend");
+    const disp_par_config_t par_config = {
+        .min_px = EXAMPLE_PAR_MIN_PX,
+        .task_stack = EXAMPLE_PAR_TASK_STACK_SIZE,
+        .task_priority = EXAMPLE_PAR_TASK_PRIORITY,
+        .task_core = EXAMPLE_PAR_WORKER_CORE,
+    };
+    ESP_ERROR_CHECK(disp_par_new(&par_config, &lcd_par));
+    ESP_ERROR_CHECK(disp_par_attach(lcd_par, disp));
+    lv_timer_create(example_par_stats_cb, EXAMPLE_PAR_STATS_PERIOD_MS, lcd_par);
+#endif
+#if EXAMPLE_USE_GLYPH_CACHE
+    // Draw the letters from unpacked glyphs instead of unpacking every letter of every frame
+    ESP_LOGI(TAG, "Install glyph cache");
+    const disp_glyph_config_t glyph_config = {
+        .cache_bytes = EXAMPLE_GLYPH_CACHE_BYTES,
+    };
+    disp_glyph_handle_t lcd_glyph = NULL;
+    ESP_ERROR_CHECK(disp_glyph_new(&glyph_config, &lcd_glyph));
+    ESP_ERROR_CHECK(disp_glyph_attach(lcd_glyph, disp));
+    lv_timer_create(example_glyph_stats_cb, EXAMPLE_GLYPH_STATS_PERIOD_MS, lcd_glyph);
+#endif
+#if EXAMPLE_USE_AOD
+    // Minimal face in a band of rows, the rest of the panel is switched off by partial mode
+    ESP_LOGI(TAG, "Install always-on display");
+    const disp_aod_config_t aod_config = {
+        .io = io_handle,
+#if EXAMPLE_USE_FLUSH_ENGINE && !EXAMPLE_USE_PSRAM_FRAMEBUFFER
+        .engine = flush_engine,
+#endif
+        .rows = EXAMPLE_AOD_ROWS,
+        .brightness = EXAMPLE_AOD_BRIGHTNESS,
+        .normal_brightness = EXAMPLE_AOD_NORMAL_BRIGHTNESS,
+        .idle_mode = EXAMPLE_AOD_IDLE_MODE,
+        .text_cb = example_aod_text_cb,
+    };
+    ESP_ERROR_CHECK(disp_aod_new(&aod_config, &lcd_aod));
+#endif
 #endif
-
-    //LVGL tomer init
-    ESP_LOGI(TAG, "Install LVGL tick timer");
-    // Tick interface for LVGL (using esp_timer to generate 2ms periodic event)
-    const esp_timer_create_args_t lvgl_tick_timer_args = {
-        .callback = &example_increase_lvgl_tick,
-        .name = "lvgl_tick"};
-    esp_timer_handle_t lvgl_tick_timer = NULL;
-    ESP_ERROR_CHECK(esp_timer_create(&lvgl_tick_timer_args, &lvgl_tick_timer));
-    ESP_ERROR_CHECK(esp_timer_start_periodic(lvgl_tick_timer, EXAMPLE_LVGL_TICK_PERIOD_MS * 1000));
 
     //LVGL touch drive init
 #if EXAMPLE_USE_TOUCH
@@ -457,21 +1490,208 @@ static void lv_lcdtouch_init(void)
     indev_drv.disp = disp;
     indev_drv.read_cb = example_lvgl_touch_cb;
     indev_drv.user_data = tp;
-    lv_indev_drv_register(&indev_drv);
+    lcd_indev = lv_indev_drv_register(&indev_drv);
+#if EXAMPLE_USE_TOUCH_IRQ
+    // Read the controller only when it raises INT; LVGL stops polling while nothing touches the screen
+    ESP_LOGI(TAG, "Install interrupt-driven touch input");
+    const disp_touch_config_t touch_config = {
+        .tp = tp,
+        .queue_depth = EXAMPLE_TOUCH_QUEUE_DEPTH,
+        .task_stack = EXAMPLE_TOUCH_TASK_STACK_SIZE,
+        .task_priority = EXAMPLE_TOUCH_TASK_PRIORITY,
+        .task_core = tskNO_AFFINITY,
+#if EXAMPLE_USE_AOD
+        .on_edge = example_touch_edge_cb,
+#endif
+        .on_sample = example_touch_sample_cb,
+#if EXAMPLE_USE_GESTURES && EXAMPLE_USE_SNAPSHOT_TRANSITIONS
+        .on_read = example_touch_read_cb,
+#endif
+    };
+    ESP_ERROR_CHECK(disp_touch_new(&touch_config, &lcd_touch));
+    ESP_ERROR_CHECK(disp_touch_attach(lcd_touch, lcd_indev));
+    lv_timer_create(example_touch_stats_cb, EXAMPLE_TOUCH_STATS_PERIOD_MS, lcd_touch);
+#endif
 #endif
 }
 
 void app_main(void)
 {
     lv_lcdtouch_init();
+#if EXAMPLE_USE_LOCK_TRACE
+    const disp_lock_config_t lock_config = {
+        .budget_us = EXAMPLE_LOCK_BUDGET_US,
+    };
+    ESP_ERROR_CHECK(disp_lock_new(&lock_config, &lvgl_lock));
+    lv_timer_create(example_lock_stats_cb, EXAMPLE_LOCK_STATS_PERIOD_MS, lvgl_lock);
+#else
     lvgl_mux = xSemaphoreCreateMutex();
     assert(lvgl_mux);
-    xTaskCreate(example_lvgl_port_task, "LVGL", EXAMPLE_LVGL_TASK_STACK_SIZE, NULL, EXAMPLE_LVGL_TASK_PRIORITY, NULL);
+#endif
+#if EXAMPLE_USE_UI_QUEUE
+    ESP_LOGI(TAG, "Install UI update queue");
+    const disp_update_config_t update_config = {
+        .depth = EXAMPLE_UI_QUEUE_DEPTH,
+        .on_post = example_ui_update_post_cb,
+    };
+    ESP_ERROR_CHECK(disp_update_new(&update_config, &ui_updates));
+    lv_timer_create(example_ui_update_stats_cb, EXAMPLE_UI_QUEUE_STATS_PERIOD_MS, ui_updates);
+#endif
+#if EXAMPLE_USE_UI_MODEL
+    ESP_LOGI(TAG, "Install UI data model");
+    const disp_model_config_t model_config = {
+        .on_change = example_ui_model_change_cb,
+    };
+    ESP_ERROR_CHECK(disp_model_new(&model_config, &ui_model));
+    // Until the sensors report, the values SquareLine was designed with
+    ESP_ERROR_CHECK(disp_model_add(ui_model, "time", 17 * 60 + 23, &ui_model_time));
+    ESP_ERROR_CHECK(disp_model_add(ui_model, "date", 4 * 100 + 23, &ui_model_date));
+    ESP_ERROR_CHECK(disp_model_add(ui_model, "steps", 6750, &ui_model_steps));
+    ESP_ERROR_CHECK(disp_model_add(ui_model, "kcal", 800, &ui_model_kcal));
+    ESP_ERROR_CHECK(disp_model_add(ui_model, "heart rate", 80, &ui_model_heart_rate));
+    ESP_ERROR_CHECK(disp_model_add(ui_model, "battery", 45, &ui_model_battery));
+    lv_timer_create(example_ui_model_stats_cb, EXAMPLE_UI_MODEL_STATS_PERIOD_MS, ui_model);
+    const esp_timer_create_args_t clock_timer_args = {
+        .callback = example_ui_clock_cb,
+        .name = "ui_clock",
+    };
+    esp_timer_handle_t clock_timer = NULL;
+    ESP_ERROR_CHECK(esp_timer_create(&clock_timer_args, &clock_timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(clock_timer, EXAMPLE_UI_CLOCK_PERIOD_MS * 1000));
+#endif
+#if EXAMPLE_USE_LIGHT_SLEEP
+    example_pm_init();
+#endif
+#if EXAMPLE_USE_PAR_RENDER
+    // Keep LVGL off the worker's core, so the two halves of a blend really run side by side
+    xTaskCreatePinnedToCore(example_lvgl_port_task, "LVGL", EXAMPLE_LVGL_TASK_STACK_SIZE, NULL, EXAMPLE_LVGL_TASK_PRIORITY,
+                            &lvgl_task, EXAMPLE_PAR_LVGL_CORE);
+#else
+    xTaskCreate(example_lvgl_port_task, "LVGL", EXAMPLE_LVGL_TASK_STACK_SIZE, NULL, EXAMPLE_LVGL_TASK_PRIORITY, &lvgl_task);
+#endif
 
     // Lock the mutex due to the LVGL APIs are not thread-safe
     if (example_lvgl_lock(-1))
     {
+#if EXAMPLE_RUN_RENDER_BENCHMARK
+        const disp_bench_config_t bench_config = {
+#if EXAMPLE_USE_PAR_RENDER
+            .par = lcd_par,
+#endif
+        };
+        ESP_ERROR_CHECK(disp_bench_start(&bench_config, lv_disp_get_default()));
+        example_lvgl_unlock();
+        return;
+#endif
+#if EXAMPLE_USE_SNAPSHOT_TRANSITIONS
+        const disp_trans_config_t trans_config = {
+            .caps = MALLOC_CAP_SPIRAM,
+        };
+        ESP_ERROR_CHECK(disp_trans_new(&trans_config, lv_disp_get_default(), &ui_trans));
+        _ui_screen_set_load_cb(disp_trans_load, ui_trans);
+        lv_timer_create(example_trans_stats_cb, EXAMPLE_TRANS_STATS_PERIOD_MS, ui_trans);
+#endif
+#if EXAMPLE_USE_GESTURES && EXAMPLE_USE_SNAPSHOT_TRANSITIONS && EXAMPLE_USE_TOUCH
+        const disp_gesture_config_t gesture_config = {
+            .trans = ui_trans,
+            .lock_px = EXAMPLE_GESTURE_LOCK_PX,
+            .early_flick_px_s = EXAMPLE_GESTURE_EARLY_FLICK_PX_S,
+        };
+        ESP_ERROR_CHECK(disp_gesture_new(&gesture_config, &ui_gesture));
+        ESP_ERROR_CHECK(disp_gesture_attach(ui_gesture, lcd_indev));
+        // Screen changes asked for by a gesture follow the finger, the others go to disp_trans_load
+        _ui_screen_set_load_cb(disp_gesture_load, ui_gesture);
+        lv_timer_create(example_gesture_stats_cb, EXAMPLE_GESTURE_STATS_PERIOD_MS, ui_gesture);
+#endif
+#if EXAMPLE_USE_ASSET_PARTITION
+        const disp_assets_config_t assets_config = {
+            .label = EXAMPLE_ASSET_PARTITION_LABEL,
+            .images = ui_assets,
+            .count = UI_ASSET_COUNT,
+            .ids_hash = UI_ASSETS_HASH,
+            .verify = EXAMPLE_ASSET_VERIFY,
+        };
+        // The images must point at the pack before the screens use them; without a pack they draw nothing
+        disp_assets_handle_t ui_asset_pack = NULL;
+        if (disp_assets_new(&assets_config, &ui_asset_pack) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "UI images unavailable, write the asset pack with idf.py assets-flash");
+        }
+#endif
+#if EXAMPLE_USE_COMPRESSED_IMAGES
+        // Before any screen sets an image source, LVGL reads the image header through the decoder
+        const disp_img_config_t img_config = {
+            .cache_bytes = EXAMPLE_IMG_CACHE_BYTES,
+            .cache_caps = MALLOC_CAP_SPIRAM,
+        };
+        disp_img_handle_t ui_img = NULL;
+        ESP_ERROR_CHECK(disp_img_new(&img_config, &ui_img));
+#if EXAMPLE_IMG_PIN_WATCH_FACE && EXAMPLE_IMG_CACHE_BYTES
+        for (size_t i = 0; i < sizeof(example_watch_face_images) / sizeof(example_watch_face_images[0]); i++)
+        {
+            // Drawn line by line if it fails, e.g. without a pack in the asset partition
+            if (disp_img_pin(ui_img, example_watch_face_images[i]) != ESP_OK)
+            {
+                ESP_LOGW(TAG, "watch face image %u not pinned", (unsigned)i);
+            }
+        }
+#endif
+        lv_timer_create(example_img_stats_cb, EXAMPLE_IMG_STATS_PERIOD_MS, ui_img);
+#if EXAMPLE_USE_FRAME_TRACE
+        // Hits, misses and decoded bytes per frame, next to the frame times they cost
+        ESP_ERROR_CHECK(disp_trace_set_images(lcd_trace, ui_img));
+#endif
+#endif
+#if EXAMPLE_USE_SHARED_STYLES
+        const disp_style_config_t style_config = {
+            .max_styles = EXAMPLE_SHARED_STYLES_MAX,
+            .lookup_rounds = EXAMPLE_STYLE_LOOKUP_ROUNDS,
+        };
+        ESP_ERROR_CHECK(disp_style_new(&style_config, &ui_styles));
+        lv_timer_create(example_style_stats_cb, EXAMPLE_STYLE_STATS_PERIOD_MS, ui_styles);
+#endif
+        const size_t ui_heap_before = esp_get_free_heap_size();
+        const int64_t ui_start_us = esp_timer_get_time();
+#if EXAMPLE_USE_SCREEN_MANAGER
+        const disp_screens_config_t screens_config = {
+            .budget_bytes = EXAMPLE_SCREEN_BUDGET_BYTES,
+            .on_build = example_screen_built_cb,
+        };
+        ESP_ERROR_CHECK(disp_screens_new(&screens_config, &ui_screens));
+        for (size_t i = 0; i < sizeof(example_screens) / sizeof(example_screens[0]); i++)
+        {
+            ESP_ERROR_CHECK(disp_screens_add(ui_screens, example_screens[i].name, example_screens[i].scr));
+        }
+        _ui_screen_set_build_cb(disp_screens_build, ui_screens);
+        lv_timer_create(example_screen_stats_cb, EXAMPLE_SCREEN_STATS_PERIOD_MS, ui_screens);
         ui_init();
+#else
+        ui_init();
+        for (size_t i = 0; i < sizeof(example_screens) / sizeof(example_screens[0]); i++)
+        {
+            _ui_screen_build(example_screens[i].scr, example_screens[i].init);
+            example_screen_built_cb(*example_screens[i].scr, example_screens[i].name, NULL);
+        }
+#endif
+        ESP_LOGI(TAG, "UI built in %" PRId64 " us, %u bytes of heap", esp_timer_get_time() - ui_start_us,
+                 (unsigned)(ui_heap_before - esp_get_free_heap_size()));
+#if EXAMPLE_USE_FRAME_TRACE
+#if EXAMPLE_USE_AOD
+        disp_trace_set_screen_name(lcd_trace, disp_aod_get_screen(lcd_aod), "AOD");
+#endif
+#if EXAMPLE_USE_SNAPSHOT_TRANSITIONS
+        disp_trace_set_screen_name(lcd_trace, disp_trans_get_screen(ui_trans), "Transition");
+#endif
+        xTaskCreate(example_trace_dump_task, "trace", EXAMPLE_TRACE_TASK_STACK_SIZE, lcd_trace,
+                    EXAMPLE_TRACE_TASK_PRIORITY, NULL);
+#endif
+#if EXAMPLE_USE_BUF_MANAGER && !EXAMPLE_USE_PSRAM_FRAMEBUFFER
+        disp_buf_info_t buf_info;
+        disp_buf_get_info(lcd_buf, &buf_info);
+        ESP_LOGI(TAG, "Draw buffers: %s, %d rows, %u bytes internal, %u bytes PSRAM",
+                 disp_buf_strategy_name(buf_info.strategy), buf_info.rows,
+                 (unsigned)buf_info.internal_bytes, (unsigned)buf_info.psram_bytes);
+#endif
         // Release the mutex
         example_lvgl_unlock();
     }
@@ -49,18 +49,43 @@ void _ui_slider_set_property(lv_obj_t * target, int id, int val)
 }
 
 
+static _ui_screen_build_cb_t _ui_screen_build_cb;
+static void * _ui_screen_build_user_data;
+
+void _ui_screen_set_build_cb(_ui_screen_build_cb_t cb, void * user_data)
+{
+    _ui_screen_build_cb = cb;
+    _ui_screen_build_user_data = user_data;
+}
+
+void _ui_screen_build(lv_obj_t ** target, void (*target_init)(void))
+{
+    if(*target != NULL) return;
+    if(_ui_screen_build_cb) _ui_screen_build_cb(target, target_init, _ui_screen_build_user_data);
+    else target_init();
+}
+
+static _ui_screen_load_cb_t _ui_screen_load_cb;
+static void * _ui_screen_load_user_data;
+
+void _ui_screen_set_load_cb(_ui_screen_load_cb_t cb, void * user_data)
+{
+    _ui_screen_load_cb = cb;
+    _ui_screen_load_user_data = user_data;
+}
+
 void _ui_screen_change(lv_obj_t ** target, lv_scr_load_anim_t fademode, int spd, int delay, void (*target_init)(void))
 {
-    if(*target == NULL)
-        target_init();
-    lv_scr_load_anim(*target, fademode, spd, delay, false);
+    _ui_screen_build(target, target_init);
+    if(_ui_screen_load_cb) _ui_screen_load_cb(*target, fademode, spd, delay, _ui_screen_load_user_data);
+    else lv_scr_load_anim(*target, fademode, spd, delay, false);
 }
 
 void _ui_screen_delete(lv_obj_t ** target)
 {
-    if(*target == NULL) {
+    if(*target != NULL) {
         lv_obj_del(*target);
-        target = NULL;
+        *target = NULL;
     }
 }
 
@@ -40,6 +40,17 @@ void _ui_roller_set_property(lv_obj_t * target, int id, int val);
 #define _UI_SLIDER_PROPERTY_VALUE_WITH_ANIM 1
 void _ui_slider_set_property(lv_obj_t * target, int id, int val);
 
+// Builds a screen in place of its init function, e.g. to account the time and heap it takes
+typedef void (*_ui_screen_build_cb_t)(lv_obj_t ** target, void (*target_init)(void), void * user_data);
+void _ui_screen_set_build_cb(_ui_screen_build_cb_t cb, void * user_data);
+
+// Build the screen if it does not exist, screens are built on their first load
+void _ui_screen_build(lv_obj_t ** target, void (*target_init)(void));
+
+// Loads a screen in place of lv_scr_load_anim, e.g. to animate the change differently
+typedef void (*_ui_screen_load_cb_t)(lv_obj_t * scr, lv_scr_load_anim_t fademode, int spd, int delay, void * user_data);
+void _ui_screen_set_load_cb(_ui_screen_load_cb_t cb, void * user_data);
+
 void _ui_screen_change(lv_obj_t ** target, lv_scr_load_anim_t fademode, int spd, int delay, void (*target_init)(void));
 
 void _ui_screen_delete(lv_obj_t ** target);
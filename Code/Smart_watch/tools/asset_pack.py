@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""Pack the SquareLine images into one blob for the assets partition, served by main/display/disp_assets.c.
+
+Reads the ui_img_*.c files SquareLine exports and writes the pack, plus a C source and header that define the
+image symbols ui.h declares as empty descriptors and number them. disp_assets_new maps the partition and points
+every descriptor at its pixels in flash. The pixels leave the app binary: after an art change only the pack is
+rebuilt and flashed (idf.py assets-flash), or written to the partition over the air. Adding, removing or renaming
+an image changes the IDs and needs the app rebuilt too; the pack carries a hash of the names to catch that.
+
+    python3 tools/asset_pack.py -o assets.bin --source ui_assets.c --header ui_assets.h main/ui/images/*.c
+    python3 tools/asset_pack.py --compress --report -o /tmp/assets.bin main/ui/images/*.c
+
+Pack layout, little endian (see disp_assets.h):
+    u32 magic "DAPK", u16 version, u16 images, u32 name hash, u32 pack size, u32 CRC-32 of the bytes after
+        the header, u32 offset of the names, 8 reserved bytes
+    one 16-byte entry per image, in ID order: u32 offset, u32 size, u16 width, u16 height, u8 LVGL color
+        format, u8 reserved, u16 offset of the name in the names
+    names, NUL terminated
+    image data, each at a multiple of --align from the start of the pack
+With --compress, images tools/img_conv.py can encode are stored in its format (LV_IMG_CF_USER_ENCODED_0).
+"""
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+# Keep the source tree free of __pycache__, the firmware build runs this from it
+sys.dont_write_bytecode = True
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import img_conv  # noqa: E402
+
+MAGIC = 0x4B504144  # "DAPK"
+VERSION = 1
+HEADER_SIZE = 32
+ENTRY_SIZE = 16
+
+# lv_img_cf_t values of LVGL 8
+COLOR_FORMATS = {
+    "LV_IMG_CF_TRUE_COLOR": 4,
+    "LV_IMG_CF_TRUE_COLOR_ALPHA": 5,
+    "LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED": 6,
+    "LV_IMG_CF_USER_ENCODED_0": 30,
+}
+
+
+def names_hash(names):
+    """Hash of the image names in ID order, the same in the pack and in ui_assets.h."""
+    return zlib.crc32("\n".join(names).encode())
+
+
+def enum_name(name):
+    return "UI_ASSET_" + re.sub(r"^ui_img_", "", name).upper()
+
+
+def build_pack(images, align):
+    names = b""
+    name_offsets = []
+    for name, *_ in images:
+        name_offsets.append(len(names))
+        names += name.encode() + b"\0"
+    names_offset = HEADER_SIZE + ENTRY_SIZE * len(images)
+    offset = names_offset + len(names)
+    entries = b""
+    data = b""
+    for (name, w, h, cf, blob), name_offset in zip(images, name_offsets):
+        pad = -offset % align
+        data += b"\0" * pad
+        offset += pad
+        entries += struct.pack("<IIHHBBH", offset, len(blob), w, h, COLOR_FORMATS[cf], 0, name_offset)
+        data += blob
+        offset += len(blob)
+    body = entries + names + data
+    header = struct.pack("<IHHIIII8x", MAGIC, VERSION, len(images), names_hash([i[0] for i in images]),
+                         HEADER_SIZE + len(body), zlib.crc32(body), names_offset)
+    return header + body
+
+
+def write_atomic(path, data):
+    tmp = path + ".tmp"
+    with open(tmp, "wb" if isinstance(data, bytes) else "w") as f:
+        f.write(data)
+    os.replace(tmp, path)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("files", nargs="+", help="SquareLine ui_img_*.c files")
+    parser.add_argument("-o", "--output", required=True, help="pack to write")
+    parser.add_argument("--source", help="C file defining the image descriptors and ui_assets[]")
+    parser.add_argument("--header", help="C header numbering the images")
+    parser.add_argument("--suffix", default="", help="appended to the descriptor names, to link next to the originals")
+    parser.add_argument("--compress", action="store_true", help="store the images in the tools/img_conv.py format")
+    parser.add_argument("--align", type=int, default=16, help="alignment of the image data (default 16)")
+    parser.add_argument("--report", action="store_true", help="print the size of every image")
+    args = parser.parse_args()
+    if args.source and not args.header:
+        parser.error("--source needs --header")
+
+    images = []
+    for path in sorted(args.files):
+        for name, w, h, cf, data, _ in img_conv.read_images(path):
+            if cf not in COLOR_FORMATS:
+                sys.exit("%s: %s has unsupported color format %s" % (path, name, cf))
+            if args.compress and cf == "LV_IMG_CF_TRUE_COLOR_ALPHA" and len(data) == w * h * 3:
+                data, _ = img_conv.encode(w, h, data)
+                cf = "LV_IMG_CF_USER_ENCODED_0"
+            images.append((name, w, h, cf, data))
+            if args.report:
+                print("%-44s %4dx%-4d %8d bytes %s" % (name, w, h, len(data), cf))
+    pack = build_pack(images, args.align)
+    write_atomic(args.output, pack)
+    if args.report:
+        print("%d images, %d bytes of pack" % (len(images), len(pack)))
+
+    names = [i[0] for i in images]
+    if args.header:
+        out = ["// Generated by tools/asset_pack.py from the SquareLine images, do not edit", "#pragma once", "",
+               '#include "lvgl.h"', "",
+               "#ifdef __cplusplus", 'extern "C" {', "#endif", "",
+               "// Hash of the image names in ID order, the asset pack must carry the same",
+               "#define UI_ASSETS_HASH 0x%08Xu" % names_hash(names), "",
+               "typedef enum {"]
+        out += ["    %s," % enum_name(n) for n in names]
+        out += ["    UI_ASSET_COUNT,", "} ui_asset_id_t;", "",
+                "// Descriptors of the images by ID, pointed at the asset pack by disp_assets_new",
+                "extern lv_img_dsc_t *const ui_assets[UI_ASSET_COUNT];", "",
+                "#ifdef __cplusplus", "}", "#endif", ""]
+        write_atomic(args.header, "\n".join(out))
+    if args.source:
+        out = ["// Generated by tools/asset_pack.py from the SquareLine images, do not edit", "",
+               '#include "%s"' % os.path.basename(args.header), "",
+               "// ui.h declares them const: they are written once, by disp_assets_new before the UI is built"]
+        out += ["lv_img_dsc_t %s%s;" % (n, args.suffix) for n in names]
+        out += ["", "lv_img_dsc_t *const ui_assets[UI_ASSET_COUNT] = {"]
+        out += ["    [%s] = &%s%s," % (enum_name(n), n, args.suffix) for n in names]
+        out += ["};", ""]
+        write_atomic(args.source, "\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
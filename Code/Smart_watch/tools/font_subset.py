@@ -0,0 +1,395 @@
+#!/usr/bin/env python3
+"""Cut LVGL's built-in fonts down to the characters the UI can show.
+
+Reads the lv_font_montserrat_*.c files of LVGL (lv_font_conv output, plain bitmaps, class kerning) and writes
+one C file with a ui_font_* copy of each font that keeps only the glyphs of the texts found in the given
+sources. The glyph bitmaps, metrics and kerning of the kept glyphs are copied unchanged, so a text draws the
+same as with the full font. main/CMakeLists.txt runs it at build time and compiles main/ with
+-Dlv_font_montserrat_12=ui_font_montserrat_12 and so on, which leaves the full fonts unreferenced.
+
+    python3 tools/font_subset.py -o ui_fonts.c --text-from main/ui/screens/*.c main/main.c -- \\
+        managed_components/lvgl__lvgl/src/font/lv_font_montserrat_1[246].c
+    python3 tools/font_subset.py --report -o /tmp/ui_fonts.c --text-from main/ui/screens/*.c main/main.c -- \\
+        managed_components/lvgl__lvgl/src/font/lv_font_montserrat_16.c
+
+Texts are taken from the string literals of the calls that set a label text (lv_label_set_text*, the
+disp_update_label_text* messages) and of the formats the data bindings print with (disp_model_bind_label,
+snprintf and strftime into a buffer). A conversion keeps every character it can print: digits and '-' for
+integers, also '.', 'e' and '+' for floats; a %s or a text from elsewhere must be added with --chars.
+Widgets that draw texts of their own keep them when they are created: the day names, day numbers, month names
+and arrow symbols of lv_calendar and its headers, the tick values of lv_chart; LVGL's default names, as
+sdkconfig leaves CONFIG_LV_CALENDAR_DEFAULT_DAY_NAMES and _MONTH_NAMES unset.
+Every font keeps the characters of all texts, as the sources do not say which label uses which font.
+"""
+import argparse
+import os
+import re
+import sys
+
+# Always kept: the space, and '.' for the "..." of LV_LABEL_LONG_DOT
+BASE_CHARS = " ."
+
+TEXT_CALLS = ("lv_label_set_text", "lv_label_set_text_static", "disp_update_label_text")
+FORMAT_CALLS = ("lv_label_set_text_fmt", "disp_update_label_text_fmt", "disp_model_bind_label", "snprintf")
+STRFTIME_CALLS = ("strftime",)
+TOKEN_RE = re.compile(r'"((?:[^"\\]|\\.)*)"|\b(PRI[diouxX](?:8|16|32|64|MAX|PTR)?)\b')
+CONVERSION_RE = re.compile(r"%[-+ #0]*(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|z|j|t|L)?([%a-zA-Z])")
+ESCAPES = {"n": "\n", "t": "\t", "\\": "\\", '"': '"', "'": "'", "0": "\0"}
+
+DIGITS = "0123456789"
+INT_CHARS = DIGITS + "-"
+CONVERSION_CHARS = {
+    "d": INT_CHARS, "i": INT_CHARS, "u": DIGITS, "o": DIGITS,
+    "x": DIGITS + "abcdef", "X": DIGITS + "ABCDEF",
+    "f": INT_CHARS + ".", "F": INT_CHARS + ".", "g": INT_CHARS + ".e+", "e": INT_CHARS + ".e+",
+    "c": None, "s": None, "p": None,
+}
+# LV_CALENDAR_DEFAULT_DAY_NAMES and LV_CALENDAR_DEFAULT_MONTH_NAMES of LVGL 8
+DAY_NAMES = "Su Mo Tu We Th Fr Sa"
+MONTH_NAMES = "January February March April May June July August September October November December"
+# LV_SYMBOL_LEFT, LV_SYMBOL_RIGHT and LV_SYMBOL_DOWN
+SYMBOL_LEFT = "\uf053"
+SYMBOL_RIGHT = "\uf054"
+SYMBOL_DOWN = "\uf078"
+# Characters a widget draws by itself: the calendar its day names and numbers, the arrow header "<year> <month>"
+# between two arrows, the dropdown header the years and month names in its lists, the chart its tick values
+WIDGET_CHARS = {
+    "lv_calendar_create": DAY_NAMES + DIGITS,
+    "lv_calendar_header_arrow_create": MONTH_NAMES + DIGITS + SYMBOL_LEFT + SYMBOL_RIGHT,
+    "lv_calendar_header_dropdown_create": MONTH_NAMES + DIGITS + SYMBOL_DOWN,
+    "lv_chart_create": INT_CHARS,
+}
+
+CALL_RE = re.compile(r"\b(%s)\s*\(" % "|".join(TEXT_CALLS + FORMAT_CALLS + STRFTIME_CALLS + tuple(WIDGET_CHARS)))
+
+# strftime conversions that print digits only; names of days and months are not supported
+STRFTIME_CHARS = {c: DIGITS for c in "CdeHIjmMSuUVwWyYGg"}
+STRFTIME_CHARS.update({"%": "%", "n": "\n", "t": "\t", "R": DIGITS + ":", "T": DIGITS + ":", "D": DIGITS + "/",
+                       "F": DIGITS + "-"})
+
+ARRAY_RE = r"static\s+(?:LV_ATTRIBUTE_LARGE_CONST\s+)?const\s+\w+\s+%s\[\]\s*=\s*\{(.*?)\};"
+GLYPH_RE = re.compile(r"\{\s*\.bitmap_index\s*=\s*(\d+),\s*\.adv_w\s*=\s*(\d+),\s*\.box_w\s*=\s*(\d+),\s*"
+                      r"\.box_h\s*=\s*(\d+),\s*\.ofs_x\s*=\s*(-?\d+),\s*\.ofs_y\s*=\s*(-?\d+)\s*\}")
+CMAP_RE = re.compile(r"\{\s*\.range_start\s*=\s*(\d+),\s*\.range_length\s*=\s*(\d+),\s*\.glyph_id_start\s*=\s*(\d+),"
+                     r"\s*\.unicode_list\s*=\s*(\w+),\s*\.glyph_id_ofs_list\s*=\s*(\w+),\s*\.list_length\s*=\s*(\d+),"
+                     r"\s*\.type\s*=\s*(\w+)\s*\}", re.S)
+
+
+def c_string(body):
+    """Characters of a C string literal body."""
+    out = []
+    i = 0
+    while i < len(body):
+        c = body[i]
+        if c != "\\":
+            out.append(c)
+            i += 1
+            continue
+        e = body[i + 1]
+        if e == "x":
+            m = re.match(r"[0-9a-fA-F]+", body[i + 2:])
+            out.append(chr(int(m.group(0), 16)))
+            i += 2 + len(m.group(0))
+        else:
+            out.append(ESCAPES.get(e, e))
+            i += 2
+    return "".join(out)
+
+
+def call_args(src, start):
+    """Text of the argument list of the call whose '(' is at `start`."""
+    depth = 0
+    i = start
+    in_str = False
+    while i < len(src):
+        c = src[i]
+        if in_str:
+            if c == "\\":
+                i += 1
+            elif c == '"':
+                in_str = False
+        elif c == '"':
+            in_str = True
+        elif c == "(":
+            depth += 1
+        elif c == ")":
+            depth -= 1
+            if depth == 0:
+                return src[start + 1:i]
+        i += 1
+    return src[start + 1:]
+
+
+def literal(args):
+    """The string literal argument of a call, with its adjacent pieces and PRI macros joined; None without one."""
+    pieces = []
+    for m in TOKEN_RE.finditer(args):
+        if m.group(1) is not None:
+            pieces.append(c_string(m.group(1)))
+        else:
+            pieces.append(m.group(2)[-1] if m.group(2)[3] in "diouxX" else "d")
+    return "".join(pieces) if pieces else None
+
+
+def format_chars(fmt, conversions, where):
+    chars = set()
+    pos = 0
+    for m in CONVERSION_RE.finditer(fmt):
+        chars.update(fmt[pos:m.start()])
+        pos = m.end()
+        conv = m.group(4)
+        printed = conversions.get(conv)
+        if printed is None:
+            print("%s: %%%s in \"%s\" prints text not known here, pass it with --chars" % (where, conv, fmt),
+                  file=sys.stderr)
+            continue
+        chars.update(printed)
+    chars.update(fmt[pos:])
+    return chars
+
+
+def source_chars(path):
+    """Characters the label texts, binding formats and widgets of a C file can show."""
+    with open(path, encoding="utf-8") as f:
+        src = f.read()
+    src = re.sub(r"//[^\n]*|/\*.*?\*/", "", src, flags=re.S)
+    chars = set()
+    for m in CALL_RE.finditer(src):
+        name = m.group(1)
+        if name in WIDGET_CHARS:
+            chars.update(WIDGET_CHARS[name])
+            continue
+        text = literal(call_args(src, m.end() - 1))
+        if text is None:
+            continue
+        where = "%s: %s" % (os.path.basename(path), name)
+        if name in TEXT_CALLS:
+            chars.update(text)
+        elif name in STRFTIME_CALLS:
+            chars.update(format_chars(text, STRFTIME_CHARS, where))
+        else:
+            percent = {"%": "%"}
+            percent.update(CONVERSION_CHARS)
+            chars.update(format_chars(text, percent, where))
+    return chars
+
+
+def numbers(body):
+    return [int(x, 0) for x in re.findall(r"-?0x[0-9a-fA-F]+|-?\d+", re.sub(r"/\*.*?\*/", "", body, flags=re.S))]
+
+
+def array(src, name, required=True):
+    m = re.search(ARRAY_RE % name, src, re.S)
+    if m is None:
+        if required:
+            raise ValueError("no %s[]" % name)
+        return None
+    return m.group(1)
+
+
+def field(src, name):
+    m = re.search(r"\.%s\s*=\s*(-?\d+)" % name, src)
+    if m is None:
+        raise ValueError("no .%s" % name)
+    return int(m.group(1))
+
+
+class Font:
+    """The parts of an lv_font_conv C file the subset needs."""
+
+    def __init__(self, path):
+        with open(path, encoding="utf-8") as f:
+            src = f.read()
+        m = re.search(r"const\s+lv_font_t\s+(\w+)\s*=", src)
+        if m is None:
+            raise ValueError("%s: no lv_font_t" % path)
+        self.name = m.group(1)
+        if field(src, "bitmap_format") != 0:
+            raise ValueError("%s: compressed bitmaps are not supported" % path)
+        self.bpp = field(src, "bpp")
+        self.kern_scale = field(src, "kern_scale")
+        self.line_height = field(src, "line_height")
+        self.base_line = field(src, "base_line")
+        self.underline_position = field(src, "underline_position")
+        self.underline_thickness = field(src, "underline_thickness")
+        self.bitmap = bytes(numbers(array(src, "glyph_bitmap")))
+        self.glyphs = [tuple(int(x) for x in g) for g in GLYPH_RE.findall(array(src, "glyph_dsc"))]
+
+        self.gid = {}
+        self.cmap_bytes = 0
+        for start, length, gid_start, ulist, ofs_list, list_len, kind in CMAP_RE.findall(src):
+            start, gid_start = int(start), int(gid_start)
+            if ofs_list != "NULL":
+                raise ValueError("%s: glyph id offset lists are not supported" % path)
+            if kind == "LV_FONT_FMT_TXT_CMAP_FORMAT0_TINY":
+                for i in range(int(length)):
+                    self.gid[start + i] = gid_start + i
+            elif kind == "LV_FONT_FMT_TXT_CMAP_SPARSE_TINY":
+                self.cmap_bytes += 2 * int(list_len)
+                for i, ofs in enumerate(numbers(array(src, ulist))[:int(list_len)]):
+                    self.gid[start + ofs] = gid_start + i
+            else:
+                raise ValueError("%s: cmap %s is not supported" % (path, kind))
+            self.cmap_bytes += 20
+
+        self.kern = None
+        if field(src, "kern_classes") == 1:
+            self.kern = (numbers(array(src, "kern_left_class_mapping")),
+                         numbers(array(src, "kern_right_class_mapping")),
+                         numbers(array(src, "kern_class_values")),
+                         field(src, "left_class_cnt"), field(src, "right_class_cnt"))
+        elif re.search(r"\.kern_dsc\s*=\s*NULL", src) is None:
+            raise ValueError("%s: pair kerning is not supported" % path)
+
+    def glyph_bitmap(self, gid):
+        """Bitmap bytes of a glyph: from its index to the next glyph's."""
+        start = self.glyphs[gid][0]
+        ends = [g[0] for g in self.glyphs[gid + 1:] if g[0] > start]
+        end = ends[0] if ends else len(self.bitmap)
+        box_w, box_h = self.glyphs[gid][2], self.glyphs[gid][3]
+        return self.bitmap[start:end] if box_w and box_h else b""
+
+    def size(self):
+        """Bytes of constant data, as the C file lays it out on the 32-bit target."""
+        size = len(self.bitmap) + 8 * len(self.glyphs) + self.cmap_bytes
+        if self.kern:
+            left, right, values, _, _ = self.kern
+            size += len(left) + len(right) + len(values)
+        return size
+
+
+def c_bytes(data, per_line=16, fmt="0x%02x"):
+    lines = []
+    for i in range(0, len(data), per_line):
+        lines.append("    " + ", ".join(fmt % b for b in data[i:i + per_line]))
+    return ",\n".join(lines) if lines else "    0"
+
+
+def subset(font, chars, prefix):
+    """C source of `font` cut down to `chars`, and its size."""
+    name = prefix + re.sub(r"^lv_", "", font.name)
+    kept = sorted(cp for cp in {ord(c) for c in chars} if cp in font.gid)
+    gids = [0] + [font.gid[cp] for cp in kept]
+    bitmap = b""
+    glyph_lines = ["    {.bitmap_index = 0, .adv_w = 0, .box_w = 0, .box_h = 0, .ofs_x = 0, .ofs_y = 0} /* id = 0 reserved */"]
+    for cp, gid in zip(kept, gids[1:]):
+        _, adv_w, box_w, box_h, ofs_x, ofs_y = font.glyphs[gid]
+        glyph_lines.append("    {.bitmap_index = %d, .adv_w = %d, .box_w = %d, .box_h = %d, .ofs_x = %d, .ofs_y = %d}"
+                           " /* U+%04X %s */" % (len(bitmap), adv_w, box_w, box_h, ofs_x, ofs_y, cp,
+                                                 '"%s"' % chr(cp) if 0x20 < cp < 0x7f and chr(cp) not in "*/" else ""))
+        bitmap += font.glyph_bitmap(gid)
+    range_start = kept[0] if kept else 0
+    range_length = kept[-1] - range_start + 1 if kept else 0
+    unicode_list = [cp - range_start for cp in kept]
+
+    out = ["", "/* %s: %d of %d glyphs */" % (name, len(kept), len(font.gid)), "",
+           "static LV_ATTRIBUTE_LARGE_CONST const uint8_t %s_bitmap[] = {" % name, c_bytes(bitmap), "};", "",
+           "static const lv_font_fmt_txt_glyph_dsc_t %s_glyph_dsc[] = {" % name, ",\n".join(glyph_lines), "};", "",
+           "static const uint16_t %s_unicode_list[] = {" % name, c_bytes(unicode_list, 8, "0x%04x"), "};", "",
+           "static const lv_font_fmt_txt_cmap_t %s_cmaps[] = {" % name,
+           "    {",
+           "        .range_start = %d, .range_length = %d, .glyph_id_start = 1," % (range_start, range_length),
+           "        .unicode_list = %s_unicode_list, .glyph_id_ofs_list = NULL, .list_length = %d,"
+           % (name, len(kept)),
+           "        .type = LV_FONT_FMT_TXT_CMAP_SPARSE_TINY",
+           "    }",
+           "};", ""]
+    size = len(bitmap) + 8 * len(gids) + 2 * len(unicode_list) + 20
+    kern_dsc = "NULL"
+    if font.kern:
+        left, right, values, _, right_cnt = font.kern
+        # Renumber the classes the kept glyphs use, class 0 (no kerning) stays 0
+        used_left = sorted({left[g] for g in gids if left[g]})
+        used_right = sorted({right[g] for g in gids if right[g]})
+        new_left = {c: i + 1 for i, c in enumerate(used_left)}
+        new_right = {c: i + 1 for i, c in enumerate(used_right)}
+        left_map = [new_left.get(left[g], 0) for g in gids]
+        right_map = [new_right.get(right[g], 0) for g in gids]
+        # Class values are indexed from class 1
+        pair_values = [0] * (len(used_left) * len(used_right))
+        for lc in used_left:
+            for rc in used_right:
+                pair_values[(new_left[lc] - 1) * len(used_right) + new_right[rc] - 1] = \
+                    values[(lc - 1) * right_cnt + rc - 1]
+        out += ["static const uint8_t %s_kern_left_class_mapping[] = {" % name, c_bytes(left_map, 16, "%d"), "};", "",
+                "static const uint8_t %s_kern_right_class_mapping[] = {" % name, c_bytes(right_map, 16, "%d"), "};",
+                "",
+                "static const int8_t %s_kern_class_values[] = {" % name, c_bytes(pair_values, 16, "%d"), "};", "",
+                "static const lv_font_fmt_txt_kern_classes_t %s_kern_classes = {" % name,
+                "    .class_pair_values = %s_kern_class_values," % name,
+                "    .left_class_mapping = %s_kern_left_class_mapping," % name,
+                "    .right_class_mapping = %s_kern_right_class_mapping," % name,
+                "    .left_class_cnt = %d," % len(used_left),
+                "    .right_class_cnt = %d," % len(used_right),
+                "};", ""]
+        size += 2 * len(gids) + len(pair_values)
+        kern_dsc = "&%s_kern_classes" % name
+    out += ["static lv_font_fmt_txt_glyph_cache_t %s_cache;" % name,
+            "static const lv_font_fmt_txt_dsc_t %s_dsc = {" % name,
+            "    .glyph_bitmap = %s_bitmap," % name,
+            "    .glyph_dsc = %s_glyph_dsc," % name,
+            "    .cmaps = %s_cmaps," % name,
+            "    .kern_dsc = %s," % kern_dsc,
+            "    .kern_scale = %d," % font.kern_scale,
+            "    .cmap_num = 1,",
+            "    .bpp = %d," % font.bpp,
+            "    .kern_classes = %d," % (1 if font.kern else 0),
+            "    .bitmap_format = 0,",
+            "    .cache = &%s_cache," % name,
+            "};", "",
+            "const lv_font_t %s = {" % name,
+            "    .get_glyph_dsc = lv_font_get_glyph_dsc_fmt_txt,",
+            "    .get_glyph_bitmap = lv_font_get_bitmap_fmt_txt,",
+            "    .line_height = %d," % font.line_height,
+            "    .base_line = %d," % font.base_line,
+            "    .subpx = LV_FONT_SUBPX_NONE,",
+            "    .underline_position = %d," % font.underline_position,
+            "    .underline_thickness = %d," % font.underline_thickness,
+            "    .dsc = &%s_dsc," % name,
+            "};"]
+    return name, "\n".join(out), size, len(kept)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("fonts", nargs="+", help="LVGL font C files, e.g. lv_font_montserrat_16.c")
+    parser.add_argument("-o", "--output", required=True, help="C file to write")
+    parser.add_argument("--text-from", nargs="+", default=[], metavar="FILE",
+                        help="C sources whose label texts and binding formats to keep")
+    parser.add_argument("--chars", default="", help="characters to keep besides, e.g. the text of a %%s")
+    parser.add_argument("--prefix", default="ui_", help="replaces the lv_ of the font names (default ui_)")
+    parser.add_argument("--report", action="store_true", help="print the characters kept and the sizes")
+    args = parser.parse_args()
+
+    chars = set(BASE_CHARS) | set(args.chars)
+    for path in args.text_from:
+        chars |= source_chars(path)
+    chars.discard("\n")
+    chars.discard("\0")
+
+    out = ["// Generated by tools/font_subset.py, do not edit",
+           "// Characters: %s" % "".join(sorted(c for c in chars if c.isprintable())).replace("*/", "* /"),
+           "",
+           "#include \"lvgl.h\""]
+    for path in args.fonts:
+        try:
+            font = Font(path)
+        except ValueError as e:
+            sys.exit(str(e))
+        name, source, size, count = subset(font, chars, args.prefix)
+        out.append(source)
+        missing = sorted(c for c in chars if ord(c) not in font.gid and c.isprintable() and c != " ")
+        if missing:
+            print("%s: no glyph for %s" % (font.name, " ".join(repr(c) for c in missing)), file=sys.stderr)
+        if args.report:
+            print("%-24s %4d -> %3d glyphs, %6d -> %5d bytes" % (font.name, len(font.gid), count, font.size(), size))
+    if args.report:
+        print("characters: %s" % "".join(sorted(chars)))
+    tmp = args.output + ".tmp"
+    with open(tmp, "w", encoding="utf-8") as f:
+        f.write("\n".join(out) + "\n")
+    os.replace(tmp, args.output)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+"""Compress the SquareLine image arrays into the run-length format of main/display/disp_img.c.
+
+Reads the ui_img_*.c files SquareLine exports (LV_IMG_CF_TRUE_COLOR_ALPHA, 16-bit color) and writes one C file
+that defines the same lv_img_dsc_t symbols with LV_IMG_CF_USER_ENCODED_0 data. Images in other formats are
+written through unchanged. main/CMakeLists.txt runs it at build time in place of the exported arrays.
+
+    python3 tools/img_conv.py -o ui_images_rle.c main/ui/images/*.c
+    python3 tools/img_conv.py --report -o /tmp/ui_images_rle.c main/ui/images/*.c
+
+Blob layout, little endian (see disp_img.h):
+    u32 magic "DIMG", u16 width, u16 height, u8 mode, u8 flags, u16 palette entries
+    u32 row offsets from the start of the blob, one per row
+    palette, 3 bytes per entry (RGB565 as stored, then alpha), indexed mode only
+    rows; planes mode: [u16 offset of the alpha plane in the row, when there is alpha] RGB565 packets, A8 packets
+          indexed mode: index packets
+A packet starts with a byte c: c & 0x80 repeats the next unit (c & 0x7f) + 1 times, else (c + 1) units follow.
+"""
+import argparse
+import os
+import re
+import struct
+import sys
+
+MAGIC = 0x474D4944  # "DIMG"
+MODE_PLANES = 0
+MODE_INDEXED = 1
+FLAG_ALPHA = 0x01
+MAX_PACKET = 128
+
+DATA_RE = re.compile(r"uint8_t\s+(\w+)_data\[\]\s*=\s*\{(.*?)\};", re.S)
+DSC_RE = re.compile(r"const\s+lv_img_dsc_t\s+(\w+)\s*=\s*\{(.*?)\};", re.S)
+FIELD_RE = re.compile(r"\.header\.(\w+)\s*=\s*(\w+)")
+SOURCE_RE = re.compile(r"//\s*IMAGE DATA:\s*(.*)")
+
+
+def packets(units):
+    """Run-length packets of a list of equal-sized byte strings."""
+    out = bytearray()
+    i = 0
+    n = len(units)
+    while i < n:
+        run = 1
+        while i + run < n and run < MAX_PACKET and units[i + run] == units[i]:
+            run += 1
+        if run >= 2:
+            out.append(0x80 | (run - 1))
+            out += units[i]
+            i += run
+            continue
+        # Literal up to the next run of two
+        start = i
+        while i < n and i - start < MAX_PACKET and not (i + 1 < n and units[i + 1] == units[i]):
+            i += 1
+        out.append(i - start - 1)
+        for u in units[start:i]:
+            out += u
+    return bytes(out)
+
+
+def encode_rows(rows, header, palette=b""):
+    """Blob of the encoded rows behind the header, the row offset table and the palette."""
+    base = 12 + 4 * len(rows) + len(palette)
+    offsets = []
+    body = bytearray()
+    for row in rows:
+        offsets.append(base + len(body))
+        body += row
+    return header + struct.pack("<%dI" % len(rows), *offsets) + palette + bytes(body)
+
+
+def encode_planes(w, h, px, alpha):
+    rows = []
+    for y in range(h):
+        colors, alphas = [], []
+        prev = px[y * w][0]
+        for x in range(w):
+            color, a = px[y * w + x]
+            # Invisible pixels take the color before them, which only lengthens the runs
+            if a == 0:
+                color = prev
+            prev = color
+            colors.append(color)
+            alphas.append(bytes((a,)))
+        color_plane = packets(colors)
+        if alpha:
+            rows.append(struct.pack("<H", 2 + len(color_plane)) + color_plane + packets(alphas))
+        else:
+            rows.append(color_plane)
+    header = struct.pack("<IHHBBH", MAGIC, w, h, MODE_PLANES, FLAG_ALPHA if alpha else 0, 0)
+    return encode_rows(rows, header)
+
+
+def encode_indexed(w, h, px, alpha):
+    """None when the image has more than 256 distinct pixels."""
+    entries = {}
+    indices = []
+    for color, a in px:
+        key = (b"\x00\x00", 0) if a == 0 else (color, a)
+        if key not in entries:
+            if len(entries) == 256:
+                return None
+            entries[key] = len(entries)
+        indices.append(bytes((entries[key],)))
+    palette = b"".join(color + bytes((a,)) for color, a in entries)
+    rows = [packets(indices[y * w:(y + 1) * w]) for y in range(h)]
+    header = struct.pack("<IHHBBH", MAGIC, w, h, MODE_INDEXED, FLAG_ALPHA if alpha else 0, len(entries))
+    return encode_rows(rows, header, palette)
+
+
+def encode(w, h, data):
+    """Smallest blob of an RGB565 + A8 image and the name of its mode."""
+    px = [(data[i:i + 2], data[i + 2]) for i in range(0, w * h * 3, 3)]
+    alpha = any(a != 0xFF for _, a in px)
+    candidates = [(encode_planes(w, h, px, alpha), "planes")]
+    indexed = encode_indexed(w, h, px, alpha)
+    if indexed is not None:
+        candidates.append((indexed, "indexed"))
+    return min(candidates, key=lambda c: len(c[0]))
+
+
+def c_array(data):
+    lines = []
+    for i in range(0, len(data), 32):
+        lines.append("    " + ",".join("0x%02X" % b for b in data[i:i + 32]) + ",")
+    return "\n".join(lines)
+
+
+def read_images(path):
+    text = open(path).read()
+    arrays = {m.group(1): m.group(2) for m in DATA_RE.finditer(text)}
+    source = SOURCE_RE.search(text)
+    for m in DSC_RE.finditer(text):
+        name = m.group(1)
+        fields = dict(FIELD_RE.findall(m.group(2)))
+        if name not in arrays:
+            sys.exit("%s: no data array for %s" % (path, name))
+        data = bytes(int(v, 16) for v in re.findall(r"0x([0-9A-Fa-f]{2})", arrays[name]))
+        yield name, int(fields["w"]), int(fields["h"]), fields["cf"], data, source.group(1) if source else path
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("files", nargs="+", help="SquareLine ui_img_*.c files")
+    parser.add_argument("-o", "--output", required=True, help="C file to write")
+    parser.add_argument("--suffix", default="", help="appended to the symbol names, to link next to the originals")
+    parser.add_argument("--table", help="also define <TABLE>_raw[], <TABLE>_rle[], <TABLE>_names[] and "
+                        "<TABLE>_count pairing the originals with the compressed images")
+    parser.add_argument("--report", action="store_true", help="print the size of every image")
+    args = parser.parse_args()
+
+    out = ["// Generated by tools/img_conv.py from the SquareLine images, do not edit", "",
+           '#include "lvgl.h"', "",
+           "#ifndef LV_ATTRIBUTE_MEM_ALIGN", "    #define LV_ATTRIBUTE_MEM_ALIGN", "#endif", ""]
+    names = []
+    raw_total = rle_total = 0
+    for path in sorted(args.files):
+        for name, w, h, cf, data, source in read_images(path):
+            sym = name + args.suffix
+            names.append(name)
+            if cf == "LV_IMG_CF_TRUE_COLOR_ALPHA" and len(data) == w * h * 3:
+                blob, mode = encode(w, h, data)
+                cf_out = "LV_IMG_CF_USER_ENCODED_0"
+            else:
+                blob, mode, cf_out = data, "raw", cf
+            raw_total += len(data)
+            rle_total += len(blob)
+            if args.report:
+                print("%-44s %4dx%-4d %8d -> %7d bytes %5.1f%% %s" % (name, w, h, len(data), len(blob),
+                      100.0 * len(blob) / len(data), mode))
+            out += ["// %s: %dx%d, %d -> %d bytes (%s)" % (source, w, h, len(data), len(blob), mode),
+                    "static const LV_ATTRIBUTE_MEM_ALIGN uint8_t %s_data[] = {" % sym, c_array(blob), "};",
+                    "const lv_img_dsc_t %s = {" % sym,
+                    "    .header.always_zero = 0,",
+                    "    .header.w = %d," % w,
+                    "    .header.h = %d," % h,
+                    "    .data_size = sizeof(%s_data)," % sym,
+                    "    .header.cf = %s," % cf_out,
+                    "    .data = %s_data," % sym,
+                    "};", ""]
+    if args.table:
+        out += ["extern const lv_img_dsc_t %s;" % n for n in names if args.suffix]
+        out += ["", "const lv_img_dsc_t *const %s_raw[] = {" % args.table]
+        out += ["    &%s," % n for n in names]
+        out += ["};", "const lv_img_dsc_t *const %s_rle[] = {" % args.table]
+        out += ["    &%s%s," % (n, args.suffix) for n in names]
+        out += ["};", "const char *const %s_names[] = {" % args.table]
+        out += ['    "%s",' % n for n in names]
+        out += ["};", "const size_t %s_count = %d;" % (args.table, len(names)), ""]
+    if args.report:
+        print("%d images, %d -> %d bytes (%.1f%%)" % (len(names), raw_total, rle_total,
+              100.0 * rle_total / raw_total if raw_total else 0.0))
+
+    tmp = args.output + ".tmp"
+    with open(tmp, "w") as f:
+        f.write("\n".join(out))
+    os.replace(tmp, args.output)
+
+
+if __name__ == "__main__":
+    main()